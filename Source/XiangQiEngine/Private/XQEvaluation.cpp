@@ -0,0 +1,102 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQEvaluation.h"
+#include "XQFile.h"
+#include "XQPosition.h"
+#include "XQTunedEvalParams.h"
+
+#include <cstdio>
+#include <cstring>
+
+static FXQEvalParams MakeDefaultXQEvalParams()
+{
+    FXQEvalParams Params;
+    std::memcpy(Params.Material, XQTunedMaterial, sizeof(Params.Material));
+    std::memcpy(Params.PositionValues, XQTunedPositionValues, sizeof(Params.PositionValues));
+    return Params;
+}
+
+const FXQEvalParams& FXQEvalParams::GetDefault()
+{
+    static const FXQEvalParams Default = MakeDefaultXQEvalParams();
+    return Default;
+}
+
+bool FXQEvalParams::LoadFromFile(const std::string& Path)
+{
+    std::FILE* File = OpenXQFile(Path, "r");
+    if (File == nullptr)
+    {
+        return false;
+    }
+
+    // 格式：子力价值8个，然后是8x90的位置分，空白分隔
+    FXQEvalParams Loaded;
+    bool bOk = true;
+    for (int32 i = 0; i < 8 && bOk; i++)
+    {
+        bOk = std::fscanf(File, "%d", &Loaded.Material[i]) == 1;
+    }
+    for (int32 Type = 0; Type < 8 && bOk; Type++)
+    {
+        for (int32 Square = 0; Square < XQ_SQUARES && bOk; Square++)
+        {
+            bOk = std::fscanf(File, "%d", &Loaded.PositionValues[Type][Square]) == 1;
+        }
+    }
+    std::fclose(File);
+
+    if (bOk)
+    {
+        *this = Loaded;
+    }
+    return bOk;
+}
+
+bool FXQEvalParams::SaveToFile(const std::string& Path) const
+{
+    std::FILE* File = OpenXQFile(Path, "w");
+    if (File == nullptr)
+    {
+        return false;
+    }
+
+    for (int32 i = 0; i < 8; i++)
+    {
+        std::fprintf(File, i < 7 ? "%d " : "%d\n", Material[i]);
+    }
+    for (int32 Type = 0; Type < 8; Type++)
+    {
+        for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+        {
+            std::fprintf(File, XQFileOf(Square) < XQ_FILES - 1 ? "%d " : "%d\n", PositionValues[Type][Square]);
+        }
+    }
+    return std::fclose(File) == 0;
+}
+
+int32 XQGetPieceValue(EXQPieceType Type)
+{
+    return XQTunedMaterial[static_cast<int32>(Type)];
+}
+
+int32 XQEvaluate(const FXQPosition& Position, EXQColor Color, const FXQEvalParams& Params)
+{
+    int32 Score = 0;
+    for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+    {
+        const uint8 Piece = Position.GetPiece(Square);
+        if (Piece == 0)
+        {
+            continue;
+        }
+
+        const int32 Type = static_cast<int32>(XQPieceTypeOf(Piece));
+        const EXQColor PieceColor = XQPieceColorOf(Piece);
+        const int32 RelativeSquare = PieceColor == EXQColor::Red ? Square : XQMirrorSquare(Square);
+        const int32 Value = Params.Material[Type] + Params.PositionValues[Type][RelativeSquare];
+
+        Score += PieceColor == Color ? Value : -Value;
+    }
+    return Score;
+}
@@ -0,0 +1,90 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQFile.h"
+
+#include <system_error>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if !XQ_STANDALONE
+#include "Containers/StringConv.h"
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+std::filesystem::path MakeXQFilePath(const std::string& Path)
+{
+#if defined(_WIN32)
+#if !XQ_STANDALONE
+    // Windows上TCHAR就是wchar_t
+    return std::filesystem::path(std::wstring(UTF8_TO_TCHAR(Path.c_str())));
+#else
+    const int Length = MultiByteToWideChar(CP_UTF8, 0, Path.c_str(), -1, nullptr, 0);
+    if (Length <= 1)
+    {
+        return std::filesystem::path();
+    }
+    std::wstring WidePath(Length - 1, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, Path.c_str(), -1, &WidePath[0], Length);
+    return std::filesystem::path(WidePath);
+#endif
+#else
+    return std::filesystem::path(Path);
+#endif
+}
+
+std::FILE* OpenXQFile(const std::string& Path, const char* Mode)
+{
+#if defined(_WIN32)
+    const std::wstring WideMode(Mode, Mode + std::char_traits<char>::length(Mode));
+    return _wfopen(MakeXQFilePath(Path).c_str(), WideMode.c_str());
+#else
+    return std::fopen(Path.c_str(), Mode);
+#endif
+}
+
+bool SyncXQFile(std::FILE* File)
+{
+    if (std::fflush(File) != 0)
+    {
+        return false;
+    }
+#if defined(_WIN32)
+    return _commit(_fileno(File)) == 0;
+#else
+    return fsync(fileno(File)) == 0;
+#endif
+}
+
+bool RenameXQFile(const std::string& From, const std::string& To)
+{
+    std::error_code Error;
+    std::filesystem::rename(MakeXQFilePath(From), MakeXQFilePath(To), Error);
+    return !Error;
+}
+
+bool RemoveXQFile(const std::string& Path)
+{
+    std::error_code Error;
+    return std::filesystem::remove(MakeXQFilePath(Path), Error);
+}
+
+int64 GetXQFileSize(const std::string& Path)
+{
+    std::error_code Error;
+    const uintmax_t Size = std::filesystem::file_size(MakeXQFilePath(Path), Error);
+    return Error ? -1 : static_cast<int64>(Size);
+}
+
+bool ResizeXQFile(const std::string& Path, int64 Size)
+{
+    std::error_code Error;
+    std::filesystem::resize_file(MakeXQFilePath(Path), static_cast<uintmax_t>(Size), Error);
+    return !Error;
+}
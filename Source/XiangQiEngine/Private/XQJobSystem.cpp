@@ -0,0 +1,149 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQJobSystem.h"
+
+#include <algorithm>
+
+void FXQJobStateBase::Cancel()
+{
+    bCancelled = true;
+
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (RunningSearch != nullptr)
+    {
+        RunningSearch->Stop();
+    }
+}
+
+void FXQJobStateBase::SetRunningSearch(FXQSearch* InSearch)
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    RunningSearch = InSearch;
+}
+
+bool FXQJobStateBase::IsReady() const
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return bReady;
+}
+
+void FXQJobStateBase::Wait() const
+{
+    std::unique_lock<std::mutex> Lock(Mutex);
+    ReadyCondition.wait(Lock, [this]() { return bReady; });
+}
+
+void FXQJobStateBase::MarkReady()
+{
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        bReady = true;
+    }
+    ReadyCondition.notify_all();
+}
+
+FXQJobSystem::FXQJobSystem(int32 InNumWorkers)
+{
+    const int32 NumWorkers = std::max(1, InNumWorkers);
+    Running.resize(NumWorkers);
+    for (int32 i = 0; i < NumWorkers; i++)
+    {
+        Contexts.push_back(std::make_unique<FXQSearchContext>());
+        Contexts.back()->WorkerIndex = i;
+    }
+    for (int32 i = 0; i < NumWorkers; i++)
+    {
+        Workers.emplace_back(&FXQJobSystem::WorkerLoop, this, i);
+    }
+}
+
+FXQJobSystem::~FXQJobSystem()
+{
+    CancelAll();
+    ResumeAll();
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        bExit = true;
+    }
+    WorkCondition.notify_all();
+    for (std::thread& Worker : Workers)
+    {
+        Worker.join();
+    }
+}
+
+void FXQJobSystem::CancelAll()
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    for (FQueuedJob& Job : Queue)
+    {
+        Job.State->Cancel();
+    }
+    for (std::shared_ptr<FXQJobStateBase>& State : Running)
+    {
+        if (State)
+        {
+            State->Cancel();
+        }
+    }
+}
+
+void FXQJobSystem::PauseAll()
+{
+    for (std::unique_ptr<FXQSearchContext>& Context : Contexts)
+    {
+        Context->Search.Pause();
+    }
+}
+
+void FXQJobSystem::ResumeAll()
+{
+    for (std::unique_ptr<FXQSearchContext>& Context : Contexts)
+    {
+        Context->Search.Resume();
+    }
+}
+
+void FXQJobSystem::Enqueue(std::shared_ptr<FXQJobStateBase> State, std::function<void(FXQSearchContext&)> Task)
+{
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (bExit)
+        {
+            State->Cancel();
+        }
+        Queue.push_back(FQueuedJob{ std::move(State), std::move(Task) });
+    }
+    WorkCondition.notify_one();
+}
+
+void FXQJobSystem::WorkerLoop(int32 Index)
+{
+    FXQSearchContext& Context = *Contexts[Index];
+    for (;;)
+    {
+        FQueuedJob Job;
+        {
+            std::unique_lock<std::mutex> Lock(Mutex);
+            WorkCondition.wait(Lock, [this]() { return bExit || !Queue.empty(); });
+            if (Queue.empty())
+            {
+                return; // 退出前先把队列里（已取消）的任务处理完，等待它们的一方不会卡住
+            }
+            Job = std::move(Queue.front());
+            Queue.pop_front();
+            Running[Index] = Job.State;
+        }
+
+        // 上一个任务被取消时留下的停止请求在这里清除，之后到达的Cancel经由SetRunningSearch照常生效
+        Context.Search.ResetStop();
+        Context.CancelFlag = &Job.State->GetCancelFlag();
+        Job.State->SetRunningSearch(&Context.Search);
+        Job.Task(Context);
+        Job.State->SetRunningSearch(nullptr);
+        Context.CancelFlag = nullptr;
+
+        std::lock_guard<std::mutex> Lock(Mutex);
+        Running[Index].reset();
+    }
+}
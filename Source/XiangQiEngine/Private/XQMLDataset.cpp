@@ -0,0 +1,147 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMLDataset.h"
+#include "XQPosition.h"
+
+#include <algorithm>
+#include <cstring>
+
+void XQMLEncodeFeatures(const FXQPosition& Position, float* OutFeatures)
+{
+    std::memset(OutFeatures, 0, sizeof(float) * XQ_ML_NUM_FEATURES);
+    for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+    {
+        const uint8 Piece = Position.GetPiece(Square);
+        if (Piece != 0)
+        {
+            OutFeatures[XQMLFeatureIndex(Square, XQPieceColorOf(Piece), XQPieceTypeOf(Piece))] = 1.0f;
+        }
+    }
+}
+
+void XQMLEncodeFeatures(const FXQPackedPosition& Position, float* OutFeatures)
+{
+    // 直接按槽位展开，不需要还原局面
+    std::memset(OutFeatures, 0, sizeof(float) * XQ_ML_NUM_FEATURES);
+    for (int32 Slot = 0; Slot < 32; Slot++)
+    {
+        const int32 Square = Slot == 0 ? (Position.Slots[0] & 0x7F) : Position.Slots[Slot];
+        if (Square < XQ_SQUARES)
+        {
+            OutFeatures[XQMLFeatureIndex(Square, FXQPackedPosition::GetSlotColor(Slot), FXQPackedPosition::GetSlotType(Slot))] = 1.0f;
+        }
+    }
+}
+
+int32 XQMLEncodeActiveFeatures(const FXQPosition& Position, uint16* OutIndices)
+{
+    int32 Num = 0;
+    for (int32 Square = 0; Square < XQ_SQUARES && Num < XQ_ML_MAX_ACTIVE_FEATURES; Square++)
+    {
+        const uint8 Piece = Position.GetPiece(Square);
+        if (Piece != 0)
+        {
+            OutIndices[Num++] = static_cast<uint16>(XQMLFeatureIndex(Square, XQPieceColorOf(Piece), XQPieceTypeOf(Piece)));
+        }
+    }
+    return Num;
+}
+
+int32 XQMLEncodeActiveFeatures(const FXQPackedPosition& Position, uint16* OutIndices)
+{
+    int32 Num = 0;
+    for (int32 Slot = 0; Slot < 32; Slot++)
+    {
+        const int32 Square = Slot == 0 ? (Position.Slots[0] & 0x7F) : Position.Slots[Slot];
+        if (Square < XQ_SQUARES)
+        {
+            OutIndices[Num++] = static_cast<uint16>(XQMLFeatureIndex(Square, FXQPackedPosition::GetSlotColor(Slot), FXQPackedPosition::GetSlotType(Slot)));
+        }
+    }
+    return Num;
+}
+
+bool FXQMLDataset::AddFile(const std::string& Path)
+{
+    std::unique_ptr<FXQMappedFile> Mapping(new FXQMappedFile());
+    if (!Mapping->Open(Path) || Mapping->GetSize() < static_cast<int64>(sizeof(FXQTrainingFileHeader)))
+    {
+        return false;
+    }
+
+    FXQTrainingFileHeader Header;
+    std::memcpy(&Header, Mapping->GetData(), sizeof(Header));
+    if (Header.Magic != XQ_TRAINING_FILE_MAGIC || Header.Version != XQ_TRAINING_FILE_VERSION || Header.RecordSize != sizeof(FXQTrainingRecord))
+    {
+        return false;
+    }
+
+    FFile File;
+    File.Records = reinterpret_cast<const FXQTrainingRecord*>(Mapping->GetData() + sizeof(Header));
+    File.Num = (Mapping->GetSize() - static_cast<int64>(sizeof(Header))) / static_cast<int64>(sizeof(FXQTrainingRecord));
+    File.First = Num;
+    File.Mapping = std::move(Mapping);
+    if (File.Num > 0)
+    {
+        Num += File.Num;
+        Files.push_back(std::move(File));
+    }
+    return true;
+}
+
+void FXQMLDataset::AddRecords(const FXQTrainingRecord* Records, int64 Count)
+{
+    if (Count <= 0)
+    {
+        return;
+    }
+
+    FFile File;
+    File.Storage.assign(Records, Records + Count);
+    File.Records = File.Storage.data();
+    File.Num = Count;
+    File.First = Num;
+    Num += Count;
+    Files.push_back(std::move(File));
+}
+
+void FXQMLDataset::Close()
+{
+    Files.clear();
+    Num = 0;
+}
+
+const FXQTrainingRecord& FXQMLDataset::GetRecord(int64 Index) const
+{
+    // 文件数很少，二分查找所在文件
+    auto It = std::upper_bound(Files.begin(), Files.end(), Index, [](int64 Value, const FFile& File) { return Value < File.First; });
+    const FFile& File = *(It - 1);
+    return File.Records[Index - File.First];
+}
+
+void FXQMLDataset::ExpandBatch(const int64* Indices, int32 Count, float* OutFeatures, int32* OutLabels) const
+{
+    for (int32 i = 0; i < Count; i++)
+    {
+        const FXQTrainingRecord& Record = GetRecord(Indices[i]);
+        XQMLEncodeFeatures(Record.Position, OutFeatures + static_cast<int64>(i) * XQ_ML_NUM_FEATURES);
+        FXQMove Move;
+        Move.Value = Record.BestMove;
+        const int32 Label = XQMLMoveLabel(Move);
+        OutLabels[i] = Label >= 0 ? Label : 0; // 损坏的样本，不让下标越界
+    }
+}
+
+void FXQMLDataset::ExpandBatch(const int64* Indices, int32 Count, uint16* OutFeatures, int32* OutOffsets, int32* OutLabels) const
+{
+    OutOffsets[0] = 0;
+    for (int32 i = 0; i < Count; i++)
+    {
+        const FXQTrainingRecord& Record = GetRecord(Indices[i]);
+        OutOffsets[i + 1] = OutOffsets[i] + XQMLEncodeActiveFeatures(Record.Position, OutFeatures + OutOffsets[i]);
+        FXQMove Move;
+        Move.Value = Record.BestMove;
+        const int32 Label = XQMLMoveLabel(Move);
+        OutLabels[i] = Label >= 0 ? Label : 0; // 损坏的样本，不让下标越界
+    }
+}
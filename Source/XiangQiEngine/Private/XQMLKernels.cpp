@@ -0,0 +1,690 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMLKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define XQ_ML_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define XQ_ML_X86 0
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define XQ_ML_NEON 1
+#include <arm_neon.h>
+#else
+#define XQ_ML_NEON 0
+#endif
+
+// GCC/Clang需要按函数打开AVX2指令集，MSVC可以直接使用内建函数
+#if XQ_ML_X86 && !defined(_MSC_VER)
+#define XQ_ML_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define XQ_ML_TARGET_AVX2
+#endif
+
+// 一组内核实现，启动时按CPU支持的指令集选择一组
+struct FXQMLKernelTable
+{
+    const char* Name;
+
+    float (*Dot)(const float* A, const float* B, int32 Num);
+
+    // 一行B同时与四行A做点积，B只读一次
+    void (*Dot4)(const float* const* A, const float* B, int32 Num, float* Out);
+
+    void (*Axpy)(float* Y, float Alpha, const float* X, int32 Num);
+
+    // 外积累加的寄存器分块：C[r][0, TileWidth) += sum_k A[r * RowStride + k * KStride] * B[k * LdB + j]，r为0~3。
+    // 标量实现没有分块，逐行累加
+    void (*Tile)(int32 K, const float* A, int64 RowStride, int64 KStride, const float* B, int64 LdB, float* C, int64 LdC);
+
+    int32 TileWidth;
+
+    int32 (*DotInt8)(const int8* A, const int8* B, int32 Num);
+
+    void (*AddInt8)(int32* Y, const int8* X, int32 Num);
+};
+
+// 标量实现，所有平台都可用
+static float DotXQMLScalar(const float* A, const float* B, int32 Num)
+{
+    // 四路累加，减少加法的依赖链
+    float Sum0 = 0.0f, Sum1 = 0.0f, Sum2 = 0.0f, Sum3 = 0.0f;
+    int32 i = 0;
+    for (; i + 4 <= Num; i += 4)
+    {
+        Sum0 += A[i] * B[i];
+        Sum1 += A[i + 1] * B[i + 1];
+        Sum2 += A[i + 2] * B[i + 2];
+        Sum3 += A[i + 3] * B[i + 3];
+    }
+    for (; i < Num; i++)
+    {
+        Sum0 += A[i] * B[i];
+    }
+    return (Sum0 + Sum1) + (Sum2 + Sum3);
+}
+
+static void Dot4XQMLScalar(const float* const* A, const float* B, int32 Num, float* Out)
+{
+    for (int32 r = 0; r < 4; r++)
+    {
+        Out[r] = DotXQMLScalar(A[r], B, Num);
+    }
+}
+
+static void AxpyXQMLScalar(float* Y, float Alpha, const float* X, int32 Num)
+{
+    for (int32 i = 0; i < Num; i++)
+    {
+        Y[i] += Alpha * X[i];
+    }
+}
+
+static int32 DotInt8XQMLScalar(const int8* A, const int8* B, int32 Num)
+{
+    int32 Sum = 0;
+    for (int32 i = 0; i < Num; i++)
+    {
+        Sum += static_cast<int32>(A[i]) * static_cast<int32>(B[i]);
+    }
+    return Sum;
+}
+
+static void AddInt8XQMLScalar(int32* Y, const int8* X, int32 Num)
+{
+    for (int32 i = 0; i < Num; i++)
+    {
+        Y[i] += X[i];
+    }
+}
+
+// 任意大小的块，用于分块剩下的边角
+static void AccumulateXQMLBlock(int32 Rows, int32 Cols, int32 K, const float* A, int64 RowStride, int64 KStride, const float* B, int64 LdB, float* C, int64 LdC)
+{
+    for (int32 r = 0; r < Rows; r++)
+    {
+        float* CRow = C + r * LdC;
+        for (int32 k = 0; k < K; k++)
+        {
+            const float Value = A[r * RowStride + k * KStride];
+            if (Value != 0.0f)
+            {
+                const float* BRow = B + k * LdB;
+                for (int32 j = 0; j < Cols; j++)
+                {
+                    CRow[j] += Value * BRow[j];
+                }
+            }
+        }
+    }
+}
+
+#if XQ_ML_X86
+
+static float HorizontalSumXQMLSse(__m128 Value)
+{
+    __m128 Shuffled = _mm_movehl_ps(Value, Value);
+    __m128 Sum = _mm_add_ps(Value, Shuffled);
+    Shuffled = _mm_shuffle_ps(Sum, Sum, 1);
+    return _mm_cvtss_f32(_mm_add_ss(Sum, Shuffled));
+}
+
+// SSE2是x86-64的基本指令集，不需要检测
+static float DotXQMLSse(const float* A, const float* B, int32 Num)
+{
+    __m128 Sum0 = _mm_setzero_ps();
+    __m128 Sum1 = _mm_setzero_ps();
+    int32 i = 0;
+    for (; i + 8 <= Num; i += 8)
+    {
+        Sum0 = _mm_add_ps(Sum0, _mm_mul_ps(_mm_loadu_ps(A + i), _mm_loadu_ps(B + i)));
+        Sum1 = _mm_add_ps(Sum1, _mm_mul_ps(_mm_loadu_ps(A + i + 4), _mm_loadu_ps(B + i + 4)));
+    }
+    float Sum = HorizontalSumXQMLSse(_mm_add_ps(Sum0, Sum1));
+    for (; i < Num; i++)
+    {
+        Sum += A[i] * B[i];
+    }
+    return Sum;
+}
+
+static void Dot4XQMLSse(const float* const* A, const float* B, int32 Num, float* Out)
+{
+    __m128 Sums[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+    int32 i = 0;
+    for (; i + 4 <= Num; i += 4)
+    {
+        const __m128 Row = _mm_loadu_ps(B + i);
+        for (int32 r = 0; r < 4; r++)
+        {
+            Sums[r] = _mm_add_ps(Sums[r], _mm_mul_ps(_mm_loadu_ps(A[r] + i), Row));
+        }
+    }
+    for (int32 r = 0; r < 4; r++)
+    {
+        float Sum = HorizontalSumXQMLSse(Sums[r]);
+        for (int32 k = i; k < Num; k++)
+        {
+            Sum += A[r][k] * B[k];
+        }
+        Out[r] = Sum;
+    }
+}
+
+static void AxpyXQMLSse(float* Y, float Alpha, const float* X, int32 Num)
+{
+    const __m128 Scale = _mm_set1_ps(Alpha);
+    int32 i = 0;
+    for (; i + 4 <= Num; i += 4)
+    {
+        _mm_storeu_ps(Y + i, _mm_add_ps(_mm_loadu_ps(Y + i), _mm_mul_ps(Scale, _mm_loadu_ps(X + i))));
+    }
+    for (; i < Num; i++)
+    {
+        Y[i] += Alpha * X[i];
+    }
+}
+
+static void TileXQMLSse(int32 K, const float* A, int64 RowStride, int64 KStride, const float* B, int64 LdB, float* C, int64 LdC)
+{
+    __m128 Sums[4][2];
+    for (int32 r = 0; r < 4; r++)
+    {
+        Sums[r][0] = _mm_loadu_ps(C + r * LdC);
+        Sums[r][1] = _mm_loadu_ps(C + r * LdC + 4);
+    }
+    for (int32 k = 0; k < K; k++)
+    {
+        const __m128 B0 = _mm_loadu_ps(B + k * LdB);
+        const __m128 B1 = _mm_loadu_ps(B + k * LdB + 4);
+        for (int32 r = 0; r < 4; r++)
+        {
+            const __m128 Value = _mm_set1_ps(A[r * RowStride + k * KStride]);
+            Sums[r][0] = _mm_add_ps(Sums[r][0], _mm_mul_ps(Value, B0));
+            Sums[r][1] = _mm_add_ps(Sums[r][1], _mm_mul_ps(Value, B1));
+        }
+    }
+    for (int32 r = 0; r < 4; r++)
+    {
+        _mm_storeu_ps(C + r * LdC, Sums[r][0]);
+        _mm_storeu_ps(C + r * LdC + 4, Sums[r][1]);
+    }
+}
+
+static int32 HorizontalSumXQMLSseInt(__m128i Value)
+{
+    Value = _mm_add_epi32(Value, _mm_shuffle_epi32(Value, _MM_SHUFFLE(1, 0, 3, 2)));
+    Value = _mm_add_epi32(Value, _mm_shuffle_epi32(Value, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(Value);
+}
+
+static int32 DotInt8XQMLSse(const int8* A, const int8* B, int32 Num)
+{
+    // SSE2没有8位乘法：与自身交错后算术右移8位，得到符号扩展的16位数
+    __m128i Sum = _mm_setzero_si128();
+    int32 i = 0;
+    for (; i + 16 <= Num; i += 16)
+    {
+        const __m128i ValueA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(A + i));
+        const __m128i ValueB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(B + i));
+        const __m128i LowA = _mm_srai_epi16(_mm_unpacklo_epi8(ValueA, ValueA), 8);
+        const __m128i HighA = _mm_srai_epi16(_mm_unpackhi_epi8(ValueA, ValueA), 8);
+        const __m128i LowB = _mm_srai_epi16(_mm_unpacklo_epi8(ValueB, ValueB), 8);
+        const __m128i HighB = _mm_srai_epi16(_mm_unpackhi_epi8(ValueB, ValueB), 8);
+        Sum = _mm_add_epi32(Sum, _mm_add_epi32(_mm_madd_epi16(LowA, LowB), _mm_madd_epi16(HighA, HighB)));
+    }
+    return HorizontalSumXQMLSseInt(Sum) + DotInt8XQMLScalar(A + i, B + i, Num - i);
+}
+
+static void AddInt8XQMLSse(int32* Y, const int8* X, int32 Num)
+{
+    int32 i = 0;
+    for (; i + 16 <= Num; i += 16)
+    {
+        const __m128i Value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(X + i));
+        const __m128i Low = _mm_srai_epi16(_mm_unpacklo_epi8(Value, Value), 8);
+        const __m128i High = _mm_srai_epi16(_mm_unpackhi_epi8(Value, Value), 8);
+        const __m128i Parts[4] = { _mm_srai_epi32(_mm_unpacklo_epi16(Low, Low), 16), _mm_srai_epi32(_mm_unpackhi_epi16(Low, Low), 16),
+            _mm_srai_epi32(_mm_unpacklo_epi16(High, High), 16), _mm_srai_epi32(_mm_unpackhi_epi16(High, High), 16) };
+        for (int32 p = 0; p < 4; p++)
+        {
+            __m128i* Target = reinterpret_cast<__m128i*>(Y + i + p * 4);
+            _mm_storeu_si128(Target, _mm_add_epi32(_mm_loadu_si128(Target), Parts[p]));
+        }
+    }
+    AddInt8XQMLScalar(Y + i, X + i, Num - i);
+}
+
+XQ_ML_TARGET_AVX2 static float HorizontalSumXQMLAvx2(__m256 Value)
+{
+    return HorizontalSumXQMLSse(_mm_add_ps(_mm256_castps256_ps128(Value), _mm256_extractf128_ps(Value, 1)));
+}
+
+XQ_ML_TARGET_AVX2 static float DotXQMLAvx2(const float* A, const float* B, int32 Num)
+{
+    __m256 Sum0 = _mm256_setzero_ps();
+    __m256 Sum1 = _mm256_setzero_ps();
+    int32 i = 0;
+    for (; i + 16 <= Num; i += 16)
+    {
+        Sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i), Sum0);
+        Sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(A + i + 8), _mm256_loadu_ps(B + i + 8), Sum1);
+    }
+    for (; i + 8 <= Num; i += 8)
+    {
+        Sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i), Sum0);
+    }
+    float Sum = HorizontalSumXQMLAvx2(_mm256_add_ps(Sum0, Sum1));
+    for (; i < Num; i++)
+    {
+        Sum += A[i] * B[i];
+    }
+    return Sum;
+}
+
+XQ_ML_TARGET_AVX2 static void Dot4XQMLAvx2(const float* const* A, const float* B, int32 Num, float* Out)
+{
+    __m256 Sum0 = _mm256_setzero_ps();
+    __m256 Sum1 = _mm256_setzero_ps();
+    __m256 Sum2 = _mm256_setzero_ps();
+    __m256 Sum3 = _mm256_setzero_ps();
+    int32 i = 0;
+    for (; i + 8 <= Num; i += 8)
+    {
+        const __m256 Row = _mm256_loadu_ps(B + i);
+        Sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(A[0] + i), Row, Sum0);
+        Sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(A[1] + i), Row, Sum1);
+        Sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(A[2] + i), Row, Sum2);
+        Sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(A[3] + i), Row, Sum3);
+    }
+    Out[0] = HorizontalSumXQMLAvx2(Sum0);
+    Out[1] = HorizontalSumXQMLAvx2(Sum1);
+    Out[2] = HorizontalSumXQMLAvx2(Sum2);
+    Out[3] = HorizontalSumXQMLAvx2(Sum3);
+    for (; i < Num; i++)
+    {
+        for (int32 r = 0; r < 4; r++)
+        {
+            Out[r] += A[r][i] * B[i];
+        }
+    }
+}
+
+XQ_ML_TARGET_AVX2 static void AxpyXQMLAvx2(float* Y, float Alpha, const float* X, int32 Num)
+{
+    const __m256 Scale = _mm256_set1_ps(Alpha);
+    int32 i = 0;
+    for (; i + 8 <= Num; i += 8)
+    {
+        _mm256_storeu_ps(Y + i, _mm256_fmadd_ps(Scale, _mm256_loadu_ps(X + i), _mm256_loadu_ps(Y + i)));
+    }
+    for (; i < Num; i++)
+    {
+        Y[i] += Alpha * X[i];
+    }
+}
+
+XQ_ML_TARGET_AVX2 static void TileXQMLAvx2(int32 K, const float* A, int64 RowStride, int64 KStride, const float* B, int64 LdB, float* C, int64 LdC)
+{
+    // 4行x16列共8个累加寄存器
+    __m256 Sums[4][2];
+    for (int32 r = 0; r < 4; r++)
+    {
+        Sums[r][0] = _mm256_loadu_ps(C + r * LdC);
+        Sums[r][1] = _mm256_loadu_ps(C + r * LdC + 8);
+    }
+    for (int32 k = 0; k < K; k++)
+    {
+        const __m256 B0 = _mm256_loadu_ps(B + k * LdB);
+        const __m256 B1 = _mm256_loadu_ps(B + k * LdB + 8);
+        for (int32 r = 0; r < 4; r++)
+        {
+            const __m256 Value = _mm256_broadcast_ss(A + r * RowStride + k * KStride);
+            Sums[r][0] = _mm256_fmadd_ps(Value, B0, Sums[r][0]);
+            Sums[r][1] = _mm256_fmadd_ps(Value, B1, Sums[r][1]);
+        }
+    }
+    for (int32 r = 0; r < 4; r++)
+    {
+        _mm256_storeu_ps(C + r * LdC, Sums[r][0]);
+        _mm256_storeu_ps(C + r * LdC + 8, Sums[r][1]);
+    }
+}
+
+XQ_ML_TARGET_AVX2 static int32 DotInt8XQMLAvx2(const int8* A, const int8* B, int32 Num)
+{
+    // 每次16个int8扩展为16位，两两相乘相加得到8个32位部分和
+    __m256i Sum0 = _mm256_setzero_si256();
+    __m256i Sum1 = _mm256_setzero_si256();
+    int32 i = 0;
+    for (; i + 32 <= Num; i += 32)
+    {
+        const __m256i A0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(A + i)));
+        const __m256i B0 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(B + i)));
+        const __m256i A1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(A + i + 16)));
+        const __m256i B1 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(B + i + 16)));
+        Sum0 = _mm256_add_epi32(Sum0, _mm256_madd_epi16(A0, B0));
+        Sum1 = _mm256_add_epi32(Sum1, _mm256_madd_epi16(A1, B1));
+    }
+    const __m256i Sum = _mm256_add_epi32(Sum0, Sum1);
+    const __m128i Half = _mm_add_epi32(_mm256_castsi256_si128(Sum), _mm256_extracti128_si256(Sum, 1));
+    return HorizontalSumXQMLSseInt(Half) + DotInt8XQMLScalar(A + i, B + i, Num - i);
+}
+
+XQ_ML_TARGET_AVX2 static void AddInt8XQMLAvx2(int32* Y, const int8* X, int32 Num)
+{
+    int32 i = 0;
+    for (; i + 8 <= Num; i += 8)
+    {
+        const __m256i Value = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(X + i)));
+        __m256i* Target = reinterpret_cast<__m256i*>(Y + i);
+        _mm256_storeu_si256(Target, _mm256_add_epi32(_mm256_loadu_si256(Target), Value));
+    }
+    AddInt8XQMLScalar(Y + i, X + i, Num - i);
+}
+
+static bool IsXQMLAvx2Supported()
+{
+#if defined(_MSC_VER)
+    int32 Info[4];
+    __cpuid(Info, 0);
+    if (Info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(Info, 1);
+    const bool bOsxSave = (Info[2] & (1 << 27)) != 0;
+    const bool bFma = (Info[2] & (1 << 12)) != 0;
+    const bool bAvx = (Info[2] & (1 << 28)) != 0;
+    if (!bOsxSave || !bFma || !bAvx || (_xgetbv(0) & 6) != 6) // 操作系统需要保存YMM寄存器
+    {
+        return false;
+    }
+    __cpuidex(Info, 7, 0);
+    return (Info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif // XQ_ML_X86
+
+#if XQ_ML_NEON
+
+// NEON是AArch64的基本指令集，不需要检测
+static float DotXQMLNeon(const float* A, const float* B, int32 Num)
+{
+    float32x4_t Sum0 = vdupq_n_f32(0.0f);
+    float32x4_t Sum1 = vdupq_n_f32(0.0f);
+    int32 i = 0;
+    for (; i + 8 <= Num; i += 8)
+    {
+        Sum0 = vfmaq_f32(Sum0, vld1q_f32(A + i), vld1q_f32(B + i));
+        Sum1 = vfmaq_f32(Sum1, vld1q_f32(A + i + 4), vld1q_f32(B + i + 4));
+    }
+    float Sum = vaddvq_f32(vaddq_f32(Sum0, Sum1));
+    for (; i < Num; i++)
+    {
+        Sum += A[i] * B[i];
+    }
+    return Sum;
+}
+
+static void Dot4XQMLNeon(const float* const* A, const float* B, int32 Num, float* Out)
+{
+    float32x4_t Sums[4] = { vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f), vdupq_n_f32(0.0f) };
+    int32 i = 0;
+    for (; i + 4 <= Num; i += 4)
+    {
+        const float32x4_t Row = vld1q_f32(B + i);
+        for (int32 r = 0; r < 4; r++)
+        {
+            Sums[r] = vfmaq_f32(Sums[r], vld1q_f32(A[r] + i), Row);
+        }
+    }
+    for (int32 r = 0; r < 4; r++)
+    {
+        float Sum = vaddvq_f32(Sums[r]);
+        for (int32 k = i; k < Num; k++)
+        {
+            Sum += A[r][k] * B[k];
+        }
+        Out[r] = Sum;
+    }
+}
+
+static void AxpyXQMLNeon(float* Y, float Alpha, const float* X, int32 Num)
+{
+    const float32x4_t Scale = vdupq_n_f32(Alpha);
+    int32 i = 0;
+    for (; i + 4 <= Num; i += 4)
+    {
+        vst1q_f32(Y + i, vfmaq_f32(vld1q_f32(Y + i), Scale, vld1q_f32(X + i)));
+    }
+    for (; i < Num; i++)
+    {
+        Y[i] += Alpha * X[i];
+    }
+}
+
+static void TileXQMLNeon(int32 K, const float* A, int64 RowStride, int64 KStride, const float* B, int64 LdB, float* C, int64 LdC)
+{
+    float32x4_t Sums[4][2];
+    for (int32 r = 0; r < 4; r++)
+    {
+        Sums[r][0] = vld1q_f32(C + r * LdC);
+        Sums[r][1] = vld1q_f32(C + r * LdC + 4);
+    }
+    for (int32 k = 0; k < K; k++)
+    {
+        const float32x4_t B0 = vld1q_f32(B + k * LdB);
+        const float32x4_t B1 = vld1q_f32(B + k * LdB + 4);
+        for (int32 r = 0; r < 4; r++)
+        {
+            const float Value = A[r * RowStride + k * KStride];
+            Sums[r][0] = vfmaq_n_f32(Sums[r][0], B0, Value);
+            Sums[r][1] = vfmaq_n_f32(Sums[r][1], B1, Value);
+        }
+    }
+    for (int32 r = 0; r < 4; r++)
+    {
+        vst1q_f32(C + r * LdC, Sums[r][0]);
+        vst1q_f32(C + r * LdC + 4, Sums[r][1]);
+    }
+}
+
+static int32 DotInt8XQMLNeon(const int8* A, const int8* B, int32 Num)
+{
+    int32x4_t Sum = vdupq_n_s32(0);
+    int32 i = 0;
+    for (; i + 16 <= Num; i += 16)
+    {
+        const int8x16_t ValueA = vld1q_s8(A + i);
+        const int8x16_t ValueB = vld1q_s8(B + i);
+        Sum = vpadalq_s16(Sum, vmull_s8(vget_low_s8(ValueA), vget_low_s8(ValueB)));
+        Sum = vpadalq_s16(Sum, vmull_high_s8(ValueA, ValueB));
+    }
+    return vaddvq_s32(Sum) + DotInt8XQMLScalar(A + i, B + i, Num - i);
+}
+
+static void AddInt8XQMLNeon(int32* Y, const int8* X, int32 Num)
+{
+    int32 i = 0;
+    for (; i + 8 <= Num; i += 8)
+    {
+        const int16x8_t Value = vmovl_s8(vld1_s8(X + i));
+        vst1q_s32(Y + i, vaddw_s16(vld1q_s32(Y + i), vget_low_s16(Value)));
+        vst1q_s32(Y + i + 4, vaddw_high_s16(vld1q_s32(Y + i + 4), Value));
+    }
+    AddInt8XQMLScalar(Y + i, X + i, Num - i);
+}
+
+#endif // XQ_ML_NEON
+
+static const FXQMLKernelTable XQMLScalarKernels = { "scalar", DotXQMLScalar, Dot4XQMLScalar, AxpyXQMLScalar, nullptr, 0, DotInt8XQMLScalar, AddInt8XQMLScalar };
+
+static const FXQMLKernelTable* SelectXQMLKernels()
+{
+#if XQ_ML_X86
+    static const FXQMLKernelTable Avx2Kernels = { "avx2", DotXQMLAvx2, Dot4XQMLAvx2, AxpyXQMLAvx2, TileXQMLAvx2, 16, DotInt8XQMLAvx2, AddInt8XQMLAvx2 };
+    static const FXQMLKernelTable SseKernels = { "sse", DotXQMLSse, Dot4XQMLSse, AxpyXQMLSse, TileXQMLSse, 8, DotInt8XQMLSse, AddInt8XQMLSse };
+    return IsXQMLAvx2Supported() ? &Avx2Kernels : &SseKernels;
+#elif XQ_ML_NEON
+    static const FXQMLKernelTable NeonKernels = { "neon", DotXQMLNeon, Dot4XQMLNeon, AxpyXQMLNeon, TileXQMLNeon, 8, DotInt8XQMLNeon, AddInt8XQMLNeon };
+    return &NeonKernels;
+#else
+    return &XQMLScalarKernels;
+#endif
+}
+
+// 第一次使用时检测，之后只读
+static const FXQMLKernelTable* GetXQMLKernels()
+{
+    static const FXQMLKernelTable* const Kernels = SelectXQMLKernels();
+    return Kernels;
+}
+
+static std::atomic<bool> bXQMLForceScalar(false);
+
+const char* XQMLGetKernelName()
+{
+    return bXQMLForceScalar ? XQMLScalarKernels.Name : GetXQMLKernels()->Name;
+}
+
+void XQMLForceScalarKernels(bool bForce)
+{
+    bXQMLForceScalar = bForce;
+}
+
+static const FXQMLKernelTable& GetActiveXQMLKernels()
+{
+    return bXQMLForceScalar.load(std::memory_order_relaxed) ? XQMLScalarKernels : *GetXQMLKernels();
+}
+
+float XQMLDot(const float* A, const float* B, int32 Num)
+{
+    return GetActiveXQMLKernels().Dot(A, B, Num);
+}
+
+void XQMLAxpy(float* Y, float Alpha, const float* X, int32 Num)
+{
+    GetActiveXQMLKernels().Axpy(Y, Alpha, X, Num);
+}
+
+int32 XQMLDotInt8(const int8* A, const int8* B, int32 Num)
+{
+    return GetActiveXQMLKernels().DotInt8(A, B, Num);
+}
+
+void XQMLAddInt8(int32* Y, const int8* X, int32 Num)
+{
+    GetActiveXQMLKernels().AddInt8(Y, X, Num);
+}
+
+void XQMLGemv(int32 N, int32 K, const float* A, const float* B, float* C)
+{
+    const FXQMLKernelTable& Kernels = GetActiveXQMLKernels();
+    for (int32 j = 0; j < N; j++)
+    {
+        C[j] = Kernels.Dot(A, B + static_cast<int64>(j) * K, K);
+    }
+}
+
+void XQMLGemmABt(int32 M, int32 N, int32 K, const float* A, const float* B, float* C)
+{
+    if (M == 1)
+    {
+        XQMLGemv(N, K, A, B, C);
+        return;
+    }
+
+    // 把B按行分块，每块约128KB留在二级缓存中；A每四行一组，B的每一行读一次算四个点积
+    const FXQMLKernelTable& Kernels = GetActiveXQMLKernels();
+    const int32 BlockRows = K > 0 ? std::max(4, 32768 / K) : N;
+    for (int32 BlockStart = 0; BlockStart < N; BlockStart += BlockRows)
+    {
+        const int32 BlockEnd = std::min(N, BlockStart + BlockRows);
+        int32 i = 0;
+        for (; i + 4 <= M; i += 4)
+        {
+            const float* Rows[4] = { A + static_cast<int64>(i) * K, A + static_cast<int64>(i + 1) * K, A + static_cast<int64>(i + 2) * K, A + static_cast<int64>(i + 3) * K };
+            for (int32 j = BlockStart; j < BlockEnd; j++)
+            {
+                float Out[4];
+                Kernels.Dot4(Rows, B + static_cast<int64>(j) * K, K, Out);
+                for (int32 r = 0; r < 4; r++)
+                {
+                    C[static_cast<int64>(i + r) * N + j] = Out[r];
+                }
+            }
+        }
+        for (; i < M; i++)
+        {
+            const float* ARow = A + static_cast<int64>(i) * K;
+            float* CRow = C + static_cast<int64>(i) * N;
+            for (int32 j = BlockStart; j < BlockEnd; j++)
+            {
+                CRow[j] = Kernels.Dot(ARow, B + static_cast<int64>(j) * K, K);
+            }
+        }
+    }
+}
+
+// C[M x N] += sum_k A(i, k) * B[k][j]，A(i, k) = A[i * RowStride + k * KStride]。
+// K每256分一段：A的4行一段留在一级缓存中，B的一段留在二级缓存中，C的4行x TileWidth列在寄存器中累加
+static void AccumulateXQMLOuter(int32 M, int32 N, int32 K, const float* A, int64 RowStride, int64 KStride, const float* B, float* C)
+{
+    const FXQMLKernelTable& Kernels = GetActiveXQMLKernels();
+    if (Kernels.Tile == nullptr)
+    {
+        AccumulateXQMLBlock(M, N, K, A, RowStride, KStride, B, N, C, N);
+        return;
+    }
+
+    const int32 Width = Kernels.TileWidth;
+    const int32 FullCols = N - N % Width;
+    const int32 FullRows = M - M % 4;
+    const int32 KBlock = 256;
+    for (int32 KStart = 0; KStart < K; KStart += KBlock)
+    {
+        const int32 KCount = std::min(KBlock, K - KStart);
+        const float* ABlock = A + KStart * KStride;
+        const float* BBlock = B + static_cast<int64>(KStart) * N;
+        for (int32 i = 0; i < FullRows; i += 4)
+        {
+            for (int32 j = 0; j < FullCols; j += Width)
+            {
+                Kernels.Tile(KCount, ABlock + i * RowStride, RowStride, KStride, BBlock + j, N, C + static_cast<int64>(i) * N + j, N);
+            }
+        }
+        if (FullRows < M)
+        {
+            AccumulateXQMLBlock(M - FullRows, FullCols, KCount, ABlock + FullRows * RowStride, RowStride, KStride, BBlock, N, C + static_cast<int64>(FullRows) * N, N);
+        }
+        if (FullCols < N)
+        {
+            AccumulateXQMLBlock(M, N - FullCols, KCount, ABlock, RowStride, KStride, BBlock + FullCols, N, C + FullCols, N);
+        }
+    }
+}
+
+void XQMLGemmAtB(int32 M, int32 N, int32 K, const float* A, const float* B, float* C)
+{
+    AccumulateXQMLOuter(M, N, K, A, 1, M, B, C);
+}
+
+void XQMLGemmAB(int32 M, int32 N, int32 K, const float* A, const float* B, float* C)
+{
+    std::memset(C, 0, sizeof(float) * static_cast<size_t>(M) * N);
+    AccumulateXQMLOuter(M, N, K, A, K, 1, B, C);
+}
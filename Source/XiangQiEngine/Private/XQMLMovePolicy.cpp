@@ -0,0 +1,66 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMLMovePolicy.h"
+
+#include "XQMLDataset.h"
+#include "XQMLPolicy.h"
+
+#include <algorithm>
+
+FXQMLMovePolicy::FXQMLMovePolicy(const FXQMLQuantizedNetwork* InNetwork)
+    : Network(InNetwork)
+{
+}
+
+void FXQMLMovePolicy::Evaluate(const FXQPolicyQuery* Queries, int32 Count)
+{
+    const bool bUsable = Network != nullptr && !Network->IsEmpty() && Network->GetOutputSize() == XQ_ML_NUM_MOVES;
+    for (int32 q = 0; q < Count; q++)
+    {
+        const FXQPolicyQuery& Query = Queries[q];
+        const int32 NumMoves = Query.Moves->Num;
+        std::fill(Query.Priors, Query.Priors + NumMoves, 0.0f);
+        if (!bUsable || NumMoves == 0)
+        {
+            continue;
+        }
+
+        // 只保留网络有输出的走法，其余走法先验为0
+        Labels.clear();
+        for (int32 i = 0; i < NumMoves; i++)
+        {
+            const int32 Label = XQMLMoveLabel(Query.Moves->Moves[i]);
+            if (Label >= 0)
+            {
+                Labels.push_back(Label);
+            }
+        }
+        if (Labels.empty())
+        {
+            continue;
+        }
+
+        uint16 Features[XQ_ML_MAX_ACTIVE_FEATURES];
+        const int32 NumFeatures = XQMLEncodeActiveFeatures(*Query.Position, Features);
+
+        const int32 NumLabels = static_cast<int32>(Labels.size());
+        Logits.resize(NumLabels);
+        Probabilities.resize(NumLabels);
+        Network->ForwardLogits(Features, NumFeatures, Labels.data(), NumLabels, Logits.data(), Scratch);
+
+        // Logits已按Labels的顺序排列，用恒等下标做Softmax
+        for (int32 i = 0; i < NumLabels; i++)
+        {
+            Labels[i] = i;
+        }
+        XQMLMaskedSoftmax(Logits.data(), Labels.data(), NumLabels, Probabilities.data());
+
+        for (int32 i = 0, j = 0; i < NumMoves; i++)
+        {
+            if (XQMLMoveLabel(Query.Moves->Moves[i]) >= 0)
+            {
+                Query.Priors[i] = Probabilities[j++];
+            }
+        }
+    }
+}
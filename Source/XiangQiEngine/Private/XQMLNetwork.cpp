@@ -0,0 +1,398 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMLNetwork.h"
+#include "XQMLKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static uint64 NextXQMLRandom(uint64& State)
+{
+    // SplitMix64
+    uint64 Value = (State += 0x9E3779B97F4A7C15ull);
+    Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+    return Value ^ (Value >> 31);
+}
+
+void FXQMLNetwork::Initialize(const std::vector<int32>& LayerSizes, uint64 Seed)
+{
+    Layers.clear();
+    uint64 State = Seed;
+    for (size_t i = 1; i < LayerSizes.size(); i++)
+    {
+        FXQMLLayer Layer;
+        Layer.InputSize = LayerSizes[i - 1];
+        Layer.OutputSize = LayerSizes[i];
+        Layer.Weights.resize(static_cast<size_t>(Layer.InputSize) * Layer.OutputSize);
+        Layer.Biases.assign(Layer.OutputSize, 0.0f);
+
+        const float Scale = std::sqrt(6.0f / static_cast<float>(Layer.InputSize + Layer.OutputSize));
+        for (float& Weight : Layer.Weights)
+        {
+            const float Unit = static_cast<float>(NextXQMLRandom(State) >> 40) / static_cast<float>(1 << 24);
+            Weight = (Unit * 2.0f - 1.0f) * Scale;
+        }
+        Layers.push_back(std::move(Layer));
+    }
+}
+
+bool FXQMLNetwork::SetLayers(std::vector<FXQMLLayer>&& InLayers)
+{
+    for (size_t i = 0; i < InLayers.size(); i++)
+    {
+        const FXQMLLayer& Layer = InLayers[i];
+        if (Layer.InputSize <= 0 || Layer.OutputSize <= 0 || Layer.Weights.size() != static_cast<size_t>(Layer.InputSize) * Layer.OutputSize ||
+            Layer.Biases.size() != static_cast<size_t>(Layer.OutputSize) || (i > 0 && InLayers[i - 1].OutputSize != Layer.InputSize))
+        {
+            return false;
+        }
+    }
+    Layers = std::move(InLayers);
+    return true;
+}
+
+int32 FXQMLNetwork::GetMaxLayerSize() const
+{
+    int32 Result = 0;
+    for (const FXQMLLayer& Layer : Layers)
+    {
+        Result = std::max(Result, std::max(Layer.InputSize, Layer.OutputSize));
+    }
+    return Result;
+}
+
+void FXQMLNetwork::ForwardLayer(const FXQMLLayer& Layer, const float* Input, int32 Count, float* Output, bool bReLU)
+{
+    XQMLGemmABt(Count, Layer.OutputSize, Layer.InputSize, Input, Layer.Weights.data(), Output);
+    for (int32 i = 0; i < Count; i++)
+    {
+        float* Row = Output + static_cast<int64>(i) * Layer.OutputSize;
+        for (int32 j = 0; j < Layer.OutputSize; j++)
+        {
+            const float Value = Row[j] + Layer.Biases[j];
+            Row[j] = bReLU && Value < 0.0f ? 0.0f : Value;
+        }
+    }
+}
+
+void FXQMLNetwork::ForwardSparseLayer(const FXQMLLayer& Layer, const FXQMLSparseInput& Input, int32 Count, float* Output, bool bReLU)
+{
+    for (int32 i = 0; i < Count; i++)
+    {
+        float* Row = Output + static_cast<int64>(i) * Layer.OutputSize;
+        std::memcpy(Row, Layer.Biases.data(), sizeof(float) * Layer.OutputSize);
+        for (int32 k = Input.Offsets[i]; k < Input.Offsets[i + 1]; k++)
+        {
+            XQMLAxpy(Row, 1.0f, Layer.Weights.data() + static_cast<int64>(Input.Indices[k]) * Layer.OutputSize, Layer.OutputSize);
+        }
+        if (bReLU)
+        {
+            for (int32 j = 0; j < Layer.OutputSize; j++)
+            {
+                Row[j] = Row[j] < 0.0f ? 0.0f : Row[j];
+            }
+        }
+    }
+}
+
+void FXQMLNetwork::Softmax(float* Data, int32 Count, int32 Size)
+{
+    for (int32 i = 0; i < Count; i++)
+    {
+        float* Row = Data + static_cast<int64>(i) * Size;
+        const float MaxValue = *std::max_element(Row, Row + Size);
+        float Sum = 0.0f;
+        for (int32 j = 0; j < Size; j++)
+        {
+            Row[j] = std::exp(Row[j] - MaxValue); // 数值稳定性
+            Sum += Row[j];
+        }
+        const float InvSum = 1.0f / Sum;
+        for (int32 j = 0; j < Size; j++)
+        {
+            Row[j] *= InvSum;
+        }
+    }
+}
+
+void FXQMLNetwork::Forward(const FXQMLSparseInput& Input, int32 Count, float* Output, std::vector<float>& Scratch) const
+{
+    if (Layers.empty() || Count <= 0)
+    {
+        return;
+    }
+    ForwardLogits(Input, Count, Output, Scratch);
+    Softmax(Output, Count, GetOutputSize());
+}
+
+void FXQMLNetwork::ForwardLogits(const FXQMLSparseInput& Input, int32 Count, float* Output, std::vector<float>& Scratch) const
+{
+    if (Layers.empty() || Count <= 0)
+    {
+        return;
+    }
+
+    // 两块缓冲区交替作为各隐藏层的输入和输出
+    const size_t BufferSize = static_cast<size_t>(Count) * GetMaxLayerSize();
+    if (Scratch.size() < BufferSize * 2)
+    {
+        Scratch.resize(BufferSize * 2);
+    }
+
+    const float* Current = nullptr;
+    for (size_t i = 0; i < Layers.size(); i++)
+    {
+        const bool bLast = i + 1 == Layers.size();
+        float* Next = bLast ? Output : Scratch.data() + (i & 1) * BufferSize;
+        if (i == 0)
+        {
+            ForwardSparseLayer(Layers[i], Input, Count, Next, !bLast);
+        }
+        else
+        {
+            ForwardLayer(Layers[i], Current, Count, Next, !bLast);
+        }
+        Current = Next;
+    }
+}
+
+FXQMLTrainer::FXQMLTrainer(FXQMLNetwork& InNetwork, const FXQMLOptimizerSettings& InSettings, int32 InMaxBatchSize, int32 InNumThreads)
+    : Network(InNetwork)
+    , Settings(InSettings)
+    , MaxBatchSize(std::max(1, InMaxBatchSize))
+{
+    const int32 NumThreads = std::max(1, std::min(InNumThreads, MaxBatchSize / 8));
+    const int32 ShardSize = (MaxBatchSize + NumThreads - 1) / NumThreads;
+    const int32 NumLayers = Network.GetNumLayers();
+
+    Shards.resize(NumThreads);
+    for (FShard& Shard : Shards)
+    {
+        Shard.Activations.resize(NumLayers);
+        Shard.Deltas.resize(NumLayers);
+        Shard.WeightGradients.resize(NumLayers);
+        Shard.BiasGradients.resize(NumLayers);
+        for (int32 i = 0; i < NumLayers; i++)
+        {
+            const FXQMLLayer& Layer = Network.GetLayer(i);
+            Shard.Activations[i].resize(static_cast<size_t>(ShardSize) * Layer.OutputSize);
+            Shard.Deltas[i].resize(static_cast<size_t>(ShardSize) * Layer.OutputSize);
+            Shard.WeightGradients[i].resize(Layer.Weights.size());
+            Shard.BiasGradients[i].resize(Layer.Biases.size());
+        }
+    }
+
+    const int32 NumMoments = Settings.Type == EXQMLOptimizer::Adam ? 2 : 1;
+    for (int32 m = 0; m < 2; m++)
+    {
+        WeightMoments[m].resize(NumLayers);
+        BiasMoments[m].resize(NumLayers);
+    }
+    for (int32 i = 0; i < NumLayers; i++)
+    {
+        const FXQMLLayer& Layer = Network.GetLayer(i);
+        for (int32 m = 0; m < NumMoments; m++)
+        {
+            WeightMoments[m][i].assign(Layer.Weights.size(), 0.0f);
+            BiasMoments[m][i].assign(Layer.Biases.size(), 0.0f);
+        }
+    }
+
+    Pool.reset(new FXQMLWorkerPool(NumThreads));
+}
+
+float FXQMLTrainer::TrainBatch(const FXQMLSparseInput& Input, const int32* Labels, int32 Count, int32* OutCorrect)
+{
+    Count = std::min(Count, MaxBatchSize);
+    if (Network.IsEmpty() || Count <= 0)
+    {
+        return 0.0f;
+    }
+
+    const int32 NumShards = static_cast<int32>(Shards.size());
+    for (int32 t = 0; t < NumShards; t++)
+    {
+        Shards[t].Begin = static_cast<int32>(static_cast<int64>(Count) * t / NumShards);
+        Shards[t].Count = static_cast<int32>(static_cast<int64>(Count) * (t + 1) / NumShards) - Shards[t].Begin;
+    }
+
+    Pool->Run([this, &Input, Labels, Count](int32 Index) { TrainShard(Shards[Index], Input, Labels, Count); });
+
+    Step++;
+    Pool->Run([this](int32 Index) { ReduceAndApply(Index); });
+
+    double Loss = 0.0;
+    int32 Correct = 0;
+    for (const FShard& Shard : Shards)
+    {
+        Loss += Shard.Loss;
+        Correct += Shard.Correct;
+    }
+
+    if (OutCorrect != nullptr)
+    {
+        *OutCorrect = Correct;
+    }
+    return static_cast<float>(Loss / Count);
+}
+
+void FXQMLTrainer::TrainShard(FShard& Shard, const FXQMLSparseInput& Input, const int32* Labels, int32 TotalCount)
+{
+    const int32 NumLayers = Network.GetNumLayers();
+    const int32 Count = Shard.Count;
+    Shard.Loss = 0.0;
+    Shard.Correct = 0;
+    for (int32 i = 0; i < NumLayers; i++)
+    {
+        std::fill(Shard.WeightGradients[i].begin(), Shard.WeightGradients[i].end(), 0.0f);
+        std::fill(Shard.BiasGradients[i].begin(), Shard.BiasGradients[i].end(), 0.0f);
+    }
+    if (Count <= 0)
+    {
+        return;
+    }
+
+    // 偏移量仍指向整个小批量的Indices，只需要从本段的第一个样本开始
+    FXQMLSparseInput ShardInput;
+    ShardInput.Indices = Input.Indices;
+    ShardInput.Offsets = Input.Offsets + Shard.Begin;
+    Labels += Shard.Begin;
+
+    // 前向传播
+    FXQMLNetwork::ForwardSparseLayer(Network.GetLayer(0), ShardInput, Count, Shard.Activations[0].data(), NumLayers > 1);
+    for (int32 i = 1; i < NumLayers; i++)
+    {
+        FXQMLNetwork::ForwardLayer(Network.GetLayer(i), Shard.Activations[i - 1].data(), Count, Shard.Activations[i].data(), i + 1 < NumLayers);
+    }
+    const int32 OutputSize = Network.GetOutputSize();
+    float* Probabilities = Shard.Activations[NumLayers - 1].data();
+    FXQMLNetwork::Softmax(Probabilities, Count, OutputSize);
+
+    // Softmax与交叉熵一起求导：输出误差 = 概率 - 独热标签，按整个小批量的大小取平均
+    double Loss = 0.0;
+    int32 Correct = 0;
+    const float InvCount = 1.0f / static_cast<float>(TotalCount);
+    float* OutputDelta = Shard.Deltas[NumLayers - 1].data();
+    for (int32 b = 0; b < Count; b++)
+    {
+        const float* Row = Probabilities + static_cast<int64>(b) * OutputSize;
+        float* DeltaRow = OutputDelta + static_cast<int64>(b) * OutputSize;
+        const int32 Label = Labels[b];
+        Loss -= std::log(std::max(Row[Label], 1e-8f));
+        Correct += static_cast<int32>(std::max_element(Row, Row + OutputSize) - Row) == Label ? 1 : 0;
+        for (int32 j = 0; j < OutputSize; j++)
+        {
+            DeltaRow[j] = Row[j] * InvCount;
+        }
+        DeltaRow[Label] -= InvCount;
+    }
+    Shard.Loss = Loss;
+    Shard.Correct = Correct;
+
+    // 反向传播：dW = Delta^T * 输入，dB = 按列求和，上一层误差 = Delta * W 再乘ReLU导数。
+    // 第一层的输入是0/1特征，dW只有激活特征对应的行，每行加上该样本的误差
+    for (int32 i = NumLayers - 1; i >= 0; i--)
+    {
+        const FXQMLLayer& Layer = Network.GetLayer(i);
+        const float* Delta = Shard.Deltas[i].data();
+
+        if (i > 0)
+        {
+            XQMLGemmAtB(Layer.OutputSize, Layer.InputSize, Count, Delta, Shard.Activations[i - 1].data(), Shard.WeightGradients[i].data());
+        }
+        else
+        {
+            float* Gradients = Shard.WeightGradients[0].data();
+            for (int32 b = 0; b < Count; b++)
+            {
+                const float* DeltaRow = Delta + static_cast<int64>(b) * Layer.OutputSize;
+                for (int32 k = ShardInput.Offsets[b]; k < ShardInput.Offsets[b + 1]; k++)
+                {
+                    XQMLAxpy(Gradients + static_cast<int64>(ShardInput.Indices[k]) * Layer.OutputSize, 1.0f, DeltaRow, Layer.OutputSize);
+                }
+            }
+        }
+        for (int32 b = 0; b < Count; b++)
+        {
+            XQMLAxpy(Shard.BiasGradients[i].data(), 1.0f, Delta + static_cast<int64>(b) * Layer.OutputSize, Layer.OutputSize);
+        }
+
+        if (i > 0)
+        {
+            float* PreviousDelta = Shard.Deltas[i - 1].data();
+            XQMLGemmAB(Count, Layer.InputSize, Layer.OutputSize, Delta, Layer.Weights.data(), PreviousDelta);
+            const float* PreviousOutput = Shard.Activations[i - 1].data();
+            const int64 Size = static_cast<int64>(Count) * Layer.InputSize;
+            for (int64 k = 0; k < Size; k++)
+            {
+                PreviousDelta[k] = PreviousOutput[k] > 0.0f ? PreviousDelta[k] : 0.0f;
+            }
+        }
+    }
+}
+
+static void ApplyXQMLUpdate(const FXQMLOptimizerSettings& Settings, int64 Step, float* Params, const float* Gradients,
+    float* Moment1, float* Moment2, size_t Num)
+{
+    if (Settings.Type == EXQMLOptimizer::Adam)
+    {
+        const float Correction1 = 1.0f - std::pow(Settings.Beta1, static_cast<float>(Step));
+        const float Correction2 = 1.0f - std::pow(Settings.Beta2, static_cast<float>(Step));
+        const float StepSize = Settings.LearningRate * std::sqrt(Correction2) / Correction1;
+        for (size_t k = 0; k < Num; k++)
+        {
+            const float Gradient = Gradients[k] + Settings.WeightDecay * Params[k];
+            Moment1[k] = Settings.Beta1 * Moment1[k] + (1.0f - Settings.Beta1) * Gradient;
+            Moment2[k] = Settings.Beta2 * Moment2[k] + (1.0f - Settings.Beta2) * Gradient * Gradient;
+            Params[k] -= StepSize * Moment1[k] / (std::sqrt(Moment2[k]) + Settings.Epsilon);
+        }
+    }
+    else
+    {
+        for (size_t k = 0; k < Num; k++)
+        {
+            const float Gradient = Gradients[k] + Settings.WeightDecay * Params[k];
+            Moment1[k] = Settings.Momentum * Moment1[k] + Gradient;
+            Params[k] -= Settings.LearningRate * Moment1[k];
+        }
+    }
+}
+
+void FXQMLTrainer::ReduceAndApply(int32 Index)
+{
+    const size_t NumShards = Shards.size();
+    for (int32 i = 0; i < Network.GetNumLayers(); i++)
+    {
+        FXQMLLayer& Layer = Network.GetLayer(i);
+        for (int32 Part = 0; Part < 2; Part++)
+        {
+            const bool bWeights = Part == 0;
+            std::vector<float>& Params = bWeights ? Layer.Weights : Layer.Biases;
+            std::vector<std::vector<float>>* Moments = bWeights ? WeightMoments : BiasMoments;
+
+            // 每个线程处理参数数组中连续的一份，互不重叠
+            const size_t Num = Params.size();
+            const size_t Begin = Num * Index / NumShards;
+            const size_t End = Num * (Index + 1) / NumShards;
+            if (Begin == End)
+            {
+                continue;
+            }
+
+            float* Gradients = (bWeights ? Shards[0].WeightGradients[i] : Shards[0].BiasGradients[i]).data();
+            for (size_t t = 1; t < NumShards; t++)
+            {
+                const float* Local = (bWeights ? Shards[t].WeightGradients[i] : Shards[t].BiasGradients[i]).data();
+                for (size_t k = Begin; k < End; k++)
+                {
+                    Gradients[k] += Local[k];
+                }
+            }
+
+            float* Moment2 = Moments[1][i].empty() ? nullptr : Moments[1][i].data() + Begin;
+            ApplyXQMLUpdate(Settings, Step, Params.data() + Begin, Gradients + Begin, Moments[0][i].data() + Begin, Moment2, End - Begin);
+        }
+    }
+}
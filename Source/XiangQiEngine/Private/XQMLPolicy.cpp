@@ -0,0 +1,153 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMLPolicy.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr int32 XQMLAbs(int32 Value)
+{
+    return Value < 0 ? -Value : Value;
+}
+
+static constexpr bool IsXQMLPalaceSquare(int32 Rank, int32 File)
+{
+    return File >= 3 && File <= 5 && (Rank <= 2 || Rank >= 7);
+}
+
+// 象只能走到己方的7个象位
+static constexpr bool IsXQMLElephantSquare(int32 Rank, int32 File)
+{
+    const int32 Relative = Rank >= 5 ? XQ_RANKS - 1 - Rank : Rank;
+    return (Relative == 0 || Relative == 4) ? (File == 2 || File == 6) : (Relative == 2 && File % 4 == 0);
+}
+
+static constexpr bool IsXQMLGeometricMove(int32 From, int32 To)
+{
+    const int32 FromRank = From / XQ_FILES;
+    const int32 FromFile = From % XQ_FILES;
+    const int32 ToRank = To / XQ_FILES;
+    const int32 ToFile = To % XQ_FILES;
+    const int32 RankDelta = XQMLAbs(ToRank - FromRank);
+    const int32 FileDelta = XQMLAbs(ToFile - FromFile);
+    if (From == To)
+    {
+        return false;
+    }
+
+    // 车、炮、帅、兵
+    if (RankDelta == 0 || FileDelta == 0)
+    {
+        return true;
+    }
+
+    // 马
+    if (RankDelta * FileDelta == 2)
+    {
+        return true;
+    }
+
+    // 士，九宫中心与四角之间
+    if (RankDelta == 1 && FileDelta == 1)
+    {
+        const bool bFromCenter = FromFile == 4 && (FromRank == 1 || FromRank == 8);
+        const bool bToCenter = ToFile == 4 && (ToRank == 1 || ToRank == 8);
+        return (bFromCenter || bToCenter) && IsXQMLPalaceSquare(FromRank, FromFile) && IsXQMLPalaceSquare(ToRank, ToFile);
+    }
+
+    // 象，不过河
+    if (RankDelta == 2 && FileDelta == 2)
+    {
+        return IsXQMLElephantSquare(FromRank, FromFile) && IsXQMLElephantSquare(ToRank, ToFile) && (FromRank <= 4) == (ToRank <= 4);
+    }
+    return false;
+}
+
+static constexpr int32 CountXQMLGeometricMoves()
+{
+    int32 Num = 0;
+    for (int32 From = 0; From < XQ_SQUARES; From++)
+    {
+        for (int32 To = 0; To < XQ_SQUARES; To++)
+        {
+            Num += IsXQMLGeometricMove(From, To) ? 1 : 0;
+        }
+    }
+    return Num;
+}
+
+static_assert(CountXQMLGeometricMoves() == XQ_ML_NUM_MOVES, "XQ_ML_NUM_MOVES must match the move table");
+
+struct FXQMLMoveTable
+{
+    int16 Labels[XQ_SQUARES * XQ_SQUARES];
+
+    FXQMove Moves[XQ_ML_NUM_MOVES];
+
+    FXQMLMoveTable()
+    {
+        int32 Num = 0;
+        for (int32 From = 0; From < XQ_SQUARES; From++)
+        {
+            for (int32 To = 0; To < XQ_SQUARES; To++)
+            {
+                int16& Label = Labels[From * XQ_SQUARES + To];
+                Label = -1;
+                if (IsXQMLGeometricMove(From, To))
+                {
+                    Label = static_cast<int16>(Num);
+                    Moves[Num++] = FXQMove(From, To);
+                }
+            }
+        }
+    }
+};
+
+static const FXQMLMoveTable& GetXQMLMoveTable()
+{
+    static const FXQMLMoveTable Table;
+    return Table;
+}
+
+int32 XQMLMoveLabel(FXQMove Move)
+{
+    const int32 From = Move.From();
+    const int32 To = Move.To();
+    if (From >= XQ_SQUARES || To >= XQ_SQUARES)
+    {
+        return -1;
+    }
+    return GetXQMLMoveTable().Labels[From * XQ_SQUARES + To];
+}
+
+FXQMove XQMLLabelMove(int32 Label)
+{
+    return Label >= 0 && Label < XQ_ML_NUM_MOVES ? GetXQMLMoveTable().Moves[Label] : FXQMove();
+}
+
+void XQMLMaskedSoftmax(const float* Logits, const int32* Labels, int32 Num, float* OutProbabilities)
+{
+    if (Num <= 0)
+    {
+        return;
+    }
+
+    float MaxValue = Logits[Labels[0]];
+    for (int32 i = 1; i < Num; i++)
+    {
+        MaxValue = std::max(MaxValue, Logits[Labels[i]]);
+    }
+
+    float Sum = 0.0f;
+    for (int32 i = 0; i < Num; i++)
+    {
+        OutProbabilities[i] = std::exp(Logits[Labels[i]] - MaxValue);
+        Sum += OutProbabilities[i];
+    }
+
+    const float InvSum = 1.0f / Sum;
+    for (int32 i = 0; i < Num; i++)
+    {
+        OutProbabilities[i] *= InvSum;
+    }
+}
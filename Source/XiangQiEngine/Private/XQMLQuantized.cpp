@@ -0,0 +1,308 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMLQuantized.h"
+#include "XQFile.h"
+#include "XQMLKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static uint64 AlignXQMLOffset(uint64 Offset)
+{
+    return (Offset + 63) & ~static_cast<uint64>(63);
+}
+
+// 把Values量化到[-127, 127]，返回还原比例；Num到Stride之间补0
+static float QuantizeXQMLVector(const float* Values, int32 Num, int32 Stride, int8* Out)
+{
+    float MaxValue = 0.0f;
+    for (int32 i = 0; i < Num; i++)
+    {
+        MaxValue = std::max(MaxValue, std::fabs(Values[i]));
+    }
+
+    const float Scale = MaxValue > 0.0f ? MaxValue / 127.0f : 1.0f;
+    const float InvScale = 1.0f / Scale;
+    for (int32 i = 0; i < Num; i++)
+    {
+        Out[i] = static_cast<int8>(std::lrint(Values[i] * InvScale));
+    }
+    std::memset(Out + Num, 0, static_cast<size_t>(Stride - Num));
+    return Scale;
+}
+
+// 按[输入][输出]存放的第一层：每个输出（列）一个比例
+static void QuantizeXQMLColumns(const FXQMLLayer& Layer, int32 Stride, int8* Out, float* OutScales)
+{
+    std::vector<float> InvScales(static_cast<size_t>(Layer.OutputSize));
+    for (int32 j = 0; j < Layer.OutputSize; j++)
+    {
+        float MaxValue = 0.0f;
+        for (int32 k = 0; k < Layer.InputSize; k++)
+        {
+            MaxValue = std::max(MaxValue, std::fabs(Layer.Weights[static_cast<size_t>(k) * Layer.OutputSize + j]));
+        }
+        OutScales[j] = MaxValue > 0.0f ? MaxValue / 127.0f : 1.0f;
+        InvScales[j] = 1.0f / OutScales[j];
+    }
+
+    for (int32 k = 0; k < Layer.InputSize; k++)
+    {
+        const float* Row = Layer.Weights.data() + static_cast<int64>(k) * Layer.OutputSize;
+        int8* OutRow = Out + static_cast<int64>(k) * Stride;
+        for (int32 j = 0; j < Layer.OutputSize; j++)
+        {
+            OutRow[j] = static_cast<int8>(std::lrint(Row[j] * InvScales[j]));
+        }
+        std::memset(OutRow + Layer.OutputSize, 0, static_cast<size_t>(Stride - Layer.OutputSize));
+    }
+}
+
+bool FXQMLQuantizedNetwork::Quantize(const FXQMLNetwork& Network)
+{
+    Clear();
+    if (Network.IsEmpty())
+    {
+        return false;
+    }
+
+    // 先排好布局，再按布局填入数据
+    const int32 NumLayers = Network.GetNumLayers();
+    std::vector<FXQMLQuantizedLayerDesc> Descs(static_cast<size_t>(NumLayers));
+    uint64 Offset = AlignXQMLOffset(sizeof(FXQMLQuantizedFileHeader) + sizeof(FXQMLQuantizedLayerDesc) * NumLayers);
+    for (int32 i = 0; i < NumLayers; i++)
+    {
+        const FXQMLLayer& Layer = Network.GetLayer(i);
+        FXQMLQuantizedLayerDesc& Desc = Descs[i];
+        Desc.InputSize = Layer.InputSize;
+        Desc.OutputSize = Layer.OutputSize;
+        Desc.Flags = i == 0 ? XQ_ML_QUANTIZED_INPUT_MAJOR : 0;
+        Desc.Stride = ((i == 0 ? Layer.OutputSize : Layer.InputSize) + 31) & ~31;
+        Desc.WeightOffset = Offset;
+        Offset = AlignXQMLOffset(Offset + static_cast<uint64>(Desc.Stride) * (i == 0 ? Desc.InputSize : Desc.OutputSize));
+        Desc.ScaleOffset = Offset;
+        Offset = AlignXQMLOffset(Offset + sizeof(float) * Desc.OutputSize);
+        Desc.BiasOffset = Offset;
+        Offset = AlignXQMLOffset(Offset + sizeof(float) * Desc.OutputSize);
+    }
+
+    Storage.assign(static_cast<size_t>(Offset / sizeof(uint64)), 0);
+    uint8* Buffer = reinterpret_cast<uint8*>(Storage.data());
+
+    FXQMLQuantizedFileHeader Header;
+    Header.NumLayers = static_cast<uint32>(NumLayers);
+    Header.FileSize = Offset;
+    std::memcpy(Buffer, &Header, sizeof(Header));
+    std::memcpy(Buffer + sizeof(Header), Descs.data(), sizeof(FXQMLQuantizedLayerDesc) * NumLayers);
+
+    for (int32 i = 0; i < NumLayers; i++)
+    {
+        const FXQMLLayer& Layer = Network.GetLayer(i);
+        const FXQMLQuantizedLayerDesc& Desc = Descs[i];
+        int8* Weights = reinterpret_cast<int8*>(Buffer + Desc.WeightOffset);
+        float* Scales = reinterpret_cast<float*>(Buffer + Desc.ScaleOffset);
+        if (i == 0)
+        {
+            QuantizeXQMLColumns(Layer, Desc.Stride, Weights, Scales);
+        }
+        else
+        {
+            for (int32 j = 0; j < Layer.OutputSize; j++)
+            {
+                const float* Row = Layer.Weights.data() + static_cast<int64>(j) * Layer.InputSize;
+                Scales[j] = QuantizeXQMLVector(Row, Layer.InputSize, Desc.Stride, Weights + static_cast<int64>(j) * Desc.Stride);
+            }
+        }
+        std::memcpy(Buffer + Desc.BiasOffset, Layer.Biases.data(), sizeof(float) * Layer.OutputSize);
+    }
+
+    return Bind(Buffer, static_cast<int64>(Offset));
+}
+
+bool FXQMLQuantizedNetwork::Save(const std::string& Path) const
+{
+    if (Data == nullptr)
+    {
+        return false;
+    }
+
+    std::FILE* File = OpenXQFile(Path, "wb");
+    if (File == nullptr)
+    {
+        return false;
+    }
+    const bool bWritten = std::fwrite(Data, 1, static_cast<size_t>(Size), File) == static_cast<size_t>(Size);
+    const bool bClosed = std::fclose(File) == 0;
+    return bWritten && bClosed;
+}
+
+bool FXQMLQuantizedNetwork::Load(const std::string& Path)
+{
+    Clear();
+
+    std::unique_ptr<FXQMappedFile> NewMapping(new FXQMappedFile());
+    if (!NewMapping->Open(Path) || !Bind(NewMapping->GetData(), NewMapping->GetSize()))
+    {
+        Clear();
+        return false;
+    }
+    Mapping = std::move(NewMapping);
+    return true;
+}
+
+bool FXQMLQuantizedNetwork::Load(std::shared_ptr<const FXQMappedFile> InMapping, int64 Offset, int64 InSize)
+{
+    Clear();
+
+    if (!InMapping || Offset < 0 || InSize < 0 || Offset > InMapping->GetSize() - InSize ||
+        !Bind(InMapping->GetData() + Offset, InSize))
+    {
+        Clear();
+        return false;
+    }
+    Mapping = std::move(InMapping);
+    return true;
+}
+
+void FXQMLQuantizedNetwork::Clear()
+{
+    Layers.clear();
+    Data = nullptr;
+    Size = 0;
+    Storage.clear();
+    Storage.shrink_to_fit();
+    Mapping.reset();
+}
+
+bool FXQMLQuantizedNetwork::Bind(const uint8* InData, int64 InSize)
+{
+    FXQMLQuantizedFileHeader Header;
+    if (InSize < static_cast<int64>(sizeof(Header)))
+    {
+        return false;
+    }
+    std::memcpy(&Header, InData, sizeof(Header));
+    if (Header.Magic != XQ_ML_QUANTIZED_MAGIC || Header.Version != XQ_ML_QUANTIZED_VERSION || Header.FileSize != static_cast<uint64>(InSize) ||
+        Header.NumLayers == 0 || Header.NumLayers > 64 ||
+        sizeof(Header) + sizeof(FXQMLQuantizedLayerDesc) * static_cast<uint64>(Header.NumLayers) > Header.FileSize)
+    {
+        return false;
+    }
+
+    std::vector<FLayer> NewLayers(Header.NumLayers);
+    for (uint32 i = 0; i < Header.NumLayers; i++)
+    {
+        FXQMLQuantizedLayerDesc Desc;
+        std::memcpy(&Desc, InData + sizeof(Header) + sizeof(Desc) * i, sizeof(Desc));
+
+        // 只有第一层按[输入][输出]存放；各段都要落在文件内，相邻层的大小要衔接
+        const bool bInputMajor = (Desc.Flags & XQ_ML_QUANTIZED_INPUT_MAJOR) != 0;
+        const int32 RowLength = bInputMajor ? Desc.OutputSize : Desc.InputSize;
+        const int32 NumRows = bInputMajor ? Desc.InputSize : Desc.OutputSize;
+        const uint64 RowsSize = sizeof(float) * static_cast<uint64>(Desc.OutputSize);
+        if (Desc.InputSize <= 0 || Desc.OutputSize <= 0 || bInputMajor != (i == 0) || Desc.Stride < RowLength || Desc.Stride % 32 != 0 ||
+            Desc.WeightOffset % 64 != 0 || Desc.ScaleOffset % 64 != 0 || Desc.BiasOffset % 64 != 0 ||
+            Desc.WeightOffset + static_cast<uint64>(Desc.Stride) * NumRows > Header.FileSize ||
+            Desc.ScaleOffset + RowsSize > Header.FileSize || Desc.BiasOffset + RowsSize > Header.FileSize ||
+            (i > 0 && NewLayers[i - 1].OutputSize != Desc.InputSize))
+        {
+            return false;
+        }
+
+        FLayer& Layer = NewLayers[i];
+        Layer.InputSize = Desc.InputSize;
+        Layer.OutputSize = Desc.OutputSize;
+        Layer.Stride = Desc.Stride;
+        Layer.bInputMajor = bInputMajor;
+        Layer.Weights = reinterpret_cast<const int8*>(InData + Desc.WeightOffset);
+        Layer.Scales = reinterpret_cast<const float*>(InData + Desc.ScaleOffset);
+        Layer.Biases = reinterpret_cast<const float*>(InData + Desc.BiasOffset);
+    }
+
+    Layers = std::move(NewLayers);
+    Data = InData;
+    Size = InSize;
+    return true;
+}
+
+void FXQMLQuantizedNetwork::ForwardLogits(const uint16* Features, int32 NumFeatures, float* Output, FXQMLQuantizedScratch& Scratch) const
+{
+    ForwardLogits(Features, NumFeatures, nullptr, Layers.empty() ? 0 : Layers.back().OutputSize, Output, Scratch);
+}
+
+void FXQMLQuantizedNetwork::ForwardLogits(const uint16* Features, int32 NumFeatures, const int32* Rows, int32 NumRows, float* Output, FXQMLQuantizedScratch& Scratch) const
+{
+    if (Layers.empty())
+    {
+        return;
+    }
+
+    int32 MaxSize = 0;
+    int32 MaxStride = 0;
+    for (const FLayer& Layer : Layers)
+    {
+        MaxSize = std::max(MaxSize, Layer.OutputSize);
+        MaxStride = std::max(MaxStride, Layer.Stride);
+    }
+    if (Scratch.Values.size() < static_cast<size_t>(MaxSize))
+    {
+        Scratch.Values.resize(MaxSize);
+    }
+    if (Scratch.Quantized.size() < static_cast<size_t>(MaxStride))
+    {
+        Scratch.Quantized.resize(MaxStride);
+    }
+    if (Scratch.Accumulators.size() < static_cast<size_t>(MaxStride))
+    {
+        Scratch.Accumulators.resize(MaxStride);
+    }
+
+    // 第一层：激活特征对应的权重行相加，再乘以每列的比例
+    const FLayer& First = Layers.front();
+    const bool bSingleLayer = Layers.size() == 1;
+    float* Current = bSingleLayer && Rows == nullptr ? Output : Scratch.Values.data();
+    int32* Accumulators = Scratch.Accumulators.data();
+    std::fill(Accumulators, Accumulators + First.OutputSize, 0);
+    for (int32 k = 0; k < NumFeatures; k++)
+    {
+        if (Features[k] < First.InputSize)
+        {
+            XQMLAddInt8(Accumulators, First.Weights + static_cast<int64>(Features[k]) * First.Stride, First.OutputSize);
+        }
+    }
+    for (int32 j = 0; j < First.OutputSize; j++)
+    {
+        const float Value = static_cast<float>(Accumulators[j]) * First.Scales[j] + First.Biases[j];
+        Current[j] = !bSingleLayer && Value < 0.0f ? 0.0f : Value;
+    }
+    if (bSingleLayer && Rows != nullptr)
+    {
+        for (int32 r = 0; r < NumRows; r++)
+        {
+            Output[r] = Current[Rows[r]];
+        }
+        return;
+    }
+
+    for (size_t i = 1; i < Layers.size(); i++)
+    {
+        const FLayer& Layer = Layers[i];
+        const bool bLast = i + 1 == Layers.size();
+        float* Next = bLast ? Output : Scratch.Values.data();
+
+        // 输入先整体量化到Scratch.Quantized，所以隐藏层可以共用一块输出缓冲区。
+        // 量化后的输入与每行权重做整数点积，再乘以两边的比例还原
+        const float InputScale = QuantizeXQMLVector(Current, Layer.InputSize, Layer.Stride, Scratch.Quantized.data());
+        const int32 NumOutputs = bLast ? NumRows : Layer.OutputSize;
+        for (int32 r = 0; r < NumOutputs; r++)
+        {
+            const int32 j = bLast && Rows != nullptr ? Rows[r] : r;
+            const int32 Dot = XQMLDotInt8(Layer.Weights + static_cast<int64>(j) * Layer.Stride, Scratch.Quantized.data(), Layer.Stride);
+            const float Value = static_cast<float>(Dot) * Layer.Scales[j] * InputScale + Layer.Biases[j];
+            Next[r] = !bLast && Value < 0.0f ? 0.0f : Value;
+        }
+        Current = Next;
+    }
+}
@@ -0,0 +1,740 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMLTree.h"
+#include "XQMLWorkerPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// 样本少于此数的节点不值得唤醒线程
+static constexpr int32 XQMLParallelTreeNodeSamples = 4096;
+
+static uint64 NextXQMLTreeRandom(uint64& State)
+{
+    // splitmix64
+    uint64 Z = (State += 0x9E3779B97F4A7C15ull);
+    Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBull;
+    return Z ^ (Z >> 31);
+}
+
+void FXQMLTreeData::Reset(int32 InNumFeatures, int32 InNumClasses)
+{
+    NumFeatures = InNumFeatures;
+    NumClasses = InNumClasses;
+    Offsets.assign(1, 0);
+    Features.clear();
+    Bins.clear();
+    Labels.clear();
+
+    // 默认0/1特征：一个分界0.5
+    EdgeOffsets.resize(NumFeatures + 1);
+    for (int32 f = 0; f <= NumFeatures; f++)
+    {
+        EdgeOffsets[f] = f;
+    }
+    Edges.assign(NumFeatures, 0.5f);
+}
+
+void FXQMLTreeData::SetFeatureBins(int32 Feature, const float* InEdges, int32 NumEdges)
+{
+    NumEdges = std::min(NumEdges, XQ_ML_TREE_MAX_BINS - 1);
+    const int32 Old = EdgeOffsets[Feature + 1] - EdgeOffsets[Feature];
+    Edges.erase(Edges.begin() + EdgeOffsets[Feature], Edges.begin() + EdgeOffsets[Feature + 1]);
+    Edges.insert(Edges.begin() + EdgeOffsets[Feature], InEdges, InEdges + NumEdges);
+    for (int32 f = Feature + 1; f <= NumFeatures; f++)
+    {
+        EdgeOffsets[f] += NumEdges - Old;
+    }
+}
+
+void FXQMLTreeData::AddSample(const uint16* InFeatures, const uint8* InBins, int32 NumEntries, int32 Label)
+{
+    Features.insert(Features.end(), InFeatures, InFeatures + NumEntries);
+    if (InBins != nullptr)
+    {
+        Bins.insert(Bins.end(), InBins, InBins + NumEntries);
+    }
+    else
+    {
+        Bins.insert(Bins.end(), NumEntries, 1);
+    }
+    Offsets.push_back(static_cast<int32>(Features.size()));
+    Labels.push_back(Label);
+}
+
+void FXQMLTreeData::Reserve(int32 NumSamples, int64 NumEntries)
+{
+    Offsets.reserve(NumSamples + 1);
+    Labels.reserve(NumSamples);
+    Features.reserve(NumEntries);
+    Bins.reserve(NumEntries);
+}
+
+int32 FXQMLTreeData::GetBin(int32 Sample, int32 Feature) const
+{
+    const int32 End = Offsets[Sample + 1];
+    for (int32 e = Offsets[Sample]; e < End; e++)
+    {
+        if (Features[e] == Feature)
+        {
+            return Bins[e];
+        }
+    }
+    return 0;
+}
+
+bool FXQMLTreeData::IsBelow(int32 Sample, int32 Feature, float Threshold) const
+{
+    // 值落在Bin号桶，即(分界[Bin-1], 分界[Bin]]，Threshold本身是一个分界
+    const int32 Bin = GetBin(Sample, Feature);
+    return Bin == 0 || GetEdge(Feature, Bin - 1) < Threshold;
+}
+
+void FXQMLTree::Clear()
+{
+    Nodes.clear();
+    LeafEntries.clear();
+}
+
+int32 FXQMLTree::FindLeaf(const float* Features) const
+{
+    int32 Index = 0;
+    while (!Nodes[Index].IsLeaf())
+    {
+        const FXQMLTreeNode& Node = Nodes[Index];
+        Index = Features[Node.Feature] <= Node.Threshold ? Index + 1 : Node.Child;
+    }
+    return Index;
+}
+
+int32 FXQMLTree::FindLeaf(const FXQMLTreeData& Data, int32 Sample) const
+{
+    int32 Index = 0;
+    while (!Nodes[Index].IsLeaf())
+    {
+        const FXQMLTreeNode& Node = Nodes[Index];
+        Index = Data.IsBelow(Sample, Node.Feature, Node.Threshold) ? Index + 1 : Node.Child;
+    }
+    return Index;
+}
+
+void FXQMLTree::FindLeaves(const float* Features, int32 Count, int32* OutLeaves) const
+{
+    for (int32 i = 0; i < Count; i++)
+    {
+        OutLeaves[i] = FindLeaf(Features + static_cast<int64>(i) * NumFeatures);
+    }
+}
+
+void FXQMLTree::AddLeafPrediction(int32 Leaf, float Weight, float* OutDistribution) const
+{
+    const FXQMLTreeNode& Node = Nodes[Leaf];
+    const FXQMLTreeLeafEntry* Entries = LeafEntries.data() + Node.Child;
+    for (int32 i = 0; i < Node.Count; i++)
+    {
+        OutDistribution[Entries[i].Label] += Weight * Entries[i].Probability;
+    }
+}
+
+void FXQMLTree::PredictBatch(const float* Features, int32 Count, float* OutDistributions) const
+{
+    std::fill(OutDistributions, OutDistributions + static_cast<int64>(Count) * NumClasses, 0.0f);
+    if (Nodes.empty())
+    {
+        return;
+    }
+
+    std::vector<int32> Leaves(Count);
+    FindLeaves(Features, Count, Leaves.data());
+    for (int32 i = 0; i < Count; i++)
+    {
+        AddLeafPrediction(Leaves[i], 1.0f, OutDistributions + static_cast<int64>(i) * NumClasses);
+    }
+}
+
+void FXQMLTree::Serialize(std::vector<uint8>& Out) const
+{
+    FXQMLTreeFileHeader Header;
+    Header.NumFeatures = NumFeatures;
+    Header.NumClasses = NumClasses;
+    Header.NumNodes = static_cast<int32>(Nodes.size());
+    Header.NumLeafEntries = static_cast<int32>(LeafEntries.size());
+
+    const size_t NodeBytes = Nodes.size() * sizeof(FXQMLTreeNode);
+    const size_t EntryBytes = LeafEntries.size() * sizeof(FXQMLTreeLeafEntry);
+    const size_t Start = Out.size();
+    Out.resize(Start + sizeof(Header) + NodeBytes + EntryBytes);
+    uint8* Cursor = Out.data() + Start;
+    std::memcpy(Cursor, &Header, sizeof(Header));
+    std::memcpy(Cursor + sizeof(Header), Nodes.data(), NodeBytes);
+    std::memcpy(Cursor + sizeof(Header) + NodeBytes, LeafEntries.data(), EntryBytes);
+}
+
+int64 FXQMLTree::Deserialize(const uint8* Data, int64 Size)
+{
+    Clear();
+    FXQMLTreeFileHeader Header;
+    if (Size < static_cast<int64>(sizeof(Header)))
+    {
+        return 0;
+    }
+    std::memcpy(&Header, Data, sizeof(Header));
+    if (Header.Magic != XQ_ML_TREE_MAGIC || Header.Version != XQ_ML_TREE_VERSION || Header.NumNodes <= 0 || Header.NumLeafEntries < 0
+        || Header.NumFeatures <= 0 || Header.NumClasses <= 0)
+    {
+        return 0;
+    }
+    const int64 NodeBytes = static_cast<int64>(Header.NumNodes) * sizeof(FXQMLTreeNode);
+    const int64 EntryBytes = static_cast<int64>(Header.NumLeafEntries) * sizeof(FXQMLTreeLeafEntry);
+    const int64 Total = static_cast<int64>(sizeof(Header)) + NodeBytes + EntryBytes;
+    if (Size < Total)
+    {
+        return 0;
+    }
+
+    Nodes.resize(Header.NumNodes);
+    LeafEntries.resize(Header.NumLeafEntries);
+    std::memcpy(Nodes.data(), Data + sizeof(Header), NodeBytes);
+    std::memcpy(LeafEntries.data(), Data + sizeof(Header) + NodeBytes, EntryBytes);
+    NumFeatures = Header.NumFeatures;
+    NumClasses = Header.NumClasses;
+
+    // 内部节点的两个孩子都在它之后，下行必然终止；叶子和特征下标不越界
+    for (int32 i = 0; i < Header.NumNodes; i++)
+    {
+        const FXQMLTreeNode& Node = Nodes[i];
+        bool bValid = true;
+        if (Node.IsLeaf())
+        {
+            bValid = Node.Count >= 0 && Node.Child >= 0 && static_cast<int64>(Node.Child) + Node.Count <= Header.NumLeafEntries;
+            for (int32 e = 0; bValid && e < Node.Count; e++)
+            {
+                bValid = LeafEntries[Node.Child + e].Label >= 0 && LeafEntries[Node.Child + e].Label < NumClasses;
+            }
+        }
+        else
+        {
+            bValid = Node.Feature < NumFeatures && i + 1 < Header.NumNodes && Node.Child > i + 1 && Node.Child < Header.NumNodes;
+        }
+        if (!bValid)
+        {
+            Clear();
+            return 0;
+        }
+    }
+    return Total;
+}
+
+FXQMLTreeBuilder::FXQMLTreeBuilder(const FXQMLTreeData& InData, const FXQMLTreeSettings& InSettings, FXQMLWorkerPool* InPool)
+    : Data(InData)
+    , Settings(InSettings)
+    , Pool(InPool)
+{
+    Settings.MinSamplesLeaf = std::max(Settings.MinSamplesLeaf, 1);
+    Settings.MinSamplesSplit = std::max(Settings.MinSamplesSplit, 2 * Settings.MinSamplesLeaf);
+
+    States.resize(Pool != nullptr ? Pool->GetNumThreads() : 1);
+    for (FThreadState& State : States)
+    {
+        // 每个特征的计数区比分界多一格，0号格用作“已记入Touched”的标记
+        State.Counts.assign(Data.GetNumEdges() + Data.GetNumFeatures(), 0);
+        State.RightSquares.resize(Data.GetNumEdges());
+        State.CrossTerms.resize(Data.GetNumEdges());
+        State.RightCounts.resize(Data.GetNumEdges());
+    }
+    Candidates.assign(Data.GetNumFeatures(), 1);
+}
+
+void FXQMLTreeBuilder::Build(const int32* Samples, int32 Num, FXQMLTree& OutTree)
+{
+    OutTree.Clear();
+    OutTree.NumFeatures = Data.GetNumFeatures();
+    OutTree.NumClasses = Data.GetNumClasses();
+    RandomState = Settings.Seed;
+
+    // 整体按标签排序一次，之后的稳定划分保持每段有序
+    Indices.assign(Samples, Samples + Num);
+    std::sort(Indices.begin(), Indices.end(), [this](int32 A, int32 B)
+    {
+        const int32 LabelA = Data.GetLabel(A);
+        const int32 LabelB = Data.GetLabel(B);
+        return LabelA != LabelB ? LabelA < LabelB : A < B;
+    });
+    Scratch.resize(Num);
+
+    BuildNode(0, Num, 0, OutTree);
+}
+
+void FXQMLTreeBuilder::BuildNode(int32 Begin, int32 End, int32 Depth, FXQMLTree& Tree)
+{
+    const int32 Num = End - Begin;
+    if (Num < Settings.MinSamplesSplit || Depth >= Settings.MaxDepth || Data.GetLabel(Indices[Begin]) == Data.GetLabel(Indices[End - 1]))
+    {
+        MakeLeaf(Begin, End, Tree);
+        return;
+    }
+
+    const FSplit Split = FindBestSplit(Begin, End);
+    if (Split.Feature < 0)
+    {
+        MakeLeaf(Begin, End, Tree);
+        return;
+    }
+
+    int32 Middle = Begin;
+    Partition(Begin, End, Split.Feature, Split.Bin, Middle);
+
+    const int32 NodeIndex = static_cast<int32>(Tree.Nodes.size());
+    FXQMLTreeNode Node;
+    Node.Feature = Split.Feature;
+    Node.Threshold = Data.GetEdge(Split.Feature, Split.Bin);
+    Tree.Nodes.push_back(Node);
+
+    BuildNode(Begin, Middle, Depth + 1, Tree);
+    Tree.Nodes[NodeIndex].Child = static_cast<int32>(Tree.Nodes.size());
+    BuildNode(Middle, End, Depth + 1, Tree);
+}
+
+FXQMLTreeBuilder::FSplit FXQMLTreeBuilder::FindBestSplit(int32 Begin, int32 End)
+{
+    SampleCandidates();
+
+    // 父节点的sum(n_c^2)
+    double TotalSquares = 0.0;
+    for (int32 i = Begin; i < End;)
+    {
+        const int32 Label = Data.GetLabel(Indices[i]);
+        int32 j = i + 1;
+        while (j < End && Data.GetLabel(Indices[j]) == Label)
+        {
+            j++;
+        }
+        TotalSquares += static_cast<double>(j - i) * (j - i);
+        i = j;
+    }
+
+    // 按标签边界把样本大致均分给各线程
+    const int32 NumThreads = End - Begin >= XQMLParallelTreeNodeSamples ? static_cast<int32>(States.size()) : 1;
+    int32 ChunkBegin = Begin;
+    for (int32 t = 0; t < NumThreads; t++)
+    {
+        int32 ChunkEnd = t + 1 == NumThreads ? End : std::max(ChunkBegin, Begin + static_cast<int32>(static_cast<int64>(End - Begin) * (t + 1) / NumThreads));
+        while (ChunkEnd > Begin && ChunkEnd < End && Data.GetLabel(Indices[ChunkEnd]) == Data.GetLabel(Indices[ChunkEnd - 1]))
+        {
+            ChunkEnd++;
+        }
+        States[t].Begin = ChunkBegin;
+        States[t].End = ChunkEnd;
+        ChunkBegin = ChunkEnd;
+    }
+
+    const int32 NumFeatures = Data.GetNumFeatures();
+    const int32 PerThread = (NumFeatures + NumThreads - 1) / NumThreads;
+    auto Accumulate = [&](int32 Index)
+    {
+        AccumulateHistograms(States[Index].Begin, States[Index].End, States[Index]);
+    };
+    auto Evaluate = [&](int32 Index)
+    {
+        const int32 First = std::min(Index * PerThread, NumFeatures);
+        const int32 Last = std::min(First + PerThread, NumFeatures);
+        EvaluateFeatures(End - Begin, First, Last, TotalSquares, NumThreads, States[Index].Best);
+    };
+    if (NumThreads > 1)
+    {
+        Pool->Run(Accumulate);
+        Pool->Run(Evaluate);
+    }
+    else
+    {
+        Accumulate(0);
+        Evaluate(0);
+    }
+
+    // 按线程顺序归约，同分取特征下标小的，结果与线程数无关
+    FSplit Best;
+    Best.Score = TotalSquares / (End - Begin) * (1.0 + 1e-9);
+    for (int32 t = 0; t < NumThreads; t++)
+    {
+        if (States[t].Best.Feature >= 0 && States[t].Best.Score > Best.Score)
+        {
+            Best = States[t].Best;
+        }
+    }
+    return Best;
+}
+
+void FXQMLTreeBuilder::AccumulateHistograms(int32 Begin, int32 End, FThreadState& State) const
+{
+    std::fill(State.RightSquares.begin(), State.RightSquares.end(), 0.0);
+    std::fill(State.CrossTerms.begin(), State.CrossTerms.end(), 0.0);
+    std::fill(State.RightCounts.begin(), State.RightCounts.end(), 0);
+
+    // 逐个标签：统计该标签样本在各特征各桶的直方图，累加到每个分界的右侧统计量。
+    // 只有出现过的特征需要处理，0号桶的数量由总数推出
+    for (int32 i = Begin; i < End;)
+    {
+        const int32 Label = Data.GetLabel(Indices[i]);
+        int32 j = i;
+        for (; j < End && Data.GetLabel(Indices[j]) == Label; j++)
+        {
+            const int32 Sample = Indices[j];
+            const int32 NumEntries = Data.GetNumEntries(Sample);
+            const uint16* Features = Data.GetFeatures(Sample);
+            const uint8* Bins = Data.GetBins(Sample);
+            for (int32 e = 0; e < NumEntries; e++)
+            {
+                const int32 Feature = Features[e];
+                if (Candidates[Feature] == 0)
+                {
+                    continue;
+                }
+                int32* Counts = State.Counts.data() + Data.GetEdgeOffset(Feature) + Feature;
+                if (Counts[0] == 0)
+                {
+                    Counts[0] = 1;
+                    State.Touched.push_back(Feature);
+                }
+                Counts[Bins[e]]++;
+            }
+        }
+
+        const double GroupSize = j - i;
+        for (int32 Feature : State.Touched)
+        {
+            int32* Counts = State.Counts.data() + Data.GetEdgeOffset(Feature) + Feature;
+            const int32 EdgeOffset = Data.GetEdgeOffset(Feature);
+            int32 Right = 0;
+            for (int32 b = Data.GetNumBins(Feature) - 1; b >= 1; b--)
+            {
+                Right += Counts[b];
+                Counts[b] = 0;
+                if (Right > 0)
+                {
+                    // 分界b-1：左边为0..b-1号桶
+                    State.RightSquares[EdgeOffset + b - 1] += static_cast<double>(Right) * Right;
+                    State.CrossTerms[EdgeOffset + b - 1] += GroupSize * Right;
+                    State.RightCounts[EdgeOffset + b - 1] += Right;
+                }
+            }
+            Counts[0] = 0;
+        }
+        State.Touched.clear();
+        i = j;
+    }
+}
+
+void FXQMLTreeBuilder::EvaluateFeatures(int32 Num, int32 FirstFeature, int32 LastFeature, double TotalSquares, int32 NumThreads, FSplit& OutBest)
+{
+    OutBest = FSplit();
+    if (FirstFeature >= LastFeature)
+    {
+        return;
+    }
+
+    // 累加量都是整数，相加顺序不影响结果
+    FThreadState& Sum = States[0];
+    const int32 FirstEdge = Data.GetEdgeOffset(FirstFeature);
+    const int32 LastEdge = Data.GetEdgeOffset(LastFeature);
+    for (int32 t = 1; t < NumThreads; t++)
+    {
+        const FThreadState& Other = States[t];
+        for (int32 Edge = FirstEdge; Edge < LastEdge; Edge++)
+        {
+            Sum.RightSquares[Edge] += Other.RightSquares[Edge];
+            Sum.CrossTerms[Edge] += Other.CrossTerms[Edge];
+            Sum.RightCounts[Edge] += Other.RightCounts[Edge];
+        }
+    }
+
+    // 加权基尼不纯度最小等价于 sum(l_c^2)/n_l + sum(r_c^2)/n_r 最大，
+    // 其中 sum(l_c^2) = sum(n_c^2) - 2*sum(n_c*r_c) + sum(r_c^2)
+    for (int32 Feature = FirstFeature; Feature < LastFeature; Feature++)
+    {
+        if (Candidates[Feature] == 0)
+        {
+            continue;
+        }
+        const int32 EdgeOffset = Data.GetEdgeOffset(Feature);
+        const int32 NumEdges = Data.GetNumBins(Feature) - 1;
+        for (int32 b = 0; b < NumEdges; b++)
+        {
+            const int32 RightCount = Sum.RightCounts[EdgeOffset + b];
+            const int32 LeftCount = Num - RightCount;
+            if (RightCount < Settings.MinSamplesLeaf || LeftCount < Settings.MinSamplesLeaf)
+            {
+                continue;
+            }
+            const double RightSquares = Sum.RightSquares[EdgeOffset + b];
+            const double LeftSquares = TotalSquares - 2.0 * Sum.CrossTerms[EdgeOffset + b] + RightSquares;
+            const double Score = LeftSquares / LeftCount + RightSquares / RightCount;
+            if (OutBest.Feature < 0 || Score > OutBest.Score)
+            {
+                OutBest.Score = Score;
+                OutBest.Feature = Feature;
+                OutBest.Bin = b;
+            }
+        }
+    }
+}
+
+void FXQMLTreeBuilder::Partition(int32 Begin, int32 End, int32 Feature, int32 Bin, int32& OutMiddle)
+{
+    // 稳定划分：左边原地前移，右边先放到临时区再拷回，两段都保持按标签有序
+    int32 Left = Begin;
+    int32 Right = 0;
+    for (int32 i = Begin; i < End; i++)
+    {
+        const int32 Sample = Indices[i];
+        if (Data.GetBin(Sample, Feature) <= Bin)
+        {
+            Indices[Left++] = Sample;
+        }
+        else
+        {
+            Scratch[Right++] = Sample;
+        }
+    }
+    std::copy(Scratch.begin(), Scratch.begin() + Right, Indices.begin() + Left);
+    OutMiddle = Left;
+}
+
+void FXQMLTreeBuilder::MakeLeaf(int32 Begin, int32 End, FXQMLTree& Tree)
+{
+    FXQMLTreeNode Node;
+    Node.Child = static_cast<int32>(Tree.LeafEntries.size());
+
+    // 样本按标签有序，逐段计数
+    const size_t First = Tree.LeafEntries.size();
+    for (int32 i = Begin; i < End;)
+    {
+        const int32 Label = Data.GetLabel(Indices[i]);
+        int32 j = i + 1;
+        while (j < End && Data.GetLabel(Indices[j]) == Label)
+        {
+            j++;
+        }
+        FXQMLTreeLeafEntry Entry;
+        Entry.Label = Label;
+        Entry.Probability = static_cast<float>(j - i) / static_cast<float>(End - Begin);
+        Tree.LeafEntries.push_back(Entry);
+        i = j;
+    }
+
+    auto ByProbability = [](const FXQMLTreeLeafEntry& A, const FXQMLTreeLeafEntry& B)
+    {
+        return A.Probability != B.Probability ? A.Probability > B.Probability : A.Label < B.Label;
+    };
+    const size_t Kept = std::min<size_t>(Tree.LeafEntries.size() - First, static_cast<size_t>(std::max(Settings.MaxLeafLabels, 1)));
+    std::partial_sort(Tree.LeafEntries.begin() + First, Tree.LeafEntries.begin() + First + Kept, Tree.LeafEntries.end(), ByProbability);
+    Tree.LeafEntries.resize(First + Kept);
+
+    Node.Count = static_cast<int32>(Kept);
+    Tree.Nodes.push_back(Node);
+}
+
+void FXQMLTreeBuilder::SampleCandidates()
+{
+    if (Settings.FeatureFraction >= 1.0f)
+    {
+        return;
+    }
+
+    const uint64 Limit = static_cast<uint64>(static_cast<double>(Settings.FeatureFraction) * 4294967296.0);
+    bool bAny = false;
+    for (uint8& Candidate : Candidates)
+    {
+        Candidate = (NextXQMLTreeRandom(RandomState) & 0xFFFFFFFFull) < Limit ? 1 : 0;
+        bAny |= Candidate != 0;
+    }
+    if (!bAny)
+    {
+        Candidates[NextXQMLTreeRandom(RandomState) % Candidates.size()] = 1;
+    }
+}
+
+void FXQMLForest::Train(const FXQMLTreeData& Data, const int32* Samples, int32 Num, const FXQMLForestSettings& Settings, FXQMLWorkerPool* Pool)
+{
+    Trees.assign(std::max(Settings.NumTrees, 1), FXQMLTree());
+    if (Trees.size() == 1)
+    {
+        FXQMLTreeBuilder Builder(Data, Settings.Tree, Pool);
+        Builder.Build(Samples, Num, Trees[0]);
+        return;
+    }
+
+    const int32 BagSize = Settings.MaxSamplesPerTree > 0 ? std::min(Num, Settings.MaxSamplesPerTree) : Num;
+    const int32 NumThreads = Pool != nullptr ? Pool->GetNumThreads() : 1;
+    auto BuildTrees = [&](int32 Index)
+    {
+        // 第t棵树固定由t % NumThreads号线程单线程地建，样本和候选特征都只取决于t
+        std::vector<int32> Bag(BagSize);
+        for (int32 t = Index; t < static_cast<int32>(Trees.size()); t += NumThreads)
+        {
+            FXQMLTreeSettings TreeSettings = Settings.Tree;
+            uint64 RandomState = Settings.Tree.Seed + 0xD1B54A32D192ED03ull * (t + 1);
+            TreeSettings.Seed = NextXQMLTreeRandom(RandomState);
+            for (int32& Sample : Bag)
+            {
+                Sample = Samples[NextXQMLTreeRandom(RandomState) % static_cast<uint64>(Num)];
+            }
+            FXQMLTreeBuilder TreeBuilder(Data, TreeSettings);
+            TreeBuilder.Build(Bag.data(), BagSize, Trees[t]);
+        }
+    };
+    if (Pool != nullptr)
+    {
+        Pool->Run(BuildTrees);
+    }
+    else
+    {
+        BuildTrees(0);
+    }
+}
+
+void FXQMLForest::Clear()
+{
+    Trees.clear();
+}
+
+void FXQMLForest::Predict(const float* Features, float* OutDistribution) const
+{
+    std::fill(OutDistribution, OutDistribution + GetNumClasses(), 0.0f);
+    const float Weight = 1.0f / static_cast<float>(std::max(GetNumTrees(), 1));
+    for (const FXQMLTree& Tree : Trees)
+    {
+        Tree.AddLeafPrediction(Tree.FindLeaf(Features), Weight, OutDistribution);
+    }
+}
+
+void FXQMLForest::PredictBatch(const float* Features, int32 Count, float* OutDistributions) const
+{
+    const int32 NumClasses = GetNumClasses();
+    std::fill(OutDistributions, OutDistributions + static_cast<int64>(Count) * NumClasses, 0.0f);
+    if (Trees.empty())
+    {
+        return;
+    }
+
+    const float Weight = 1.0f / static_cast<float>(Trees.size());
+    std::vector<int32> Leaves(Count);
+    for (const FXQMLTree& Tree : Trees)
+    {
+        Tree.FindLeaves(Features, Count, Leaves.data());
+        for (int32 i = 0; i < Count; i++)
+        {
+            Tree.AddLeafPrediction(Leaves[i], Weight, OutDistributions + static_cast<int64>(i) * NumClasses);
+        }
+    }
+}
+
+void FXQMLForest::Predict(const FXQMLTreeData& Data, int32 Sample, float* OutDistribution) const
+{
+    std::fill(OutDistribution, OutDistribution + GetNumClasses(), 0.0f);
+    const float Weight = 1.0f / static_cast<float>(std::max(GetNumTrees(), 1));
+    for (const FXQMLTree& Tree : Trees)
+    {
+        Tree.AddLeafPrediction(Tree.FindLeaf(Data, Sample), Weight, OutDistribution);
+    }
+}
+
+void FXQMLForest::Evaluate(const FXQMLTreeData& Data, const int32* Samples, int32 Num, FXQMLWorkerPool* Pool, float& OutAccuracy, float& OutLoss) const
+{
+    OutAccuracy = 0.0f;
+    OutLoss = 0.0f;
+    if (Trees.empty() || Num <= 0)
+    {
+        return;
+    }
+
+    // 每个线程一段连续的样本，按线程顺序相加
+    const int32 NumThreads = Pool != nullptr ? Pool->GetNumThreads() : 1;
+    std::vector<double> Losses(NumThreads, 0.0);
+    std::vector<int32> Correct(NumThreads, 0);
+    auto EvaluateRange = [&](int32 Index)
+    {
+        const int32 Begin = static_cast<int32>(static_cast<int64>(Num) * Index / NumThreads);
+        const int32 End = static_cast<int32>(static_cast<int64>(Num) * (Index + 1) / NumThreads);
+        std::vector<float> Distribution(GetNumClasses());
+        for (int32 i = Begin; i < End; i++)
+        {
+            Predict(Data, Samples[i], Distribution.data());
+            const int32 Label = Data.GetLabel(Samples[i]);
+            const int32 Best = static_cast<int32>(std::max_element(Distribution.begin(), Distribution.end()) - Distribution.begin());
+            Correct[Index] += Best == Label ? 1 : 0;
+            Losses[Index] -= std::log(std::max(Distribution[Label], 1e-6f));
+        }
+    };
+    if (Pool != nullptr)
+    {
+        Pool->Run(EvaluateRange);
+    }
+    else
+    {
+        EvaluateRange(0);
+    }
+
+    int32 TotalCorrect = 0;
+    double TotalLoss = 0.0;
+    for (int32 t = 0; t < NumThreads; t++)
+    {
+        TotalCorrect += Correct[t];
+        TotalLoss += Losses[t];
+    }
+    OutAccuracy = static_cast<float>(TotalCorrect) / static_cast<float>(Num);
+    OutLoss = static_cast<float>(TotalLoss / Num);
+}
+
+void FXQMLForest::Serialize(std::vector<uint8>& Out) const
+{
+    FXQMLForestFileHeader Header;
+    Header.NumTrees = GetNumTrees();
+    const uint8* Bytes = reinterpret_cast<const uint8*>(&Header);
+    Out.insert(Out.end(), Bytes, Bytes + sizeof(Header));
+    for (const FXQMLTree& Tree : Trees)
+    {
+        Tree.Serialize(Out);
+    }
+}
+
+bool FXQMLForest::Deserialize(const uint8* Data, int64 Size)
+{
+    Clear();
+    FXQMLForestFileHeader Header;
+    if (Size < static_cast<int64>(sizeof(Header)))
+    {
+        return false;
+    }
+    std::memcpy(&Header, Data, sizeof(Header));
+    if (Header.Magic == XQ_ML_TREE_MAGIC)
+    {
+        Trees.resize(1);
+        if (Trees[0].Deserialize(Data, Size) == 0)
+        {
+            Clear();
+            return false;
+        }
+        return true;
+    }
+    if (Header.Magic != XQ_ML_FOREST_MAGIC || Header.Version != XQ_ML_FOREST_VERSION || Header.NumTrees <= 0)
+    {
+        return false;
+    }
+
+    Trees.resize(Header.NumTrees);
+    int64 Offset = sizeof(Header);
+    for (FXQMLTree& Tree : Trees)
+    {
+        const int64 Read = Tree.Deserialize(Data + Offset, Size - Offset);
+        // 所有树的特征数和类别数必须一致
+        if (Read == 0 || Tree.NumFeatures != Trees[0].NumFeatures || Tree.NumClasses != Trees[0].NumClasses)
+        {
+            Clear();
+            return false;
+        }
+        Offset += Read;
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMLWorkerPool.h"
+
+FXQMLWorkerPool::FXQMLWorkerPool(int32 InNumThreads)
+{
+    for (int32 t = 1; t < InNumThreads; t++)
+    {
+        Workers.emplace_back(&FXQMLWorkerPool::WorkerLoop, this, t);
+    }
+}
+
+FXQMLWorkerPool::~FXQMLWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        bExit = true;
+    }
+    WorkCondition.notify_all();
+    for (std::thread& Worker : Workers)
+    {
+        Worker.join();
+    }
+}
+
+void FXQMLWorkerPool::Run(const std::function<void(int32)>& Task)
+{
+    if (Workers.empty())
+    {
+        Task(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        CurrentTask = &Task;
+        Pending = static_cast<int32>(Workers.size());
+        Generation++;
+    }
+    WorkCondition.notify_all();
+
+    Task(0);
+
+    std::unique_lock<std::mutex> Lock(Mutex);
+    DoneCondition.wait(Lock, [this]() { return Pending == 0; });
+    CurrentTask = nullptr;
+}
+
+void FXQMLWorkerPool::WorkerLoop(int32 Index)
+{
+    int64 LastGeneration = 0;
+    for (;;)
+    {
+        const std::function<void(int32)>* Task = nullptr;
+        {
+            std::unique_lock<std::mutex> Lock(Mutex);
+            WorkCondition.wait(Lock, [this, LastGeneration]() { return bExit || Generation != LastGeneration; });
+            if (bExit)
+            {
+                return;
+            }
+            LastGeneration = Generation;
+            Task = CurrentTask;
+        }
+
+        (*Task)(Index);
+
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (--Pending == 0)
+        {
+            DoneCondition.notify_one();
+        }
+    }
+}
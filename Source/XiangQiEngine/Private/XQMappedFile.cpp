@@ -0,0 +1,150 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMappedFile.h"
+#include "XQFile.h"
+
+#if !XQ_STANDALONE
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FXQMappedFile::~FXQMappedFile()
+{
+    Close();
+}
+
+#if !XQ_STANDALONE
+
+bool FXQMappedFile::Open(const std::string& Path)
+{
+    Close();
+
+    IMappedFileHandle* Handle = FPlatformFileManager::Get().GetPlatformFile().OpenMapped(UTF8_TO_TCHAR(Path.c_str()));
+    if (Handle == nullptr)
+    {
+        return false;
+    }
+    IMappedFileRegion* Region = Handle->GetFileSize() > 0 ? Handle->MapRegion(0, Handle->GetFileSize()) : nullptr;
+    if (Region == nullptr)
+    {
+        delete Handle;
+        return false;
+    }
+
+    FileHandle = Handle;
+    MappingHandle = Region;
+    Data = Region->GetMappedPtr();
+    Size = Region->GetMappedSize();
+    return true;
+}
+
+void FXQMappedFile::Close()
+{
+    // 映射区域必须先于文件句柄释放
+    delete static_cast<IMappedFileRegion*>(MappingHandle);
+    delete static_cast<IMappedFileHandle*>(FileHandle);
+    MappingHandle = nullptr;
+    FileHandle = nullptr;
+    Data = nullptr;
+    Size = 0;
+}
+
+#elif defined(_WIN32)
+
+bool FXQMappedFile::Open(const std::string& Path)
+{
+    Close();
+
+    HANDLE File = CreateFileW(MakeXQFilePath(Path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (File == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER FileSize;
+    if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+    {
+        CloseHandle(File);
+        return false;
+    }
+    HANDLE Mapping = CreateFileMappingW(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* View = Mapping != nullptr ? MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (View == nullptr)
+    {
+        if (Mapping != nullptr)
+        {
+            CloseHandle(Mapping);
+        }
+        CloseHandle(File);
+        return false;
+    }
+
+    FileHandle = File;
+    MappingHandle = Mapping;
+    Data = static_cast<const uint8*>(View);
+    Size = FileSize.QuadPart;
+    return true;
+}
+
+void FXQMappedFile::Close()
+{
+    if (Data != nullptr)
+    {
+        UnmapViewOfFile(Data);
+        CloseHandle(static_cast<HANDLE>(MappingHandle));
+        CloseHandle(static_cast<HANDLE>(FileHandle));
+    }
+    MappingHandle = nullptr;
+    FileHandle = nullptr;
+    Data = nullptr;
+    Size = 0;
+}
+
+#else
+
+bool FXQMappedFile::Open(const std::string& Path)
+{
+    Close();
+
+    const int Descriptor = open(Path.c_str(), O_RDONLY);
+    if (Descriptor < 0)
+    {
+        return false;
+    }
+    struct stat Status;
+    if (fstat(Descriptor, &Status) != 0 || Status.st_size == 0)
+    {
+        close(Descriptor);
+        return false;
+    }
+    void* View = mmap(nullptr, static_cast<size_t>(Status.st_size), PROT_READ, MAP_SHARED, Descriptor, 0);
+    close(Descriptor); // 映射建立后不再需要文件描述符
+    if (View == MAP_FAILED)
+    {
+        return false;
+    }
+
+    Data = static_cast<const uint8*>(View);
+    Size = static_cast<int64>(Status.st_size);
+    return true;
+}
+
+void FXQMappedFile::Close()
+{
+    if (Data != nullptr)
+    {
+        munmap(const_cast<uint8*>(Data), static_cast<size_t>(Size));
+    }
+    Data = nullptr;
+    Size = 0;
+}
+
+#endif
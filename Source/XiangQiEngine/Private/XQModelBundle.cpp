@@ -0,0 +1,216 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQModelBundle.h"
+#include "XQFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+
+static uint64 AlignXQModelBundleOffset(uint64 Offset)
+{
+    return (Offset + XQ_MODEL_BUNDLE_ALIGNMENT - 1) & ~static_cast<uint64>(XQ_MODEL_BUNDLE_ALIGNMENT - 1);
+}
+
+// 按8字节的字做FNV-1a，比逐字节快得多；最后不足一个字的部分补0
+class FXQModelBundleHasher
+{
+public:
+    void Update(const uint8* Data, uint64 Size)
+    {
+        // 先补齐上次剩下的不足一个字的部分
+        if (TailSize > 0)
+        {
+            const uint64 Count = std::min<uint64>(8 - TailSize, Size);
+            std::memcpy(Tail + TailSize, Data, static_cast<size_t>(Count));
+            TailSize += static_cast<int32>(Count);
+            Data += Count;
+            Size -= Count;
+            if (TailSize < 8)
+            {
+                return;
+            }
+            MixWord(Tail);
+            TailSize = 0;
+        }
+        for (; Size >= 8; Data += 8, Size -= 8)
+        {
+            MixWord(Data);
+        }
+        std::memcpy(Tail, Data, static_cast<size_t>(Size));
+        TailSize = static_cast<int32>(Size);
+    }
+
+    uint64 Finish()
+    {
+        if (TailSize > 0)
+        {
+            std::memset(Tail + TailSize, 0, 8 - TailSize);
+            MixWord(Tail);
+            TailSize = 0;
+        }
+        return Hash;
+    }
+
+private:
+    void MixWord(const uint8* Data)
+    {
+        uint64 Word;
+        std::memcpy(&Word, Data, sizeof(Word));
+        Hash = (Hash ^ Word) * 1099511628211ull;
+    }
+
+private:
+    uint64 Hash = 14695981039346656037ull;
+
+    uint8 Tail[8] = {};
+
+    int32 TailSize = 0;
+};
+
+bool FXQModelBundle::Write(const std::string& Path, uint64 Generation, const FXQModelBundleSection* Sections, int32 NumSections)
+{
+    if (NumSections <= 0 || NumSections > XQ_MODEL_BUNDLE_MAX_SECTIONS)
+    {
+        return false;
+    }
+
+    // 不覆盖已有的模型包：它可能正被映射着，Windows上无法替换
+    if (GetXQFileSize(Path) >= 0)
+    {
+        return false;
+    }
+
+    FXQModelBundleHeader Header;
+    Header.NumSections = static_cast<uint32>(NumSections);
+    Header.Generation = Generation;
+
+    std::vector<FXQModelBundleSectionDesc> Descs(NumSections);
+    const uint64 TableEnd = sizeof(Header) + sizeof(FXQModelBundleSectionDesc) * NumSections;
+    uint64 Offset = AlignXQModelBundleOffset(TableEnd);
+    for (int32 i = 0; i < NumSections; i++)
+    {
+        if (Sections[i].Size < 0 || (Sections[i].Data == nullptr && Sections[i].Size > 0))
+        {
+            return false;
+        }
+        Descs[i].Type = static_cast<uint32>(Sections[i].Type);
+        Descs[i].Offset = Offset;
+        Descs[i].Size = static_cast<uint64>(Sections[i].Size);
+        Offset = AlignXQModelBundleOffset(Offset + Descs[i].Size);
+    }
+    Header.FileSize = Offset;
+
+    // 文件头之后的内容按顺序逐块产生，先算校验和，再连同文件头一起写出
+    static const uint8 Padding[XQ_MODEL_BUNDLE_ALIGNMENT] = {};
+    auto ForEachChunk = [&](const std::function<bool(const uint8*, uint64)>& Emit)
+    {
+        bool bOk = Emit(reinterpret_cast<const uint8*>(Descs.data()), sizeof(FXQModelBundleSectionDesc) * Descs.size()) &&
+            Emit(Padding, AlignXQModelBundleOffset(TableEnd) - TableEnd);
+        for (int32 i = 0; bOk && i < NumSections; i++)
+        {
+            const uint64 End = Descs[i].Offset + Descs[i].Size;
+            bOk = Emit(Sections[i].Data, Descs[i].Size) && Emit(Padding, AlignXQModelBundleOffset(End) - End);
+        }
+        return bOk;
+    };
+
+    FXQModelBundleHasher Hasher;
+    ForEachChunk([&Hasher](const uint8* Data, uint64 Size)
+    {
+        Hasher.Update(Data, Size);
+        return true;
+    });
+    Header.Checksum = Hasher.Finish();
+
+    const std::string TempPath = Path + ".tmp";
+    std::FILE* File = OpenXQFile(TempPath, "wb");
+    if (File == nullptr)
+    {
+        return false;
+    }
+    bool bOk = std::fwrite(&Header, sizeof(Header), 1, File) == 1 && ForEachChunk([File](const uint8* Data, uint64 Size)
+    {
+        return Size == 0 || std::fwrite(Data, 1, static_cast<size_t>(Size), File) == static_cast<size_t>(Size);
+    });
+    bOk = bOk && SyncXQFile(File);
+    bOk = std::fclose(File) == 0 && bOk;
+
+    bOk = bOk && RenameXQFile(TempPath, Path);
+    if (!bOk)
+    {
+        RemoveXQFile(TempPath);
+    }
+    return bOk;
+}
+
+bool FXQModelBundle::Open(const std::string& Path)
+{
+    Close();
+
+    std::shared_ptr<FXQMappedFile> NewMapping = std::make_shared<FXQMappedFile>();
+    if (!NewMapping->Open(Path))
+    {
+        return false;
+    }
+    const uint8* Data = NewMapping->GetData();
+    const uint64 Size = static_cast<uint64>(NewMapping->GetSize());
+
+    FXQModelBundleHeader Header;
+    if (Size < sizeof(Header))
+    {
+        return false;
+    }
+    std::memcpy(&Header, Data, sizeof(Header));
+    const uint64 TableEnd = sizeof(Header) + sizeof(FXQModelBundleSectionDesc) * static_cast<uint64>(Header.NumSections);
+    if (Header.Magic != XQ_MODEL_BUNDLE_MAGIC || Header.Version != XQ_MODEL_BUNDLE_VERSION || Header.FileSize != Size ||
+        Header.NumSections == 0 || Header.NumSections > XQ_MODEL_BUNDLE_MAX_SECTIONS || TableEnd > Size)
+    {
+        return false;
+    }
+
+    FXQModelBundleHasher Hasher;
+    Hasher.Update(Data + sizeof(Header), Size - sizeof(Header));
+    if (Hasher.Finish() != Header.Checksum)
+    {
+        return false;
+    }
+
+    std::vector<FXQModelBundleSectionDesc> NewSections(Header.NumSections);
+    std::memcpy(NewSections.data(), Data + sizeof(Header), sizeof(FXQModelBundleSectionDesc) * NewSections.size());
+    for (const FXQModelBundleSectionDesc& Desc : NewSections)
+    {
+        if (Desc.Offset % XQ_MODEL_BUNDLE_ALIGNMENT != 0 || Desc.Offset < TableEnd || Desc.Size > Size || Desc.Offset > Size - Desc.Size)
+        {
+            return false;
+        }
+    }
+
+    Mapping = std::move(NewMapping);
+    Sections = std::move(NewSections);
+    Generation = Header.Generation;
+    return true;
+}
+
+void FXQModelBundle::Close()
+{
+    Mapping.reset();
+    Sections.clear();
+    Generation = 0;
+}
+
+bool FXQModelBundle::FindSection(EXQModelSection Type, FXQModelBundleSection& OutSection) const
+{
+    for (const FXQModelBundleSectionDesc& Desc : Sections)
+    {
+        if (Desc.Type == static_cast<uint32>(Type))
+        {
+            OutSection.Type = Type;
+            OutSection.Data = Mapping->GetData() + Desc.Offset;
+            OutSection.Size = static_cast<int64>(Desc.Size);
+            return true;
+        }
+    }
+    return false;
+}
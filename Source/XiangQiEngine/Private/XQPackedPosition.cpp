@@ -0,0 +1,132 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQPackedPosition.h"
+#include "XQPosition.h"
+
+#include <cstring>
+
+// 每种棋子在一方16个槽位中的起始位置和数量，按EXQPieceType索引
+static const int32 XQPackedSlotStart[8] = { 0, 0, 1, 3, 5, 7, 9, 11 };
+static const int32 XQPackedSlotCount[8] = { 0, 1, 2, 2, 2, 2, 2, 5 };
+
+bool FXQPackedPosition::Pack(const FXQPosition& Position)
+{
+    return PackBoard(Position.GetBoard(), Position.GetSideToMove());
+}
+
+bool FXQPackedPosition::Unpack(FXQPosition& OutPosition) const
+{
+    uint8 Board[XQ_SQUARES];
+    EXQColor SideToMove = EXQColor::Red;
+    OutPosition.Clear();
+    if (!UnpackBoard(Board, SideToMove))
+    {
+        return false;
+    }
+
+    for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+    {
+        if (Board[Square] != 0)
+        {
+            OutPosition.SetPiece(Square, Board[Square]);
+        }
+    }
+    OutPosition.SetSideToMove(SideToMove);
+    return true;
+}
+
+bool FXQPackedPosition::PackBoard(const uint8* Board, EXQColor SideToMove)
+{
+    std::memset(Slots, XQ_PACKED_EMPTY, sizeof(Slots));
+
+    int32 Used[2][8] = {};
+    for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+    {
+        const uint8 Piece = Board[Square];
+        if (Piece == 0)
+        {
+            continue;
+        }
+
+        const int32 Type = static_cast<int32>(XQPieceTypeOf(Piece));
+        const int32 Color = static_cast<int32>(XQPieceColorOf(Piece));
+        if (Used[Color][Type] >= XQPackedSlotCount[Type])
+        {
+            return false;
+        }
+        Slots[Color * 16 + XQPackedSlotStart[Type] + Used[Color][Type]++] = static_cast<uint8>(Square);
+    }
+
+    if (Used[0][1] == 0 || Used[1][1] == 0)
+    {
+        return false;
+    }
+
+    if (SideToMove == EXQColor::Black)
+    {
+        Slots[0] |= 0x80;
+    }
+    return true;
+}
+
+bool FXQPackedPosition::UnpackBoard(uint8* OutBoard, EXQColor& OutSideToMove) const
+{
+    std::memset(OutBoard, 0, XQ_SQUARES);
+    for (int32 Color = 0; Color < 2; Color++)
+    {
+        for (int32 Type = 1; Type < 8; Type++)
+        {
+            for (int32 i = 0; i < XQPackedSlotCount[Type]; i++)
+            {
+                uint8 Square = Slots[Color * 16 + XQPackedSlotStart[Type] + i];
+                if (Color == 0 && Type == 1)
+                {
+                    Square &= 0x7F;
+                }
+                if (Square == XQ_PACKED_EMPTY)
+                {
+                    continue;
+                }
+                if (Square >= XQ_SQUARES || OutBoard[Square] != 0)
+                {
+                    std::memset(OutBoard, 0, XQ_SQUARES);
+                    return false;
+                }
+                OutBoard[Square] = XQMakePiece(static_cast<EXQPieceType>(Type), static_cast<EXQColor>(Color));
+            }
+        }
+    }
+
+    OutSideToMove = (Slots[0] & 0x80) != 0 ? EXQColor::Black : EXQColor::Red;
+    return true;
+}
+
+bool FXQPackedPosition::SetFromFen(const char* Fen, int32 Length)
+{
+    uint8 Board[XQ_SQUARES];
+    EXQColor SideToMove = EXQColor::Red;
+    return XQParseFen(Fen, Length, Board, SideToMove) && PackBoard(Board, SideToMove);
+}
+
+int32 FXQPackedPosition::WriteFen(char* Out) const
+{
+    uint8 Board[XQ_SQUARES];
+    EXQColor SideToMove = EXQColor::Red;
+    if (!UnpackBoard(Board, SideToMove))
+    {
+        Out[0] = '\0';
+        return 0;
+    }
+    return XQWriteFen(Board, SideToMove, Out);
+}
+
+EXQPieceType FXQPackedPosition::GetSlotType(int32 Slot)
+{
+    static const uint8 SlotTypes[16] = { 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 7, 7, 7 };
+    return static_cast<EXQPieceType>(SlotTypes[Slot & 15]);
+}
+
+bool FXQPackedPosition::operator==(const FXQPackedPosition& Other) const
+{
+    return std::memcmp(Slots, Other.Slots, sizeof(Slots)) == 0;
+}
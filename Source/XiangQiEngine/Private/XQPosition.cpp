@@ -0,0 +1,749 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQPosition.h"
+
+#include <cstring>
+
+// 预先计算的走法表，-1表示列表结束
+struct FXQMoveTables
+{
+    int8 JiangTo[XQ_SQUARES][5];
+    int8 ShiTo[XQ_SQUARES][5];
+    int8 XiangTo[XQ_SQUARES][5];
+    int8 XiangEye[XQ_SQUARES][4];
+    int8 MaTo[XQ_SQUARES][9];
+    int8 MaLeg[XQ_SQUARES][8];
+    int8 BingTo[2][XQ_SQUARES][4];
+
+    // 四个方向（上、下、左、右）上依次经过的格子
+    int8 Ray[XQ_SQUARES][4][11];
+
+    // 能攻击到该格的马所在位置及其马腿
+    int8 MaAttackFrom[XQ_SQUARES][9];
+    int8 MaAttackLeg[XQ_SQUARES][8];
+
+    FXQMoveTables();
+
+    static bool IsOnBoard(int32 Rank, int32 File)
+    {
+        return Rank >= 0 && Rank < XQ_RANKS && File >= 0 && File < XQ_FILES;
+    }
+
+    static bool IsInPalace(int32 Rank, int32 File)
+    {
+        return File >= 3 && File <= 5 && ((Rank >= 0 && Rank <= 2) || (Rank >= 7 && Rank < XQ_RANKS));
+    }
+};
+
+FXQMoveTables::FXQMoveTables()
+{
+    std::memset(this, -1, sizeof(FXQMoveTables));
+
+    static const int32 OrthDirs[4][2] = { {1, 0}, {-1, 0}, {0, -1}, {0, 1} };
+    static const int32 DiagDirs[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+    static const int32 MaDirs[8][2] = { {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {-1, 2}, {1, -2}, {-1, -2} };
+
+    for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+    {
+        const int32 Rank = XQRankOf(Square);
+        const int32 File = XQFileOf(Square);
+
+        // 将/帅与士/仕只在九宫内移动
+        if (IsInPalace(Rank, File))
+        {
+            int32 NumJiang = 0;
+            int32 NumShi = 0;
+            for (int32 i = 0; i < 4; i++)
+            {
+                if (IsInPalace(Rank + OrthDirs[i][0], File + OrthDirs[i][1]))
+                {
+                    JiangTo[Square][NumJiang++] = static_cast<int8>(XQMakeSquare(Rank + OrthDirs[i][0], File + OrthDirs[i][1]));
+                }
+                if (IsInPalace(Rank + DiagDirs[i][0], File + DiagDirs[i][1]))
+                {
+                    ShiTo[Square][NumShi++] = static_cast<int8>(XQMakeSquare(Rank + DiagDirs[i][0], File + DiagDirs[i][1]));
+                }
+            }
+        }
+
+        // 象/相走田字，不能过河
+        int32 NumXiang = 0;
+        for (int32 i = 0; i < 4; i++)
+        {
+            const int32 ToRank = Rank + DiagDirs[i][0] * 2;
+            const int32 ToFile = File + DiagDirs[i][1] * 2;
+            if (IsOnBoard(ToRank, ToFile) && (ToRank <= 4) == (Rank <= 4))
+            {
+                XiangEye[Square][NumXiang] = static_cast<int8>(XQMakeSquare(Rank + DiagDirs[i][0], File + DiagDirs[i][1]));
+                XiangTo[Square][NumXiang++] = static_cast<int8>(XQMakeSquare(ToRank, ToFile));
+            }
+        }
+
+        // 马走日字，马腿在长边方向的第一格
+        int32 NumMa = 0;
+        int32 NumMaAttack = 0;
+        for (int32 i = 0; i < 8; i++)
+        {
+            const bool bLongRank = MaDirs[i][0] == 2 || MaDirs[i][0] == -2;
+            const int32 LegRank = bLongRank ? MaDirs[i][0] / 2 : 0;
+            const int32 LegFile = bLongRank ? 0 : MaDirs[i][1] / 2;
+
+            if (IsOnBoard(Rank + MaDirs[i][0], File + MaDirs[i][1]))
+            {
+                MaLeg[Square][NumMa] = static_cast<int8>(XQMakeSquare(Rank + LegRank, File + LegFile));
+                MaTo[Square][NumMa++] = static_cast<int8>(XQMakeSquare(Rank + MaDirs[i][0], File + MaDirs[i][1]));
+            }
+
+            // 反向：位于Square - Dir的马经过其马腿攻击Square
+            const int32 FromRank = Rank - MaDirs[i][0];
+            const int32 FromFile = File - MaDirs[i][1];
+            if (IsOnBoard(FromRank, FromFile))
+            {
+                MaAttackLeg[Square][NumMaAttack] = static_cast<int8>(XQMakeSquare(FromRank + LegRank, FromFile + LegFile));
+                MaAttackFrom[Square][NumMaAttack++] = static_cast<int8>(XQMakeSquare(FromRank, FromFile));
+            }
+        }
+
+        // 兵/卒：红方向上，黑方向下，过河后可以左右移动
+        for (int32 Color = 0; Color < 2; Color++)
+        {
+            const int32 Forward = Color == 0 ? 1 : -1;
+            const bool bCrossed = Color == 0 ? Rank >= 5 : Rank <= 4;
+            int32 NumBing = 0;
+            if (IsOnBoard(Rank + Forward, File))
+            {
+                BingTo[Color][Square][NumBing++] = static_cast<int8>(XQMakeSquare(Rank + Forward, File));
+            }
+            if (bCrossed)
+            {
+                if (File > 0)
+                {
+                    BingTo[Color][Square][NumBing++] = static_cast<int8>(Square - 1);
+                }
+                if (File < XQ_FILES - 1)
+                {
+                    BingTo[Color][Square][NumBing++] = static_cast<int8>(Square + 1);
+                }
+            }
+        }
+
+        // 直线方向
+        for (int32 Dir = 0; Dir < 4; Dir++)
+        {
+            int32 NumRay = 0;
+            int32 ToRank = Rank + OrthDirs[Dir][0];
+            int32 ToFile = File + OrthDirs[Dir][1];
+            while (IsOnBoard(ToRank, ToFile))
+            {
+                Ray[Square][Dir][NumRay++] = static_cast<int8>(XQMakeSquare(ToRank, ToFile));
+                ToRank += OrthDirs[Dir][0];
+                ToFile += OrthDirs[Dir][1];
+            }
+        }
+    }
+}
+
+static const FXQMoveTables& GetXQMoveTables()
+{
+    static const FXQMoveTables Tables;
+    return Tables;
+}
+
+// Zobrist随机数，用固定种子生成，保证不同进程、不同平台得到相同的键值
+struct FXQZobrist
+{
+    uint64 Pieces[16][XQ_SQUARES];
+    uint64 Side;
+
+    FXQZobrist()
+    {
+        uint64 Seed = 0x9E3779B97F4A7C15ull;
+        auto Next = [&Seed]()
+        {
+            // SplitMix64
+            uint64 Z = (Seed += 0x9E3779B97F4A7C15ull);
+            Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBull;
+            return Z ^ (Z >> 31);
+        };
+
+        for (int32 Piece = 0; Piece < 16; Piece++)
+        {
+            for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+            {
+                Pieces[Piece][Square] = (Piece & 7) != 0 ? Next() : 0;
+            }
+        }
+        Side = Next();
+    }
+};
+
+static const FXQZobrist& GetXQZobrist()
+{
+    static const FXQZobrist Zobrist;
+    return Zobrist;
+}
+
+FXQPosition::FXQPosition()
+{
+    Clear();
+}
+
+void FXQPosition::Clear()
+{
+    std::memset(Board, 0, sizeof(Board));
+    KingSquares[0] = -1;
+    KingSquares[1] = -1;
+    SideToMove = EXQColor::Red;
+    Key = 0;
+    History.clear();
+}
+
+void FXQPosition::SetStartPosition()
+{
+    SetFromFen(XQ_START_FEN);
+}
+
+static uint8 XQPieceFromFenChar(char Char)
+{
+    const EXQColor Color = (Char >= 'A' && Char <= 'Z') ? EXQColor::Red : EXQColor::Black;
+    switch (Char | 0x20) // 转小写
+    {
+    case 'k': return XQMakePiece(EXQPieceType::Jiang, Color);
+    case 'a': return XQMakePiece(EXQPieceType::Shi, Color);
+    case 'b':
+    case 'e': return XQMakePiece(EXQPieceType::Xiang, Color);
+    case 'n':
+    case 'h': return XQMakePiece(EXQPieceType::Ma, Color);
+    case 'r': return XQMakePiece(EXQPieceType::Jv, Color);
+    case 'c': return XQMakePiece(EXQPieceType::Pao, Color);
+    case 'p': return XQMakePiece(EXQPieceType::Bing, Color);
+    default: return 0;
+    }
+}
+
+static char XQFenCharFromPiece(uint8 Piece)
+{
+    static const char RedChars[8] = { '?', 'K', 'A', 'B', 'N', 'R', 'C', 'P' };
+    const char Char = RedChars[static_cast<int32>(XQPieceTypeOf(Piece))];
+    return XQPieceColorOf(Piece) == EXQColor::Red ? Char : static_cast<char>(Char | 0x20);
+}
+
+bool XQParseFen(const char* Fen, int32 Length, uint8* OutBoard, EXQColor& OutSideToMove)
+{
+    const int32 End = Length < 0 ? static_cast<int32>(std::strlen(Fen)) : Length;
+    std::memset(OutBoard, 0, XQ_SQUARES);
+    OutSideToMove = EXQColor::Red;
+
+    // FEN从黑方底线（第9行）开始
+    int32 Rank = XQ_RANKS - 1;
+    int32 File = 0;
+    int32 Index = 0;
+    for (; Index < End && Fen[Index] != ' '; Index++)
+    {
+        const char Char = Fen[Index];
+        if (Char == '/')
+        {
+            if (File != XQ_FILES || Rank == 0)
+            {
+                return false;
+            }
+            Rank--;
+            File = 0;
+        }
+        else if (Char >= '1' && Char <= '9')
+        {
+            File += Char - '0';
+            if (File > XQ_FILES)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            const uint8 Piece = XQPieceFromFenChar(Char);
+            if (Piece == 0 || File >= XQ_FILES)
+            {
+                return false;
+            }
+            OutBoard[XQMakeSquare(Rank, File)] = Piece;
+            File++;
+        }
+    }
+
+    if (Rank != 0 || File != XQ_FILES)
+    {
+        return false;
+    }
+
+    // 执棋方：w/r为红方，b为黑方
+    while (Index < End && Fen[Index] == ' ')
+    {
+        Index++;
+    }
+    if (Index < End && Fen[Index] == 'b')
+    {
+        OutSideToMove = EXQColor::Black;
+    }
+    return true;
+}
+
+int32 XQWriteFen(const uint8* Board, EXQColor SideToMove, char* Out)
+{
+    int32 Length = 0;
+    for (int32 Rank = XQ_RANKS - 1; Rank >= 0; Rank--)
+    {
+        int32 Empty = 0;
+        for (int32 File = 0; File < XQ_FILES; File++)
+        {
+            const uint8 Piece = Board[XQMakeSquare(Rank, File)];
+            if (Piece == 0)
+            {
+                Empty++;
+                continue;
+            }
+            if (Empty > 0)
+            {
+                Out[Length++] = static_cast<char>('0' + Empty);
+                Empty = 0;
+            }
+            Out[Length++] = XQFenCharFromPiece(Piece);
+        }
+        if (Empty > 0)
+        {
+            Out[Length++] = static_cast<char>('0' + Empty);
+        }
+        if (Rank > 0)
+        {
+            Out[Length++] = '/';
+        }
+    }
+
+    const char* Suffix = SideToMove == EXQColor::Red ? " w - - 0 1" : " b - - 0 1";
+    while (*Suffix != '\0')
+    {
+        Out[Length++] = *Suffix++;
+    }
+    Out[Length] = '\0';
+    return Length;
+}
+
+bool FXQPosition::SetFromFen(const std::string& Fen)
+{
+    return SetFromFen(Fen.c_str(), static_cast<int32>(Fen.size()));
+}
+
+bool FXQPosition::SetFromFen(const char* Fen, int32 Length)
+{
+    uint8 Parsed[XQ_SQUARES];
+    EXQColor Side = EXQColor::Red;
+    if (!XQParseFen(Fen, Length, Parsed, Side))
+    {
+        return false;
+    }
+
+    Clear();
+    for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+    {
+        if (Parsed[Square] != 0)
+        {
+            SetPiece(Square, Parsed[Square]);
+        }
+    }
+    SetSideToMove(Side);
+    return true;
+}
+
+std::string FXQPosition::ToFen() const
+{
+    char Fen[XQ_FEN_BUFFER_SIZE];
+    const int32 Length = WriteFen(Fen);
+    return std::string(Fen, Length);
+}
+
+int32 FXQPosition::WriteFen(char* Out) const
+{
+    return XQWriteFen(Board, SideToMove, Out);
+}
+
+void FXQPosition::SetPiece(int32 Square, uint8 Piece)
+{
+    const uint8 Old = Board[Square];
+    if (Old != 0 && XQPieceTypeOf(Old) == EXQPieceType::Jiang)
+    {
+        KingSquares[static_cast<int32>(XQPieceColorOf(Old))] = -1;
+    }
+
+    const FXQZobrist& Zobrist = GetXQZobrist();
+    Key ^= Zobrist.Pieces[Old][Square] ^ Zobrist.Pieces[Piece][Square];
+
+    Board[Square] = Piece;
+    if (Piece != 0 && XQPieceTypeOf(Piece) == EXQPieceType::Jiang)
+    {
+        KingSquares[static_cast<int32>(XQPieceColorOf(Piece))] = Square;
+    }
+}
+
+void FXQPosition::SetSideToMove(EXQColor Color)
+{
+    if (SideToMove != Color)
+    {
+        SideToMove = Color;
+        Key ^= GetXQZobrist().Side;
+    }
+}
+
+int32 FXQPosition::GetRepetitionCount() const
+{
+    // 只需比较执棋方相同的局面，遇到吃子后更早的局面不可能重现
+    int32 Count = 0;
+    const int32 Num = static_cast<int32>(History.size());
+    for (int32 i = Num - 1; i >= 0; i--)
+    {
+        if (History[i].Captured != 0)
+        {
+            break;
+        }
+        if (((Num - i) & 1) == 0 && History[i].Key == Key)
+        {
+            Count++;
+        }
+    }
+    return Count;
+}
+
+void FXQPosition::MakeMove(FXQMove Move)
+{
+    const int32 From = Move.From();
+    const int32 To = Move.To();
+    const uint8 Piece = Board[From];
+
+    FUndoInfo Undo;
+    Undo.Move = Move;
+    Undo.Captured = Board[To];
+    Undo.Key = Key;
+    History.push_back(Undo);
+
+    const FXQZobrist& Zobrist = GetXQZobrist();
+    Key ^= Zobrist.Pieces[Piece][From] ^ Zobrist.Pieces[Piece][To] ^ Zobrist.Pieces[Undo.Captured][To] ^ Zobrist.Side;
+
+    if (Undo.Captured != 0 && XQPieceTypeOf(Undo.Captured) == EXQPieceType::Jiang)
+    {
+        KingSquares[static_cast<int32>(XQPieceColorOf(Undo.Captured))] = -1;
+    }
+
+    Board[To] = Piece;
+    Board[From] = 0;
+    if (XQPieceTypeOf(Piece) == EXQPieceType::Jiang)
+    {
+        KingSquares[static_cast<int32>(XQPieceColorOf(Piece))] = To;
+    }
+
+    SideToMove = XQOpponent(SideToMove);
+}
+
+void FXQPosition::UnmakeMove()
+{
+    const FUndoInfo Undo = History.back();
+    History.pop_back();
+
+    const int32 From = Undo.Move.From();
+    const int32 To = Undo.Move.To();
+    const uint8 Piece = Board[To];
+
+    Board[From] = Piece;
+    Board[To] = Undo.Captured;
+    if (XQPieceTypeOf(Piece) == EXQPieceType::Jiang)
+    {
+        KingSquares[static_cast<int32>(XQPieceColorOf(Piece))] = From;
+    }
+    if (Undo.Captured != 0 && XQPieceTypeOf(Undo.Captured) == EXQPieceType::Jiang)
+    {
+        KingSquares[static_cast<int32>(XQPieceColorOf(Undo.Captured))] = To;
+    }
+
+    SideToMove = XQOpponent(SideToMove);
+    Key = Undo.Key;
+}
+
+void FXQPosition::GenerateMoves(FXQMoveList& Moves, bool bCapturesOnly) const
+{
+    const FXQMoveTables& Tables = GetXQMoveTables();
+    const EXQColor Us = SideToMove;
+    Moves.Num = 0;
+
+    // 目标格可以落子：空格（非仅吃子模式）或对方棋子
+    auto CanLand = [this, Us, bCapturesOnly](int32 To)
+    {
+        const uint8 Target = Board[To];
+        return Target == 0 ? !bCapturesOnly : XQPieceColorOf(Target) != Us;
+    };
+
+    for (int32 From = 0; From < XQ_SQUARES; From++)
+    {
+        const uint8 Piece = Board[From];
+        if (Piece == 0 || XQPieceColorOf(Piece) != Us)
+        {
+            continue;
+        }
+
+        switch (XQPieceTypeOf(Piece))
+        {
+        case EXQPieceType::Jiang:
+            for (const int8* To = Tables.JiangTo[From]; *To >= 0; To++)
+            {
+                if (CanLand(*To)) Moves.Add(FXQMove(From, *To));
+            }
+            break;
+        case EXQPieceType::Shi:
+            for (const int8* To = Tables.ShiTo[From]; *To >= 0; To++)
+            {
+                if (CanLand(*To)) Moves.Add(FXQMove(From, *To));
+            }
+            break;
+        case EXQPieceType::Xiang:
+            for (int32 i = 0; Tables.XiangTo[From][i] >= 0; i++)
+            {
+                if (Board[Tables.XiangEye[From][i]] == 0 && CanLand(Tables.XiangTo[From][i]))
+                {
+                    Moves.Add(FXQMove(From, Tables.XiangTo[From][i]));
+                }
+            }
+            break;
+        case EXQPieceType::Ma:
+            for (int32 i = 0; Tables.MaTo[From][i] >= 0; i++)
+            {
+                if (Board[Tables.MaLeg[From][i]] == 0 && CanLand(Tables.MaTo[From][i]))
+                {
+                    Moves.Add(FXQMove(From, Tables.MaTo[From][i]));
+                }
+            }
+            break;
+        case EXQPieceType::Jv:
+            for (int32 Dir = 0; Dir < 4; Dir++)
+            {
+                for (const int8* To = Tables.Ray[From][Dir]; *To >= 0; To++)
+                {
+                    if (Board[*To] == 0)
+                    {
+                        if (!bCapturesOnly) Moves.Add(FXQMove(From, *To));
+                        continue;
+                    }
+                    if (XQPieceColorOf(Board[*To]) != Us) Moves.Add(FXQMove(From, *To));
+                    break;
+                }
+            }
+            break;
+        case EXQPieceType::Pao:
+            for (int32 Dir = 0; Dir < 4; Dir++)
+            {
+                const int8* To = Tables.Ray[From][Dir];
+                for (; *To >= 0 && Board[*To] == 0; To++)
+                {
+                    if (!bCapturesOnly) Moves.Add(FXQMove(From, *To));
+                }
+                if (*To < 0)
+                {
+                    continue;
+                }
+                // 越过炮架找到第一个棋子
+                for (To++; *To >= 0; To++)
+                {
+                    if (Board[*To] != 0)
+                    {
+                        if (XQPieceColorOf(Board[*To]) != Us) Moves.Add(FXQMove(From, *To));
+                        break;
+                    }
+                }
+            }
+            break;
+        case EXQPieceType::Bing:
+            for (const int8* To = Tables.BingTo[static_cast<int32>(Us)][From]; *To >= 0; To++)
+            {
+                if (CanLand(*To)) Moves.Add(FXQMove(From, *To));
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void FXQPosition::GenerateLegalMoves(FXQMoveList& Moves)
+{
+    FXQMoveList Pseudo;
+    GenerateMoves(Pseudo);
+
+    Moves.Num = 0;
+    for (FXQMove Move : Pseudo)
+    {
+        if (MakeMoveIfLegal(Move))
+        {
+            UnmakeMove();
+            Moves.Add(Move);
+        }
+    }
+}
+
+bool FXQPosition::IsLegalMove(FXQMove Move)
+{
+    FXQMoveList Pseudo;
+    GenerateMoves(Pseudo);
+    for (FXQMove Candidate : Pseudo)
+    {
+        if (Candidate == Move)
+        {
+            if (MakeMoveIfLegal(Move))
+            {
+                UnmakeMove();
+                return true;
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+bool FXQPosition::MakeMoveIfLegal(FXQMove Move)
+{
+    const EXQColor Us = SideToMove;
+    MakeMove(Move);
+    if (IsInCheck(Us))
+    {
+        UnmakeMove();
+        return false;
+    }
+    return true;
+}
+
+bool FXQPosition::IsInCheck(EXQColor Color) const
+{
+    const int32 King = KingSquares[static_cast<int32>(Color)];
+    return King >= 0 && IsSquareAttacked(King, XQOpponent(Color));
+}
+
+bool FXQPosition::IsSquareAttacked(int32 Square, EXQColor ByColor) const
+{
+    const FXQMoveTables& Tables = GetXQMoveTables();
+
+    // 车、炮以及将帅照面
+    for (int32 Dir = 0; Dir < 4; Dir++)
+    {
+        const int8* To = Tables.Ray[Square][Dir];
+        for (; *To >= 0 && Board[*To] == 0; To++)
+        {
+        }
+        if (*To < 0)
+        {
+            continue;
+        }
+
+        const uint8 First = Board[*To];
+        if (XQPieceColorOf(First) == ByColor)
+        {
+            const EXQPieceType Type = XQPieceTypeOf(First);
+            if (Type == EXQPieceType::Jv || (Type == EXQPieceType::Jiang && Dir < 2))
+            {
+                return true;
+            }
+        }
+
+        for (To++; *To >= 0; To++)
+        {
+            if (Board[*To] != 0)
+            {
+                if (Board[*To] == XQMakePiece(EXQPieceType::Pao, ByColor))
+                {
+                    return true;
+                }
+                break;
+            }
+        }
+    }
+
+    // 马
+    const uint8 EnemyMa = XQMakePiece(EXQPieceType::Ma, ByColor);
+    for (int32 i = 0; Tables.MaAttackFrom[Square][i] >= 0; i++)
+    {
+        if (Board[Tables.MaAttackFrom[Square][i]] == EnemyMa && Board[Tables.MaAttackLeg[Square][i]] == 0)
+        {
+            return true;
+        }
+    }
+
+    // 兵/卒：从后方或过河后从侧面攻击
+    const uint8 EnemyBing = XQMakePiece(EXQPieceType::Bing, ByColor);
+    const int32 Rank = XQRankOf(Square);
+    const int32 File = XQFileOf(Square);
+    if (ByColor == EXQColor::Red)
+    {
+        if (Rank > 0 && Board[Square - XQ_FILES] == EnemyBing) return true;
+        if (Rank >= 5 && File > 0 && Board[Square - 1] == EnemyBing) return true;
+        if (Rank >= 5 && File < XQ_FILES - 1 && Board[Square + 1] == EnemyBing) return true;
+    }
+    else
+    {
+        if (Rank < XQ_RANKS - 1 && Board[Square + XQ_FILES] == EnemyBing) return true;
+        if (Rank <= 4 && File > 0 && Board[Square - 1] == EnemyBing) return true;
+        if (Rank <= 4 && File < XQ_FILES - 1 && Board[Square + 1] == EnemyBing) return true;
+    }
+
+    return false;
+}
+
+bool FXQPosition::IsMated()
+{
+    FXQMoveList Pseudo;
+    GenerateMoves(Pseudo);
+    for (FXQMove Move : Pseudo)
+    {
+        if (MakeMoveIfLegal(Move))
+        {
+            UnmakeMove();
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string XQMoveToString(FXQMove Move)
+{
+    char Text[5];
+    XQWriteMove(Move, Text);
+    return std::string(Text, 4);
+}
+
+void XQWriteMove(FXQMove Move, char* Out)
+{
+    Out[0] = static_cast<char>('a' + XQFileOf(Move.From()));
+    Out[1] = static_cast<char>('0' + XQRankOf(Move.From()));
+    Out[2] = static_cast<char>('a' + XQFileOf(Move.To()));
+    Out[3] = static_cast<char>('0' + XQRankOf(Move.To()));
+    Out[4] = '\0';
+}
+
+bool XQParseMove(const std::string& Text, FXQMove& OutMove)
+{
+    return XQParseMove(Text.c_str(), static_cast<int32>(Text.size()), OutMove);
+}
+
+bool XQParseMove(const char* Text, int32 Length, FXQMove& OutMove)
+{
+    if (Length < 4)
+    {
+        return false;
+    }
+
+    const int32 FromFile = Text[0] - 'a';
+    const int32 FromRank = Text[1] - '0';
+    const int32 ToFile = Text[2] - 'a';
+    const int32 ToRank = Text[3] - '0';
+    if (FromFile < 0 || FromFile >= XQ_FILES || ToFile < 0 || ToFile >= XQ_FILES ||
+        FromRank < 0 || FromRank >= XQ_RANKS || ToRank < 0 || ToRank >= XQ_RANKS)
+    {
+        return false;
+    }
+
+    OutMove = FXQMove(XQMakeSquare(FromRank, FromFile), XQMakeSquare(ToRank, ToFile));
+    return !OutMove.IsNull();
+}
@@ -0,0 +1,123 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQReferee.h"
+#include "XQPosition.h"
+
+FXQReferee::FXQReferee(const FXQRefereeSettings& InSettings)
+    : Settings(InSettings)
+{
+}
+
+void FXQReferee::Reset(const FXQPosition& Start)
+{
+    Keys.assign(1, Start.GetKey());
+    GaveCheck.assign(1, Start.IsInCheck(Start.GetSideToMove()));
+    Plies = 0;
+    PliesSinceCapture = 0;
+    Reason = "";
+}
+
+EXQGameResult FXQReferee::OnMove(FXQPosition& Position)
+{
+    Plies++;
+    PliesSinceCapture = Position.GetLastCaptured() != 0 ? 0 : PliesSinceCapture + 1;
+    Keys.push_back(Position.GetKey());
+    GaveCheck.push_back(Position.IsInCheck(Position.GetSideToMove()));
+
+    if (Position.GetRepetitionCount() >= 2)
+    {
+        const EXQGameResult Result = AdjudicateRepetition(XQOpponent(Position.GetSideToMove()));
+        if (Result != EXQGameResult::Ongoing)
+        {
+            return Result;
+        }
+    }
+    return Adjudicate(Position);
+}
+
+EXQGameResult FXQReferee::Adjudicate(FXQPosition& Position)
+{
+    const EXQColor Us = Position.GetSideToMove();
+    if (Position.IsMated())
+    {
+        Reason = Position.IsInCheck(Us) ? "mate" : "stalemate";
+        return Us == EXQColor::Red ? EXQGameResult::BlackWin : EXQGameResult::RedWin;
+    }
+    if (IsInsufficientMaterial(Position))
+    {
+        Reason = "insufficient material";
+        return EXQGameResult::Draw;
+    }
+    if (Plies >= Settings.MaxPlies)
+    {
+        Reason = "max plies";
+        return EXQGameResult::Draw;
+    }
+    if (PliesSinceCapture >= Settings.NoCaptureLimit)
+    {
+        Reason = "no capture limit";
+        return EXQGameResult::Draw;
+    }
+    return EXQGameResult::Ongoing;
+}
+
+EXQGameResult FXQReferee::AdjudicateRepetition(EXQColor LastMover)
+{
+    // 找到上一次出现当前局面的位置，两者之间的走法构成一个循环
+    const int32 Last = static_cast<int32>(Keys.size()) - 1;
+    int32 CycleStart = -1;
+    for (int32 i = Last - 2; i >= 0; i -= 2)
+    {
+        if (Keys[i] == Keys[Last])
+        {
+            CycleStart = i;
+            break;
+        }
+    }
+    if (CycleStart < 0)
+    {
+        return EXQGameResult::Ongoing;
+    }
+
+    bool bPerpetual[2] = { true, true }; // 0：最后一步的走子方，1：对方
+    for (int32 i = CycleStart + 1; i <= Last; i++)
+    {
+        if (!GaveCheck[i])
+        {
+            bPerpetual[(Last - i) & 1] = false;
+        }
+    }
+
+    if (bPerpetual[0] != bPerpetual[1])
+    {
+        const EXQColor Loser = bPerpetual[0] ? LastMover : XQOpponent(LastMover);
+        Reason = "perpetual check";
+        return Loser == EXQColor::Red ? EXQGameResult::BlackWin : EXQGameResult::RedWin;
+    }
+
+    Reason = "repetition";
+    return EXQGameResult::Draw;
+}
+
+double FXQReferee::GetRedScore(EXQGameResult Result)
+{
+    switch (Result)
+    {
+    case EXQGameResult::RedWin: return 1.0;
+    case EXQGameResult::BlackWin: return 0.0;
+    default: return 0.5;
+    }
+}
+
+bool FXQReferee::IsInsufficientMaterial(const FXQPosition& Position)
+{
+    for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+    {
+        const EXQPieceType Type = XQPieceTypeOf(Position.GetPiece(Square));
+        if (Type == EXQPieceType::Jv || Type == EXQPieceType::Ma || Type == EXQPieceType::Pao || Type == EXQPieceType::Bing)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,565 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQSearch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+// 每搜索这么多个节点检查一次暂停请求，须为2的幂
+#define XQ_PAUSE_CHECK_NODES 256
+
+// 攻击方价值排序（越小越优先用来吃子）
+static const int32 XQAttackerRank[8] = { 0, 6, 2, 2, 3, 4, 3, 1 };
+
+// 先验低于这两个值的安静走法分别少搜两层、一层
+static constexpr float XQPolicyDeepReduction = 0.005f;
+static constexpr float XQPolicyReduction = 0.02f;
+
+void FXQSearch::FPVLine::Set(FXQMove Move, const FPVLine& Child)
+{
+    Moves[0] = Move;
+    Num = 1;
+    for (int32 i = 0; i < Child.Num && Num < XQ_MAX_PLY; i++)
+    {
+        Moves[Num++] = Child.Moves[i];
+    }
+}
+
+const char* FXQSearchStats::GetCsvHeader()
+{
+    return "depth,seldepth,nodes,qnodes,time_ms,iteration_ms,nps,beta_cutoffs,first_move_cutoff_rate,"
+        "reductions,reduction_success_rate,policy_probes,policy_hit_rate";
+}
+
+std::string FXQSearchStats::ToCsvRow() const
+{
+    char Buffer[320];
+    std::snprintf(Buffer, sizeof(Buffer), "%d,%d,%lld,%lld,%lld,%lld,%lld,%lld,%.4f,%lld,%.4f,%lld,%.4f",
+        Depth, SelDepth, static_cast<long long>(Nodes), static_cast<long long>(QNodes), static_cast<long long>(TimeMs),
+        static_cast<long long>(IterationTimeMs), static_cast<long long>(GetNps()), static_cast<long long>(BetaCutoffs), GetFirstMoveCutoffRate(),
+        static_cast<long long>(Reductions), GetReductionSuccessRate(), static_cast<long long>(PolicyProbes), GetPolicyHitRate());
+    return Buffer;
+}
+
+FXQSearch::FXQSearch()
+    : EvalParams(FXQEvalParams::GetDefault())
+    , bStopRequested(false)
+    , bPondering(false)
+    , bPauseRequested(false)
+    , StartTimeMs(0)
+{
+}
+
+FXQSearchResult FXQSearch::Search(const FXQPosition& Root, const FXQSearchLimits& InLimits, const FIterationCallback& OnIteration)
+{
+    Position = Root;
+    Limits = InLimits;
+    bAborted = false;
+    Nodes = 0;
+    SelDepth = 0;
+    Stats = FXQSearchStats();
+    bPondering = Limits.bPonder;
+    StartTimeMs = GetNowMs();
+    for (int32 Ply = 0; Ply < XQ_MAX_PLY; Ply++)
+    {
+        Killers[Ply][0] = FXQMove();
+        Killers[Ply][1] = FXQMove();
+    }
+    PolicyCache.clear();
+
+    FXQSearchResult Result;
+
+    // 根节点走法，首轮按先验排序，之后每轮按上一轮的评分重新排序
+    FXQMoveList RootMoves;
+    Position.GenerateLegalMoves(RootMoves);
+    OrderMoves(RootMoves, 0, Policy != nullptr && Limits.PolicyPlies > 0 ? FetchPolicy(0) : nullptr);
+
+    std::vector<FXQSearchLine> Lines;
+    for (FXQMove Move : RootMoves)
+    {
+        FXQSearchLine Line;
+        Line.Move = Move;
+        Line.PV.push_back(Move);
+        Lines.push_back(Line);
+    }
+
+    if (Lines.empty())
+    {
+        return Result;
+    }
+
+    const int32 MultiPV = std::max(1, std::min(Limits.MultiPV, static_cast<int32>(Lines.size())));
+    const int32 MaxDepth = std::max(1, std::min(Limits.Depth, XQ_MAX_PLY - 1));
+    for (int32 Depth = 1; Depth <= MaxDepth; Depth++)
+    {
+        const int64 IterationStartMs = GetElapsedMs();
+        SelDepth = 0;
+
+        std::vector<FXQSearchLine> IterationLines = Lines;
+        if (!SearchRoot(Depth, MultiPV, IterationLines))
+        {
+            break; // 本轮未完成，沿用上一轮的结果
+        }
+
+        Lines = IterationLines;
+        Result.Depth = Depth;
+        Result.Lines = Lines;
+        Result.Nodes = Nodes;
+        Result.TimeMs = GetElapsedMs();
+
+        Stats.Depth = Depth;
+        Stats.SelDepth = SelDepth;
+        Stats.Nodes = Nodes;
+        Stats.TimeMs = Result.TimeMs;
+        Stats.IterationTimeMs = Result.TimeMs - IterationStartMs;
+        Result.Stats = Stats;
+
+        if (OnIteration)
+        {
+            OnIteration(Result);
+        }
+
+        // 剩余时间不足以完成下一轮迭代
+        if (Limits.MoveTimeMs > 0 && !bPondering && !Limits.bInfinite && Result.TimeMs > Limits.MoveTimeMs / 2)
+        {
+            break;
+        }
+    }
+
+    // 连第一轮都没完成时，至少返回一个合法走法
+    if (Result.Lines.empty())
+    {
+        Result.Lines = Lines;
+    }
+    Result.Nodes = Nodes;
+    Result.TimeMs = GetElapsedMs();
+
+    // 计数包括未完成的那一轮，深度和选择深度仍为最后完成的一轮
+    Stats.Nodes = Nodes;
+    Stats.TimeMs = Result.TimeMs;
+    Result.Stats = Stats;
+    return Result;
+}
+
+void FXQSearch::Stop()
+{
+    std::lock_guard<std::mutex> Lock(PauseMutex);
+    bStopRequested = true;
+    PauseCondition.notify_all();
+}
+
+void FXQSearch::ResetStop()
+{
+    bStopRequested = false;
+}
+
+void FXQSearch::Pause()
+{
+    bPauseRequested = true;
+}
+
+void FXQSearch::Resume()
+{
+    std::lock_guard<std::mutex> Lock(PauseMutex);
+    bPauseRequested = false;
+    PauseCondition.notify_all();
+}
+
+void FXQSearch::WaitWhilePaused()
+{
+    const int64 PauseStartMs = GetNowMs();
+    {
+        std::unique_lock<std::mutex> Lock(PauseMutex);
+        PauseCondition.wait(Lock, [this]()
+        {
+            return !bPauseRequested || bStopRequested || (Limits.CancelFlag != nullptr && Limits.CancelFlag->load());
+        });
+    }
+
+    // 暂停的时间不计入思考时间
+    StartTimeMs += GetNowMs() - PauseStartMs;
+}
+
+void FXQSearch::PonderHit()
+{
+    StartTimeMs = GetNowMs();
+    bPondering = false;
+}
+
+bool FXQSearch::SearchRoot(int32 Depth, int32 MultiPV, std::vector<FXQSearchLine>& Lines)
+{
+    int32 ExactCount = 0;
+    for (size_t i = 0; i < Lines.size(); i++)
+    {
+        FXQSearchLine& Line = Lines[i];
+
+        // 已有K个精确评分时，只需证明其余走法不优于第K个
+        const int32 Alpha = ExactCount >= MultiPV ? Lines[MultiPV - 1].Score : -XQ_INFINITE_SCORE;
+
+        FPVLine ChildPV;
+        Position.MakeMove(Line.Move);
+        const int32 Score = -Negamax(Depth - 1, -XQ_INFINITE_SCORE, -Alpha, 1, ChildPV);
+        Position.UnmakeMove();
+
+        if (bAborted)
+        {
+            return false;
+        }
+
+        Line.Score = Score;
+        Line.bExact = Score > Alpha;
+        if (Line.bExact)
+        {
+            Line.PV.assign(1, Line.Move);
+            Line.PV.insert(Line.PV.end(), ChildPV.Moves, ChildPV.Moves + ChildPV.Num);
+            ExactCount++;
+        }
+
+        // 插入排序：精确评分在前，按分数从高到低
+        for (size_t j = i; j > 0; j--)
+        {
+            const FXQSearchLine& Prev = Lines[j - 1];
+            if (Prev.bExact && !Lines[j].bExact) break;
+            if (Prev.bExact == Lines[j].bExact && Prev.Score >= Lines[j].Score) break;
+            std::swap(Lines[j - 1], Lines[j]);
+        }
+    }
+    return true;
+}
+
+int32 FXQSearch::Negamax(int32 Depth, int32 Alpha, int32 Beta, int32 Ply, FPVLine& PV)
+{
+    PV.Num = 0;
+    if (CheckAbort())
+    {
+        return 0;
+    }
+    SelDepth = std::max(SelDepth, Ply);
+
+    // 重复局面按和棋处理
+    if (Position.GetRepetitionCount() > 0)
+    {
+        return 0;
+    }
+
+    const EXQColor Us = Position.GetSideToMove();
+    const bool bInCheck = Position.IsInCheck(Us);
+
+    // 被将军时延伸一层，避免在地平线处漏掉杀棋
+    if (bInCheck && Ply < XQ_MAX_PLY / 2)
+    {
+        Depth++;
+    }
+
+    if (Depth <= 0 || Ply >= XQ_MAX_PLY - 1)
+    {
+        return Quiescence(Alpha, Beta, Ply);
+    }
+
+    const FPolicyPriors* Priors = Policy != nullptr && Ply < Limits.PolicyPlies ? FetchPolicy(Ply) : nullptr;
+    const bool bReduce = Priors != nullptr && Limits.bPolicyReductions && !bInCheck && Depth >= 3;
+
+    FXQMoveList Moves;
+    float MovePriors[128];
+    Position.GenerateMoves(Moves);
+    OrderMoves(Moves, Ply, Priors, MovePriors);
+
+    FPVLine ChildPV;
+    int32 LegalMoves = 0;
+    int32 BestScore = -XQ_INFINITE_SCORE;
+    for (int32 i = 0; i < Moves.Num; i++)
+    {
+        const FXQMove Move = Moves.Moves[i];
+        if (!Position.MakeMoveIfLegal(Move))
+        {
+            continue;
+        }
+        LegalMoves++;
+
+        const bool bCapture = Position.GetLastCaptured() != 0;
+
+        // 先验很低的安静走法（不将军、不是杀手走法、不是前两步）先用零窗口浅搜，超过Alpha再全深度重搜
+        int32 Reduction = 0;
+        if (bReduce && !bCapture && LegalMoves > 2 && MovePriors[i] < XQPolicyReduction && Move != Killers[Ply][0] && Move != Killers[Ply][1]
+            && !Position.IsInCheck(Position.GetSideToMove()))
+        {
+            Reduction = MovePriors[i] < XQPolicyDeepReduction ? 2 : 1;
+        }
+
+        int32 Score = 0;
+        if (Reduction > 0)
+        {
+            Stats.Reductions++;
+            Score = -Negamax(Depth - 1 - Reduction, -Alpha - 1, -Alpha, Ply + 1, ChildPV);
+            if (!bAborted && Score > Alpha)
+            {
+                Stats.ReductionResearches++;
+                Score = -Negamax(Depth - 1, -Beta, -Alpha, Ply + 1, ChildPV);
+            }
+        }
+        else
+        {
+            Score = -Negamax(Depth - 1, -Beta, -Alpha, Ply + 1, ChildPV);
+        }
+        Position.UnmakeMove();
+
+        if (bAborted)
+        {
+            return 0;
+        }
+
+        if (Score > BestScore)
+        {
+            BestScore = Score;
+            if (Score > Alpha)
+            {
+                Alpha = Score;
+                PV.Set(Move, ChildPV);
+            }
+        }
+
+        if (Alpha >= Beta)
+        {
+            Stats.BetaCutoffs++;
+            if (LegalMoves == 1)
+            {
+                Stats.FirstMoveCutoffs++;
+            }
+            if (!bCapture)
+            {
+                StoreKiller(Move, Ply);
+            }
+            break;
+        }
+    }
+
+    // 无棋可走即告负（象棋中困毙也判负）
+    if (LegalMoves == 0)
+    {
+        return -XQ_MATE_SCORE + Ply;
+    }
+    return BestScore;
+}
+
+int32 FXQSearch::Quiescence(int32 Alpha, int32 Beta, int32 Ply)
+{
+    if (CheckAbort())
+    {
+        return 0;
+    }
+    Stats.QNodes++;
+    SelDepth = std::max(SelDepth, Ply);
+
+    const int32 StandPat = XQEvaluate(Position, Position.GetSideToMove(), EvalParams);
+    if (StandPat >= Beta || Ply >= XQ_MAX_PLY - 1)
+    {
+        return StandPat;
+    }
+    if (StandPat > Alpha)
+    {
+        Alpha = StandPat;
+    }
+
+    FXQMoveList Captures;
+    Position.GenerateMoves(Captures, true);
+    OrderMoves(Captures, Ply);
+
+    for (FXQMove Move : Captures)
+    {
+        if (!Position.MakeMoveIfLegal(Move))
+        {
+            continue;
+        }
+        const int32 Score = -Quiescence(-Beta, -Alpha, Ply + 1);
+        Position.UnmakeMove();
+
+        if (bAborted)
+        {
+            return 0;
+        }
+
+        if (Score > Alpha)
+        {
+            Alpha = Score;
+            if (Alpha >= Beta)
+            {
+                break;
+            }
+        }
+    }
+    return Alpha;
+}
+
+void FXQSearch::OrderMoves(FXQMoveList& Moves, int32 Ply, const FPolicyPriors* Priors, float* OutPriors) const
+{
+    int32 Scores[128];
+    float MovePriors[128];
+    for (int32 i = 0; i < Moves.Num; i++)
+    {
+        const FXQMove Move = Moves.Moves[i];
+        MovePriors[i] = Priors != nullptr ? Priors->Find(Move) : 0.0f;
+        const uint8 Victim = Position.GetPiece(Move.To());
+        if (Victim != 0)
+        {
+            const EXQPieceType Attacker = XQPieceTypeOf(Position.GetPiece(Move.From()));
+            Scores[i] = 1000000 + XQGetPieceValue(XQPieceTypeOf(Victim)) * 10 - XQAttackerRank[static_cast<int32>(Attacker)];
+        }
+        else if (Move == Killers[Ply][0])
+        {
+            Scores[i] = 900000;
+        }
+        else if (Move == Killers[Ply][1])
+        {
+            Scores[i] = 899999;
+        }
+        else
+        {
+            // 安静走法按先验排在杀手走法之后，没有先验时保持生成顺序
+            Scores[i] = static_cast<int32>(MovePriors[i] * 100000.0f);
+        }
+    }
+
+    // 插入排序，走法数量很少
+    for (int32 i = 1; i < Moves.Num; i++)
+    {
+        const FXQMove Move = Moves.Moves[i];
+        const int32 Score = Scores[i];
+        const float Prior = MovePriors[i];
+        int32 j = i;
+        for (; j > 0 && Scores[j - 1] < Score; j--)
+        {
+            Moves.Moves[j] = Moves.Moves[j - 1];
+            Scores[j] = Scores[j - 1];
+            MovePriors[j] = MovePriors[j - 1];
+        }
+        Moves.Moves[j] = Move;
+        Scores[j] = Score;
+        MovePriors[j] = Prior;
+    }
+
+    if (OutPriors != nullptr)
+    {
+        std::copy(MovePriors, MovePriors + Moves.Num, OutPriors);
+    }
+}
+
+float FXQSearch::FPolicyPriors::Find(FXQMove Move) const
+{
+    for (int32 i = 0; i < Moves.Num; i++)
+    {
+        if (Moves.Moves[i] == Move)
+        {
+            return Priors[i];
+        }
+    }
+    return 0.0f;
+}
+
+const FXQSearch::FPolicyPriors* FXQSearch::FetchPolicy(int32 Ply)
+{
+    const bool bChildren = Ply + 1 < Limits.PolicyPlies;
+    const auto It = PolicyCache.find(Position.GetKey());
+    const bool bNew = It == PolicyCache.end();
+    Stats.PolicyProbes++;
+    if (!bNew && (It->second.bChildrenFetched || !bChildren))
+    {
+        Stats.PolicyHits++;
+        return &It->second;
+    }
+
+    // 当前局面（第一次遇到时）和还没有先验的子局面合成一批查询。
+    // 插入可能引起重新散列，It此后失效，只用bNew判断；元素的引用不受影响
+    std::vector<FXQPosition> Positions;
+    std::vector<FPolicyPriors*> Entries;
+    FPolicyPriors& Self = PolicyCache[Position.GetKey()];
+    if (bNew)
+    {
+        Position.GenerateLegalMoves(Self.Moves);
+        if (Self.Moves.Num > 0)
+        {
+            Positions.push_back(Position);
+            Entries.push_back(&Self);
+        }
+    }
+    if (bChildren)
+    {
+        Self.bChildrenFetched = true;
+        Positions.reserve(Positions.size() + Self.Moves.Num);
+        for (FXQMove Move : Self.Moves)
+        {
+            Position.MakeMove(Move);
+            if (PolicyCache.find(Position.GetKey()) == PolicyCache.end())
+            {
+                FPolicyPriors& Child = PolicyCache[Position.GetKey()];
+                Position.GenerateLegalMoves(Child.Moves);
+                if (Child.Moves.Num > 0)
+                {
+                    Positions.push_back(Position);
+                    Entries.push_back(&Child);
+                }
+            }
+            Position.UnmakeMove();
+        }
+    }
+
+    if (!Positions.empty())
+    {
+        std::vector<FXQPolicyQuery> Queries(Positions.size());
+        for (size_t i = 0; i < Positions.size(); i++)
+        {
+            Queries[i].Position = &Positions[i];
+            Queries[i].Moves = &Entries[i]->Moves;
+            Queries[i].Priors = Entries[i]->Priors;
+        }
+        Policy->Evaluate(Queries.data(), static_cast<int32>(Queries.size()));
+    }
+    return &Self;
+}
+
+void FXQSearch::StoreKiller(FXQMove Move, int32 Ply)
+{
+    if (Killers[Ply][0] != Move)
+    {
+        Killers[Ply][1] = Killers[Ply][0];
+        Killers[Ply][0] = Move;
+    }
+}
+
+bool FXQSearch::CheckAbort()
+{
+    if (bAborted)
+    {
+        return true;
+    }
+
+    Nodes++;
+    if ((Nodes & (XQ_PAUSE_CHECK_NODES - 1)) == 0 && bPauseRequested.load(std::memory_order_relaxed))
+    {
+        WaitWhilePaused();
+    }
+
+    if (Limits.Nodes > 0 && Nodes >= Limits.Nodes)
+    {
+        bAborted = true;
+    }
+    else if (bStopRequested.load(std::memory_order_relaxed) || (Limits.CancelFlag != nullptr && Limits.CancelFlag->load(std::memory_order_relaxed)))
+    {
+        bAborted = true;
+    }
+    else if ((Nodes & 1023) == 0 && Limits.MoveTimeMs > 0 && !Limits.bInfinite && !bPondering && GetElapsedMs() >= Limits.MoveTimeMs)
+    {
+        bAborted = true;
+    }
+    return bAborted;
+}
+
+int64 FXQSearch::GetElapsedMs() const
+{
+    return GetNowMs() - StartTimeMs;
+}
+
+int64 FXQSearch::GetNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
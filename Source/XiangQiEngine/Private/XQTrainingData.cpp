@@ -0,0 +1,130 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQTrainingData.h"
+#include "XQFile.h"
+
+uint64 GetXQTrainingRecordKey(const FXQTrainingRecord& Record)
+{
+    // FNV-1a，64位
+    uint64 Hash = 14695981039346656037ull;
+    for (int32 i = 0; i < 32; i++)
+    {
+        Hash = (Hash ^ Record.Position.Slots[i]) * 1099511628211ull;
+    }
+    Hash = (Hash ^ (Record.BestMove & 0xFF)) * 1099511628211ull;
+    Hash = (Hash ^ (Record.BestMove >> 8)) * 1099511628211ull;
+    return Hash;
+}
+
+// 数据文件可能超过2GB，使用64位偏移
+static int64 GetXQFileSize(std::FILE* File)
+{
+#if defined(_WIN32)
+    const int64 Current = _ftelli64(File);
+    _fseeki64(File, 0, SEEK_END);
+    const int64 Size = _ftelli64(File);
+    _fseeki64(File, Current, SEEK_SET);
+#else
+    const int64 Current = static_cast<int64>(ftello(File));
+    fseeko(File, 0, SEEK_END);
+    const int64 Size = static_cast<int64>(ftello(File));
+    fseeko(File, static_cast<off_t>(Current), SEEK_SET);
+#endif
+    return Size;
+}
+
+FXQTrainingFileReader::~FXQTrainingFileReader()
+{
+    Close();
+}
+
+bool FXQTrainingFileReader::Open(const std::string& Path)
+{
+    Close();
+
+    File = OpenXQFile(Path, "rb");
+    if (File == nullptr)
+    {
+        return false;
+    }
+
+    FXQTrainingFileHeader Header;
+    if (std::fread(&Header, sizeof(Header), 1, File) != 1 || Header.Magic != XQ_TRAINING_FILE_MAGIC ||
+        Header.Version != XQ_TRAINING_FILE_VERSION || Header.RecordSize != sizeof(FXQTrainingRecord))
+    {
+        Close();
+        return false;
+    }
+
+    // 由文件大小计算样本数，末尾不完整的样本（写入中断）忽略
+    const int64 DataSize = GetXQFileSize(File) - static_cast<int64>(sizeof(Header));
+    Num = DataSize > 0 ? DataSize / static_cast<int64>(sizeof(FXQTrainingRecord)) : 0;
+    return true;
+}
+
+void FXQTrainingFileReader::Close()
+{
+    if (File != nullptr)
+    {
+        std::fclose(File);
+        File = nullptr;
+    }
+    Num = 0;
+}
+
+int64 FXQTrainingFileReader::Read(FXQTrainingRecord* OutRecords, int64 MaxNum)
+{
+    if (File == nullptr || MaxNum <= 0)
+    {
+        return 0;
+    }
+    return static_cast<int64>(std::fread(OutRecords, sizeof(FXQTrainingRecord), static_cast<size_t>(MaxNum), File));
+}
+
+FXQTrainingFileWriter::~FXQTrainingFileWriter()
+{
+    Close();
+}
+
+bool FXQTrainingFileWriter::Open(const std::string& Path)
+{
+    Close();
+
+    File = OpenXQFile(Path, "wb");
+    if (File == nullptr)
+    {
+        return false;
+    }
+
+    const FXQTrainingFileHeader Header;
+    if (std::fwrite(&Header, sizeof(Header), 1, File) != 1)
+    {
+        Close();
+        return false;
+    }
+    Num = 0;
+    return true;
+}
+
+bool FXQTrainingFileWriter::Write(const FXQTrainingRecord* Records, int64 Count)
+{
+    if (File == nullptr)
+    {
+        return false;
+    }
+    const size_t Written = std::fwrite(Records, sizeof(FXQTrainingRecord), static_cast<size_t>(Count), File);
+    Num += static_cast<int64>(Written);
+    return Written == static_cast<size_t>(Count);
+}
+
+bool FXQTrainingFileWriter::Close()
+{
+    if (File == nullptr)
+    {
+        return true;
+    }
+    const bool bOk = std::fflush(File) == 0;
+    std::fclose(File);
+    File = nullptr;
+    return bOk;
+}
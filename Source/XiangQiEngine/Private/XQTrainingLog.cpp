@@ -0,0 +1,339 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQTrainingLog.h"
+#include "XQFile.h"
+
+#include <cstring>
+
+// 每条记录的前缀：负载长度和校验和
+#define XQ_TRAINING_LOG_PREFIX 8
+
+static uint32 HashXQTrainingLogPayload(const uint8* Data, uint32 Size)
+{
+    // FNV-1a
+    uint32 Hash = 2166136261u;
+    for (uint32 i = 0; i < Size; i++)
+    {
+        Hash = (Hash ^ Data[i]) * 16777619u;
+    }
+    return Hash;
+}
+
+static bool SeekXQTrainingLog(std::FILE* File, int64 Offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(File, Offset, SEEK_SET) == 0;
+#else
+    return fseeko(File, static_cast<off_t>(Offset), SEEK_SET) == 0;
+#endif
+}
+
+static bool WriteXQTrainingLogHeader(std::FILE* File)
+{
+    const FXQTrainingLogHeader Header;
+    return std::fwrite(&Header, sizeof(Header), 1, File) == 1;
+}
+
+static bool WriteXQTrainingLogEntry(std::FILE* File, const FXQTrainingLogEntry& Entry)
+{
+    // 前缀和负载一次写入，进程在写入中途退出时最多留下一条不完整的记录
+    uint8 Buffer[XQ_TRAINING_LOG_PREFIX + sizeof(FXQTrainingLogEntry)];
+    const uint32 Size = sizeof(FXQTrainingLogEntry);
+    std::memcpy(Buffer + XQ_TRAINING_LOG_PREFIX, &Entry, Size);
+    const uint32 Hash = HashXQTrainingLogPayload(Buffer + XQ_TRAINING_LOG_PREFIX, Size);
+    std::memcpy(Buffer, &Size, 4);
+    std::memcpy(Buffer + 4, &Hash, 4);
+    return std::fwrite(Buffer, sizeof(Buffer), 1, File) == 1;
+}
+
+FXQTrainingLogReader::~FXQTrainingLogReader()
+{
+    Close();
+}
+
+bool FXQTrainingLogReader::Open(const std::string& Path)
+{
+    Close();
+
+    File = OpenXQFile(Path, "rb");
+    if (File == nullptr)
+    {
+        return false;
+    }
+
+    FXQTrainingLogHeader Header;
+    if (std::fread(&Header, sizeof(Header), 1, File) != 1 || Header.Magic != XQ_TRAINING_LOG_MAGIC || Header.Version != XQ_TRAINING_LOG_VERSION)
+    {
+        Close();
+        return false;
+    }
+    ValidEnd = sizeof(Header);
+    return true;
+}
+
+void FXQTrainingLogReader::Close()
+{
+    if (File != nullptr)
+    {
+        std::fclose(File);
+        File = nullptr;
+    }
+    ValidEnd = 0;
+}
+
+bool FXQTrainingLogReader::Next(FXQTrainingLogEntry& OutEntry)
+{
+    if (File == nullptr)
+    {
+        return false;
+    }
+
+    uint32 Prefix[2];
+    if (std::fread(Prefix, sizeof(Prefix), 1, File) != 1)
+    {
+        return false;
+    }
+    const uint32 Size = Prefix[0];
+    if (Size < sizeof(FXQTrainingLogEntry) || Size > XQ_TRAINING_LOG_MAX_PAYLOAD)
+    {
+        return false;
+    }
+
+    uint8 Payload[XQ_TRAINING_LOG_MAX_PAYLOAD];
+    if (std::fread(Payload, Size, 1, File) != 1 || HashXQTrainingLogPayload(Payload, Size) != Prefix[1])
+    {
+        return false;
+    }
+
+    std::memcpy(&OutEntry, Payload, sizeof(FXQTrainingLogEntry));
+    ValidEnd += XQ_TRAINING_LOG_PREFIX + Size;
+    return true;
+}
+
+FXQTrainingLog::~FXQTrainingLog()
+{
+    Close();
+}
+
+bool FXQTrainingLog::Open(const std::string& InPath)
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (File != nullptr)
+    {
+        std::fclose(File);
+        File = nullptr;
+    }
+    Path = InPath;
+    Num = 0;
+
+    const int64 FileSize = GetXQFileSize(Path);
+    if (FileSize <= 0)
+    {
+        std::FILE* NewFile = OpenXQFile(Path, "wb");
+        if (NewFile == nullptr)
+        {
+            return false;
+        }
+        const bool bOk = WriteXQTrainingLogHeader(NewFile);
+        std::fclose(NewFile);
+        return bOk && OpenForAppend();
+    }
+
+    // 统计有效记录，不认识的文件不做任何修改
+    FXQTrainingLogReader Reader;
+    if (!Reader.Open(Path))
+    {
+        return false;
+    }
+    FXQTrainingLogEntry Entry;
+    while (Reader.Next(Entry))
+    {
+        Num++;
+    }
+    const int64 ValidEnd = Reader.GetValidEnd();
+    Reader.Close();
+
+    // 截掉上次写入中断留下的半条记录，否则之后追加的记录都读不到
+    if (ValidEnd < FileSize)
+    {
+        if (!ResizeXQFile(Path, ValidEnd))
+        {
+            return false;
+        }
+    }
+    return OpenForAppend();
+}
+
+bool FXQTrainingLog::OpenForAppend()
+{
+    File = OpenXQFile(Path, "ab");
+    return File != nullptr;
+}
+
+void FXQTrainingLog::Close()
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (File != nullptr)
+    {
+        std::fclose(File);
+        File = nullptr;
+    }
+}
+
+bool FXQTrainingLog::IsOpen() const
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return File != nullptr;
+}
+
+bool FXQTrainingLog::Append(const FXQTrainingLogEntry& Entry)
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (File == nullptr || !WriteXQTrainingLogEntry(File, Entry) || std::fflush(File) != 0)
+    {
+        return false;
+    }
+    Num++;
+    return true;
+}
+
+int64 FXQTrainingLog::GetNum() const
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    return Num;
+}
+
+bool FXQTrainingLog::Compact(int64 MaxRecords)
+{
+    if (bCompacting.exchange(true))
+    {
+        return true;
+    }
+
+    struct FCompactingGuard
+    {
+        std::atomic<bool>& Flag;
+        ~FCompactingGuard() { Flag = false; }
+    } Guard{ bCompacting };
+
+    // 第一步：记下当前的记录数和文件长度，之后的追加不受影响
+    int64 SnapshotNum = 0;
+    int64 SnapshotGeneration = 0;
+    std::string LogPath;
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (File == nullptr)
+        {
+            return false;
+        }
+        SnapshotNum = Num;
+        SnapshotGeneration = Generation;
+        LogPath = Path;
+    }
+    if (SnapshotNum <= MaxRecords)
+    {
+        return true;
+    }
+
+    // 第二步：不持有锁，把快照中最后MaxRecords条写到临时文件
+    const std::string TempPath = LogPath + ".tmp";
+    std::FILE* Temp = OpenXQFile(TempPath, "wb");
+    if (Temp == nullptr)
+    {
+        return false;
+    }
+
+    FXQTrainingLogReader Reader;
+    bool bOk = WriteXQTrainingLogHeader(Temp) && Reader.Open(LogPath);
+    const int64 Skip = SnapshotNum - MaxRecords;
+    int64 Index = 0;
+    FXQTrainingLogEntry Entry;
+    while (bOk && Index < SnapshotNum && Reader.Next(Entry))
+    {
+        if (Index++ >= Skip)
+        {
+            bOk = WriteXQTrainingLogEntry(Temp, Entry);
+        }
+    }
+    const int64 SnapshotEnd = Reader.GetValidEnd();
+    Reader.Close();
+    bOk = bOk && Index == SnapshotNum;
+
+    // 第三步：持有锁，补上压缩期间追加的记录后替换原文件
+    std::lock_guard<std::mutex> Lock(Mutex);
+    bOk = bOk && File != nullptr && Generation == SnapshotGeneration && std::fflush(File) == 0;
+    if (bOk && Num > SnapshotNum)
+    {
+        std::FILE* Source = OpenXQFile(LogPath, "rb");
+        bOk = Source != nullptr && SeekXQTrainingLog(Source, SnapshotEnd);
+        uint8 Buffer[1 << 14];
+        size_t Read;
+        while (bOk && (Read = std::fread(Buffer, 1, sizeof(Buffer), Source)) > 0)
+        {
+            bOk = std::fwrite(Buffer, 1, Read, Temp) == Read;
+        }
+        if (Source != nullptr)
+        {
+            std::fclose(Source);
+        }
+    }
+    bOk = std::fclose(Temp) == 0 && bOk;
+
+    if (!bOk)
+    {
+        RemoveXQFile(TempPath);
+        return false;
+    }
+
+    // Windows上不能替换仍被打开的文件
+    std::fclose(File);
+    File = nullptr;
+    if (!RenameXQFile(TempPath, LogPath))
+    {
+        RemoveXQFile(TempPath);
+        OpenForAppend();
+        return false;
+    }
+    Num = MaxRecords + (Num - SnapshotNum);
+    return OpenForAppend();
+}
+
+bool FXQTrainingLog::Clear()
+{
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (File != nullptr)
+    {
+        std::fclose(File);
+        File = nullptr;
+    }
+    if (Path.empty())
+    {
+        return false;
+    }
+
+    Generation++;
+    Num = 0;
+    std::FILE* NewFile = OpenXQFile(Path, "wb");
+    if (NewFile == nullptr)
+    {
+        return false;
+    }
+    const bool bOk = WriteXQTrainingLogHeader(NewFile);
+    std::fclose(NewFile);
+    return bOk && OpenForAppend();
+}
+
+bool FXQTrainingLog::ReadAll(const std::string& Path, const std::function<void(const FXQTrainingLogEntry&)>& Visitor)
+{
+    FXQTrainingLogReader Reader;
+    if (!Reader.Open(Path))
+    {
+        return false;
+    }
+    FXQTrainingLogEntry Entry;
+    while (Reader.Next(Entry))
+    {
+        Visitor(Entry);
+    }
+    return true;
+}
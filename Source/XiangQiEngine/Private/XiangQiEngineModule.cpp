@@ -0,0 +1,5 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, XiangQiEngine);
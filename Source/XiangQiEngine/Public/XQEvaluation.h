@@ -0,0 +1,33 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+#include <string>
+
+class FXQPosition;
+
+// 评估参数：子力价值和位置分表（红方视角，黑方上下翻转使用）
+struct XIANGQIENGINE_API FXQEvalParams
+{
+    int32 Material[8];
+
+    int32 PositionValues[8][XQ_SQUARES];
+
+    // 默认参数，来自xqtune生成的XQTunedEvalParams.h
+    static const FXQEvalParams& GetDefault();
+
+    // 文本格式读写，用于不重新编译就比较调参结果
+    bool LoadFromFile(const std::string& Path);
+
+    bool SaveToFile(const std::string& Path) const;
+};
+
+// 子力价值（按棋子类型）
+XIANGQIENGINE_API int32 XQGetPieceValue(EXQPieceType Type);
+
+/**
+ * 局面评估，返回Color视角的分数
+ */
+XIANGQIENGINE_API int32 XQEvaluate(const FXQPosition& Position, EXQColor Color, const FXQEvalParams& Params = FXQEvalParams::GetDefault());
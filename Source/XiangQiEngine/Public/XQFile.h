@@ -0,0 +1,33 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+/**
+ * 引擎中所有的文件操作都经由这里。路径一律是UTF-8（游戏中由TCHAR_TO_UTF8得到），
+ * Windows上转成宽字符再交给系统，不按ANSI代码页解释，存档路径含中文时也能打开
+ */
+
+// UTF-8路径转成std::filesystem::path，Windows上其native()即宽字符路径
+XIANGQIENGINE_API std::filesystem::path MakeXQFilePath(const std::string& Path);
+
+// 同std::fopen，Mode只含ASCII字符
+XIANGQIENGINE_API std::FILE* OpenXQFile(const std::string& Path, const char* Mode);
+
+// 把缓冲区和已写入的数据刷到磁盘。写临时文件再改名替换时在改名之前调用，断电后不会得到空的或不完整的文件
+XIANGQIENGINE_API bool SyncXQFile(std::FILE* File);
+
+// 重命名，目标已存在时替换
+XIANGQIENGINE_API bool RenameXQFile(const std::string& From, const std::string& To);
+
+XIANGQIENGINE_API bool RemoveXQFile(const std::string& Path);
+
+// 文件不存在或出错时返回-1
+XIANGQIENGINE_API int64 GetXQFileSize(const std::string& Path);
+
+XIANGQIENGINE_API bool ResizeXQFile(const std::string& Path, int64 Size);
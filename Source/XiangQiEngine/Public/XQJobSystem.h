@@ -0,0 +1,202 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+#include "XQPosition.h"
+#include "XQSearch.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 每个工作线程常驻的搜索上下文。搜索对象和局面副本在各次任务之间保留，不再每回合重新分配
+struct FXQSearchContext
+{
+    int32 WorkerIndex = 0;
+
+    FXQSearch Search;
+
+    FXQPosition Position;
+
+    // 当前任务的取消标志，搜索时放进FXQSearchLimits::CancelFlag
+    const std::atomic<bool>* CancelFlag = nullptr;
+
+    bool IsCancelled() const { return CancelFlag != nullptr && CancelFlag->load(std::memory_order_relaxed); }
+};
+
+// 一个任务的共享状态，提交方的future和工作线程各持一份
+class XIANGQIENGINE_API FXQJobStateBase
+{
+public:
+    virtual ~FXQJobStateBase() = default;
+
+    // 请求取消（线程安全）。未开始的任务不再执行，执行中的搜索在下一个节点停止，暂停中的也会被唤醒
+    void Cancel();
+
+    bool IsCancelled() const { return bCancelled.load(); }
+
+    const std::atomic<bool>& GetCancelFlag() const { return bCancelled; }
+
+    bool IsReady() const;
+
+    void Wait() const;
+
+    // 在工作线程中写入结果之后调用
+    void MarkReady();
+
+    // 工作线程开始和结束执行时设置，Cancel借此唤醒暂停中的搜索
+    void SetRunningSearch(FXQSearch* InSearch);
+
+private:
+    std::atomic<bool> bCancelled{ false };
+
+    FXQSearch* RunningSearch = nullptr;
+
+    mutable std::mutex Mutex;
+
+    mutable std::condition_variable ReadyCondition;
+
+    bool bReady = false;
+};
+
+template <typename T>
+class TXQJobState : public FXQJobStateBase
+{
+public:
+    T Result{};
+};
+
+/**
+ * 任务结果。可以复制，所有副本共享同一个状态；默认构造的future无效
+ */
+template <typename T>
+class TXQJobFuture
+{
+public:
+    TXQJobFuture() = default;
+
+    explicit TXQJobFuture(std::shared_ptr<TXQJobState<T>> InState)
+        : State(std::move(InState))
+    {
+    }
+
+    bool IsValid() const { return State != nullptr; }
+
+    bool IsReady() const { return State != nullptr && State->IsReady(); }
+
+    // 已提交且尚未完成
+    bool IsRunning() const { return State != nullptr && !State->IsReady(); }
+
+    bool IsCancelled() const { return State != nullptr && State->IsCancelled(); }
+
+    void Cancel() const
+    {
+        if (State)
+        {
+            State->Cancel();
+        }
+    }
+
+    void Wait() const
+    {
+        if (State)
+        {
+            State->Wait();
+        }
+    }
+
+    // 等待完成并返回结果，被取消而未执行的任务得到默认值
+    const T& Get() const
+    {
+        State->Wait();
+        return State->Result;
+    }
+
+    void Reset() { State.reset(); }
+
+private:
+    std::shared_ptr<TXQJobState<T>> State;
+};
+
+/**
+ * 常驻的搜索任务线程池：工作线程在构造时全部创建，各自持有一个FXQSearchContext，
+ * 任务按提交顺序由空闲的线程取走执行。析构时取消未完成的任务并等待线程退出
+ */
+class XIANGQIENGINE_API FXQJobSystem
+{
+public:
+    explicit FXQJobSystem(int32 InNumWorkers);
+
+    ~FXQJobSystem();
+
+    FXQJobSystem(const FXQJobSystem&) = delete;
+
+    FXQJobSystem& operator=(const FXQJobSystem&) = delete;
+
+    int32 GetNumWorkers() const { return static_cast<int32>(Workers.size()); }
+
+    /**
+     * 提交一个任务。Job在工作线程中执行；OnComplete随后在同一线程调用，
+     * 任务被取消时也会调用，可由future的IsCancelled区分
+     */
+    template <typename T>
+    TXQJobFuture<T> Submit(std::function<T(FXQSearchContext&)> Job, std::function<void(const TXQJobFuture<T>&)> OnComplete = nullptr)
+    {
+        std::shared_ptr<TXQJobState<T>> State = std::make_shared<TXQJobState<T>>();
+        Enqueue(State, [State, Job = std::move(Job), OnComplete = std::move(OnComplete)](FXQSearchContext& Context)
+        {
+            if (!State->IsCancelled())
+            {
+                State->Result = Job(Context);
+            }
+            State->MarkReady();
+            if (OnComplete)
+            {
+                OnComplete(TXQJobFuture<T>(State));
+            }
+        });
+        return TXQJobFuture<T>(State);
+    }
+
+    // 取消所有排队中和执行中的任务
+    void CancelAll();
+
+    // 暂停所有工作线程的搜索（线程安全），之后开始的任务也在第一次检查时停下，直到ResumeAll
+    void PauseAll();
+
+    void ResumeAll();
+
+private:
+    struct FQueuedJob
+    {
+        std::shared_ptr<FXQJobStateBase> State;
+
+        std::function<void(FXQSearchContext&)> Task;
+    };
+
+    void Enqueue(std::shared_ptr<FXQJobStateBase> State, std::function<void(FXQSearchContext&)> Task);
+
+    void WorkerLoop(int32 Index);
+
+private:
+    std::vector<std::unique_ptr<FXQSearchContext>> Contexts;
+
+    std::vector<std::thread> Workers;
+
+    std::mutex Mutex;
+
+    std::condition_variable WorkCondition;
+
+    std::deque<FQueuedJob> Queue;
+
+    // 各工作线程正在执行的任务，CancelAll用
+    std::vector<std::shared_ptr<FXQJobStateBase>> Running;
+
+    bool bExit = false;
+};
@@ -0,0 +1,83 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQMLPolicy.h"
+#include "XQMappedFile.h"
+#include "XQTrainingData.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class FXQPosition;
+
+// 神经网络输入：每个格子16个特征（红方7种棋子、黑方7种棋子，各留一个空位）
+#define XQ_ML_PIECE_FEATURES 16
+#define XQ_ML_NUM_FEATURES (XQ_SQUARES * XQ_ML_PIECE_FEATURES)
+
+// 一个局面最多32个子，即最多32个激活的特征
+#define XQ_ML_MAX_ACTIVE_FEATURES 32
+
+// 格子上某方某种棋子对应的特征下标
+inline int32 XQMLFeatureIndex(int32 Square, EXQColor Color, EXQPieceType Type)
+{
+    return Square * XQ_ML_PIECE_FEATURES + static_cast<int32>(Color) * 8 + static_cast<int32>(Type) - 1;
+}
+
+// 把局面展开为XQ_ML_NUM_FEATURES个0/1特征
+XIANGQIENGINE_API void XQMLEncodeFeatures(const FXQPosition& Position, float* OutFeatures);
+
+XIANGQIENGINE_API void XQMLEncodeFeatures(const FXQPackedPosition& Position, float* OutFeatures);
+
+// 局面中值为1的特征下标，OutIndices至少XQ_ML_MAX_ACTIVE_FEATURES个，返回个数
+XIANGQIENGINE_API int32 XQMLEncodeActiveFeatures(const FXQPosition& Position, uint16* OutIndices);
+
+XIANGQIENGINE_API int32 XQMLEncodeActiveFeatures(const FXQPackedPosition& Position, uint16* OutIndices);
+
+/**
+ * 内存映射的训练集：由若干个XQTrainingData格式的文件组成，样本保持40字节的紧凑形式，
+ * 训练时按小批量展开到调用方复用的缓冲区，内存占用与样本数无关
+ */
+class XIANGQIENGINE_API FXQMLDataset
+{
+public:
+    // 映射一个数据文件，格式不对时返回false
+    bool AddFile(const std::string& Path);
+
+    // 复制一段内存中的样本（例如刚从训练日志读出的新样本）
+    void AddRecords(const FXQTrainingRecord* Records, int64 Count);
+
+    void Close();
+
+    int64 GetNum() const { return Num; }
+
+    const FXQTrainingRecord& GetRecord(int64 Index) const;
+
+    // 第Index条样本的稳定键（GetXQTrainingRecordKey），划分验证集用
+    uint64 GetRecordKey(int64 Index) const { return GetXQTrainingRecordKey(GetRecord(Index)); }
+
+    // 展开Indices指定的样本：OutFeatures为Count行XQ_ML_NUM_FEATURES列，OutLabels为走法的策略输出下标
+    void ExpandBatch(const int64* Indices, int32 Count, float* OutFeatures, int32* OutLabels) const;
+
+    // 稀疏展开：OutFeatures至少Count * XQ_ML_MAX_ACTIVE_FEATURES个，第i个样本的特征为[OutOffsets[i], OutOffsets[i + 1])
+    void ExpandBatch(const int64* Indices, int32 Count, uint16* OutFeatures, int32* OutOffsets, int32* OutLabels) const;
+
+private:
+    struct FFile
+    {
+        std::unique_ptr<FXQMappedFile> Mapping;
+
+        std::vector<FXQTrainingRecord> Storage; // 内存中的样本，与Mapping只有一个
+
+        const FXQTrainingRecord* Records = nullptr;
+
+        int64 First = 0;    // 第一条样本在整个数据集中的下标
+
+        int64 Num = 0;
+    };
+
+    std::vector<FFile> Files;
+
+    int64 Num = 0;
+};
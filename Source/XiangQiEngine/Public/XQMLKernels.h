@@ -0,0 +1,38 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+// 神经网络使用的稠密矩阵运算，矩阵均为行主序且连续存放。
+// 第一次调用时按CPU选择AVX2/SSE（x86）或NEON（ARM64）实现，其他平台使用标量实现
+
+// 当前使用的实现："avx2"、"sse"、"neon"或"scalar"
+XIANGQIENGINE_API const char* XQMLGetKernelName();
+
+// 强制使用标量实现（用于对比结果和性能）
+XIANGQIENGINE_API void XQMLForceScalarKernels(bool bForce);
+
+// 点积
+XIANGQIENGINE_API float XQMLDot(const float* A, const float* B, int32 Num);
+
+// 8位整数点积，用于量化推理（A、B的取值在[-127, 127]内）
+XIANGQIENGINE_API int32 XQMLDotInt8(const int8* A, const int8* B, int32 Num);
+
+// Y += X，用于量化网络的稀疏第一层
+XIANGQIENGINE_API void XQMLAddInt8(int32* Y, const int8* X, int32 Num);
+
+// Y += Alpha * X
+XIANGQIENGINE_API void XQMLAxpy(float* Y, float Alpha, const float* X, int32 Num);
+
+// C[N] = B[N x K] * A[K]，单个样本的前向传播
+XIANGQIENGINE_API void XQMLGemv(int32 N, int32 K, const float* A, const float* B, float* C);
+
+// C[M x N] = A[M x K] * B[N x K]^T，用于前向传播（B为[输出][输入]的权重）
+XIANGQIENGINE_API void XQMLGemmABt(int32 M, int32 N, int32 K, const float* A, const float* B, float* C);
+
+// C[M x N] += A[K x M]^T * B[K x N]，用于累加权重梯度
+XIANGQIENGINE_API void XQMLGemmAtB(int32 M, int32 N, int32 K, const float* A, const float* B, float* C);
+
+// C[M x N] = A[M x K] * B[K x N]，用于把误差传回上一层
+XIANGQIENGINE_API void XQMLGemmAB(int32 M, int32 N, int32 K, const float* A, const float* B, float* C);
@@ -0,0 +1,30 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQMLQuantized.h"
+#include "XQSearch.h"
+
+/**
+ * 用量化策略网络给搜索提供走法先验。
+ * 输出层只计算合法走法对应的行，一批查询共用一个缓冲区
+ */
+class XIANGQIENGINE_API FXQMLMovePolicy : public FXQMovePolicy
+{
+public:
+    // 不持有网络，调用方保证搜索期间网络有效
+    explicit FXQMLMovePolicy(const FXQMLQuantizedNetwork* InNetwork);
+
+    virtual void Evaluate(const FXQPolicyQuery* Queries, int32 Count) override;
+
+private:
+    const FXQMLQuantizedNetwork* Network = nullptr;
+
+    FXQMLQuantizedScratch Scratch;
+
+    std::vector<int32> Labels;
+
+    std::vector<float> Logits;
+
+    std::vector<float> Probabilities;
+};
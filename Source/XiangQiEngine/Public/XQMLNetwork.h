@@ -0,0 +1,169 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQMLWorkerPool.h"
+
+#include <memory>
+#include <vector>
+
+// 全连接层，权重按[输出][输入]行主序连续存放；
+// 第一层的输入是稀疏的0/1特征，权重按[输入][输出]存放，每个激活的特征对应连续的一行
+struct FXQMLLayer
+{
+    int32 InputSize = 0;
+
+    int32 OutputSize = 0;
+
+    std::vector<float> Weights;
+
+    std::vector<float> Biases;
+};
+
+// 稀疏的0/1输入：第i个样本激活的特征为Indices[Offsets[i], Offsets[i + 1])
+struct FXQMLSparseInput
+{
+    const uint16* Indices = nullptr;
+
+    const int32* Offsets = nullptr;
+};
+
+/**
+ * 全连接策略网络：隐藏层使用ReLU，输出层使用Softmax。
+ * 一次前向传播处理一整个小批量，第一层是激活特征对应的权重行之和，之后每层是一次矩阵乘法
+ */
+class XIANGQIENGINE_API FXQMLNetwork
+{
+public:
+    // 按层大小（输入、隐藏层……、输出）初始化，权重使用Xavier均匀分布
+    void Initialize(const std::vector<int32>& LayerSizes, uint64 Seed);
+
+    // 由已有权重构建，层之间大小不匹配时返回false
+    bool SetLayers(std::vector<FXQMLLayer>&& InLayers);
+
+    void Clear() { Layers.clear(); }
+
+    bool IsEmpty() const { return Layers.empty(); }
+
+    int32 GetNumLayers() const { return static_cast<int32>(Layers.size()); }
+
+    const FXQMLLayer& GetLayer(int32 Index) const { return Layers[Index]; }
+
+    FXQMLLayer& GetLayer(int32 Index) { return Layers[Index]; }
+
+    int32 GetInputSize() const { return Layers.empty() ? 0 : Layers.front().InputSize; }
+
+    int32 GetOutputSize() const { return Layers.empty() ? 0 : Layers.back().OutputSize; }
+
+    // 最宽一层的神经元数
+    int32 GetMaxLayerSize() const;
+
+    // 推理：Input为Count个样本，Output为Count行的概率分布，Scratch由调用方复用
+    void Forward(const FXQMLSparseInput& Input, int32 Count, float* Output, std::vector<float>& Scratch) const;
+
+    // 同Forward，但输出层不做Softmax，由调用方只在合法走法上归一化
+    void ForwardLogits(const FXQMLSparseInput& Input, int32 Count, float* Output, std::vector<float>& Scratch) const;
+
+    // 单层前向：Output = Input * W^T + B，bReLU为true时再取ReLU
+    static void ForwardLayer(const FXQMLLayer& Layer, const float* Input, int32 Count, float* Output, bool bReLU);
+
+    // 第一层前向：Output = 激活特征的权重行之和 + B，bReLU为true时再取ReLU
+    static void ForwardSparseLayer(const FXQMLLayer& Layer, const FXQMLSparseInput& Input, int32 Count, float* Output, bool bReLU);
+
+    // 按行做Softmax
+    static void Softmax(float* Data, int32 Count, int32 Size);
+
+private:
+    std::vector<FXQMLLayer> Layers;
+};
+
+enum class EXQMLOptimizer : uint8
+{
+    SGD,        // 带动量的随机梯度下降
+    Adam
+};
+
+struct FXQMLOptimizerSettings
+{
+    EXQMLOptimizer Type = EXQMLOptimizer::Adam;
+
+    float LearningRate = 0.001f;
+
+    float Momentum = 0.9f;      // SGD
+
+    float Beta1 = 0.9f;         // Adam
+
+    float Beta2 = 0.999f;
+
+    float Epsilon = 1e-8f;
+
+    float WeightDecay = 0.0f;   // L2正则
+};
+
+/**
+ * 小批量训练：激活值、误差和梯度缓冲区按最大批大小预先分配，
+ * 每个小批量的前向和反向传播都是整层的矩阵乘法，之后做一次优化器更新。
+ * 多线程时小批量按样本均分给各线程，各自累加梯度后按线程顺序归约，
+ * 同样的线程数下结果与调度无关
+ */
+class XIANGQIENGINE_API FXQMLTrainer
+{
+public:
+    // NumThreads包括调用线程，每个线程至少分到8个样本
+    FXQMLTrainer(FXQMLNetwork& InNetwork, const FXQMLOptimizerSettings& InSettings, int32 InMaxBatchSize, int32 InNumThreads = 1);
+
+    // 训练一个小批量，Labels为输出类别下标，返回平均交叉熵；OutCorrect返回预测正确的样本数
+    float TrainBatch(const FXQMLSparseInput& Input, const int32* Labels, int32 Count, int32* OutCorrect = nullptr);
+
+    int32 GetMaxBatchSize() const { return MaxBatchSize; }
+
+    int32 GetNumThreads() const { return static_cast<int32>(Shards.size()); }
+
+private:
+    // 一个线程负责的一段样本及其缓冲区
+    struct FShard
+    {
+        int32 Begin = 0;
+
+        int32 Count = 0;
+
+        // 每层的输出（激活后）和对该层输出的误差，均为[最大样本数 x OutputSize]
+        std::vector<std::vector<float>> Activations;
+
+        std::vector<std::vector<float>> Deltas;
+
+        // 本段样本的权重和偏置梯度
+        std::vector<std::vector<float>> WeightGradients;
+
+        std::vector<std::vector<float>> BiasGradients;
+
+        double Loss = 0.0;
+
+        int32 Correct = 0;
+    };
+
+    // 前向、反向传播一段样本，TotalCount为整个小批量的样本数（梯度按它取平均）
+    void TrainShard(FShard& Shard, const FXQMLSparseInput& Input, const int32* Labels, int32 TotalCount);
+
+    // 把各段梯度按顺序加到第0段，并更新参数，Index线程负责每个参数数组的第Index份
+    void ReduceAndApply(int32 Index);
+
+private:
+    FXQMLNetwork& Network;
+
+    FXQMLOptimizerSettings Settings;
+
+    int32 MaxBatchSize = 0;
+
+    int64 Step = 0;
+
+    std::vector<FShard> Shards;
+
+    // 优化器的一阶、二阶矩
+    std::vector<std::vector<float>> WeightMoments[2];
+
+    std::vector<std::vector<float>> BiasMoments[2];
+
+    // 常驻的工作线程，每个小批量唤醒两次（传播、归约更新）
+    std::unique_ptr<FXQMLWorkerPool> Pool;
+};
@@ -0,0 +1,18 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+// 策略输出：空棋盘上任意棋子几何上可能的走法（同行同列、马步、士和象在己方的斜线），
+// 按（起点，终点）排序编号，共2086种
+#define XQ_ML_NUM_MOVES 2086
+
+// 走法的输出下标，不是几何上可能的走法时返回-1
+XIANGQIENGINE_API int32 XQMLMoveLabel(FXQMove Move);
+
+// 输出下标对应的走法
+XIANGQIENGINE_API FXQMove XQMLLabelMove(int32 Label);
+
+// 只在Labels指定的输出（合法走法）上做Softmax：OutProbabilities[i]为Labels[i]的概率
+XIANGQIENGINE_API void XQMLMaskedSoftmax(const float* Logits, const int32* Labels, int32 Num, float* OutProbabilities);
@@ -0,0 +1,135 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQMappedFile.h"
+#include "XQMLNetwork.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#define XQ_ML_QUANTIZED_MAGIC 0x4E4E5158u // "XQNN"
+#define XQ_ML_QUANTIZED_VERSION 2
+
+// 层描述的Flags：权重按[输入][输出]存放（第一层，输入为稀疏特征）
+#define XQ_ML_QUANTIZED_INPUT_MAJOR 1u
+
+// 量化模型文件头，后面紧跟NumLayers个层描述，之后是各层数据，小端序
+struct FXQMLQuantizedFileHeader
+{
+    uint32 Magic = XQ_ML_QUANTIZED_MAGIC;
+
+    uint32 Version = XQ_ML_QUANTIZED_VERSION;
+
+    uint32 NumLayers = 0;
+
+    uint32 Reserved = 0;
+
+    uint64 FileSize = 0;
+};
+
+// 层描述，偏移量从文件开头算起，按64字节对齐
+struct FXQMLQuantizedLayerDesc
+{
+    int32 InputSize = 0;
+
+    int32 OutputSize = 0;
+
+    int32 Stride = 0;           // 每行权重的字节数，行长向上取整到32
+
+    uint32 Flags = 0;
+
+    uint64 WeightOffset = 0;    // int8[OutputSize][Stride]，XQ_ML_QUANTIZED_INPUT_MAJOR时为int8[InputSize][Stride]
+
+    uint64 ScaleOffset = 0;     // float[OutputSize]，每行的量化比例
+
+    uint64 BiasOffset = 0;      // float[OutputSize]
+};
+
+static_assert(sizeof(FXQMLQuantizedFileHeader) == 24, "FXQMLQuantizedFileHeader layout is part of the file format");
+static_assert(sizeof(FXQMLQuantizedLayerDesc) == 40, "FXQMLQuantizedLayerDesc layout is part of the file format");
+
+// 推理时复用的缓冲区
+struct FXQMLQuantizedScratch
+{
+    std::vector<float> Values;
+
+    std::vector<int8> Quantized;
+
+    std::vector<int32> Accumulators;
+};
+
+/**
+ * int8量化的策略网络，只用于推理：每个输出神经元的权重共用一个比例。
+ * 第一层把激活特征对应的int8权重行累加到32位；之后每层的输入在运行时按整个向量量化，
+ * 点积用8位整数累加到32位。
+ * 模型文件的布局与内存中相同，加载时映射文件后直接使用，不逐个反序列化
+ */
+class XIANGQIENGINE_API FXQMLQuantizedNetwork
+{
+public:
+    // 由训练好的浮点网络量化
+    bool Quantize(const FXQMLNetwork& Network);
+
+    bool Save(const std::string& Path) const;
+
+    // 映射模型文件，格式或版本不对时返回false
+    bool Load(const std::string& Path);
+
+    // 使用已映射文件中从Offset开始的一段（模型包中的量化网络），与其他使用者共享映射
+    bool Load(std::shared_ptr<const FXQMappedFile> InMapping, int64 Offset, int64 InSize);
+
+    void Clear();
+
+    bool IsEmpty() const { return Layers.empty(); }
+
+    int32 GetInputSize() const { return Layers.empty() ? 0 : Layers.front().InputSize; }
+
+    int32 GetOutputSize() const { return Layers.empty() ? 0 : Layers.back().OutputSize; }
+
+    // 模型文件的内容，与Save写出的相同
+    const uint8* GetData() const { return Data; }
+
+    int64 GetDataSize() const { return Size; }
+
+    // 单个样本的前向传播，Features为激活的输入特征，输出层不做Softmax
+    void ForwardLogits(const uint16* Features, int32 NumFeatures, float* Output, FXQMLQuantizedScratch& Scratch) const;
+
+    // 同ForwardLogits，但输出层只计算Rows指定的输出，Output[i]对应Rows[i]。
+    // 策略头有两千多个输出而一个局面只有几十个合法走法，搜索中用这个
+    void ForwardLogits(const uint16* Features, int32 NumFeatures, const int32* Rows, int32 NumRows, float* Output, FXQMLQuantizedScratch& Scratch) const;
+
+private:
+    struct FLayer
+    {
+        int32 InputSize = 0;
+
+        int32 OutputSize = 0;
+
+        int32 Stride = 0;
+
+        bool bInputMajor = false;
+
+        const int8* Weights = nullptr;
+
+        const float* Scales = nullptr;
+
+        const float* Biases = nullptr;
+    };
+
+    // 校验数据并建立各层的指针
+    bool Bind(const uint8* InData, int64 InSize);
+
+private:
+    // 量化得到的模型数据，或者映射的模型文件，二者只有一个
+    std::vector<uint64> Storage;
+
+    std::shared_ptr<const FXQMappedFile> Mapping;
+
+    const uint8* Data = nullptr;
+
+    int64 Size = 0;
+
+    std::vector<FLayer> Layers;
+};
@@ -0,0 +1,335 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+#include <vector>
+
+class FXQMLWorkerPool;
+
+// 每个特征最多的桶数（桶号用uint8保存）
+#define XQ_ML_TREE_MAX_BINS 64
+
+#define XQ_ML_TREE_MAGIC 0x54445158 // "XQDT"
+#define XQ_ML_TREE_VERSION 1
+
+#define XQ_ML_FOREST_MAGIC 0x46525158 // "XQRF"
+#define XQ_ML_FOREST_VERSION 1
+
+/**
+ * 决策树训练数据：特征先分桶，样本按CSR只保存不在0号桶的特征及其桶号。
+ * 默认每个特征都是0/1特征（两个桶，分界0.5），棋盘特征因此每个样本只有三十来项
+ */
+class XIANGQIENGINE_API FXQMLTreeData
+{
+public:
+    void Reset(int32 InNumFeatures, int32 InNumClasses);
+
+    // 把某个特征改为多桶特征：Edges为升序分界值，值<=Edges[b]的落在b号桶（或更低）
+    void SetFeatureBins(int32 Feature, const float* Edges, int32 NumEdges);
+
+    // Bins为nullptr时所有特征都在1号桶
+    void AddSample(const uint16* Features, const uint8* Bins, int32 NumEntries, int32 Label);
+
+    void Reserve(int32 NumSamples, int64 NumEntries);
+
+    int32 GetNum() const { return static_cast<int32>(Labels.size()); }
+
+    int32 GetNumFeatures() const { return NumFeatures; }
+
+    int32 GetNumClasses() const { return NumClasses; }
+
+    int32 GetLabel(int32 Sample) const { return Labels[Sample]; }
+
+    int32 GetNumEntries(int32 Sample) const { return Offsets[Sample + 1] - Offsets[Sample]; }
+
+    const uint16* GetFeatures(int32 Sample) const { return Features.data() + Offsets[Sample]; }
+
+    const uint8* GetBins(int32 Sample) const { return Bins.data() + Offsets[Sample]; }
+
+    // 样本在某个特征上的桶号
+    int32 GetBin(int32 Sample, int32 Feature) const;
+
+    // 样本在该特征上的值是否<=Threshold（Threshold为该特征的某个分界）
+    bool IsBelow(int32 Sample, int32 Feature, float Threshold) const;
+
+    int32 GetNumBins(int32 Feature) const { return EdgeOffsets[Feature + 1] - EdgeOffsets[Feature] + 1; }
+
+    // 所有特征的分界总数，也就是候选划分的总数
+    int32 GetNumEdges() const { return EdgeOffsets[NumFeatures]; }
+
+    // 第一个分界在分界表中的位置
+    int32 GetEdgeOffset(int32 Feature) const { return EdgeOffsets[Feature]; }
+
+    float GetEdge(int32 Feature, int32 Bin) const { return Edges[EdgeOffsets[Feature] + Bin]; }
+
+private:
+    int32 NumFeatures = 0;
+
+    int32 NumClasses = 0;
+
+    std::vector<int32> Offsets = { 0 };
+
+    std::vector<uint16> Features;
+
+    std::vector<uint8> Bins;
+
+    std::vector<int32> Labels;
+
+    std::vector<int32> EdgeOffsets;
+
+    std::vector<float> Edges;
+};
+
+// 先序排列的节点：左孩子紧跟在父节点之后，只记录右孩子位置，
+// 文件中的节点数组与内存中完全相同
+struct FXQMLTreeNode
+{
+    // 小于0表示叶子
+    int32 Feature = -1;
+
+    // 特征值<=Threshold走左边
+    float Threshold = 0.0f;
+
+    // 内部节点：右孩子的下标；叶子：第一条预测在预测池中的位置
+    int32 Child = 0;
+
+    // 叶子的预测条数
+    int32 Count = 0;
+
+    bool IsLeaf() const { return Feature < 0; }
+};
+
+// 叶子中的一个类别及其概率，同一叶子的各条按概率从大到小排列
+struct FXQMLTreeLeafEntry
+{
+    int32 Label = 0;
+
+    float Probability = 0.0f;
+};
+
+static_assert(sizeof(FXQMLTreeNode) == 16, "FXQMLTreeNode is written to disk");
+static_assert(sizeof(FXQMLTreeLeafEntry) == 8, "FXQMLTreeLeafEntry is written to disk");
+
+// 文件头之后依次是NumNodes个节点和NumLeafEntries条叶子预测
+struct FXQMLTreeFileHeader
+{
+    uint32 Magic = XQ_ML_TREE_MAGIC;
+
+    uint32 Version = XQ_ML_TREE_VERSION;
+
+    int32 NumFeatures = 0;
+
+    int32 NumClasses = 0;
+
+    int32 NumNodes = 0;
+
+    int32 NumLeafEntries = 0;
+};
+
+static_assert(sizeof(FXQMLTreeFileHeader) == 24, "FXQMLTreeFileHeader layout changed");
+
+// 扁平的决策树：节点数组加一个连续的叶子预测池
+struct XIANGQIENGINE_API FXQMLTree
+{
+    std::vector<FXQMLTreeNode> Nodes;
+
+    std::vector<FXQMLTreeLeafEntry> LeafEntries;
+
+    int32 NumFeatures = 0;
+
+    int32 NumClasses = 0;
+
+    void Clear();
+
+    bool IsEmpty() const { return Nodes.empty(); }
+
+    // 稠密特征，返回叶子节点下标
+    int32 FindLeaf(const float* Features) const;
+
+    // 训练数据中的样本
+    int32 FindLeaf(const FXQMLTreeData& Data, int32 Sample) const;
+
+    // Count个样本，每个NumFeatures个特征
+    void FindLeaves(const float* Features, int32 Count, int32* OutLeaves) const;
+
+    // 把叶子的预测乘以Weight加到OutDistribution（NumClasses个）
+    void AddLeafPrediction(int32 Leaf, float Weight, float* OutDistribution) const;
+
+    // OutDistributions为Count*NumClasses，先清零再填入
+    void PredictBatch(const float* Features, int32 Count, float* OutDistributions) const;
+
+    // 追加到Out末尾
+    void Serialize(std::vector<uint8>& Out) const;
+
+    // 校验结构后读入，返回读取的字节数，失败返回0
+    int64 Deserialize(const uint8* Data, int64 Size);
+};
+
+struct FXQMLTreeSettings
+{
+    int32 MaxDepth = 10;
+
+    int32 MinSamplesSplit = 2;
+
+    int32 MinSamplesLeaf = 1;
+
+    // 叶子最多保留的类别数，其余的概率舍去
+    int32 MaxLeafLabels = 64;
+
+    // 每个节点随机抽取的候选特征比例（随机森林用），1表示全部
+    float FeatureFraction = 1.0f;
+
+    uint64 Seed = 0x9E3779B97F4A7C15ull;
+};
+
+// 文件头之后依次是NumTrees棵树，每棵以FXQMLTreeFileHeader开头
+struct FXQMLForestFileHeader
+{
+    uint32 Magic = XQ_ML_FOREST_MAGIC;
+
+    uint32 Version = XQ_ML_FOREST_VERSION;
+
+    int32 NumTrees = 0;
+
+    int32 Reserved = 0;
+};
+
+static_assert(sizeof(FXQMLForestFileHeader) == 16, "FXQMLForestFileHeader layout changed");
+
+/**
+ * 直方图法建树：节点的样本是一个下标数组中的一段，整体按标签排好序，
+ * 划分时稳定地原地分成左右两段，子节点仍按标签有序。
+ * 大节点按标签把样本分给各线程，逐个标签统计直方图，累加出按基尼不纯度计算增益所需的平方和；
+ * 各线程的累加量相加后，候选特征再按线程分段评估
+ */
+class XIANGQIENGINE_API FXQMLTreeBuilder
+{
+public:
+    // Pool为nullptr时单线程
+    FXQMLTreeBuilder(const FXQMLTreeData& InData, const FXQMLTreeSettings& InSettings, FXQMLWorkerPool* InPool = nullptr);
+
+    // Samples允许重复（自助采样）
+    void Build(const int32* Samples, int32 Num, FXQMLTree& OutTree);
+
+private:
+    struct FSplit
+    {
+        double Score = 0.0;
+
+        int32 Feature = -1;
+
+        int32 Bin = 0;
+    };
+
+    // 每个线程的直方图和累加量
+    struct FThreadState
+    {
+        // [特征][桶]的计数，只在一个标签内有效
+        std::vector<int32> Counts;
+
+        std::vector<int32> Touched;
+
+        // 按分界累加：右侧平方和、右侧与整体的交叉项、右侧样本数
+        std::vector<double> RightSquares;
+
+        std::vector<double> CrossTerms;
+
+        std::vector<int32> RightCounts;
+
+        FSplit Best;
+
+        // 分给该线程的样本段
+        int32 Begin = 0;
+
+        int32 End = 0;
+    };
+
+    void BuildNode(int32 Begin, int32 End, int32 Depth, FXQMLTree& Tree);
+
+    FSplit FindBestSplit(int32 Begin, int32 End);
+
+    void AccumulateHistograms(int32 Begin, int32 End, FThreadState& State) const;
+
+    // 先把各线程在这段特征上的累加量加到0号线程，再评估
+    void EvaluateFeatures(int32 Num, int32 FirstFeature, int32 LastFeature, double TotalSquares, int32 NumThreads, FSplit& OutBest);
+
+    void Partition(int32 Begin, int32 End, int32 Feature, int32 Bin, int32& OutMiddle);
+
+    void MakeLeaf(int32 Begin, int32 End, FXQMLTree& Tree);
+
+    void SampleCandidates();
+
+private:
+    const FXQMLTreeData& Data;
+
+    FXQMLTreeSettings Settings;
+
+    FXQMLWorkerPool* Pool = nullptr;
+
+    std::vector<FThreadState> States;
+
+    // 节点样本（按标签有序）和划分用的临时区
+    std::vector<int32> Indices;
+
+    std::vector<int32> Scratch;
+
+    // 当前节点的候选特征
+    std::vector<uint8> Candidates;
+
+    uint64 RandomState = 0;
+};
+
+struct FXQMLForestSettings
+{
+    FXQMLTreeSettings Tree;
+
+    int32 NumTrees = 16;
+
+    // 多于一棵树时，每棵树有放回地抽取的样本数，0表示与训练样本数相同
+    int32 MaxSamplesPerTree = 200000;
+};
+
+/**
+ * 随机森林：每棵树在自助采样的样本上建树，节点随机抽取候选特征，预测取各树叶子分布的平均。
+ * 多棵树时每个线程轮流建整棵树，只有一棵树时在树内并行
+ */
+class XIANGQIENGINE_API FXQMLForest
+{
+public:
+    // Pool为nullptr时单线程；各树的随机种子固定，结果与线程数无关
+    void Train(const FXQMLTreeData& Data, const int32* Samples, int32 Num, const FXQMLForestSettings& Settings, FXQMLWorkerPool* Pool = nullptr);
+
+    void Clear();
+
+    bool IsEmpty() const { return Trees.empty(); }
+
+    int32 GetNumTrees() const { return static_cast<int32>(Trees.size()); }
+
+    int32 GetNumFeatures() const { return Trees.empty() ? 0 : Trees[0].NumFeatures; }
+
+    int32 GetNumClasses() const { return Trees.empty() ? 0 : Trees[0].NumClasses; }
+
+    const FXQMLTree& GetTree(int32 Index) const { return Trees[Index]; }
+
+    // 稠密特征，OutDistribution为NumClasses个，先清零再填入
+    void Predict(const float* Features, float* OutDistribution) const;
+
+    // 逐棵树处理整批样本，树的节点留在缓存中
+    void PredictBatch(const float* Features, int32 Count, float* OutDistributions) const;
+
+    // 训练数据中的样本
+    void Predict(const FXQMLTreeData& Data, int32 Sample, float* OutDistribution) const;
+
+    // 留出样本上的准确率（最大概率的类别等于标签）和平均交叉熵（概率下限1e-6）
+    void Evaluate(const FXQMLTreeData& Data, const int32* Samples, int32 Num, FXQMLWorkerPool* Pool, float& OutAccuracy, float& OutLoss) const;
+
+    void Serialize(std::vector<uint8>& Out) const;
+
+    // 也接受单棵树的文件
+    bool Deserialize(const uint8* Data, int64 Size);
+
+private:
+    std::vector<FXQMLTree> Trees;
+};
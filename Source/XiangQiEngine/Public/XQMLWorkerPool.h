@@ -0,0 +1,51 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 机器学习训练用的常驻线程组：Run让每个线程（包括调用线程，编号0）各执行一次任务，
+ * 全部完成后返回。任务按线程编号分工，结果与调度无关
+ */
+class XIANGQIENGINE_API FXQMLWorkerPool
+{
+public:
+    explicit FXQMLWorkerPool(int32 InNumThreads);
+
+    ~FXQMLWorkerPool();
+
+    FXQMLWorkerPool(const FXQMLWorkerPool&) = delete;
+
+    FXQMLWorkerPool& operator=(const FXQMLWorkerPool&) = delete;
+
+    int32 GetNumThreads() const { return static_cast<int32>(Workers.size()) + 1; }
+
+    void Run(const std::function<void(int32)>& Task);
+
+private:
+    void WorkerLoop(int32 Index);
+
+private:
+    std::vector<std::thread> Workers;
+
+    std::mutex Mutex;
+
+    std::condition_variable WorkCondition;
+
+    std::condition_variable DoneCondition;
+
+    const std::function<void(int32)>* CurrentTask = nullptr;
+
+    int64 Generation = 0;
+
+    int32 Pending = 0;
+
+    bool bExit = false;
+};
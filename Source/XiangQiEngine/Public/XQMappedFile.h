@@ -0,0 +1,44 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+#include <string>
+
+/**
+ * 只读内存映射文件。虚幻引擎中通过IPlatformFile::OpenMapped实现，
+ * 单独编译时使用mmap或CreateFileMapping
+ */
+class XIANGQIENGINE_API FXQMappedFile
+{
+public:
+    FXQMappedFile() = default;
+
+    ~FXQMappedFile();
+
+    FXQMappedFile(const FXQMappedFile&) = delete;
+
+    FXQMappedFile& operator=(const FXQMappedFile&) = delete;
+
+    // 映射整个文件（UTF-8路径），空文件或失败时返回false
+    bool Open(const std::string& Path);
+
+    void Close();
+
+    bool IsOpen() const { return Data != nullptr; }
+
+    const uint8* GetData() const { return Data; }
+
+    int64 GetSize() const { return Size; }
+
+private:
+    const uint8* Data = nullptr;
+
+    int64 Size = 0;
+
+    // 平台相关的句柄
+    void* FileHandle = nullptr;
+
+    void* MappingHandle = nullptr;
+};
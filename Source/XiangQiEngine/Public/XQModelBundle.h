@@ -0,0 +1,102 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQMappedFile.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#define XQ_MODEL_BUNDLE_MAGIC 0x424D5158u // "XQMB"
+#define XQ_MODEL_BUNDLE_VERSION 1
+
+// 段表和各段的起始偏移都按64字节对齐，映射后各段可以直接使用
+#define XQ_MODEL_BUNDLE_ALIGNMENT 64
+
+#define XQ_MODEL_BUNDLE_MAX_SECTIONS 16
+
+// 模型包中的段
+enum class EXQModelSection : uint32
+{
+    QuantizedNetwork = 1,   // FXQMLQuantizedNetwork的模型文件
+    NetworkWeights = 2,     // 浮点权重，继续训练用
+    DecisionForest = 3,     // FXQMLForest::Serialize的结果
+    TrainingResult = 4,     // 训练状态，UTF-8 JSON
+};
+
+// 模型包文件头，后面是NumSections个段描述，小端序
+struct FXQModelBundleHeader
+{
+    uint32 Magic = XQ_MODEL_BUNDLE_MAGIC;
+
+    uint32 Version = XQ_MODEL_BUNDLE_VERSION;
+
+    uint32 NumSections = 0;
+
+    uint32 Reserved = 0;
+
+    uint64 Generation = 0;  // 每次保存加一，同名的多个模型包中最大的为当前模型
+
+    uint64 FileSize = 0;
+
+    uint64 Checksum = 0;    // 文件头之后全部内容的校验和
+};
+
+struct FXQModelBundleSectionDesc
+{
+    uint32 Type = 0;
+
+    uint32 Reserved = 0;
+
+    uint64 Offset = 0;      // 从文件开头算起
+
+    uint64 Size = 0;
+};
+
+static_assert(sizeof(FXQModelBundleHeader) == 40, "FXQModelBundleHeader layout is part of the file format");
+static_assert(sizeof(FXQModelBundleSectionDesc) == 24, "FXQModelBundleSectionDesc layout is part of the file format");
+
+// 写入或读出的一段数据
+struct FXQModelBundleSection
+{
+    EXQModelSection Type = EXQModelSection::QuantizedNetwork;
+
+    const uint8* Data = nullptr;
+
+    int64 Size = 0;
+};
+
+/**
+ * 模型包：一个模型的量化网络、浮点权重、决策树和训练状态放在同一个文件里，
+ * 带版本号和校验和。写入时先写临时文件再改名，中途退出不会留下不一致的模型；
+ * 读取时映射整个文件并校验，各段直接在映射上使用
+ */
+class XIANGQIENGINE_API FXQModelBundle
+{
+public:
+    // 写入Path（UTF-8路径）。先写Path.tmp，全部写完后改名，Path已存在时失败
+    static bool Write(const std::string& Path, uint64 Generation, const FXQModelBundleSection* Sections, int32 NumSections);
+
+    // 映射并校验模型包，文件头、版本、段的范围或校验和不对时返回false
+    bool Open(const std::string& Path);
+
+    void Close();
+
+    bool IsOpen() const { return Mapping != nullptr; }
+
+    uint64 GetGeneration() const { return Generation; }
+
+    // 没有该段时返回false
+    bool FindSection(EXQModelSection Type, FXQModelBundleSection& OutSection) const;
+
+    // 各段所在的映射，量化网络等直接引用段内数据时共享它
+    const std::shared_ptr<const FXQMappedFile>& GetMapping() const { return Mapping; }
+
+private:
+    std::shared_ptr<const FXQMappedFile> Mapping;
+
+    std::vector<FXQModelBundleSectionDesc> Sections;
+
+    uint64 Generation = 0;
+};
@@ -0,0 +1,44 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+class FXQPosition;
+
+#define XQ_PACKED_EMPTY 0xFF
+
+/**
+ * 32字节的紧凑局面：每个棋子占一个固定槽位，值为所在格子，被吃为0xFF
+ * 红方槽位0-15，黑方16-31，顺序为将、士x2、象x2、马x2、车x2、炮x2、兵x5
+ * 红帅槽位的最高位保存执棋方（1为黑方）
+ */
+struct XIANGQIENGINE_API FXQPackedPosition
+{
+    uint8 Slots[32];
+
+    // 打包局面，某类棋子数量超出槽位或缺少将帅时返回false
+    bool Pack(const FXQPosition& Position);
+
+    // 还原局面（不含走子历史），数据无效时返回false
+    bool Unpack(FXQPosition& OutPosition) const;
+
+    // 与Pack/Unpack相同，但直接读写XQ_SQUARES个格子的棋盘，不经过FXQPosition
+    bool PackBoard(const uint8* Board, EXQColor SideToMove);
+
+    bool UnpackBoard(uint8* OutBoard, EXQColor& OutSideToMove) const;
+
+    // FEN与紧凑局面直接互转，不分配内存。WriteFen的Out至少XQ_FEN_BUFFER_SIZE字节，数据无效时返回0
+    bool SetFromFen(const char* Fen, int32 Length = -1);
+
+    int32 WriteFen(char* Out) const;
+
+    bool operator==(const FXQPackedPosition& Other) const;
+
+    // 槽位对应的棋子类型和颜色
+    static EXQPieceType GetSlotType(int32 Slot);
+
+    static EXQColor GetSlotColor(int32 Slot) { return Slot < 16 ? EXQColor::Red : EXQColor::Black; }
+};
+
+static_assert(sizeof(FXQPackedPosition) == 32, "FXQPackedPosition must stay 32 bytes");
@@ -0,0 +1,143 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+#include <string>
+#include <vector>
+
+// 标准开局FEN
+#define XQ_START_FEN "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR w - - 0 1"
+
+// FEN缓冲区的长度：棋盘部分最多90个字符加9个'/'，再加执棋方等后缀和结尾的'\0'
+#define XQ_FEN_BUFFER_SIZE 128
+
+// 单个局面的走法列表，象棋伪合法走法最多不超过120步
+struct FXQMoveList
+{
+    FXQMove Moves[128];
+    int32 Num = 0;
+
+    void Add(FXQMove Move) { Moves[Num++] = Move; }
+
+    FXQMove* begin() { return Moves; }
+    FXQMove* end() { return Moves + Num; }
+    const FXQMove* begin() const { return Moves; }
+    const FXQMove* end() const { return Moves + Num; }
+};
+
+/**
+ * 引擎局面：10x9棋盘、执棋方以及走子历史
+ */
+class XIANGQIENGINE_API FXQPosition
+{
+public:
+    FXQPosition();
+
+    // 清空棋盘
+    void Clear();
+
+    // 设置为标准开局
+    void SetStartPosition();
+
+    // 从FEN读取局面，格式错误时返回false且局面不变
+    bool SetFromFen(const std::string& Fen);
+
+    // 同上，不分配内存；Length小于0时读到'\0'为止
+    bool SetFromFen(const char* Fen, int32 Length = -1);
+
+    // 输出FEN
+    std::string ToFen() const;
+
+    // 把FEN写入Out（至少XQ_FEN_BUFFER_SIZE字节，以'\0'结尾），返回长度，不分配内存
+    int32 WriteFen(char* Out) const;
+
+    // XQ_SQUARES个格子上的棋子
+    const uint8* GetBoard() const { return Board; }
+
+    uint8 GetPiece(int32 Square) const { return Board[Square]; }
+
+    // 放置棋子（0表示清空），同时维护将帅位置
+    void SetPiece(int32 Square, uint8 Piece);
+
+    EXQColor GetSideToMove() const { return SideToMove; }
+
+    void SetSideToMove(EXQColor Color);
+
+    // 局面的Zobrist键值（包含执棋方）
+    uint64 GetKey() const { return Key; }
+
+    // 当前局面在历史中（最近一次吃子之后）重复出现过的次数
+    int32 GetRepetitionCount() const;
+
+    // 将/帅所在格子，不存在时为-1
+    int32 GetKingSquare(EXQColor Color) const { return KingSquares[static_cast<int32>(Color)]; }
+
+    // 执行走法（不检查合法性）
+    void MakeMove(FXQMove Move);
+
+    // 撤销最近一步走法
+    void UnmakeMove();
+
+    // 上一步吃掉的棋子
+    uint8 GetLastCaptured() const { return History.empty() ? 0 : History.back().Captured; }
+
+    // 已执行且未撤销的走法数
+    int32 GetHistoryNum() const { return static_cast<int32>(History.size()); }
+
+    // 生成伪合法走法（不检查是否送将）
+    void GenerateMoves(FXQMoveList& Moves, bool bCapturesOnly = false) const;
+
+    // 生成合法走法
+    void GenerateLegalMoves(FXQMoveList& Moves);
+
+    // 走法是否合法（伪合法且走后不被将军）
+    bool IsLegalMove(FXQMove Move);
+
+    // 执行伪合法走法，若走后己方被将则撤销并返回false
+    bool MakeMoveIfLegal(FXQMove Move);
+
+    // 指定方是否被将军（包括将帅照面）
+    bool IsInCheck(EXQColor Color) const;
+
+    // 格子是否被指定方攻击
+    bool IsSquareAttacked(int32 Square, EXQColor ByColor) const;
+
+    // 当前执棋方是否被将死或困毙
+    bool IsMated();
+
+private:
+    struct FUndoInfo
+    {
+        FXQMove Move;
+        uint8 Captured = 0;
+        uint64 Key = 0;     // 走子前的键值
+    };
+
+    uint8 Board[XQ_SQUARES];
+
+    EXQColor SideToMove = EXQColor::Red;
+
+    int32 KingSquares[2];
+
+    uint64 Key = 0;
+
+    std::vector<FUndoInfo> History;
+};
+
+// ICCS坐标记法（如"h2e2"），列a-i，行0-9，红方底线为0
+XIANGQIENGINE_API std::string XQMoveToString(FXQMove Move);
+
+XIANGQIENGINE_API bool XQParseMove(const std::string& Text, FXQMove& OutMove);
+
+XIANGQIENGINE_API bool XQParseMove(const char* Text, int32 Length, FXQMove& OutMove);
+
+// 走法写入Out（至少5字节，以'\0'结尾）
+XIANGQIENGINE_API void XQWriteMove(FXQMove Move, char* Out);
+
+// 不分配内存的FEN编解码，FXQPosition和FXQPackedPosition共用。Board为XQ_SQUARES个格子上的棋子，
+// Length小于0时读到'\0'为止；Out至少XQ_FEN_BUFFER_SIZE字节，返回写入的长度
+XIANGQIENGINE_API bool XQParseFen(const char* Fen, int32 Length, uint8* OutBoard, EXQColor& OutSideToMove);
+
+XIANGQIENGINE_API int32 XQWriteFen(const uint8* Board, EXQColor SideToMove, char* Out);
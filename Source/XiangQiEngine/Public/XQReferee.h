@@ -0,0 +1,70 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+#include <vector>
+
+class FXQPosition;
+
+enum class EXQGameResult : uint8
+{
+    Ongoing,
+    RedWin,
+    BlackWin,
+    Draw
+};
+
+struct FXQRefereeSettings
+{
+    int32 MaxPlies = 400;           // 超过后判和
+
+    int32 NoCaptureLimit = 120;     // 连续不吃子的半回合数上限（60回合自然限着）
+};
+
+/**
+ * 对局裁判：将死/困毙、重复局面（单方长将判负，其余判和，长捉不做判断）、
+ * 自然限着、双方都没有进攻子力以及最大步数
+ */
+class XIANGQIENGINE_API FXQReferee
+{
+public:
+    explicit FXQReferee(const FXQRefereeSettings& InSettings = FXQRefereeSettings());
+
+    // 以Start为起始局面开始新对局
+    void Reset(const FXQPosition& Start);
+
+    // 每走一步后调用（Position为走子后的局面），返回裁决结果
+    EXQGameResult OnMove(FXQPosition& Position);
+
+    // 裁决当前局面
+    EXQGameResult Adjudicate(FXQPosition& Position);
+
+    // 最近一次裁决的原因
+    const char* GetReason() const { return Reason; }
+
+    int32 GetPlies() const { return Plies; }
+
+    // 红方得分：胜1、和0.5、负0
+    static double GetRedScore(EXQGameResult Result);
+
+    static bool IsInsufficientMaterial(const FXQPosition& Position);
+
+private:
+    EXQGameResult AdjudicateRepetition(EXQColor LastMover);
+
+private:
+    FXQRefereeSettings Settings;
+
+    // 起始局面之后每半回合的局面键值，以及走成该局面的一步是否将军
+    std::vector<uint64> Keys;
+
+    std::vector<bool> GaveCheck;
+
+    int32 Plies = 0;
+
+    int32 PliesSinceCapture = 0;
+
+    const char* Reason = "";
+};
@@ -0,0 +1,260 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+#include "XQPosition.h"
+#include "XQEvaluation.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 搜索限制，为0的项表示不限制
+struct FXQSearchLimits
+{
+    int32 Depth = XQ_MAX_PLY - 1;   // 最大迭代深度
+
+    int64 Nodes = 0;                // 节点数上限
+
+    int32 MoveTimeMs = 0;           // 思考时间（毫秒）
+
+    int32 MultiPV = 1;              // 需要精确评分的候选走法数量
+
+    bool bInfinite = false;         // 无限思考，直到调用Stop
+
+    bool bPonder = false;           // 后台思考，调用PonderHit后才开始计时
+
+    int32 PolicyPlies = 2;          // 设置了走法先验时，按先验排序的层数（根节点为第0层）
+
+    bool bPolicyReductions = true;  // 先验很低的安静走法少搜几层，不够好时再全深度重搜
+
+    const std::atomic<bool>* CancelFlag = nullptr; // 外部的停止标志（如任务取消），置位后与Stop效果相同
+};
+
+// 向走法先验查询的一个局面
+struct FXQPolicyQuery
+{
+    const FXQPosition* Position = nullptr;
+
+    const FXQMoveList* Moves = nullptr; // 该局面的合法走法
+
+    float* Priors = nullptr;            // 输出，与Moves一一对应，和为1
+};
+
+/**
+ * 走法先验（例如策略网络），在搜索线程中调用。
+ * 搜索每次传入一个节点的全部子局面，实现可以借此分摊推理开销
+ */
+class XIANGQIENGINE_API FXQMovePolicy
+{
+public:
+    virtual ~FXQMovePolicy() = default;
+
+    virtual void Evaluate(const FXQPolicyQuery* Queries, int32 Count) = 0;
+};
+
+// 根节点的一条候选变例
+struct FXQSearchLine
+{
+    FXQMove Move;
+
+    int32 Score = 0;                // 执棋方视角的评分
+
+    bool bExact = false;            // 评分是否精确（否则为上界）
+
+    std::vector<FXQMove> PV;        // 主要变例，PV[0] == Move
+};
+
+/**
+ * 搜索统计。计数器是搜索对象的普通成员，只由执行搜索的线程累加，不用原子操作；
+ * 每轮迭代结束时随FXQSearchResult复制给调用方
+ */
+struct XIANGQIENGINE_API FXQSearchStats
+{
+    int32 Depth = 0;                // 已完成的迭代深度
+
+    int32 SelDepth = 0;             // 该轮迭代到达的最大层数（含静态搜索）
+
+    int64 Nodes = 0;                // 节点数（含静态搜索）
+
+    int64 QNodes = 0;               // 静态搜索节点数
+
+    int64 TimeMs = 0;               // 从搜索开始的用时
+
+    int64 IterationTimeMs = 0;      // 该轮迭代的用时
+
+    int64 BetaCutoffs = 0;          // 主搜索中的Beta截断次数
+
+    int64 FirstMoveCutoffs = 0;     // 其中第一个合法走法就截断的次数
+
+    int64 Reductions = 0;           // 按先验减少深度搜索的次数
+
+    int64 ReductionResearches = 0;  // 其中浅搜超过Alpha、需要全深度重搜的次数
+
+    int64 PolicyProbes = 0;         // 查询先验缓存的次数
+
+    int64 PolicyHits = 0;           // 其中命中、不需要推理的次数
+
+    // 用时不足1毫秒时无法计算，返回0
+    int64 GetNps() const { return TimeMs > 0 ? Nodes * 1000 / TimeMs : 0; }
+
+    double GetFirstMoveCutoffRate() const { return BetaCutoffs > 0 ? static_cast<double>(FirstMoveCutoffs) / BetaCutoffs : 0.0; }
+
+    // 减少深度后不需要重搜的比例
+    double GetReductionSuccessRate() const { return Reductions > 0 ? 1.0 - static_cast<double>(ReductionResearches) / Reductions : 0.0; }
+
+    double GetPolicyHitRate() const { return PolicyProbes > 0 ? static_cast<double>(PolicyHits) / PolicyProbes : 0.0; }
+
+    // CSV表头（不含换行）与对应的一行
+    static const char* GetCsvHeader();
+
+    std::string ToCsvRow() const;
+};
+
+// 一次迭代完成后的搜索结果
+struct FXQSearchResult
+{
+    int32 Depth = 0;                // 已完成的迭代深度
+
+    int64 Nodes = 0;
+
+    int64 TimeMs = 0;
+
+    std::vector<FXQSearchLine> Lines; // 按评分从高到低，前MultiPV条为精确值
+
+    FXQSearchStats Stats;
+
+    FXQMove GetBestMove() const { return Lines.empty() ? FXQMove() : Lines[0].Move; }
+
+    // 预期的对方应着
+    FXQMove GetPonderMove() const { return Lines.empty() || Lines[0].PV.size() < 2 ? FXQMove() : Lines[0].PV[1]; }
+};
+
+/**
+ * 迭代加深Alpha-Beta搜索，支持MultiPV、节点/时间限制以及后台思考
+ * Search在调用线程中同步执行，Stop、Pause、Resume和PonderHit可以从其他线程调用。
+ * Search不清除停止请求：调用方在发起搜索之前调用ResetStop，搜索线程启动前到达的Stop不会丢失
+ */
+class XIANGQIENGINE_API FXQSearch
+{
+public:
+    // 每完成一轮迭代时回调（在搜索线程中）
+    typedef std::function<void(const FXQSearchResult&)> FIterationCallback;
+
+    FXQSearch();
+
+    FXQSearchResult Search(const FXQPosition& Root, const FXQSearchLimits& InLimits, const FIterationCallback& OnIteration = nullptr);
+
+    // 请求停止搜索（线程安全），暂停中的搜索也会被唤醒。请求一直保留到下一次ResetStop
+    void Stop();
+
+    // 清除停止请求，在发起新的搜索之前由调用方调用（不要在搜索进行中调用）
+    void ResetStop();
+
+    /**
+     * 暂停搜索（线程安全）。搜索线程每隔一些节点检查一次，暂停时在条件变量上等待，不占用CPU；
+     * Resume后从原处继续，暂停的时间不计入思考时间。暂停在两次搜索之间保持
+     */
+    void Pause();
+
+    void Resume();
+
+    bool IsPaused() const { return bPauseRequested.load(); }
+
+    // 对方走了预期的应着，后台思考转为正常计时（线程安全）
+    void PonderHit();
+
+    void SetEvalParams(const FXQEvalParams& Params) { EvalParams = Params; }
+
+    // 搜索期间由调用方保证有效，nullptr表示不使用先验
+    void SetMovePolicy(FXQMovePolicy* InPolicy) { Policy = InPolicy; }
+
+    // 是否为将死分数
+    static bool IsMateScore(int32 Score) { return Score > XQ_MATE_BOUND || Score < -XQ_MATE_BOUND; }
+
+private:
+    struct FPVLine
+    {
+        FXQMove Moves[XQ_MAX_PLY];
+        int32 Num = 0;
+
+        void Set(FXQMove Move, const FPVLine& Child);
+    };
+
+    bool SearchRoot(int32 Depth, int32 MultiPV, std::vector<FXQSearchLine>& Lines);
+
+    int32 Negamax(int32 Depth, int32 Alpha, int32 Beta, int32 Ply, FPVLine& PV);
+
+    int32 Quiescence(int32 Alpha, int32 Beta, int32 Ply);
+
+    // 一个局面的走法先验
+    struct FPolicyPriors
+    {
+        FXQMoveList Moves;
+
+        float Priors[128];
+
+        // 子局面的先验是否已经批量取得
+        bool bChildrenFetched = false;
+
+        float Find(FXQMove Move) const;
+    };
+
+    // 吃子按MVV-LVA排序，其次是杀手走法，再次是先验（有的话）；OutPriors为排序后各走法的先验
+    void OrderMoves(FXQMoveList& Moves, int32 Ply, const FPolicyPriors* Priors = nullptr, float* OutPriors = nullptr) const;
+
+    // 取当前局面的先验；还需要下一层时把所有子局面一起查询
+    const FPolicyPriors* FetchPolicy(int32 Ply);
+
+    void StoreKiller(FXQMove Move, int32 Ply);
+
+    // 计数节点并检查停止和暂停
+    bool CheckAbort();
+
+    // 暂停期间在这里等待，直到恢复、停止或取消
+    void WaitWhilePaused();
+
+    int64 GetElapsedMs() const;
+
+    static int64 GetNowMs();
+
+private:
+    FXQPosition Position;
+
+    FXQSearchLimits Limits;
+
+    FXQEvalParams EvalParams;
+
+    std::atomic<bool> bStopRequested;
+
+    std::atomic<bool> bPondering;
+
+    std::atomic<bool> bPauseRequested;
+
+    std::mutex PauseMutex;
+
+    std::condition_variable PauseCondition;
+
+    std::atomic<int64> StartTimeMs;
+
+    bool bAborted = false;
+
+    int64 Nodes = 0;
+
+    // 本轮迭代到达的最大层数
+    int32 SelDepth = 0;
+
+    FXQSearchStats Stats;
+
+    FXQMove Killers[XQ_MAX_PLY][2];
+
+    FXQMovePolicy* Policy = nullptr;
+
+    // 本次搜索中查询过的先验，按局面键值索引，各轮迭代共用
+    std::unordered_map<uint64, FPolicyPriors> PolicyCache;
+};
@@ -0,0 +1,83 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+/**
+ * 单生产者单消费者的无锁环形队列：Push只在一个线程调用，Pop只在另一个线程调用。
+ * 容量在构造时固定（向上取到2的幂），之后不再分配内存
+ */
+template <typename T>
+class TXQSpscQueue
+{
+public:
+    explicit TXQSpscQueue(uint32 InCapacity)
+        : Slots(RoundUpToPowerOfTwo(InCapacity))
+        , Mask(static_cast<uint32>(Slots.size()) - 1)
+    {
+    }
+
+    TXQSpscQueue(const TXQSpscQueue&) = delete;
+
+    TXQSpscQueue& operator=(const TXQSpscQueue&) = delete;
+
+    uint32 GetCapacity() const { return Mask + 1; }
+
+    // 生产者线程：队列满时返回false，Item不变
+    bool Push(T&& Item)
+    {
+        const uint32 CurrentTail = Tail.load(std::memory_order_relaxed);
+        if (CurrentTail - Head.load(std::memory_order_acquire) > Mask)
+        {
+            return false;
+        }
+        Slots[CurrentTail & Mask] = std::move(Item);
+        Tail.store(CurrentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 生产者线程：当前空余的位置数，消费者随时可能再腾出更多
+    uint32 GetFreeSlots() const
+    {
+        return Mask + 1 - (Tail.load(std::memory_order_relaxed) - Head.load(std::memory_order_acquire));
+    }
+
+    // 消费者线程：队列空时返回false
+    bool Pop(T& OutItem)
+    {
+        const uint32 CurrentHead = Head.load(std::memory_order_relaxed);
+        if (CurrentHead == Tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        OutItem = std::move(Slots[CurrentHead & Mask]);
+        Head.store(CurrentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static uint32 RoundUpToPowerOfTwo(uint32 Value)
+    {
+        uint32 Result = 1;
+        while (Result < Value)
+        {
+            Result <<= 1;
+        }
+        return Result;
+    }
+
+private:
+    std::vector<T> Slots;
+
+    const uint32 Mask;
+
+    // 读写位置分开放在不同的缓存行上
+    alignas(64) std::atomic<uint32> Head{ 0 };
+
+    alignas(64) std::atomic<uint32> Tail{ 0 };
+};
@@ -0,0 +1,94 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+#include "XQPackedPosition.h"
+
+#include <cstdio>
+#include <string>
+
+#define XQ_TRAINING_FILE_MAGIC 0x44545158u // "XQTD"
+#define XQ_TRAINING_FILE_VERSION 1
+
+// 训练样本，40字节定长，按小端序直接写入文件
+struct FXQTrainingRecord
+{
+    FXQPackedPosition Position;
+
+    uint16 BestMove = 0;    // FXQMove::Value
+
+    int16 Score = 0;        // 搜索评分（执棋方视角）
+
+    uint8 Depth = 0;        // 搜索深度
+
+    int8 Result = 0;        // 对局结果（红方视角）：1胜，0和，-1负
+
+    uint16 Ply = 0;         // 局面在对局中的半回合数
+};
+
+static_assert(sizeof(FXQTrainingRecord) == 40, "FXQTrainingRecord layout is part of the file format");
+
+/**
+ * 样本的稳定键：只由局面和走法决定，与样本在哪个文件、第几条无关。
+ * 训练集和验证集按它划分，日志压缩或增加自我对弈数据后样本仍留在原来的一边，相同的样本也总在同一边
+ */
+XIANGQIENGINE_API uint64 GetXQTrainingRecordKey(const FXQTrainingRecord& Record);
+
+// 文件头，后面紧跟Num个FXQTrainingRecord
+struct FXQTrainingFileHeader
+{
+    uint32 Magic = XQ_TRAINING_FILE_MAGIC;
+
+    uint32 Version = XQ_TRAINING_FILE_VERSION;
+
+    uint32 RecordSize = sizeof(FXQTrainingRecord);
+
+    uint32 Reserved = 0;
+};
+
+/**
+ * 顺序读取训练数据文件，按块缓冲，适合上百万条样本
+ */
+class XIANGQIENGINE_API FXQTrainingFileReader
+{
+public:
+    ~FXQTrainingFileReader();
+
+    bool Open(const std::string& Path);
+
+    void Close();
+
+    // 文件中的样本总数
+    int64 GetNum() const { return Num; }
+
+    // 读取最多MaxNum条，返回实际读取的条数，0表示结束
+    int64 Read(FXQTrainingRecord* OutRecords, int64 MaxNum);
+
+private:
+    std::FILE* File = nullptr;
+
+    int64 Num = 0;
+};
+
+/**
+ * 写训练数据文件（覆盖已有文件）
+ */
+class XIANGQIENGINE_API FXQTrainingFileWriter
+{
+public:
+    ~FXQTrainingFileWriter();
+
+    bool Open(const std::string& Path);
+
+    bool Write(const FXQTrainingRecord* Records, int64 Count);
+
+    bool Close();
+
+    int64 GetNum() const { return Num; }
+
+private:
+    std::FILE* File = nullptr;
+
+    int64 Num = 0;
+};
@@ -0,0 +1,112 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTrainingData.h"
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#define XQ_TRAINING_LOG_MAGIC 0x4C545158u // "XQTL"
+#define XQ_TRAINING_LOG_VERSION 1
+
+// 单条记录的负载上限，超出视为文件损坏
+#define XQ_TRAINING_LOG_MAX_PAYLOAD 4096
+
+// 日志中的一条样本
+struct FXQTrainingLogEntry
+{
+    FXQTrainingRecord Record;
+
+    int64 Timestamp = 0;    // 记录时间（Unix毫秒）
+};
+
+static_assert(sizeof(FXQTrainingLogEntry) == 48, "FXQTrainingLogEntry layout is part of the file format");
+
+struct FXQTrainingLogHeader
+{
+    uint32 Magic = XQ_TRAINING_LOG_MAGIC;
+
+    uint32 Version = XQ_TRAINING_LOG_VERSION;
+
+    uint32 EntrySize = sizeof(FXQTrainingLogEntry);
+
+    uint32 Reserved = 0;
+};
+
+/**
+ * 顺序读取训练日志。文件结构为16字节文件头，之后每条记录为
+ * [uint32 负载长度][uint32 负载校验和][负载]，负载开头是FXQTrainingLogEntry，
+ * 更长的负载（新版本追加的字段）读取时跳过。遇到不完整或校验失败的记录即视为结束
+ */
+class XIANGQIENGINE_API FXQTrainingLogReader
+{
+public:
+    ~FXQTrainingLogReader();
+
+    bool Open(const std::string& Path);
+
+    void Close();
+
+    // 读取下一条，没有更多有效记录时返回false
+    bool Next(FXQTrainingLogEntry& OutEntry);
+
+    // 最后一条有效记录之后的文件偏移
+    int64 GetValidEnd() const { return ValidEnd; }
+
+private:
+    std::FILE* File = nullptr;
+
+    int64 ValidEnd = 0;
+};
+
+/**
+ * 只追加的训练日志：记录一条样本只需一次定长的追加写入，不会重写已有数据。
+ * 打开时截掉末尾写了一半的记录；Compact在后台保留最近的若干条，
+ * 期间的追加只在最后换文件时短暂等待。所有方法都是线程安全的
+ */
+class XIANGQIENGINE_API FXQTrainingLog
+{
+public:
+    ~FXQTrainingLog();
+
+    // 打开或创建日志文件
+    bool Open(const std::string& InPath);
+
+    void Close();
+
+    bool IsOpen() const;
+
+    bool Append(const FXQTrainingLogEntry& Entry);
+
+    // 有效记录数（包括已追加但尚未压缩掉的旧记录）
+    int64 GetNum() const;
+
+    // 只保留最后MaxRecords条：写临时文件后原子替换，压缩进行中再次调用直接返回true
+    bool Compact(int64 MaxRecords);
+
+    // 删除全部记录
+    bool Clear();
+
+    // 遍历全部记录，可在任意线程调用
+    static bool ReadAll(const std::string& Path, const std::function<void(const FXQTrainingLogEntry&)>& Visitor);
+
+private:
+    bool OpenForAppend();
+
+private:
+    mutable std::mutex Mutex;
+
+    std::string Path;
+
+    std::FILE* File = nullptr;
+
+    int64 Num = 0;
+
+    int64 Generation = 0;   // Clear时递增，压缩期间被清空则放弃压缩结果
+
+    std::atomic<bool> bCompacting{ false };
+};
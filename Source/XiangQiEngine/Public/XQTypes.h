@@ -0,0 +1,120 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+// XQ_STANDALONE由Tools/CMakeLists.txt定义，在虚幻引擎之外编译时使用标准库类型
+#if XQ_STANDALONE
+#include <cstdint>
+
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+
+#define XIANGQIENGINE_API
+#else
+#include "CoreTypes.h"
+#endif
+
+// 棋盘尺寸：10行9列，第0行为红方底线
+#define XQ_RANKS 10
+#define XQ_FILES 9
+#define XQ_SQUARES 90
+
+// 搜索最大层数
+#define XQ_MAX_PLY 64
+
+// 将死分数，距离根节点越近分数绝对值越大
+#define XQ_MATE_SCORE 30000
+#define XQ_MATE_BOUND (XQ_MATE_SCORE - XQ_MAX_PLY)
+#define XQ_INFINITE_SCORE 32000
+
+// 棋子类型，数值与游戏中的EChessType保持一致
+enum class EXQPieceType : uint8
+{
+    Empty = 0,
+    Jiang = 1,  // 将/帅
+    Shi = 2,    // 士/仕
+    Xiang = 3,  // 象/相
+    Ma = 4,     // 马/傌
+    Jv = 5,     // 车/俥
+    Pao = 6,    // 炮/砲
+    Bing = 7    // 兵/卒
+};
+
+// 棋子颜色，数值与游戏中的EChessColor保持一致
+enum class EXQColor : uint8
+{
+    Red = 0,
+    Black = 1
+};
+
+inline EXQColor XQOpponent(EXQColor Color)
+{
+    return Color == EXQColor::Red ? EXQColor::Black : EXQColor::Red;
+}
+
+// 格子编号 = 行 * 9 + 列
+inline int32 XQMakeSquare(int32 Rank, int32 File)
+{
+    return Rank * XQ_FILES + File;
+}
+
+inline int32 XQRankOf(int32 Square)
+{
+    return Square / XQ_FILES;
+}
+
+inline int32 XQFileOf(int32 Square)
+{
+    return Square % XQ_FILES;
+}
+
+// 上下翻转格子（用于黑方共用红方的位置分表）
+inline int32 XQMirrorSquare(int32 Square)
+{
+    return XQMakeSquare(XQ_RANKS - 1 - XQRankOf(Square), XQFileOf(Square));
+}
+
+// 棋子编码：低3位为类型，第4位为颜色，0表示空
+inline uint8 XQMakePiece(EXQPieceType Type, EXQColor Color)
+{
+    return static_cast<uint8>(static_cast<uint8>(Type) | (static_cast<uint8>(Color) << 3));
+}
+
+inline EXQPieceType XQPieceTypeOf(uint8 Piece)
+{
+    return static_cast<EXQPieceType>(Piece & 7);
+}
+
+inline EXQColor XQPieceColorOf(uint8 Piece)
+{
+    return static_cast<EXQColor>((Piece >> 3) & 1);
+}
+
+// 走法：低7位为起点，高7位为终点，0为空走法
+struct FXQMove
+{
+    uint16 Value = 0;
+
+    FXQMove() = default;
+
+    FXQMove(int32 From, int32 To)
+        : Value(static_cast<uint16>(From | (To << 7)))
+    {
+    }
+
+    int32 From() const { return Value & 0x7F; }
+
+    int32 To() const { return (Value >> 7) & 0x7F; }
+
+    bool IsNull() const { return Value == 0; }
+
+    bool operator==(const FXQMove& Other) const { return Value == Other.Value; }
+
+    bool operator!=(const FXQMove& Other) const { return Value != Other.Value; }
+};
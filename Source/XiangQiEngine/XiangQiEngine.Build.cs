@@ -0,0 +1,16 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+using UnrealBuildTool;
+
+// 象棋引擎核心（棋盘、走法生成、搜索），不依赖引擎对象，也可由Tools/CMakeLists.txt单独编译
+public class XiangQiEngine : ModuleRules
+{
+	public XiangQiEngine(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] {
+			"Core"
+		});
+	}
+}
@@ -5,814 +5,406 @@
 #include "XIANGQIPRO/GameObject/ChessBoard2P.h"
 #include "XIANGQIPRO/Chess/Chesses.h"
 #include <Kismet/GameplayStatics.h>
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
 
 UAI2P::UAI2P()
 {
-    PositionValues[EChessType::BING][EChessColor::REDCHESS] = {
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {10, 0, 10, 0, 15, 0, 10, 0, 10},
-        {20, 0, 20, 0, 20, 0, 20, 0, 20},
-        {30, 0, 30, 0, 35, 0, 30, 0, 30},
-        {40, 0, 40, 0, 45, 0, 40, 0, 40},
-        {50, 0, 50, 0, 55, 0, 50, 0, 50}
-    };
-
-    PositionValues[EChessType::BING][EChessColor::BLACKCHESS] = {
-        {50, 0, 50, 0, 55, 0, 50, 0, 50},
-        {40, 0, 40, 0, 45, 0, 40, 0, 40},
-        {30, 0, 30, 0, 35, 0, 30, 0, 30},
-        {20, 0, 20, 0, 20, 0, 20, 0, 20},
-        {10, 0, 10, 0, 15, 0, 10, 0, 10},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0}
-    };
-
-    PositionValues[EChessType::MA][EChessColor::REDCHESS] = {
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {90, 90, 100, 80, 70, 80, 100, 90, 90},
-        {90, 100, 120, 110, 100, 110, 120, 100, 90},
-        {90, 110, 120, 130, 120, 130, 120, 110, 90},
-        {100, 120, 130, 140, 140, 140, 130, 120, 100},
-        {100, 120, 130, 140, 140, 140, 130, 120, 100},
-        {90, 110, 120, 130, 120, 130, 120, 110, 90},
-        {90, 100, 120, 110, 100, 110, 120, 100, 90},
-        {90, 90, 100, 80, 70, 80, 100, 90, 90}
-    };
-
-    PositionValues[EChessType::MA][EChessColor::BLACKCHESS] = {
-        {90, 90, 100, 80, 70, 80, 100, 90, 90},
-        {90, 100, 120, 110, 100, 110, 120, 100, 90},
-        {90, 110, 120, 130, 120, 130, 120, 110, 90},
-        {100, 120, 130, 140, 140, 140, 130, 120, 100},
-        {100, 120, 130, 140, 140, 140, 130, 120, 100},
-        {90, 110, 120, 130, 120, 130, 120, 110, 90},
-        {90, 100, 120, 110, 100, 110, 120, 100, 90},
-        {90, 90, 100, 80, 70, 80, 100, 90, 90},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0},
-        {0, 0, 0, 0, 0, 0, 0, 0, 0}
-    };
 }
 
-void UAI2P::SetBoard(TWeakObjectPtr<UChessBoard2P> AIMove2P)
-{
-    LocalAllChess = AIMove2P->AllChess; 
-    int32 ChessNum = 0;
-    for (const auto& list : LocalAllChess)
-    {
-        for (const auto& chess : list)
-        {
-            if (chess.IsValid())
-            {
-                ChessNum++;
-            }
-        }
-    }
-
-    if (ChessNum > 30)
-    {
-        Phase = EGamePhase::Opening;
-    }
-    else if (ChessNum <= 15)
-    {
-        Phase = EGamePhase::Ending;
-    }
-    else
-    {
-        Phase = EGamePhase::Middle;
-    }
-}
-
-// 获取AI最优走法（对外接口）
-FChessMove2P UAI2P::GetBestMove(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor InAiColor, EAI2PDifficulty InDifficulty)
+void UAI2P::Initialize(FSubsystemCollectionBase& Collection)
 {
-    bStopThinking = false;
-    SetBoard(InBoard2P);
-    GlobalAIColor = InAiColor;
-    GlobalPlayerColor = (GlobalAIColor == EChessColor::BLACKCHESS ? EChessColor::REDCHESS : EChessColor::BLACKCHESS);
+    Super::Initialize(Collection);
 
-    int32 Depth = 4;
-    switch (InDifficulty)
+    // 搜索线程和信箱在这里一次创建，之后每回合只提交任务
+    for (int32 i = 0; i < NumSearchWorkers; i++)
     {
-    case EAI2PDifficulty::Easy:
-        Depth = 3;
-        break;
-    case EAI2PDifficulty::Normal:
-        Depth = 4;
-        break;
-    case EAI2PDifficulty::Hard:
-        Depth = 5;
-        break;
-    case EAI2PDifficulty::Master:
-        Depth = 6;
-        break;
-    default:
-        Depth = 4;
-        break;
+        Mailboxes.Add(MakeUnique<TXQSpscQueue<FAI2PMessage>>(MailboxCapacity));
     }
-    return Minimax(Depth, -INT_MAX, INT_MAX, true).first;
+    JobSystem = MakeUnique<FXQJobSystem>(NumSearchWorkers);
 }
 
-void UAI2P::StopThinkingImmediately()
+void UAI2P::Deinitialize()
 {
-    bStopThinking = true;
+    // 未完成的请求和StopThinkingImmediately一样以取消回调结束，再等待线程退出
+    StopThinkingImmediately();
+    JobSystem.Reset();
+    Mailboxes.Empty();
+    Super::Deinitialize();
 }
 
-std::pair<FChessMove2P, int32> UAI2P::Minimax(int32 depth, int32 alpha, int32 beta, bool maximiziongPlayer)
+void UAI2P::Tick(float DeltaTime)
 {
-    FChessMove2P BestMove;
-    BestMove.bIsValid = false;
-
-    if (depth == 0)
+    FAI2PMessage Message;
+    for (TUniquePtr<TXQSpscQueue<FAI2PMessage>>& Mailbox : Mailboxes)
     {
-        return { BestMove, EvaluateBoard(GlobalAIColor)};
-    }
-
-
-    EChessColor CurrentColor = maximiziongPlayer ? GlobalAIColor : GlobalPlayerColor;
-    TArray<FChessMove2P> moves = GetAllPossibleMoves(CurrentColor);
-
-    if (moves.Num() == 0)
-    {
-        return { BestMove, maximiziongPlayer ? -10000 : 10000 };
-    }
-
-    if (maximiziongPlayer)
-    {
-        int32 maxEval = -INT_MAX;
-
-        for (const FChessMove2P& move : moves)
+        while (Mailbox->Pop(Message))
         {
-            // 执行移动
-            WeakChessPtr OriginalChess = MakeTestMove(move);
-            int32 evaluation = Minimax(depth - 1, alpha, beta, false).second;
-
-            // 恢复移动
-            UndoTestMove(move, OriginalChess);
-
-            if (evaluation > maxEval)
+            // 已取消或已完成的请求：过期的消息直接丢弃
+            FAI2PRequest* Request = PendingRequests.Find(Message.Generation);
+            if (Request == nullptr)
             {
-                maxEval = evaluation;
-                BestMove = move;
-            }
-
-            // Alpha-Beta剪枝
-            alpha = Math::Max(alpha, evaluation);
-            if (beta <= alpha)
-            {
-                break;
+                continue;
             }
 
-            if (bStopThinking)
+            if (!Message.bFinished)
             {
-                break;
-            }
-        }
-
-        return { BestMove, maxEval };
-    }
-    else
-    {
-        int32 minEval = INT_MAX;
-
-        for (const FChessMove2P& move : moves)
-        {
-            // 执行移动
-            WeakChessPtr OriginalChess = MakeTestMove(move);
-            int32 evaluation = Minimax(depth - 1, alpha, beta, true).second;
-
-            // 恢复移动
-            UndoTestMove(move, OriginalChess); 
-            
-            if (evaluation < minEval) {
-                minEval = evaluation;
-                BestMove = move;
+                OnSearchStats.Broadcast(Message.Analysis.Stats);
+                if (Request->OnProgress)
+                {
+                    Request->OnProgress(Message.Analysis);
+                }
+                continue;
             }
 
-            beta = Math::Min(beta, evaluation);
-            if (beta <= alpha)
+            // 先移除再回调，回调中可以提交新的请求
+            TFunction<void(const FAI2PAnalysis&, bool)> OnComplete = MoveTemp(Request->OnComplete);
+            PendingRequests.Remove(Message.Generation);
+            if (!Message.bCancelled)
             {
-                break;
+                LastAnalysis = Message.Analysis;
+                OnSearchStats.Broadcast(Message.Analysis.Stats);
+                if (bDumpSearchStats)
+                {
+                    AppendSearchStatsCsv(Message.Analysis);
+                }
             }
-
-            if (bStopThinking)
+            if (OnComplete)
             {
-                break;
+                OnComplete(Message.Analysis, Message.bCancelled);
             }
         }
-
-        return { BestMove, minEval };
     }
 }
 
-int32 UAI2P::EvaluateBoard(EChessColor Color)
+void UAI2P::SetBoard(TWeakObjectPtr<UChessBoard2P> AIMove2P)
 {
-    int32 Score = 0;
-    // 计算双方棋子价值差
-    for (int32 i = 0; i < 10; i++)
-    {
-        for (int32 j = 0; j < 9; j++)
-        {
-            WeakChessPtr piece = GetChess(i, j);
-            if (piece.IsValid())
-            {
-                int32 value = GetChessValue(piece->GetType());
-                value += GetChessPositionValue(piece->GetType(), piece->GetColor(), piece->GetPosition());
-
-                if (piece->GetColor() == Color)
-                {
-                    Score += value;
-                }
-                else
-                {
-                    Score -= value;
-                }
-            }
-        }
-    }
-    return Score;
+    BuildPosition(AIMove2P, EnginePosition.GetSideToMove() == EXQColor::Red ? EChessColor::REDCHESS : EChessColor::BLACKCHESS, EnginePosition);
 }
 
-TArray<FChessMove2P> UAI2P::GetAllPossibleMoves(EChessColor Color)
+void UAI2P::SetMovePolicy(TSharedPtr<FXQMovePolicy, ESPMode::ThreadSafe> InPolicy)
 {
-    TArray<FChessMove2P> Moves = GenerateAllMoves(Color);
-    TArray<FChessMove2P> SelectedMoves;
+    MovePolicy = InPolicy;
+}
 
-    if (Phase == EGamePhase::Ending)
+void UAI2P::BuildPosition(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor SideToMove, FXQPosition& OutPosition)
+{
+    OutPosition.Clear();
+    OutPosition.SetSideToMove(SideToMove == EChessColor::REDCHESS ? EXQColor::Red : EXQColor::Black);
+    if (!InBoard2P.IsValid())
     {
-        EChessColor OppoColor = Color == EChessColor::REDCHESS ? EChessColor::BLACKCHESS : EChessColor::REDCHESS;
-        Position KingPos = GetKingPos(Color);
-        Position OppoKingPos = GetKingPos(OppoColor);
+        return;
+    }
 
-        for (const auto& move : Moves)
+    // AllChess[X][Y]：X为行（红方底线为0），Y为列，与引擎格子编号一致
+    const TArray<TArray<WeakChessPtr>>& AllChess = InBoard2P->AllChess;
+    for (int32 X = 0; X < AllChess.Num() && X < XQ_RANKS; X++)
+    {
+        for (int32 Y = 0; Y < AllChess[X].Num() && Y < XQ_FILES; Y++)
         {
-            if (move.to == OppoKingPos)
+            const WeakChessPtr& Chess = AllChess[X][Y];
+            if (Chess.IsValid() && Chess->GetType() != EChessType::EMPTY)
             {
-                return { move };
+                const EXQColor Color = Chess->GetColor() == EChessColor::REDCHESS ? EXQColor::Red : EXQColor::Black;
+                OutPosition.SetPiece(XQMakeSquare(X, Y), XQMakePiece(static_cast<EXQPieceType>(Chess->GetType()), Color));
             }
-
-            WeakChessPtr chess = MakeTestMove(move);
-            if (!IsInCheck(Color, move.from != KingPos ? KingPos : move.to /* 如果是将移动，则需要传入移动后的位置 */))
-            {
-                SelectedMoves.Add(move);
-            }
-            UndoTestMove(move, chess);
         }
     }
-
-    if (SelectedMoves.IsEmpty())
-    {
-        SelectedMoves.Append(Moves);
-    }
-
-    SelectedMoves.Sort([this, Color](const FChessMove2P& a, const FChessMove2P& b) {
-
-        // 优先考虑吃子
-        bool aCapture = GetChess(a.to.X, a.to.Y).IsValid() && GetChess(a.to.X, a.to.Y)->GetColor() != Color;
-        bool bCapture = GetChess(b.to.X, b.to.Y).IsValid() && GetChess(b.to.X, b.to.Y)->GetColor() != Color;
-
-        if (aCapture != bCapture)
-        {
-            return bCapture < aCapture;
-        }
-
-        int32 aValue = GetChessValue(GetChess(a.from.X, a.from.Y)->GetType());
-        int32 bValue = GetChessValue(GetChess(b.from.X, b.from.Y)->GetType());
-
-        if (aValue != bValue)
-        {
-            return bValue < aValue;
-        }
-        
-        if (a.to.X != b.to.X) {
-            return a.to.X < b.to.X;
-        }
-        return a.to.Y < b.to.Y;
-        });
-    return SelectedMoves;
 }
 
-WeakChessPtr UAI2P::MakeTestMove(FChessMove2P Move)
+FString UAI2P::GetBoardFen(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor SideToMove)
 {
-    WeakChessPtr OriginalChess = GetChess(Move.to.X, Move.to.Y);
-    LocalAllChess[Move.to.X][Move.to.Y] = GetChess(Move.from.X, Move.from.Y);
-    LocalAllChess[Move.from.X][Move.from.Y] = nullptr;
-    return OriginalChess;
-}
+    FXQPosition Position;
+    BuildPosition(InBoard2P, SideToMove, Position);
 
-void UAI2P::UndoTestMove(FChessMove2P Move, WeakChessPtr OriginalChess)
-{
-    LocalAllChess[Move.from.X][Move.from.Y] = GetChess(Move.to.X, Move.to.Y);
-    LocalAllChess[Move.to.X][Move.to.Y] = OriginalChess;
+    char Fen[XQ_FEN_BUFFER_SIZE];
+    Position.WriteFen(Fen);
+    return FString(UTF8_TO_TCHAR(Fen));
 }
 
-int32 UAI2P::GetChessValue(EChessType Type)
+FXQMove UAI2P::ToEngineMove(const FChessMove2P& Move)
 {
-    int32 value = 0;
-    switch (Type)
-    {
-    case EChessType::JIANG:
-        value = 10000;
-        break;
-    case EChessType::SHI:
-        value = 120;
-        break;
-    case EChessType::XIANG:
-        value = 120;
-        break;
-    case EChessType::MA:
-        value = 265;
-        break;
-    case EChessType::JV:
-        value = 500;
-        break;
-    case EChessType::PAO:
-        value = 270;
-        break;
-    case EChessType::BING:
-        value = 60;
-        break;
-    default:
-        break;
-    }
-    return value;
+    return FXQMove(XQMakeSquare(Move.from.X, Move.from.Y), XQMakeSquare(Move.to.X, Move.to.Y));
 }
 
-int32 UAI2P::GetChessPositionValue(EChessType Type, EChessColor Color, Position Pos)
+FChessMove2P UAI2P::FromEngineMove(FXQMove Move)
 {
-    if (PositionValues.find(Type) == PositionValues.end())
-    {
-        return 0;
-    }
-    return PositionValues[Type][Color][Pos.X][Pos.Y];
+    FChessMove2P Result(Position(XQRankOf(Move.From()), XQFileOf(Move.From())), Position(XQRankOf(Move.To()), XQFileOf(Move.To())));
+    Result.bIsValid = !Move.IsNull();
+    return Result;
 }
 
-TArray<FChessMove2P> UAI2P::GenerateAllMoves(EChessColor Color)
+uint64 UAI2P::AnalyzePositionAsync(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor InColor, int32 InMaxDepth, int32 InMultiPV,
+    TFunction<void(const FAI2PAnalysis& Analysis, bool bCancelled)> OnComplete,
+    TFunction<void(const FAI2PAnalysis& Analysis)> OnProgress)
 {
-    TArray<FChessMove2P> moves;
+    TSharedRef<const FAI2PSnapshot, ESPMode::ThreadSafe> Snapshot = MakeSnapshot(InBoard2P, InColor, InMaxDepth, InMultiPV);
 
-    for (int32 i = 0; i < 10; i++)
-    {
-        for (int32 j = 0; j < 9; j++)
-        {
-            TWeakObjectPtr<AChesses> Chess = GetChess(i, j);
-            if (!Chess.IsValid())
-            {
-                continue;
-            }
-            if (Chess->GetType() != EChessType::EMPTY && Chess->GetColor() == Color)
-            {
-                TArray<FChessMove2P> chessMoves = GenerateMovesForChess(i, j, Chess);
-                moves.Append(chessMoves);
-            }
-        }
-    }
-
-    return moves;
+    FAI2PRequest& Request = PendingRequests.Add(Snapshot->Generation);
+    Request.OnComplete = MoveTemp(OnComplete);
+    Request.OnProgress = MoveTemp(OnProgress);
+    Request.Future = SubmitAnalysis(Snapshot);
+    return Snapshot->Generation;
 }
 
-TArray<FChessMove2P> UAI2P::GenerateMovesForChess(int32 x, int32 y, TWeakObjectPtr<AChesses> chess)
+void UAI2P::CancelAnalysis(uint64 Generation)
 {
-    if (!chess.IsValid())
+    FAI2PRequest Request;
+    if (!PendingRequests.RemoveAndCopyValue(Generation, Request))
     {
-        ULogger::LogError(TEXT("Can't generate moves for chess, because chess is nullptr!"));
-        return TArray<FChessMove2P>();
+        return;
     }
-    TArray<FChessMove2P> moves;
-    EChessType type = chess->GetType();
-    EChessColor color = chess->GetColor();
 
-    switch (type)
+    Request.Future.Cancel();
+    if (Request.OnComplete)
     {
-    case EChessType::JIANG:
-        GenerateJiangMoves(x, y, color, moves);
-        break;
-    case EChessType::SHI:
-        GenerateShiMoves(x, y, color, moves);
-        break;
-    case EChessType::XIANG:
-        GenerateXiangMoves(x, y, color, moves);
-        break;
-    case EChessType::MA:
-        GenerateMaMoves(x, y, color, moves);
-        break;
-    case EChessType::JV:
-        GenerateJvMoves(x, y, color, moves);
-        break;
-    case EChessType::PAO:
-        GeneratePaoMoves(x, y, color, moves);
-        break;
-    case EChessType::BING:
-        GenerateBingMoves(x, y, color, moves);
-        break;
-    default:
-        break;
+        Request.OnComplete(FAI2PAnalysis(), true);
     }
-
-    return moves;
 }
 
-void UAI2P::GenerateJiangMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves)
+TSharedRef<const FAI2PSnapshot, ESPMode::ThreadSafe> UAI2P::MakeSnapshot(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor InColor, int32 InMaxDepth, int32 InMultiPV)
 {
-    // 将/帅的移动方向：上、下、左、右
-    int32 directions[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
-
-    for (int32 i = 0; i < 4; i++)
-    {
-        int32 newX = x + directions[i][0];
-        int32 newY = y + directions[i][1];
-
-        // 检查是否在九宫格内
-        if (IsInPalace(newX, newY, color))
-        {
-            TWeakObjectPtr<AChesses> target = GetChess(newX, newY);
-            if (target == nullptr || target->GetColor() != color)
-            {
-                moves.Add(FChessMove2P(Position(x, y), Position(newX, newY)));
-            }
-        }
-    }
-
-    // 添加将帅直接攻击的走法
-    GenerateKingDirectAttackMoves(x, y, color, moves);
+    TSharedRef<FAI2PSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FAI2PSnapshot, ESPMode::ThreadSafe>();
+    Snapshot->Generation = NextGeneration++;
+    BuildPosition(InBoard2P, InColor, Snapshot->Position);
+    EnginePosition = Snapshot->Position;
+    Snapshot->Color = InColor;
+    Snapshot->Limits.Depth = InMaxDepth;
+    Snapshot->Limits.MultiPV = InMultiPV;
+    Snapshot->Limits.MoveTimeMs = MaxTime;
+    Snapshot->Policy = MovePolicy;
+    return Snapshot;
 }
 
-void UAI2P::GenerateKingDirectAttackMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves)
+TXQJobFuture<FAI2PAnalysis> UAI2P::SubmitAnalysis(const TSharedRef<const FAI2PSnapshot, ESPMode::ThreadSafe>& Snapshot)
 {
-    // 查找对方将/帅的位置
-    EChessColor opponentColor = (color == EChessColor::BLACKCHESS) ? EChessColor::REDCHESS : EChessColor::BLACKCHESS;
-    int32 opponentKingX = -1, opponentKingY = -1;
-
-    for (int32 i = 0; i < 10; i++)
+    return JobSystem->Submit<FAI2PAnalysis>([this, Snapshot](FXQSearchContext& Context)
     {
-        for (int32 j = 0; j < 9; j++)
-        {
-            TWeakObjectPtr<AChesses> chess = GetChess(i, j);
-            if (chess.IsValid() && chess->GetType() == EChessType::JIANG && chess->GetColor() == opponentColor)
-            {
-                opponentKingX = i;
-                opponentKingY = j;
-                break;
-            }
-        }
-        if (opponentKingX != -1) break;
-    }
+        TXQSpscQueue<FAI2PMessage>* Mailbox = Mailboxes[Context.WorkerIndex].Get();
 
-    if (opponentKingX == -1) return;
-
-    // 检查是否在同一列且中间无棋子
-    if (y == opponentKingY)
-    {
-        int32 minX = FMath::Min(x, opponentKingX);
-        int32 maxX = FMath::Max(x, opponentKingX);
-        bool hasPieceBetween = false;
+        FXQSearchLimits Limits = Snapshot->Limits;
+        Limits.CancelFlag = Context.CancelFlag;
+        Context.Position = Snapshot->Position;
 
-        for (int32 checkX = minX + 1; checkX < maxX; checkX++)
+        FXQSearch::FIterationCallback OnIteration = [Mailbox, &Snapshot](const FXQSearchResult& Iteration)
         {
-            TWeakObjectPtr<AChesses> chess = GetChess(checkX, y);
-            if (chess.IsValid() && chess->GetType() != EChessType::EMPTY)
+            // 给最终结果留一个位置，放不下的进度直接丢弃
+            if (Mailbox->GetFreeSlots() > 1)
             {
-                hasPieceBetween = true;
-                break;
+                FAI2PMessage Message;
+                Message.Generation = Snapshot->Generation;
+                Message.Analysis = MakeAnalysis(Iteration, Snapshot->Color, false);
+                Mailbox->Push(MoveTemp(Message));
             }
-        }
-
-        // 如果中间没有棋子，可以吃掉对方将/帅
-        if (!hasPieceBetween)
-        {
-            moves.Add(FChessMove2P(Position(x, y), Position(opponentKingX, opponentKingY)));
-        }
-    }
-}
+        };
 
-void UAI2P::GenerateShiMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves)
-{
-    // 士/仕的移动方向：四个斜方向
-    int32 directions[4][2] = { {-1, -1}, {-1, 1}, {1, -1}, {1, 1} };
+        Context.Search.SetMovePolicy(Snapshot->Policy.Get());
+        const FXQSearchResult Result = Context.Search.Search(Context.Position, Limits, OnIteration);
+        Context.Search.SetMovePolicy(nullptr);
 
-    for (int32 i = 0; i < 4; i++)
-    {
-        int32 newX = x + directions[i][0];
-        int32 newY = y + directions[i][1];
+        FAI2PAnalysis Analysis = MakeAnalysis(Result, Snapshot->Color, true);
+        FAI2PMessage Message;
+        Message.Generation = Snapshot->Generation;
+        Message.bFinished = true;
+        Message.bCancelled = Context.IsCancelled();
+        Message.Analysis = Analysis;
 
-        // 检查是否在九宫格内
-        if (IsInPalace(newX, newY, color))
+        // 游戏线程每帧清空信箱，满了就稍等；任务被取消（包括退出时）则不再等
+        while (!Mailbox->Push(MoveTemp(Message)) && !Context.IsCancelled())
         {
-            TWeakObjectPtr<AChesses> target = GetChess(newX, newY);
-            if (target == nullptr || target->GetColor() != color)
-            {
-                moves.Add(FChessMove2P(Position(x, y), Position(newX, newY)));
-            }
+            FPlatformProcess::Yield();
         }
-    }
+        return Analysis;
+    });
 }
 
-void UAI2P::GenerateXiangMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves)
+FAI2PAnalysis UAI2P::MakeAnalysis(const FXQSearchResult& Result, EChessColor InColor, bool bFinished)
 {
-    // 象/相的移动方向：四个斜方向（走田字）
-    int32 directions[4][2] = { {-2, -2}, {-2, 2}, {2, -2}, {2, 2} };
-
-    for (int32 i = 0; i < 4; i++)
-    {
-        int32 newX = x + directions[i][0];
-        int32 newY = y + directions[i][1];
-
-        if (IsValidPosition(newX, newY))
+    FAI2PAnalysis Analysis;
+    Analysis.Color = InColor;
+    Analysis.Depth = Result.Depth;
+
+    const FXQSearchStats& Stats = Result.Stats;
+    Analysis.Stats.bFinished = bFinished;
+    Analysis.Stats.Depth = Stats.Depth;
+    Analysis.Stats.SelDepth = Stats.SelDepth;
+    Analysis.Stats.Nodes = Stats.Nodes;
+    Analysis.Stats.QNodes = Stats.QNodes;
+    Analysis.Stats.Nps = Stats.GetNps();
+    Analysis.Stats.TimeMs = Stats.TimeMs;
+    Analysis.Stats.IterationTimeMs = Stats.IterationTimeMs;
+    Analysis.Stats.FirstMoveCutoffRate = static_cast<float>(Stats.GetFirstMoveCutoffRate());
+    Analysis.Stats.ReductionSuccessRate = static_cast<float>(Stats.GetReductionSuccessRate());
+    Analysis.Stats.PolicyHitRate = static_cast<float>(Stats.GetPolicyHitRate());
+    Analysis.Stats.Engine = Stats;
+
+    for (const FXQSearchLine& EngineLine : Result.Lines)
+    {
+        FAI2PLine& Line = Analysis.Lines.AddDefaulted_GetRef();
+        Line.Move = FromEngineMove(EngineLine.Move);
+        Line.Score = EngineLine.Score;
+        Line.Depth = Result.Depth;
+        Line.bExact = EngineLine.bExact;
+        for (FXQMove Move : EngineLine.PV)
         {
-            // 检查是否过河
-            if ((color == EChessColor::BLACKCHESS && newX >= 5) || (color == EChessColor::REDCHESS && newX <= 4))
-            {
-                // 检查象眼是否被塞
-                int32 eyeX = x + directions[i][0] / 2;
-                int32 eyeY = y + directions[i][1] / 2;
-
-                if (GetChess(eyeX, eyeY) == nullptr)
-                {
-                    TWeakObjectPtr<AChesses> target = GetChess(newX, newY);
-                    if (target == nullptr || target->GetColor() != color)
-                    {
-                        moves.Add(FChessMove2P(Position(x, y), Position(newX, newY)));
-                    }
-                }
-            }
+            Line.PV.Add(FromEngineMove(Move));
         }
     }
+    return Analysis;
 }
 
-void UAI2P::GenerateMaMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves)
+void UAI2P::AppendSearchStatsCsv(const FAI2PAnalysis& Analysis) const
 {
-    // 马/傌的移动方向：八个方向（走日字）
-    int32 directions[8][2] = { {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
-                           {1, -2}, {1, 2}, {2, -1}, {2, 1} };
-    // 马腿位置
-    int32 horseLegs[8][2] = { {-1, 0}, {-1, 0}, {0, -1}, {0, 1},
-                          {0, -1}, {0, 1}, {1, 0}, {1, 0} };
-
-    for (int32 i = 0; i < 8; i++)
+    const FString Path = FPaths::ProjectSavedDir() / TEXT("AI/SearchStats.csv");
+    FString Text;
+    if (!IFileManager::Get().FileExists(*Path))
     {
-        int32 newX = x + directions[i][0];
-        int32 newY = y + directions[i][1];
-
-        if (IsValidPosition(newX, newY))
-        {
-            // 检查马腿是否被绊
-            int32 legX = x + horseLegs[i][0];
-            int32 legY = y + horseLegs[i][1];
-
-            if (GetChess(legX, legY) == nullptr)
-            {
-                TWeakObjectPtr<AChesses> target = GetChess(newX, newY);
-                if (target == nullptr || target->GetColor() != color)
-                {
-                    moves.Add(FChessMove2P(Position(x, y), Position(newX, newY)));
-                }
-            }
-        }
+        Text = FString(TEXT("color,")) + UTF8_TO_TCHAR(FXQSearchStats::GetCsvHeader()) + TEXT("\n");
     }
+    Text += Analysis.Color == EChessColor::REDCHESS ? TEXT("red,") : TEXT("black,");
+    Text += UTF8_TO_TCHAR(Analysis.Stats.Engine.ToCsvRow().c_str());
+    Text += TEXT("\n");
+    FFileHelper::SaveStringToFile(Text, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM, &IFileManager::Get(), FILEWRITE_Append);
 }
 
-void UAI2P::GenerateJvMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves)
+FChessMove2P UAI2P::SelectMoveByTemperature(const FAI2PAnalysis& Analysis, float Temperature, int32 MaxScoreLoss)
 {
-    // 车/俥的移动方向：上、下、左、右
-    int32 directions[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
-
-    for (int32 i = 0; i < 4; i++)
+    if (!Analysis.IsValid())
     {
-        int32 step = 1;
-        while (true)
-        {
-            int32 newX = x + directions[i][0] * step;
-            int32 newY = y + directions[i][1] * step;
-
-            if (!IsValidPosition(newX, newY))
-            {
-                break;
-            }
-
-            TWeakObjectPtr<AChesses> target = GetChess(newX, newY);
-            if (target == nullptr)
-            {
-                moves.Add(FChessMove2P(Position(x, y), Position(newX, newY)));
-            }
-            else
-            {
-                if (target->GetColor() != color)
-                {
-                    moves.Add(FChessMove2P(Position(x, y), Position(newX, newY)));
-                }
-                break;
-            }
-
-            step++;
-        }
+        FChessMove2P InvalidMove;
+        InvalidMove.bIsValid = false;
+        return InvalidMove;
     }
-}
 
-void UAI2P::GeneratePaoMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves)
-{
-    // 炮/砲的移动方向：上、下、左、右
-    int32 directions[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
-
-    for (int32 i = 0; i < 4; i++)
+    const FAI2PLine& BestLine = Analysis.Lines[0];
+    if (Temperature <= 0.0f)
     {
-        int32 step = 1;
-        bool foundPiece = false;
-
-        while (true)
-        {
-            int32 newX = x + directions[i][0] * step;
-            int32 newY = y + directions[i][1] * step;
-
-            if (!IsValidPosition(newX, newY))
-            {
-                break;
-            }
-
-            TWeakObjectPtr<AChesses> target = GetChess(newX, newY);
-            if (!foundPiece)
-            {
-                if (target == nullptr)
-                {
-                    moves.Add(FChessMove2P(Position(x, y), Position(newX, newY)));
-                }
-                else
-                {
-                    foundPiece = true;
-                }
-            }
-            else {
-                if (target != nullptr)
-                {
-                    if (target->GetColor() != color)
-                    {
-                        moves.Add(FChessMove2P(Position(x, y), Position(newX, newY)));
-                    }
-                    break;
-                }
-            }
-
-            step++;
-        }
+        return BestLine.Move;
     }
-}
 
-void UAI2P::GenerateBingMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves)
-{
-    // 兵/卒的移动方向
-    TArray<TPair<int32, int32>> directions;
-
-    if (color == EChessColor::BLACKCHESS)
+    // 只在精确评分且损失可接受的候选中抽样
+    TArray<float> Weights;
+    float TotalWeight = 0.0f;
+    for (const FAI2PLine& Line : Analysis.Lines)
     {
-        directions.Add({ -1, 0 });  // 黑方向下移动
-        if (x <= 4)  // 过河后可以左右移动
+        if (!Line.bExact || BestLine.Score - Line.Score > MaxScoreLoss)
         {
-            directions.Add({ 0, -1 });
-            directions.Add({ 0, 1 });
-        }
-    }
-    else
-    {
-        directions.Add({ 1, 0 });  // 红方向上移动
-        if (x >= 5) // 过河后可以左右移动
-        {
-            directions.Add({ 0, -1 });
-            directions.Add({ 0, 1 });
+            break;
         }
+        float Weight = FMath::Exp((Line.Score - BestLine.Score) / Temperature);
+        Weights.Add(Weight);
+        TotalWeight += Weight;
     }
 
-    for (TPair<int32, int32> dir : directions)
+    float Pick = FMath::FRand() * TotalWeight;
+    for (int32 i = 0; i < Weights.Num(); i++)
     {
-        int32 newX = x + dir.Key;
-        int32 newY = y + dir.Value;
-
-        if (IsValidPosition(newX, newY))
+        Pick -= Weights[i];
+        if (Pick <= 0.0f)
         {
-            TWeakObjectPtr<AChesses> target = GetChess(newX, newY);
-            if (target == nullptr || target->GetColor() != color)
-            {
-                moves.Add(FChessMove2P(Position(x, y), Position(newX, newY)));
-            }
+            return Analysis.Lines[i].Move;
         }
     }
+    return BestLine.Move;
 }
 
-WeakChessPtr UAI2P::GetChess(int32 X, int32 Y)
-{
-    return LocalAllChess[X][Y];
-}
-
-bool UAI2P::IsValidPosition(int32 x, int32 y)
+FAI2PDifficultyProfile UAI2P::GetDifficultyProfile(EAI2PDifficulty InDifficulty)
 {
-    return x >= 0 && x < 10 && y >= 0 && y < 9;
-}
-
-bool UAI2P::IsInPalace(int32 x, int32 y, EChessColor color)
-{
-    if (color == EChessColor::REDCHESS)
-    {
-        return x >= 0 && x <= 2 && y >= 3 && y <= 5;
-    }
-    else
+    FAI2PDifficultyProfile Profile;
+    switch (InDifficulty)
     {
-        return x >= 7 && x <= 9 && y >= 3 && y <= 5;
+    case EAI2PDifficulty::Easy:
+        Profile.Depth = 4;
+        Profile.MultiPV = 4;
+        Profile.Temperature = 80.0f;
+        Profile.MaxScoreLoss = 250;
+        break;
+    case EAI2PDifficulty::Normal:
+        Profile.Depth = 4;
+        Profile.MultiPV = 3;
+        Profile.Temperature = 30.0f;
+        Profile.MaxScoreLoss = 100;
+        break;
+    case EAI2PDifficulty::Hard:
+        Profile.Depth = 5;
+        Profile.MultiPV = 2;
+        Profile.Temperature = 10.0f;
+        Profile.MaxScoreLoss = 30;
+        break;
+    case EAI2PDifficulty::Master:
+        Profile.Depth = 6;
+        Profile.MultiPV = 1;
+        Profile.Temperature = 0.0f;
+        Profile.MaxScoreLoss = 0;
+        break;
+    default:
+        break;
     }
+    return Profile;
 }
 
-bool UAI2P::IsInCheck(EChessColor Color, Position KingPos)
+const FAI2PAnalysis& UAI2P::GetLastAnalysis() const
 {
-    EChessColor OppoColor = (Color == EChessColor::BLACKCHESS ? EChessColor::REDCHESS : EChessColor::BLACKCHESS);
-    auto OppoMoves = GenerateAllMoves(OppoColor);
-    for (const auto& move : OppoMoves)
-    {
-        if (move.to == KingPos)
-        {
-            return true;
-        }
-    }
-    return false;
+    return LastAnalysis;
 }
 
-Position UAI2P::GetKingPos(EChessColor Color)
+bool UAI2P::GetExpectedReply(const FChessMove2P& PlayedMove, FChessMove2P& OutReply) const
 {
-    // 找到将/帅的位置
-    int32 kingX = -1, kingY = -1;
-
-    for (int32 i = 9; i >= 0; i--)
+    for (const FAI2PLine& Line : LastAnalysis.Lines)
     {
-        for (int32 j = 3; j < 6; j++)
+        if (Line.Move.from == PlayedMove.from && Line.Move.to == PlayedMove.to)
         {
-            WeakChessPtr chess = GetChess(i, j);
-            if (chess.IsValid() && chess->GetType() == EChessType::JIANG && chess->GetColor() == Color)
+            if (Line.PV.Num() > 1)
             {
-                kingX = i;
-                kingY = j;
-                break;
+                OutReply = Line.PV[1];
+                return true;
             }
+            return false;
         }
-        if (kingX != -1) break;
     }
-    return Position(kingX, kingY);
+    return false;
 }
 
-bool UAI2P::IsJueSha(EChessColor AIColor)
+void UAI2P::StopThinkingImmediately()
 {
-    EChessColor PlayerColor = (AIColor == EChessColor::BLACKCHESS ? EChessColor::REDCHESS : EChessColor::BLACKCHESS);
-    Position KingPos = GetKingPos(AIColor);
-    Position PlayerKingPos = GetKingPos(PlayerColor);
-
-    bool InCheck = false;
-    auto PlayerMoves = GetAllPossibleMoves(PlayerColor);
+    if (JobSystem)
+    {
+        JobSystem->CancelAll();
+    }
 
-    for (const auto& move : PlayerMoves)
+    // 所有未完成的请求都以取消结束
+    TMap<uint64, FAI2PRequest> Requests = MoveTemp(PendingRequests);
+    PendingRequests.Reset();
+    for (TPair<uint64, FAI2PRequest>& Pair : Requests)
     {
-        if (move.to == KingPos) // AI被将军
+        if (Pair.Value.OnComplete)
         {
-            InCheck = true;
-            break;
+            Pair.Value.OnComplete(FAI2PAnalysis(), true);
         }
     }
+}
 
-    if (!InCheck)
+void UAI2P::PauseThinking()
+{
+    if (JobSystem)
     {
-        return false;
+        JobSystem->PauseAll();
     }
+}
 
-    auto AIMoves = GetAllPossibleMoves(AIColor);
-    for (const auto& aimove : AIMoves)
+void UAI2P::ResumeThinking()
+{
+    if (JobSystem)
     {
-        if (aimove.to == PlayerKingPos)
-        {
-            return false; // 能吃掉玩家的将，如对面笑的情况
-        }
-        WeakChessPtr chess = MakeTestMove(aimove);
-
-        auto playerMoves = GetAllPossibleMoves(PlayerColor);
-
-        bool StillInCheck = false;
-        for (const auto& player_move : playerMoves)
-        {
-            if (player_move.to == (aimove.from == KingPos ? aimove.to : KingPos))
-            {
-                StillInCheck = true;
-                break;
-            }
-        }
-
-        UndoTestMove(aimove, chess);
-
-        if (!StillInCheck) // 找到了破除将军的办法
-        {
-            InCheck = false;
-            break;
-        }
+        JobSystem->ResumeAll();
     }
+}
 
-    return InCheck;
+bool UAI2P::IsJueSha(EChessColor AIColor)
+{
+    // 没有合法走法即为绝杀：将死或困毙，象棋中困毙同样判负
+    const EXQColor Color = AIColor == EChessColor::REDCHESS ? EXQColor::Red : EXQColor::Black;
+    EnginePosition.SetSideToMove(Color);
+    return EnginePosition.IsMated();
 }
@@ -8,7 +8,12 @@
 #include "XiangQiPro/Util/ChessMove.h"
 #include "XiangQiPro/Util/Clock.h"
 
+#include "XQJobSystem.h"
+#include "XQSearch.h"
+#include "XQSpscQueue.h"
+
 #include "CoreMinimal.h"
+#include "Tickable.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "AI2P.generated.h"
 
@@ -29,15 +34,125 @@ enum class EAI2PDifficulty : uint8
     Master = 3  // 大师
 };
 
-enum class EGamePhase : uint8
+// MultiPV中的一条候选变例
+USTRUCT(BlueprintType)
+struct FAI2PLine
+{
+    GENERATED_BODY()
+
+    FChessMove2P Move;          // 根节点走法
+
+    int32 Score = 0;            // 评分（分析方视角）
+
+    int32 Depth = 0;            // 完成的搜索深度
+
+    bool bExact = false;        // 评分是否为精确值（否则只是上界）
+
+    TArray<FChessMove2P> PV;    // 主要变例，PV[0] == Move
+};
+
+// 搜索统计，各项含义见FXQSearchStats
+USTRUCT(BlueprintType)
+struct FAI2PSearchStats
+{
+    GENERATED_BODY()
+
+    // 搜索已结束，否则为某一轮迭代后的进度
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    bool bFinished = false;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    int32 Depth = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    int32 SelDepth = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    int64 Nodes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    int64 QNodes = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    int64 Nps = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    int64 TimeMs = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    int64 IterationTimeMs = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    float FirstMoveCutoffRate = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    float ReductionSuccessRate = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "AI2P")
+    float PolicyHitRate = 0.0f;
+
+    FXQSearchStats Engine;      // 引擎的原始计数，写CSV用
+};
+
+// 一次迭代加深搜索的分析结果
+USTRUCT(BlueprintType)
+struct FAI2PAnalysis
+{
+    GENERATED_BODY()
+
+    EChessColor Color = EChessColor::BLACKCHESS; // 分析方
+
+    int32 Depth = 0;            // 最后一次完整迭代的深度
+
+    TArray<FAI2PLine> Lines;    // 按评分从高到低排列，前MultiPV条为精确值
+
+    FAI2PSearchStats Stats;
+
+    bool IsValid() const { return Lines.Num() > 0 && Lines[0].Move.IsValid(); }
+};
+
+// 难度模型：在前K个候选走法中按温度抽样
+struct FAI2PDifficultyProfile
+{
+    int32 Depth = 4;            // 搜索深度
+
+    int32 MultiPV = 1;          // 候选走法数量K
+
+    float Temperature = 0.0f;   // 温度（分），0表示总是走最佳走法
+
+    int32 MaxScoreLoss = 0;     // 允许相对最佳走法损失的最大分数
+};
+
+// 一次分析的输入，在游戏线程创建后不再修改，搜索线程只读
+struct FAI2PSnapshot
 {
-    Opening = 0,
-    Middle = 1,
-    Ending = 2
+    uint64 Generation = 0;      // 请求编号，结果按它交回请求方
+
+    FXQPosition Position;
+
+    EChessColor Color = EChessColor::BLACKCHESS; // 分析方
+
+    FXQSearchLimits Limits;
+
+    TSharedPtr<FXQMovePolicy, ESPMode::ThreadSafe> Policy; // 搜索期间持有先验对象的引用
 };
 
+// 搜索线程交给游戏线程的消息
+struct FAI2PMessage
+{
+    uint64 Generation = 0;
+
+    bool bFinished = false;     // false为一轮迭代后的进度，true为最终结果
+
+    bool bCancelled = false;
+
+    FAI2PAnalysis Analysis;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnAI2PSearchStats, const FAI2PSearchStats&);
+
 UCLASS()
-class XIANGQIPRO_API UAI2P : public UGameInstanceSubsystem
+class XIANGQIPRO_API UAI2P : public UGameInstanceSubsystem, public FTickableGameObject
 {
     GENERATED_BODY()
 
@@ -46,90 +161,146 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI2P")
     EAI2PDifficulty AIDifficulty = EAI2PDifficulty::Hard;
 
+    // 每次异步搜索结束时把统计追加到Saved/AI/SearchStats.csv
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI2P")
+    bool bDumpSearchStats = false;
+
+    // 异步搜索每完成一轮迭代及结束时在游戏线程广播
+    FOnAI2PSearchStats OnSearchStats;
+
     // 构造函数
     UAI2P();
 
-    // 核心：获取AI最优走法
-    FChessMove2P GetBestMove(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor InAiColor, EAI2PDifficulty InDifficulty);
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 
-    // 立刻停止搜索
-    UFUNCTION(BlueprintCallable, Category = "Chess AI")
-    void StopThinkingImmediately();
+    virtual void Deinitialize() override;
 
-    // 设置棋盘引用
-    void SetBoard(TWeakObjectPtr<UChessBoard2P> newBoard);
+    // 在游戏线程取出搜索线程交回的进度和结果
+    virtual void Tick(float DeltaTime) override;
 
-private:
+    virtual bool IsTickable() const override { return JobSystem.IsValid(); }
 
-    bool bStopThinking = false;;
+    virtual bool IsTickableWhenPaused() const override { return true; }
 
-    int32 MaxTime = 10000;
+    virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UAI2P, STATGROUP_Tickables); }
 
-    FClock Clock;
+    /*
+    * 在常驻搜索线程上做一次迭代加深搜索，得到前K个走法及其评分和主要变例。
+    * 局面在调用时（游戏线程）做成快照，之后棋盘的变化不影响本次搜索。
+    * 只有异步接口：PauseThinking之后搜索线程停在暂停处，只有游戏线程能ResumeThinking，游戏线程不能阻塞等待结果
+    * @param InColor 分析方
+    * @param InMaxDepth 最大搜索深度
+    * @param InMultiPV 需要精确评分的候选走法数量
+    * @param OnComplete 在游戏线程调用，请求被取消时bCancelled为true
+    * @param OnProgress 每完成一轮迭代在游戏线程调用，可以为空
+    * @return 请求编号，用于CancelAnalysis和IsAnalyzing
+    */
+    uint64 AnalyzePositionAsync(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor InColor, int32 InMaxDepth, int32 InMultiPV,
+        TFunction<void(const FAI2PAnalysis& Analysis, bool bCancelled)> OnComplete,
+        TFunction<void(const FAI2PAnalysis& Analysis)> OnProgress = nullptr);
 
-    EGamePhase Phase;
+    // 取消一个分析请求：OnComplete立刻以bCancelled调用，之后该请求的进度和结果都被丢弃
+    void CancelAnalysis(uint64 Generation);
 
-    EChessColor GlobalAIColor = EChessColor::BLACKCHESS;
+    // 请求是否还未完成
+    bool IsAnalyzing(uint64 Generation) const { return PendingRequests.Contains(Generation); }
 
-    EChessColor GlobalPlayerColor = EChessColor::REDCHESS;
+    // 按温度在候选走法中选择一步
+    static FChessMove2P SelectMoveByTemperature(const FAI2PAnalysis& Analysis, float Temperature, int32 MaxScoreLoss);
 
-    TArray<TArray<WeakChessPtr>> LocalAllChess;  // 10行9列的棋盘
+    // 获取难度对应的搜索参数
+    static FAI2PDifficultyProfile GetDifficultyProfile(EAI2PDifficulty InDifficulty);
 
-    std::unordered_map<EChessType, std::unordered_map<EChessColor, TArray<TArray<int32>>>> PositionValues;
+    // 最近一次搜索的分析结果
+    const FAI2PAnalysis& GetLastAnalysis() const;
 
-private:
+    /*
+    * 提示：返回上次AI所走变例中预期的对方应着，无需再次搜索
+    * @param PlayedMove AI实际走出的着法
+    */
+    bool GetExpectedReply(const FChessMove2P& PlayedMove, FChessMove2P& OutReply) const;
+
+    // 立刻停止搜索，取消所有未完成的分析请求
+    UFUNCTION(BlueprintCallable, Category = "Chess AI")
+    void StopThinkingImmediately();
+
+    // 暂停搜索：搜索线程停在原处等待，不占用CPU；暂停期间提交的分析也在开始时停下
+    UFUNCTION(BlueprintCallable, Category = "Chess AI")
+    void PauseThinking();
 
-    std::pair<FChessMove2P, int32> Minimax(int32 depth, int32 alpha, int32 beta, bool maximiziongPlayer);
+    // 恢复搜索，从暂停处继续
+    UFUNCTION(BlueprintCallable, Category = "Chess AI")
+    void ResumeThinking();
 
-    int32 EvaluateBoard(EChessColor Color);
+    // 设置棋盘引用（同步引擎局面）
+    void SetBoard(TWeakObjectPtr<UChessBoard2P> newBoard);
 
-    // 获取所有可能走法
-    TArray<FChessMove2P> GetAllPossibleMoves(EChessColor Color);
+    // 设置走法先验（策略网络），搜索前几层按它排序并减少低先验走法的深度；为空时只用传统排序
+    void SetMovePolicy(TSharedPtr<FXQMovePolicy, ESPMode::ThreadSafe> InPolicy);
 
-    WeakChessPtr MakeTestMove(FChessMove2P Move);
+    // 游戏走法与引擎走法互相转换
+    static FXQMove ToEngineMove(const FChessMove2P& Move);
 
-    void UndoTestMove(FChessMove2P Move, WeakChessPtr OriginalChess);
+    static FChessMove2P FromEngineMove(FXQMove Move);
 
-    int32 GetChessValue(EChessType Type);
+    // 由棋盘构造引擎局面
+    static void BuildPosition(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor SideToMove, FXQPosition& OutPosition);
 
-    int32 GetChessPositionValue(EChessType Type, EChessColor Color, Position Pos);
+    // 棋盘的FEN表示
+    static FString GetBoardFen(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor SideToMove);
 
-    // 生成所有合法走法
-    TArray<FChessMove2P> GenerateAllMoves(EChessColor color);
+private:
 
-    TArray<FChessMove2P> GenerateMovesForChess(int32 x, int32 y, TWeakObjectPtr<AChesses> chess);
+    int32 MaxTime = 10000;
 
-    void GenerateJiangMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves);
+    // 搜索线程数，AI走棋和提示各用一个
+    int32 NumSearchWorkers = 2;
 
-    void GenerateKingDirectAttackMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves);
+    FAI2PAnalysis LastAnalysis;
 
-    void GenerateShiMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves);
+    // 与当前棋盘同步的引擎局面
+    FXQPosition EnginePosition;
 
-    void GenerateXiangMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves);
+    // 每个搜索线程一个信箱：该线程是唯一的生产者，游戏线程是唯一的消费者
+    TArray<TUniquePtr<TXQSpscQueue<FAI2PMessage>>> Mailboxes;
 
-    void GenerateMaMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves);
+    // 信箱容量；进度消息总给最终结果留出一个位置，放不下时丢弃
+    uint32 MailboxCapacity = 64;
 
-    void GenerateJvMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves);
+    // 常驻的搜索线程及其搜索上下文，整个游戏实例期间保留
+    TUniquePtr<FXQJobSystem> JobSystem;
 
-    void GeneratePaoMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves);
+    TSharedPtr<FXQMovePolicy, ESPMode::ThreadSafe> MovePolicy;
 
-    void GenerateBingMoves(int32 x, int32 y, EChessColor color, TArray<FChessMove2P>& moves);
+    // 一个未完成的异步分析请求（只在游戏线程访问）
+    struct FAI2PRequest
+    {
+        TXQJobFuture<FAI2PAnalysis> Future;
 
-    WeakChessPtr GetChess(int32 X, int32 Y);
+        TFunction<void(const FAI2PAnalysis&, bool)> OnComplete;
 
-    // 检查位置是否在棋盘内
-    bool IsValidPosition(int32 x, int32 y);
+        TFunction<void(const FAI2PAnalysis&)> OnProgress;
+    };
 
-    // 检查位置是否在九宫格内
-    bool IsInPalace(int32 x, int32 y, EChessColor color);
+    // 按请求编号索引，取消或完成后移除，找不到编号的消息即为过期
+    TMap<uint64, FAI2PRequest> PendingRequests;
 
-    bool IsInCheck(EChessColor Color, Position KingPos);
+    uint64 NextGeneration = 1;
 
-    // 找到将的位置
-    Position GetKingPos(EChessColor Color);
+    // 引擎搜索结果转为分析结果
+    static FAI2PAnalysis MakeAnalysis(const FXQSearchResult& Result, EChessColor InColor, bool bFinished);
+
+    // 追加一行搜索统计到CSV
+    void AppendSearchStatsCsv(const FAI2PAnalysis& Analysis) const;
+
+    // 在游戏线程由棋盘生成快照
+    TSharedRef<const FAI2PSnapshot, ESPMode::ThreadSafe> MakeSnapshot(TWeakObjectPtr<UChessBoard2P> InBoard2P, EChessColor InColor, int32 InMaxDepth, int32 InMultiPV);
+
+    // 提交一次搜索，在工作线程中执行，进度和结果送进该线程的信箱
+    TXQJobFuture<FAI2PAnalysis> SubmitAnalysis(const TSharedRef<const FAI2PSnapshot, ESPMode::ThreadSafe>& Snapshot);
 
 public:
 
     // 检查是否绝杀
     bool IsJueSha(EChessColor AIColor);
-};
\ No newline at end of file
+};
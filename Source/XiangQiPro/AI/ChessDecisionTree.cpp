@@ -3,241 +3,67 @@
 
 #include "ChessDecisionTree.h"
 #include "Misc/FileHelper.h"
+#include "XQMLWorkerPool.h"
 
-ChessDecisionTree::ChessDecisionTree(int32 InMaxDepth, int32 InMinSamplesSplit)
+ChessDecisionTree::ChessDecisionTree(int32 InMaxDepth, int32 InMinSamplesSplit, int32 InNumTrees)
     : MaxDepth(InMaxDepth)
     , MinSamplesSplit(InMinSamplesSplit)
+    , NumTrees(FMath::Max(InNumTrees, 1))
 {
 }
 
-void ChessDecisionTree::Train(const TArray<TArray<float>>& Features, const TArray<TArray<float>>& Labels)
+void ChessDecisionTree::Train(const FXQMLTreeData& Data, const TArray<int32>& Samples, int32 NumThreads)
 {
-    if (Features.Num() == 0 || Labels.Num() == 0)
+    if (Samples.Num() == 0)
     {
         return;
     }
 
-    NumFeatures = Features[0].Num();
-    NumClasses = Labels[0].Num();
-
-    Root = BuildTree(Features, Labels, 0);
-}
-
-TArray<float> ChessDecisionTree::Predict(const TArray<float>& Features) const
-{
-    if (!Root.IsValid())
+    FXQMLForestSettings Settings;
+    Settings.NumTrees = NumTrees;
+    Settings.Tree.MaxDepth = MaxDepth;
+    Settings.Tree.MinSamplesSplit = MinSamplesSplit;
+    if (NumTrees > 1)
     {
-        return TArray<float>();
+        // ɭ֣ÿڵֻøĻֲͬ
+        Settings.Tree.FeatureFraction = 0.3f;
     }
 
-    TSharedPtr<ChessDecisionTreeNode> CurrentNode = Root;
-
-    while (CurrentNode.IsValid() && !CurrentNode->bIsLeaf)
-    {
-        if (Features[CurrentNode->FeatureIndex] <= CurrentNode->Threshold)
-        {
-            CurrentNode = CurrentNode->LeftChild;
-        }
-        else
-        {
-            CurrentNode = CurrentNode->RightChild;
-        }
-    }
-
-    return CurrentNode.IsValid() ? CurrentNode->Predictions : TArray<float>();
+    FXQMLWorkerPool Pool(FMath::Max(NumThreads, 1));
+    Forest.Train(Data, Samples.GetData(), Samples.Num(), Settings, &Pool);
 }
 
-TSharedPtr<ChessDecisionTreeNode> ChessDecisionTree::BuildTree(const TArray<TArray<float>>& Features,
-    const TArray<TArray<float>>& Labels,
-    int32 Depth)
+void ChessDecisionTree::Evaluate(const FXQMLTreeData& Data, const TArray<int32>& Samples, int32 NumThreads, float& OutAccuracy, float& OutLoss) const
 {
-    if (Features.Num() < MinSamplesSplit || Depth >= MaxDepth)
-    {
-        // Ҷӽڵ
-        TSharedPtr<ChessDecisionTreeNode> LeafNode = MakeShared<ChessDecisionTreeNode>();
-        LeafNode->bIsLeaf = true;
-
-        // ƽԤֵ
-        LeafNode->Predictions.SetNum(NumClasses);
-        for (int32 i = 0; i < NumClasses; i++)
-        {
-            float Sum = 0.0f;
-            for (const TArray<float>& Label : Labels)
-            {
-                Sum += Label[i];
-            }
-            LeafNode->Predictions[i] = Sum / Labels.Num();
-        }
-
-        return LeafNode;
-    }
-
-    // Ѱѻ
-    auto BestSplit = GetBestSplit(Features, Labels);
-    int32 BestFeature = BestSplit.first;
-    float BestThreshold = BestSplit.second;
-
-    if (BestFeature == -1)
-    {
-        // ޷֣Ҷӽڵ
-        return BuildTree(Features, Labels, Depth + 1);
-    }
-
-    // ѻַָ
-    TArray<TArray<float>> LeftFeatures, RightFeatures;
-    TArray<TArray<float>> LeftLabels, RightLabels;
-
-    for (int32 i = 0; i < Features.Num(); i++)
-    {
-        if (Features[i][BestFeature] <= BestThreshold)
-        {
-            LeftFeatures.Add(Features[i]);
-            LeftLabels.Add(Labels[i]);
-        }
-        else
-        {
-            RightFeatures.Add(Features[i]);
-            RightLabels.Add(Labels[i]);
-        }
-    }
-
-    // ָĳһûݣҶӽڵ
-    if (LeftFeatures.Num() == 0 || RightFeatures.Num() == 0)
-    {
-        return BuildTree(Features, Labels, Depth + 1);
-    }
-
-    // ڲڵ
-    TSharedPtr<ChessDecisionTreeNode> Node = MakeShared<ChessDecisionTreeNode>();
-    Node->FeatureIndex = BestFeature;
-    Node->Threshold = BestThreshold;
-    Node->bIsLeaf = false;
-
-    // ݹ鹹
-    Node->LeftChild = BuildTree(LeftFeatures, LeftLabels, Depth + 1);
-    Node->RightChild = BuildTree(RightFeatures, RightLabels, Depth + 1);
-
-    return Node;
-}
-
-std::pair<int32, float> ChessDecisionTree::GetBestSplit(const TArray<TArray<float>>& Features,
-    const TArray<TArray<float>>& Labels)
-{
-    int32 BestFeature = -1;
-    float BestThreshold = 0.0f;
-    float BestGain = -MAX_FLT;
-
-    // ÿ
-    for (int32 FeatureIndex = 0; FeatureIndex < NumFeatures; FeatureIndex++)
-    {
-        // ռпֵ
-        TArray<float> FeatureValues;
-        for (const TArray<float>& Feature : Features)
-        {
-            FeatureValues.Add(Feature[FeatureIndex]);
-        }
-
-        // ȥ
-        FeatureValues.Sort();
-        TArray<float> UniqueValues;
-        for (float Value : FeatureValues)
-        {
-            if (UniqueValues.Num() == 0 || Value != UniqueValues.Last())
-            {
-                UniqueValues.Add(Value);
-            }
-        }
-
-        // ÿܵķָ
-        for (int32 i = 0; i < UniqueValues.Num() - 1; i++)
-        {
-            float Threshold = (UniqueValues[i] + UniqueValues[i + 1]) / 2.0f;
-            float Gain = CalculateInformationGain(Features, Labels, FeatureIndex, Threshold);
-
-            if (Gain > BestGain)
-            {
-                BestGain = Gain;
-                BestFeature = FeatureIndex;
-                BestThreshold = Threshold;
-            }
-        }
-    }
-
-    return { BestFeature, BestThreshold };
+    FXQMLWorkerPool Pool(FMath::Max(NumThreads, 1));
+    Forest.Evaluate(Data, Samples.GetData(), Samples.Num(), &Pool, OutAccuracy, OutLoss);
 }
 
-float ChessDecisionTree::CalculateInformationGain(const TArray<TArray<float>>& Features,
-    const TArray<TArray<float>>& Labels,
-    int32 FeatureIndex, float Threshold)
+TArray<float> ChessDecisionTree::Predict(const TArray<float>& Features) const
 {
-    // 㸸ڵĻ᲻
-    float ParentGini = CalculateGiniImpurity(Labels);
-
-    // ֵָ
-    TArray<TArray<float>> LeftLabels, RightLabels;
-
-    for (int32 i = 0; i < Features.Num(); i++)
+    TArray<float> Predictions;
+    if (Forest.IsEmpty() || Features.Num() < Forest.GetNumFeatures())
     {
-        if (Features[i][FeatureIndex] <= Threshold)
-        {
-            LeftLabels.Add(Labels[i]);
-        }
-        else
-        {
-            RightLabels.Add(Labels[i]);
-        }
+        return Predictions;
     }
 
-    // Ȩƽ᲻
-    float WeightedGini = 0.0f;
-    WeightedGini += (LeftLabels.Num() / (float)Labels.Num()) * CalculateGiniImpurity(LeftLabels);
-    WeightedGini += (RightLabels.Num() / (float)Labels.Num()) * CalculateGiniImpurity(RightLabels);
-
-    // Ϣ = ڵ㲻 - ӽڵȨ
-    return ParentGini - WeightedGini;
+    Predictions.SetNumUninitialized(Forest.GetNumClasses());
+    Forest.Predict(Features.GetData(), Predictions.GetData());
+    return Predictions;
 }
 
-float ChessDecisionTree::CalculateGiniImpurity(const TArray<TArray<float>>& Labels)
+void ChessDecisionTree::PredictBatch(const float* Features, int32 Count, float* OutDistributions) const
 {
-    if (Labels.Num() == 0) return 0.0f;
-
-    // ÿĸ
-    TArray<float> ClassProbabilities;
-    ClassProbabilities.SetNum(NumClasses);
-
-    for (const TArray<float>& Label : Labels)
-    {
-        for (int32 i = 0; i < NumClasses; i++)
-        {
-            ClassProbabilities[i] += Label[i];
-        }
-    }
-
-    // һ
-    for (int32 i = 0; i < NumClasses; i++)
-    {
-        ClassProbabilities[i] /= Labels.Num();
-    }
-
-    // ᲻: 1 - sum(p_i^2)
-    float Gini = 1.0f;
-    for (float Prob : ClassProbabilities)
-    {
-        Gini -= Prob * Prob;
-    }
-
-    return Gini;
+    Forest.PredictBatch(Features, Count, OutDistributions);
 }
 
 bool ChessDecisionTree::SaveToFile(const FString& FilePath) const
 {
-    TArray<uint8> Data;
-    FMemoryWriter Writer(Data);
-
-    // ṹ
-    SerializeNode(Root, Writer);
+    // ļͷ֮ǸĽڵҶԤأڴ沼ͬ
+    std::vector<uint8> Data;
+    SaveToMemory(Data);
 
-    return FFileHelper::SaveArrayToFile(Data, *FilePath);
+    return FFileHelper::SaveArrayToFile(TArrayView<const uint8>(Data.data(), static_cast<int32>(Data.size())), *FilePath);
 }
 
 bool ChessDecisionTree::LoadFromFile(const FString& FilePath)
@@ -248,72 +74,16 @@ bool ChessDecisionTree::LoadFromFile(const FString& FilePath)
         return false;
     }
 
-    FMemoryReader Reader(Data);
-    Root = DeserializeNode(Reader);
-
-    return Root.IsValid();
+    // ɰݹʽļûļͷᱻܾҪѵ
+    return LoadFromMemory(Data.GetData(), Data.Num());
 }
 
-void ChessDecisionTree::SerializeNode(TSharedPtr<ChessDecisionTreeNode> Node, FMemoryWriter& Writer) const
+void ChessDecisionTree::SaveToMemory(std::vector<uint8>& OutData) const
 {
-    if (!Node.IsValid())
-    {
-        int32 IsNull = 1;
-        Writer << IsNull;
-        return;
-    }
-
-    int32 IsNull = 0;
-    Writer << IsNull;
-    Writer << Node->bIsLeaf;
-    Writer << Node->FeatureIndex;
-    Writer << Node->Threshold;
-
-    if (Node->bIsLeaf)
-    {
-        int32 NumPredictions = Node->Predictions.Num();
-        Writer << NumPredictions;
-        for (float Prediction : Node->Predictions)
-        {
-            Writer << Prediction;
-        }
-    }
-    else
-    {
-        SerializeNode(Node->LeftChild, Writer);
-        SerializeNode(Node->RightChild, Writer);
-    }
+    Forest.Serialize(OutData);
 }
 
-TSharedPtr<ChessDecisionTreeNode> ChessDecisionTree::DeserializeNode(FMemoryReader& Reader)
+bool ChessDecisionTree::LoadFromMemory(const uint8* Data, int64 Size)
 {
-    int32 IsNull = 0;
-    Reader << IsNull;
-    if (IsNull == 1)
-    {
-        return nullptr;
-    }
-
-    TSharedPtr<ChessDecisionTreeNode> Node = MakeShared<ChessDecisionTreeNode>();
-    Reader << Node->bIsLeaf;
-    Reader << Node->FeatureIndex;
-    Reader << Node->Threshold;
-
-    if (Node->bIsLeaf)
-    {
-        int32 NumPredictions = 0;
-        Reader << NumPredictions;
-        Node->Predictions.SetNum(NumPredictions);
-        for (int32 i = 0; i < NumPredictions; i++)
-        {
-            Reader << Node->Predictions[i];
-        }
-    }
-    else
-    {
-        Node->LeftChild = DeserializeNode(Reader);
-        Node->RightChild = DeserializeNode(Reader);
-    }
-
-    return Node;
-}
\ No newline at end of file
+    return Forest.Deserialize(Data, Size);
+}
@@ -2,66 +2,48 @@
 
 #pragma once
 
-#include "CoreMinimal.h"// 򵥵ľڵ
-struct ChessDecisionTreeNode
-{
-    int32 FeatureIndex = -1;      // 
-    float Threshold = 0.0f;       // ֵ
-    TSharedPtr<ChessDecisionTreeNode> LeftChild;  // 
-    TSharedPtr<ChessDecisionTreeNode> RightChild; // 
-    TArray<float> Predictions;    // ҶӽڵԤֵ
-    bool bIsLeaf = false;         // ǷΪҶӽڵ
-};
+#include "CoreMinimal.h"
+#include "XQMLTree.h"
 
-// 
+// ࣺһɭ֣ÿĽڵ㰴һУҶӵԤһĳ
 class XIANGQIPRO_API ChessDecisionTree
 {
 public:
-    ChessDecisionTree(int32 MaxDepth = 10, int32 MinSamplesSplit = 2);
+    ChessDecisionTree(int32 MaxDepth = 10, int32 MinSamplesSplit = 2, int32 NumTrees = 1);
+
+    // ѵSamplesΪDataвѵظNumThreads̡߳
+    // ʱѵ
+    void Train(const FXQMLTreeData& Data, const TArray<int32>& Samples, int32 NumThreads = 1);
+
+    // ϼ׼ȷʺƽ
+    void Evaluate(const FXQMLTreeData& Data, const TArray<int32>& Samples, int32 NumThreads, float& OutAccuracy, float& OutLoss) const;
 
-    // ѵ
-    void Train(const TArray<TArray<float>>& Features, const TArray<TArray<float>>& Labels);
+    bool IsTrained() const { return !Forest.IsEmpty(); }
 
-    // Ԥ
+    int32 GetNumClasses() const { return Forest.GetNumClasses(); }
+
+    int32 GetNumTrees() const { return Forest.GetNumTrees(); }
+
+    // Ԥ⣺Ҷӷֲƽ
     TArray<float> Predict(const TArray<float>& Features) const;
 
+    // Ԥ⣺FeaturesΪCount*OutDistributionsΪCount*
+    void PredictBatch(const float* Features, int32 Count, float* OutDistributions) const;
+
     // 
     bool SaveToFile(const FString& FilePath) const;
 
     // ؾ
     bool LoadFromFile(const FString& FilePath);
 
-    // Ϣ
-    float CalculateInformationGain(
-        const TArray<TArray<float>>& Features,
-        const TArray<TArray<float>>& Labels,
-        int32 FeatureIndex,
-        float Threshold);
+    // ļʽͬдģͰ
+    void SaveToMemory(std::vector<uint8>& OutData) const;
 
-    float CalculateGiniImpurity(const TArray<TArray<float>>& Labels);
+    bool LoadFromMemory(const uint8* Data, int64 Size);
 
 private:
-    // ݹ鹹
-    TSharedPtr<ChessDecisionTreeNode> BuildTree(
-        const TArray<TArray<float>>& Features,
-        const TArray<TArray<float>>& Labels,
-        int32 Depth);
-
-    // ȡѻ
-    std::pair<int32, float> GetBestSplit(
-        const TArray<TArray<float>>& Features,
-        const TArray<TArray<float>>& Labels);
-
-    // лڵ
-    void SerializeNode(TSharedPtr<ChessDecisionTreeNode> Node, FMemoryWriter& Writer) const;
-
-    // лڵ
-    TSharedPtr<ChessDecisionTreeNode> DeserializeNode(FMemoryReader& Reader);
-
-private:
-    TSharedPtr<ChessDecisionTreeNode> Root;
+    FXQMLForest Forest;
     int32 MaxDepth = 10;
     int32 MinSamplesSplit = 2;
-    int32 NumFeatures = 0;
-    int32 NumClasses = 0;
-};
\ No newline at end of file
+    int32 NumTrees = 1;
+};
@@ -3,21 +3,318 @@
 
 #include "ChessMLModule.h"
 #include "ChessDecisionTree.h"
+#include "ChessTrainingJob.h"
 
 #include "XiangQiPro/Util/AsyncWorker.h"
 #include "XiangQiPro/Util/Logger.h"
 
+#include "XQMLDataset.h"
+#include "XQMLKernels.h"
+#include "XQMLMovePolicy.h"
+#include "XQMLQuantized.h"
+#include "XQModelBundle.h"
+#include "XQPosition.h"
+#include "XQTrainingLog.h"
+
+#include "Async/Async.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/ScopeExit.h"
+#include "Misc/ScopeLock.h"
 #include "Serialization/JsonSerializer.h"
 #include "Serialization/JsonWriter.h"
+#include "Serialization/MemoryReader.h"
+
+// 约十六分之一的样本留作验证集。按样本的稳定键（GetXQTrainingRecordKey）划分，不按下标：
+// 日志压缩、自我对弈数据增减后同一条样本不会换边，完整训练、增量训练和决策树使用同一份
+static bool IsValidationSample(uint64 RecordKey)
+{
+    return ((RecordKey * 0x9E3779B97F4A7C15ull) >> 60) == 0;
+}
+
+// FString形式的FEN和走法在栈上转成UTF-8后直接解析，不经过std::string
+static bool ParseFenString(const FString& Fen, FXQPosition& OutPosition)
+{
+    FTCHARToUTF8 Utf8(*Fen);
+    return OutPosition.SetFromFen(Utf8.Get(), Utf8.Length());
+}
+
+static bool ParseMoveString(const FString& Move, FXQMove& OutMove)
+{
+    FTCHARToUTF8 Utf8(*Move);
+    return XQParseMove(Utf8.Get(), Utf8.Length(), OutMove);
+}
+
+// 增量训练检查点的文件头
+static constexpr uint32 XQIncrementalCheckpointMagic = 0x43495158; // "XQIC"
+
+// 在独立线程上运行一个函数
+class FChessMLRunnable : public FRunnable
+{
+public:
+    explicit FChessMLRunnable(TUniqueFunction<void()> InWork)
+        : Work(MoveTemp(InWork))
+    {
+    }
+
+    virtual uint32 Run() override
+    {
+        Work();
+        return 0;
+    }
+
+private:
+    TUniqueFunction<void()> Work;
+};
+
+// 增量训练的进度：对局开始时停在两个小批量之间，对局结束后从这里继续
+struct FChessIncrementalTrainingState
+{
+    FXQMLNetwork Candidate;         // 正在微调的网络
+
+    int64 BaseTimestamp = 0;        // 基础模型的LastSampleTimestamp，模型换过后进度作废
+
+    int64 BatchesDone = 0;
+
+    bool bFromScratch = false;      // 还没有模型，从随机权重开始训练
+};
+
+// StartTraining的输入和结果：游戏线程准备好输入，训练线程只读写这里、不碰模块的状态，完成回调在游戏线程一次换上
+struct FChessTrainingOutput
+{
+    TSharedPtr<FXQTrainingLog, ESPMode::ThreadSafe> TrainingLog;
+
+    FString DataDir;                // 训练日志和训练集快照所在的目录
+
+    TArray<FString> ChunkPaths;     // 自我对弈数据
+
+    FXQMLDataset Dataset;           // 训练线程映射的训练集，训练结束即释放
+
+    int64 NewestTimestamp = 0;      // 训练集中最新一条日志样本的时间
+
+    TSharedPtr<const FXQMLNetwork, ESPMode::ThreadSafe> BaseNetwork; // 开始时的网络，训练线程复制一份再训练
+
+    FXQMLNetwork Network;           // 训练线程中的网络，训练后为新网络
+
+    TSharedPtr<FXQModelBundle, ESPMode::ThreadSafe> BaseBundle; // 当前网络只在模型包中时，由训练线程读出
+
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> QuantizedNetwork;
+
+    TSharedPtr<ChessDecisionTree> DecisionTree;
+
+    FMLTrainingResult Status;       // 开始时为当前的训练状态
+
+    bool bSucceeded = false;
+};
+
+// 网络结构和每层的权重、偏置整块写入
+static void WriteNetwork(FArchive& Writer, const FXQMLNetwork& InNetwork)
+{
+    int32 NumLayers = InNetwork.GetNumLayers();
+    Writer << NumLayers;
+
+    for (int32 i = 0; i < NumLayers; i++)
+    {
+        const FXQMLLayer& Layer = InNetwork.GetLayer(i);
+
+        int32 NumWeights = static_cast<int32>(Layer.Weights.size());
+        Writer << NumWeights;
+        Writer.Serialize(const_cast<float*>(Layer.Weights.data()), sizeof(float) * NumWeights);
+
+        int32 NumBiases = static_cast<int32>(Layer.Biases.size());
+        Writer << NumBiases;
+        Writer.Serialize(const_cast<float*>(Layer.Biases.data()), sizeof(float) * NumBiases);
+    }
+}
+
+static bool ReadNetwork(FArchive& Reader, FXQMLNetwork& OutNetwork, const FString& Source)
+{
+    int32 NumLayers = 0;
+    Reader << NumLayers;
+
+    std::vector<FXQMLLayer> Layers(FMath::Max(0, NumLayers));
+    for (FXQMLLayer& Layer : Layers)
+    {
+        int32 NumWeights = 0;
+        Reader << NumWeights;
+        if (NumWeights <= 0 || NumWeights > (Reader.TotalSize() - Reader.Tell()) / 4)
+        {
+            return false;
+        }
+        Layer.Weights.resize(NumWeights);
+        Reader.Serialize(Layer.Weights.data(), sizeof(float) * NumWeights);
+
+        int32 NumBiases = 0;
+        Reader << NumBiases;
+        if (NumBiases <= 0 || NumBiases > (Reader.TotalSize() - Reader.Tell()) / 4)
+        {
+            return false;
+        }
+        Layer.Biases.resize(NumBiases);
+        Reader.Serialize(Layer.Biases.data(), sizeof(float) * NumBiases);
+
+        // 权重为[输出][输入]，输出数即偏置数
+        Layer.OutputSize = NumBiases;
+        Layer.InputSize = NumWeights / NumBiases;
+    }
+
+    if (Reader.IsError() || Layers.empty())
+    {
+        return false;
+    }
+
+    // 旧版模型的输出层是全部8100个格子对，与现在的策略输出不兼容，需要重新训练
+    if (Layers.front().InputSize != XQ_ML_NUM_FEATURES || Layers.back().OutputSize != XQ_ML_NUM_MOVES)
+    {
+        ULogger::LogWarning(FString::Printf(TEXT("Neural network in %s has %d outputs, expected %d; it will be retrained"),
+            *Source, Layers.back().OutputSize, XQ_ML_NUM_MOVES));
+        return false;
+    }
+
+    return OutNetwork.SetLayers(MoveTemp(Layers));
+}
+
+// 模型包中的浮点权重
+static bool ReadNetworkSection(const FXQModelBundle& Bundle, FXQMLNetwork& OutNetwork, const FString& Source)
+{
+    FXQModelBundleSection Section;
+    if (!Bundle.FindSection(EXQModelSection::NetworkWeights, Section))
+    {
+        return false;
+    }
+    FMemoryReaderView Reader(TArrayView<const uint8>(Section.Data, static_cast<int32>(Section.Size)));
+    return ReadNetwork(Reader, OutNetwork, Source);
+}
+
+static FString TrainingResultToJson(const FMLTrainingResult& Result)
+{
+    TSharedPtr<FJsonObject> ResultObject = MakeShared<FJsonObject>();
+    ResultObject->SetNumberField("EpochsTrained", Result.EpochsTrained);
+    ResultObject->SetNumberField("Accuracy", Result.Accuracy);
+    ResultObject->SetNumberField("Loss", Result.Loss);
+    ResultObject->SetNumberField("TreeAccuracy", Result.TreeAccuracy);
+    ResultObject->SetNumberField("TreeLoss", Result.TreeLoss);
+    ResultObject->SetStringField("LastTrainingTime", Result.LastTrainingTime.ToString());
+    ResultObject->SetNumberField("LastSampleTimestamp", static_cast<double>(Result.LastSampleTimestamp));
+
+    FString OutputString;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
+    FJsonSerializer::Serialize(ResultObject.ToSharedRef(), Writer);
+    return OutputString;
+}
+
+static bool TrainingResultFromJson(const FString& Json, FMLTrainingResult& OutResult)
+{
+    TSharedPtr<FJsonObject> ResultObject;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Json);
+    if (!FJsonSerializer::Deserialize(Reader, ResultObject) || !ResultObject.IsValid())
+    {
+        return false;
+    }
+
+    ResultObject->TryGetNumberField(TEXT("EpochsTrained"), OutResult.EpochsTrained);
+    ResultObject->TryGetNumberField(TEXT("Accuracy"), OutResult.Accuracy);
+    ResultObject->TryGetNumberField(TEXT("Loss"), OutResult.Loss);
+    ResultObject->TryGetNumberField(TEXT("TreeAccuracy"), OutResult.TreeAccuracy);
+    ResultObject->TryGetNumberField(TEXT("TreeLoss"), OutResult.TreeLoss);
+    ResultObject->TryGetNumberField(TEXT("LastSampleTimestamp"), OutResult.LastSampleTimestamp);
+
+    FString TimeString;
+    if (ResultObject->TryGetStringField(TEXT("LastTrainingTime"), TimeString))
+    {
+        FDateTime::Parse(TimeString, OutResult.LastTrainingTime);
+    }
+    return true;
+}
+
+// 模型包的扩展名，文件名为ModelName.<代数>.xqmodel
+static const TCHAR* const XQModelBundleExtension = TEXT(".xqmodel");
+
+// 旧版分散保存的模型文件，升级为模型包后删除
+static const TCHAR* const XQLegacyModelSuffixes[] = { TEXT("_NeuralNet.bin"), TEXT("_NeuralNet.xqnn"), TEXT("_DecisionTree.bin"), TEXT("_TrainingResult.json") };
+
+// 目录中ModelName的各个模型包，按代数从新到旧排列
+static TArray<TPair<uint64, FString>> FindModelBundles(const FString& Directory, const FString& ModelName)
+{
+    TArray<FString> Files;
+    IFileManager::Get().FindFiles(Files, *(Directory + ModelName + TEXT(".*") + XQModelBundleExtension), true, false);
+
+    const FString Prefix = ModelName + TEXT(".");
+    const int32 ExtensionLength = FCString::Strlen(XQModelBundleExtension);
+    TArray<TPair<uint64, FString>> Bundles;
+    for (const FString& File : Files)
+    {
+        const FString Generation = File.Mid(Prefix.Len(), File.Len() - Prefix.Len() - ExtensionLength);
+        bool bValid = File.StartsWith(Prefix) && !Generation.IsEmpty();
+        for (TCHAR Char : Generation)
+        {
+            bValid &= FChar::IsDigit(Char);
+        }
+        if (bValid)
+        {
+            Bundles.Emplace(FCString::Strtoui64(*Generation, nullptr, 10), Directory + File);
+        }
+    }
+    Bundles.Sort([](const TPair<uint64, FString>& A, const TPair<uint64, FString>& B) { return A.Key > B.Key; });
+    return Bundles;
+}
+
+// 后台保存模型包的队列状态，保存任务持有引用，模块销毁后仍可安全完成
+struct FChessModelSaveQueue
+{
+    FCriticalSection Lock;
+
+    std::atomic<uint64> LatestSequence{ 0 };
+};
 
 UChessMLModule::UChessMLModule()
 {
     ModelSavePath = TEXT("Saved/ChessML/Models/");
     DataSavePath = TEXT("Saved/ChessML/Data/");
+    ModelSaveQueue = MakeShared<FChessModelSaveQueue, ESPMode::ThreadSafe>();
+}
+
+void UChessMLModule::LoadConfig()
+{
+    FConfigFile ConfigFile;
+    ConfigFile.Read(FPaths::ProjectConfigDir() + TEXT("MLConfig.ini"));
+
+    const TCHAR* Section = TEXT("MachineLearning");
+    ConfigFile.GetInt(Section, TEXT("TrainingBatchSize"), TrainingBatchSize);
+    ConfigFile.GetInt(Section, TEXT("MaxTrainingData"), MaxTrainingSamples);
+    ConfigFile.GetInt(Section, TEXT("TrainingThreads"), TrainingThreads);
+    ConfigFile.GetInt(Section, TEXT("DecisionTrees"), NumDecisionTrees);
+    ConfigFile.GetFloat(Section, TEXT("LearningRate"), OptimizerSettings.LearningRate);
+    ConfigFile.GetBool(Section, TEXT("bEnableIncrementalTraining"), bEnableIncrementalTraining);
+    ConfigFile.GetInt(Section, TEXT("IncrementalMinSamples"), IncrementalMinSamples);
+    ConfigFile.GetInt(Section, TEXT("IncrementalEpochs"), IncrementalEpochs);
+    ConfigFile.GetInt(Section, TEXT("IncrementalReplayRatio"), IncrementalReplayRatio);
+    ConfigFile.GetFloat(Section, TEXT("TrainingSliceMilliseconds"), TrainingSliceMilliseconds);
+    ConfigFile.GetFloat(Section, TEXT("TrainingYieldMilliseconds"), TrainingYieldMilliseconds);
+    ConfigFile.GetFloat(Section, TEXT("TrainingProgressInterval"), TrainingProgressInterval);
+
+    TrainingBatchSize = FMath::Max(1, TrainingBatchSize);
+    MaxTrainingSamples = FMath::Max(1, MaxTrainingSamples);
+    NumDecisionTrees = FMath::Max(1, NumDecisionTrees);
+    IncrementalMinSamples = FMath::Max(1, IncrementalMinSamples);
+    IncrementalEpochs = FMath::Max(1, IncrementalEpochs);
+    IncrementalReplayRatio = FMath::Max(0, IncrementalReplayRatio);
+}
+
+int32 UChessMLModule::GetTrainingThreadCount() const
+{
+    // 0表示自动：留出一个核给游戏线程
+    if (TrainingThreads > 0)
+    {
+        return TrainingThreads;
+    }
+    return FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 1);
 }
 
 bool UChessMLModule::Initialize()
 {
+    LoadConfig();
+
     // 创建保存目录
     IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
     FString ModelPath = FPaths::ProjectSavedDir() + ModelSavePath;
@@ -34,45 +331,124 @@ bool UChessMLModule::Initialize()
     }
 
     // 初始化决策树
-    DecisionTree = MakeShared<ChessDecisionTree>(10, 2);
+    DecisionTree = MakeShared<ChessDecisionTree>(12, 4, NumDecisionTrees);
 
-    // 加载已有训练数据
+    // 打开训练日志，样本留在文件里，训练时再读
     LoadTrainingDataFromFile();
 
+    // 有保存的模型时加载：量化模型只是映射文件，浮点权重等到训练时再读。
+    // 没有模型时也不在这里训练，由对局之间的增量训练从头训练
+    if (FindModelBundles(ModelPath, TEXT("ChineseChess")).Num() > 0 || FPaths::FileExists(ModelPath + TEXT("ChineseChess_TrainingResult.json")))
+    {
+        LoadModel(TEXT("ChineseChess"));
+    }
+
     bIsInitialized = true;
-    ULogger::Log(FString::Printf(TEXT("Chess ML Module Initialized with %d training samples"), TrainingData.Num()));
+    ULogger::Log(FString::Printf(TEXT("Chess ML Module Initialized with %lld training samples, %s kernels"),
+        TrainingLog.IsValid() ? TrainingLog->GetNum() : 0, UTF8_TO_TCHAR(XQMLGetKernelName())));
     return true;
 }
 
+void UChessMLModule::BeginDestroy()
+{
+    // 训练在下一个小批量之前退出，增量训练写检查点
+    bStopIncrementalTraining = true;
+    if (TrainingJob.IsValid())
+    {
+        TrainingJob->Cancel();
+    }
+    if (TrainingWorker.IsValid())
+    {
+        TrainingWorker->StopAsyncWork();
+    }
+    if (IncrementalThread)
+    {
+        IncrementalThread->WaitForCompletion();
+        delete IncrementalThread;
+        IncrementalThread = nullptr;
+    }
+    IncrementalRunnable.Reset();
+
+    // 因对局而暂停的进度也写下来，下次启动后继续
+    if (IncrementalState.IsValid())
+    {
+        SaveIncrementalCheckpoint(*IncrementalState);
+        IncrementalState.Reset();
+    }
+
+    // 等最后提交的模型包写完，之前的保存要么已写完要么被它取代
+    if (PendingModelSave.IsValid())
+    {
+        PendingModelSave.Wait();
+    }
+
+    Super::BeginDestroy();
+}
+
 void UChessMLModule::SaveTrainingData(const FString& BoardFen, const FString& Move, float Score, int32 Depth)
 {
-    FChessMLData Data;
-    Data.BoardFen = BoardFen;
-    Data.Move = Move;
-    Data.Score = Score;
-    Data.Depth = Depth;
-    Data.Timestamp = FDateTime::Now();
+    FXQPosition Position;
+    FXQMove EngineMove;
+    if (!ParseFenString(BoardFen, Position) || !ParseMoveString(Move, EngineMove))
+    {
+        ULogger::LogWarning(FString::Printf(TEXT("UChessMLModule::SaveTrainingData: invalid sample %s %s"), *BoardFen, *Move));
+        return;
+    }
 
-    TrainingData.Add(Data);
+    SaveTrainingData(Position, EngineMove, Score, Depth);
+}
 
-    // 限制数据量
-    if (TrainingData.Num() > 10000)
+void UChessMLModule::SaveTrainingData(const FXQPosition& Position, FXQMove Move, float Score, int32 Depth)
+{
+    // 追加到训练日志，局面按32字节紧凑格式保存（特征缓存在开始训练时统一更新）。
+    // 正常路径上不生成任何字符串，FEN只在报告无效样本时才格式化
+    FXQTrainingLogEntry Entry;
+    if (!TrainingLog.IsValid() || !Entry.Record.Position.Pack(Position))
     {
-        TrainingData.RemoveAt(0, TrainingData.Num() - 10000);
+        char Fen[XQ_FEN_BUFFER_SIZE];
+        char MoveText[8];
+        Position.WriteFen(Fen);
+        XQWriteMove(Move, MoveText);
+        ULogger::LogWarning(FString::Printf(TEXT("UChessMLModule::SaveTrainingData: invalid sample %s %s"), UTF8_TO_TCHAR(Fen), UTF8_TO_TCHAR(MoveText)));
+        return;
     }
+    Entry.Record.BestMove = Move.Value;
+    Entry.Record.Score = static_cast<int16>(FMath::Clamp(FMath::RoundToInt(Score), -32767, 32767));
+    Entry.Record.Depth = static_cast<uint8>(FMath::Clamp(Depth, 0, 255));
+    Entry.Timestamp = (FDateTime::Now() - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMillisecond;
+    TrainingLog->Append(Entry);
 
-    // 保存到文件
-    SaveTrainingDataToFile();
+    CompactTrainingLogIfNeeded();
+}
 
-    // 更新特征缓存
-    UpdateFeatureCache();
+void UChessMLModule::CompactTrainingLogIfNeeded()
+{
+    if (!TrainingLog.IsValid() || TrainingLog->GetNum() < 2 * static_cast<int64>(MaxTrainingSamples))
+    {
+        return;
+    }
+
+    // 日志对象由共享指针持有，模块先销毁也不影响后台压缩
+    TSharedPtr<FXQTrainingLog, ESPMode::ThreadSafe> Log = TrainingLog;
+    const int64 MaxRecords = MaxTrainingSamples;
+    Async(EAsyncExecution::ThreadPool, [Log, MaxRecords]()
+    {
+        Log->Compact(MaxRecords);
+    });
 }
 
 bool UChessMLModule::StartTraining(int32 Epochs)
 {
-    if (TrainingData.Num() < 100)
+    // 训练日志加上自我对弈数据
+    int64 NumSamples = TrainingLog.IsValid() ? TrainingLog->GetNum() : 0;
+    for (const FString& ChunkPath : GetSelfPlayChunkPaths())
+    {
+        const int64 DataSize = IFileManager::Get().FileSize(*ChunkPath) - static_cast<int64>(sizeof(FXQTrainingFileHeader));
+        NumSamples += FMath::Max<int64>(0, DataSize) / static_cast<int64>(sizeof(FXQTrainingRecord));
+    }
+    if (NumSamples < 100)
     {
-        ULogger::Log(FString::Printf(TEXT("训练数据不足，需要至少100条数据，当前只有%d条"), TrainingData.Num()));
+        ULogger::Log(FString::Printf(TEXT("训练数据不足，需要至少100条数据，当前只有%lld条"), NumSamples));
         return false;
     }
 
@@ -83,49 +459,500 @@ bool UChessMLModule::StartTraining(int32 Epochs)
     }
 
     bIsTraining = true;
-    TWeakObjectPtr<UChessMLModule> WeakThis;
-
-    // 在后台线程中进行训练
-    UAsyncWorker::CreateAndStartWorker(
-        [WeakThis, Epochs](UAsyncWorker* WorkerInstance)
+    TWeakObjectPtr<UChessMLModule> WeakThis(this);
+    TSharedPtr<FChessTrainingJob, ESPMode::ThreadSafe> Job = CreateTrainingJob();
+    TrainingJob = Job;
+
+    // 训练线程在副本上训练，当前模型在完成回调换上新模型之前照常用于推理
+    TSharedRef<FChessTrainingOutput, ESPMode::ThreadSafe> Output = MakeShared<FChessTrainingOutput, ESPMode::ThreadSafe>();
+    Output->BaseNetwork = Network;
+    Output->BaseBundle = Network.IsValid() ? nullptr : PendingNetworkBundle;
+    Output->Status = TrainingResult;
+    Output->TrainingLog = TrainingLog;
+    Output->DataDir = FPaths::ProjectSavedDir() + DataSavePath;
+    Output->ChunkPaths = GetSelfPlayChunkPaths();
+
+    // 在后台线程中进行训练，每个小批量之后检查取消、暂停和AI搜索
+    TrainingWorker = UAsyncWorker::CreateAndStartWorker(
+        [WeakThis, Job, Output, Epochs](UAsyncWorker* WorkerInstance)
         {
-            if (!WeakThis.IsValid()) return;
+            UChessMLModule* Module = WeakThis.Get();
+            if (!Module) return;
+            Job->SetWorker(WorkerInstance);
 
-            // 获取最佳移动方式和要移动的棋子
-            ULogger::Log(FString::Printf(TEXT("开始训练，数据量: %d, 轮次: %d"), WeakThis->TrainingData.Num(), Epochs));
+            // 训练集的映射随训练结束释放，下一次训练才能覆盖快照文件
+            ON_SCOPE_EXIT
+            {
+                Output->Dataset.Close();
+            };
 
-            // 转换为特征向量
-            WeakThis->UpdateFeatureCache();
+            FChessTrainingProgress Progress;
+            Progress.NumEpochs = Epochs;
+            Job->ReportProgress(Progress, true);
 
-            if (WeakThis->FeatureCache.Num() == 0)
+            // 映射训练集，特征在训练时按小批量展开
+            if (!Module->PrepareDataset(*Output))
             {
-                ULogger::LogError(UTF8_TO_TCHAR("特征提取失败，无法训练"));
-                WeakThis->bIsTraining = false;
-                return;
+                ULogger::LogError(UTF8_TO_TCHAR("训练集准备失败，无法训练"));
+                Job->Cancel();
+            }
+            else
+            {
+                ULogger::Log(FString::Printf(TEXT("开始训练，数据量: %lld, 轮次: %d"), Output->Dataset.GetNum(), Epochs));
             }
 
-            // 训练神经网络
-            WeakThis->TrainNeuralNetwork(Epochs);
+            // 训练神经网络和决策树，取消时已经训练好的部分也不采用
+            if (Job->IsCancelled() || !Module->TrainNeuralNetwork(Epochs, *Job, *Output) || !Module->TrainDecisionTree(Epochs, *Job, *Output))
+            {
+                ULogger::Log(UTF8_TO_TCHAR("训练已取消"));
+                Progress.Phase = EChessTrainingPhase::Cancelled;
+                Job->ReportProgress(Progress, true);
+                return;
+            }
 
-            // 训练决策树
-            WeakThis->TrainDecisionTree(Epochs);
+            Output->Status.EpochsTrained += Epochs;
+            Output->Status.LastTrainingTime = FDateTime::Now();
+            Output->Status.LastSampleTimestamp = Output->NewestTimestamp;
+            Output->bSucceeded = true;
 
-            WeakThis->bIsTraining = false;
-            WeakThis->TrainingResult.EpochsTrained += Epochs;
-            WeakThis->TrainingResult.LastTrainingTime = FDateTime::Now();
+            Progress.Phase = EChessTrainingPhase::Finished;
+            Progress.Epoch = Epochs;
+            Progress.Progress = 1.0f;
+            Progress.Loss = Output->Status.Loss;
+            Job->ReportProgress(Progress, true);
 
-            ULogger::Log(FString::Printf(TEXT("训练完成，总训练轮次: %d"), WeakThis->TrainingResult.EpochsTrained));
+            ULogger::Log(FString::Printf(TEXT("训练完成，总训练轮次: %d"), Output->Status.EpochsTrained));
         },
-        [WeakThis](EAsyncWorkerState State)
+        [WeakThis, Job, Output](EAsyncWorkerState State)
         {
-            if (WeakThis.IsValid())
-                WeakThis->SaveModel(TEXT("ChineseChess"));
+            UChessMLModule* Module = WeakThis.Get();
+            if (!Module) return;
+
+            // 完成回调在游戏线程：在这里一次换上新模型，正在进行的搜索持有旧模型的引用，不受影响
+            Module->bIsTraining = false;
+            if (State != EAsyncWorkerState::Completed || Job->IsCancelled() || !Output->bSucceeded)
+            {
+                return;
+            }
+            if (!Output->Network.IsEmpty())
+            {
+                Module->Network = MakeShared<FXQMLNetwork, ESPMode::ThreadSafe>(MoveTemp(Output->Network));
+                Module->PendingNetworkBundle.Reset();
+            }
+            if (Output->QuantizedNetwork.IsValid())
+            {
+                Module->QuantizedNetwork = Output->QuantizedNetwork;
+            }
+            if (Output->DecisionTree.IsValid())
+            {
+                Module->DecisionTree = Output->DecisionTree;
+            }
+            Module->TrainingResult = Output->Status;
+            Module->SaveModel(TEXT("ChineseChess"));
         }
     );
 
     return true;
 }
 
+void UChessMLModule::SetGameInProgress(bool bInProgress)
+{
+    bGameInProgress = bInProgress;
+    if (TrainingJob.IsValid())
+    {
+        TrainingJob->SetMatchRunning(bInProgress);
+    }
+    if (!bInProgress)
+    {
+        StartIncrementalTraining();
+    }
+}
+
+void UChessMLModule::BeginSearch()
+{
+    ActiveSearchCount++;
+    if (TrainingJob.IsValid())
+    {
+        TrainingJob->SetSearchRunning(true);
+    }
+}
+
+void UChessMLModule::EndSearch()
+{
+    if (ActiveSearchCount <= 0)
+    {
+        ULogger::LogWarning(TEXT("UChessMLModule::EndSearch: unbalanced call"));
+        return;
+    }
+    ActiveSearchCount--;
+    if (ActiveSearchCount == 0 && TrainingJob.IsValid())
+    {
+        TrainingJob->SetSearchRunning(false);
+    }
+}
+
+void UChessMLModule::CancelTraining()
+{
+    if (TrainingJob.IsValid())
+    {
+        TrainingJob->Cancel();
+    }
+}
+
+void UChessMLModule::PauseTraining()
+{
+    if (TrainingWorker.IsValid())
+    {
+        TrainingWorker->PauseAsyncWork();
+    }
+}
+
+void UChessMLModule::ResumeTraining()
+{
+    if (TrainingWorker.IsValid())
+    {
+        TrainingWorker->ResumeAsyncWork();
+    }
+}
+
+TSharedPtr<FChessTrainingJob, ESPMode::ThreadSafe> UChessMLModule::CreateTrainingJob()
+{
+    TWeakObjectPtr<UChessMLModule> WeakThis(this);
+    TSharedPtr<FChessTrainingJob, ESPMode::ThreadSafe> Job = MakeShared<FChessTrainingJob, ESPMode::ThreadSafe>(
+        [WeakThis](const FChessTrainingProgress& Progress)
+        {
+            if (UChessMLModule* Module = WeakThis.Get())
+            {
+                Module->OnTrainingProgress.Broadcast(Progress);
+            }
+        });
+    Job->Configure(TrainingSliceMilliseconds / 1000.0f, TrainingYieldMilliseconds / 1000.0f, TrainingProgressInterval);
+    Job->SetMatchRunning(bGameInProgress);
+    Job->SetSearchRunning(ActiveSearchCount > 0);
+    return Job;
+}
+
+bool UChessMLModule::StartIncrementalTraining()
+{
+    if (!bIsInitialized || !bEnableIncrementalTraining || bIsTraining || ShouldYieldTraining() || !TrainingLog.IsValid())
+    {
+        return false;
+    }
+
+    // 上一次增量训练已经结束，回收线程
+    if (IncrementalThread)
+    {
+        IncrementalThread->WaitForCompletion();
+        delete IncrementalThread;
+        IncrementalThread = nullptr;
+    }
+
+    bIsTraining = true;
+
+    // 训练线程在副本上微调（副本在训练线程中复制），当前模型在换上新模型之前照常用于推理
+    TSharedPtr<const FXQMLNetwork, ESPMode::ThreadSafe> BaseNetwork = Network;
+    TSharedPtr<FXQModelBundle, ESPMode::ThreadSafe> BaseBundle = Network.IsValid() ? nullptr : PendingNetworkBundle;
+    const FMLTrainingResult Status = TrainingResult;
+    TSharedPtr<FChessTrainingJob, ESPMode::ThreadSafe> Job = CreateTrainingJob();
+    TrainingJob = Job;
+    IncrementalRunnable = MakeUnique<FChessMLRunnable>([this, BaseNetwork, BaseBundle, Status, Job]()
+    {
+        RunIncrementalTraining(BaseNetwork.IsValid() ? *BaseNetwork : FXQMLNetwork(), BaseBundle, Status, *Job);
+    });
+
+    // 最低优先级，有其他工作时让出CPU
+    IncrementalThread = FRunnableThread::Create(IncrementalRunnable.Get(), TEXT("ChessMLIncrementalTraining"), 0, TPri_Lowest);
+    if (!IncrementalThread)
+    {
+        bIsTraining = false;
+        return false;
+    }
+    return true;
+}
+
+void UChessMLModule::RunIncrementalTraining(FXQMLNetwork Base, TSharedPtr<FXQModelBundle, ESPMode::ThreadSafe> BaseBundle, FMLTrainingResult Status, FChessTrainingJob& Job)
+{
+    // 换上新模型时由游戏线程清除训练标志
+    bool bApplying = false;
+    ON_SCOPE_EXIT
+    {
+        if (!bApplying)
+        {
+            bIsTraining = false;
+        }
+    };
+
+    // 训练日志压缩后最多约两倍MaxTrainingSamples条，整个读进内存。
+    // 验证集与完整训练按同一个样本键划分：基础模型没有训练过这些样本，BaseLoss才是真正的留出损失
+    TArray<FXQTrainingRecord> NewRecords;
+    TArray<FXQTrainingRecord> OldRecords;
+    TArray<FXQTrainingRecord> ValidationRecords;
+    int64 NewestTimestamp = Status.LastSampleTimestamp;
+    const FString LogPath = FPaths::ProjectSavedDir() + DataSavePath + TEXT("TrainingData.bin");
+    FXQTrainingLog::ReadAll(TCHAR_TO_UTF8(*LogPath), [this, &Status, &NewRecords, &OldRecords, &ValidationRecords, &NewestTimestamp](const FXQTrainingLogEntry& Entry)
+    {
+        if (IsValidationSample(GetXQTrainingRecordKey(Entry.Record)))
+        {
+            if (ValidationRecords.Num() < MaxValidationSamples)
+            {
+                ValidationRecords.Add(Entry.Record);
+            }
+        }
+        else if (Entry.Timestamp > Status.LastSampleTimestamp)
+        {
+            NewRecords.Add(Entry.Record);
+        }
+        else
+        {
+            OldRecords.Add(Entry.Record);
+        }
+        NewestTimestamp = FMath::Max(NewestTimestamp, Entry.Timestamp);
+    });
+
+    if (NewRecords.Num() < IncrementalMinSamples || ValidationRecords.Num() == 0 || ShouldYieldTraining())
+    {
+        return;
+    }
+
+    if (Base.IsEmpty() && BaseBundle.IsValid())
+    {
+        ReadNetworkSection(*BaseBundle, Base, TEXT("model bundle"));
+    }
+
+    // 接着上次因对局开始而中断的进度，或者上次退出游戏时的检查点
+    TSharedPtr<FChessIncrementalTrainingState, ESPMode::ThreadSafe> State = IncrementalState;
+    IncrementalState.Reset();
+    if (!State.IsValid() || State->BaseTimestamp != Status.LastSampleTimestamp)
+    {
+        State = LoadIncrementalCheckpoint(Status.LastSampleTimestamp);
+    }
+    if (!State.IsValid())
+    {
+        State = MakeShared<FChessIncrementalTrainingState, ESPMode::ThreadSafe>();
+        State->BaseTimestamp = Status.LastSampleTimestamp;
+        State->bFromScratch = Base.IsEmpty();
+        if (State->bFromScratch)
+        {
+            InitializeNeuralNetwork(State->Candidate);
+        }
+        else
+        {
+            State->Candidate = Base;
+        }
+    }
+
+    // 训练集为全部新样本，加上随机抽取的旧样本，避免模型忘掉以前学到的；从头训练时用全部样本
+    const int32 NumReplay = State->bFromScratch ? OldRecords.Num() : FMath::Min(OldRecords.Num(), NewRecords.Num() * IncrementalReplayRatio);
+    for (int32 i = 0; i < NumReplay; i++)
+    {
+        OldRecords.Swap(i, FMath::RandRange(i, OldRecords.Num() - 1));
+    }
+    FXQMLDataset TrainSet;
+    TrainSet.AddRecords(NewRecords.GetData(), NewRecords.Num());
+    TrainSet.AddRecords(OldRecords.GetData(), NumReplay);
+    FXQMLDataset ValidationSet;
+    ValidationSet.AddRecords(ValidationRecords.GetData(), ValidationRecords.Num());
+    TArray<int64> ValidationSamples;
+    for (int64 i = 0; i < ValidationSet.GetNum(); i++)
+    {
+        ValidationSamples.Add(i);
+    }
+
+    float BaseAccuracy = 0.0f;
+    float BaseLoss = MAX_flt;
+    if (!Base.IsEmpty())
+    {
+        EvaluateNetwork(Base, ValidationSet, ValidationSamples, BaseAccuracy, BaseLoss);
+    }
+
+    const int32 Epochs = State->bFromScratch ? InitialTrainingEpochs : IncrementalEpochs;
+    const int64 NumSamples = TrainSet.GetNum();
+    const int64 BatchesPerEpoch = (NumSamples + TrainingBatchSize - 1) / TrainingBatchSize;
+    const int64 TotalBatches = BatchesPerEpoch * Epochs;
+
+    TArray<int64> Order;
+    Order.SetNumUninitialized(static_cast<int32>(NumSamples));
+    for (int32 i = 0; i < Order.Num(); i++)
+    {
+        Order[i] = i;
+    }
+    TArray<uint16> BatchFeatures;
+    BatchFeatures.SetNumUninitialized(TrainingBatchSize * XQ_ML_MAX_ACTIVE_FEATURES);
+    TArray<int32> BatchOffsets;
+    BatchOffsets.SetNumUninitialized(TrainingBatchSize + 1);
+    TArray<int32> BatchLabels;
+    BatchLabels.SetNumUninitialized(TrainingBatchSize);
+
+    // 只用一个线程，不和对局抢核
+    FXQMLTrainer Trainer(State->Candidate, OptimizerSettings, TrainingBatchSize, 1);
+    ULogger::Log(FString::Printf(TEXT("Incremental training on %d new and %d replayed samples, batch %lld/%lld"),
+        NewRecords.Num(), NumReplay, State->BatchesDone, TotalBatches));
+
+    FChessTrainingProgress Progress;
+    Progress.Phase = EChessTrainingPhase::NeuralNetwork;
+    Progress.bIncremental = true;
+    Progress.NumEpochs = Epochs;
+    double EpochLoss = 0.0;
+    int32 EpochBatches = 0;
+
+    double LastCheckpointTime = FPlatformTime::Seconds();
+    bool bShuffled = false;
+    while (State->BatchesDone < TotalBatches)
+    {
+        if (ShouldYieldTraining() || !Job.CheckPoint())
+        {
+            // 对局开始时进度只留在内存里，不在开局时写盘；模块销毁或取消时才写检查点
+            if (bStopIncrementalTraining || Job.IsCancelled())
+            {
+                SaveIncrementalCheckpoint(*State);
+            }
+            else
+            {
+                IncrementalState = State;
+            }
+            if (Job.IsCancelled())
+            {
+                Progress.Phase = EChessTrainingPhase::Cancelled;
+                Job.ReportProgress(Progress, true);
+            }
+            ULogger::Log(FString::Printf(TEXT("Incremental training paused at batch %lld/%lld"), State->BatchesDone, TotalBatches));
+            return;
+        }
+
+        // 每轮打乱样本顺序
+        const int64 Batch = State->BatchesDone % BatchesPerEpoch;
+        if (Batch == 0)
+        {
+            EpochLoss = 0.0;
+            EpochBatches = 0;
+        }
+        if (Batch == 0 || !bShuffled)
+        {
+            for (int32 i = Order.Num() - 1; i > 0; i--)
+            {
+                Order.Swap(i, FMath::RandRange(0, i));
+            }
+            bShuffled = true;
+        }
+
+        const int64 BatchStart = Batch * TrainingBatchSize;
+        const int32 BatchCount = static_cast<int32>(FMath::Min<int64>(TrainingBatchSize, NumSamples - BatchStart));
+        TrainSet.ExpandBatch(&Order[static_cast<int32>(BatchStart)], BatchCount, BatchFeatures.GetData(), BatchOffsets.GetData(), BatchLabels.GetData());
+        FXQMLSparseInput BatchInput;
+        BatchInput.Indices = BatchFeatures.GetData();
+        BatchInput.Offsets = BatchOffsets.GetData();
+        EpochLoss += Trainer.TrainBatch(BatchInput, BatchLabels.GetData(), BatchCount);
+        EpochBatches++;
+        State->BatchesDone++;
+
+        Progress.Epoch = static_cast<int32>(State->BatchesDone / BatchesPerEpoch);
+        Progress.Progress = static_cast<float>(State->BatchesDone) / TotalBatches;
+        Progress.Loss = static_cast<float>(EpochLoss / EpochBatches);
+        Job.ReportProgress(Progress);
+
+        if (FPlatformTime::Seconds() - LastCheckpointTime > IncrementalCheckpointInterval)
+        {
+            SaveIncrementalCheckpoint(*State);
+            LastCheckpointTime = FPlatformTime::Seconds();
+        }
+    }
+    IFileManager::Get().Delete(*GetIncrementalCheckpointPath(), false, false, true);
+
+    // 只有验证集上更好时才采用，否则这些样本留到下一次和更多新样本一起训练
+    float Accuracy = 0.0f;
+    float Loss = 0.0f;
+    EvaluateNetwork(State->Candidate, ValidationSet, ValidationSamples, Accuracy, Loss);
+    Progress.Phase = EChessTrainingPhase::Finished;
+    Progress.Loss = Loss;
+    Job.ReportProgress(Progress, true);
+    if (Loss >= BaseLoss)
+    {
+        ULogger::Log(FString::Printf(TEXT("Incremental model rejected: validation loss %.3f, current %.3f"), Loss, BaseLoss));
+        return;
+    }
+
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> Quantized = MakeShared<FXQMLQuantizedNetwork, ESPMode::ThreadSafe>();
+    if (!Quantized->Quantize(State->Candidate))
+    {
+        return;
+    }
+
+    Status.Accuracy = Accuracy;
+    Status.Loss = Loss;
+    Status.EpochsTrained += Epochs;
+    Status.LastTrainingTime = FDateTime::Now();
+    Status.LastSampleTimestamp = NewestTimestamp;
+
+    // 回到游戏线程一次换上浮点和量化模型；正在进行的搜索持有旧模型的引用，不受影响
+    bApplying = true;
+    TWeakObjectPtr<UChessMLModule> WeakThis(this);
+    TSharedPtr<const FXQMLNetwork, ESPMode::ThreadSafe> Candidate = MakeShared<FXQMLNetwork, ESPMode::ThreadSafe>(MoveTemp(State->Candidate));
+    AsyncTask(ENamedThreads::GameThread, [WeakThis, Candidate, Quantized, Status]()
+    {
+        UChessMLModule* Module = WeakThis.Get();
+        if (!Module)
+        {
+            return;
+        }
+
+        Module->Network = Candidate;
+        Module->PendingNetworkBundle.Reset();
+        Module->QuantizedNetwork = Quantized;
+        Module->TrainingResult.Accuracy = Status.Accuracy;
+        Module->TrainingResult.Loss = Status.Loss;
+        Module->TrainingResult.EpochsTrained = Status.EpochsTrained;
+        Module->TrainingResult.LastTrainingTime = Status.LastTrainingTime;
+        Module->TrainingResult.LastSampleTimestamp = Status.LastSampleTimestamp;
+        Module->bIsTraining = false;
+        Module->SaveModel(TEXT("ChineseChess"));
+
+        ULogger::Log(FString::Printf(TEXT("Incremental model accepted: validation accuracy %.3f, loss %.3f"), Status.Accuracy, Status.Loss));
+    });
+}
+
+FString UChessMLModule::GetIncrementalCheckpointPath() const
+{
+    return FPaths::ProjectSavedDir() + ModelSavePath + TEXT("ChineseChess_Incremental.bin");
+}
+
+bool UChessMLModule::SaveIncrementalCheckpoint(const FChessIncrementalTrainingState& State) const
+{
+    TArray<uint8> Data;
+    FMemoryWriter Writer(Data);
+
+    uint32 Magic = XQIncrementalCheckpointMagic;
+    int64 BaseTimestamp = State.BaseTimestamp;
+    int64 BatchesDone = State.BatchesDone;
+    bool bFromScratch = State.bFromScratch;
+    Writer << Magic << BaseTimestamp << BatchesDone << bFromScratch;
+    WriteNetwork(Writer, State.Candidate);
+
+    // 先写临时文件再改名，中途退出不会留下写了一半的检查点
+    const FString Path = GetIncrementalCheckpointPath();
+    const FString TempPath = Path + TEXT(".tmp");
+    return FFileHelper::SaveArrayToFile(Data, *TempPath) && IFileManager::Get().Move(*Path, *TempPath, true);
+}
+
+TSharedPtr<FChessIncrementalTrainingState, ESPMode::ThreadSafe> UChessMLModule::LoadIncrementalCheckpoint(int64 BaseTimestamp) const
+{
+    const FString Path = GetIncrementalCheckpointPath();
+    TArray<uint8> Data;
+    if (!FFileHelper::LoadFileToArray(Data, *Path, FILEREAD_Silent))
+    {
+        return nullptr;
+    }
+
+    FMemoryReader Reader(Data);
+    uint32 Magic = 0;
+    TSharedPtr<FChessIncrementalTrainingState, ESPMode::ThreadSafe> State = MakeShared<FChessIncrementalTrainingState, ESPMode::ThreadSafe>();
+    Reader << Magic << State->BaseTimestamp << State->BatchesDone << State->bFromScratch;
+    if (Reader.IsError() || Magic != XQIncrementalCheckpointMagic || State->BaseTimestamp != BaseTimestamp || !ReadNetwork(Reader, State->Candidate, Path))
+    {
+        return nullptr;
+    }
+    return State;
+}
+
 FString UChessMLModule::PredictBestMove(const FString& BoardFen, const TArray<FString>& ValidMoves)
 {
     if (!bIsInitialized || ValidMoves.Num() == 0)
@@ -134,7 +961,7 @@ FString UChessMLModule::PredictBestMove(const FString& BoardFen, const TArray<FS
     }
 
     // 如果有神经网络模型，优先使用
-    if (NeuralNetworkWeights.Num() > 0)
+    if (QuantizedNetwork.IsValid() || Network.IsValid())
     {
         FString NeuralNetMove = PredictWithNeuralNetwork(BoardFen, ValidMoves);
         if (!NeuralNetMove.IsEmpty())
@@ -144,7 +971,7 @@ FString UChessMLModule::PredictBestMove(const FString& BoardFen, const TArray<FS
     }
 
     // 否则使用决策树
-    if (DecisionTree.IsValid())
+    if (DecisionTree.IsValid() && DecisionTree->IsTrained())
     {
         FString DecisionTreeMove = PredictWithDecisionTree(BoardFen, ValidMoves);
         if (!DecisionTreeMove.IsEmpty())
@@ -165,38 +992,191 @@ bool UChessMLModule::SaveModel(const FString& ModelName)
         return false;
     }
 
-    FString ModelPath = FPaths::ProjectSavedDir() + ModelSavePath + ModelName;
+    // 游戏线程上只取快照：量化网络、浮点网络（不可变，不复制权重）和还没读取的浮点权重只持有引用，
+    // 决策树和训练状态复制一份，序列化、校验和与写文件都在后台线程
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> Quantized = QuantizedNetwork;
+    TSharedPtr<const FXQMLNetwork, ESPMode::ThreadSafe> Weights = Network;
+    TSharedPtr<FXQModelBundle, ESPMode::ThreadSafe> WeightsBundle = Network.IsValid() ? nullptr : PendingNetworkBundle;
+    std::vector<uint8> Forest;
+    if (DecisionTree.IsValid() && DecisionTree->IsTrained())
+    {
+        DecisionTree->SaveToMemory(Forest);
+    }
+    const FTCHARToUTF8 ResultJson(*TrainingResultToJson(TrainingResult));
+    std::string Result(ResultJson.Get(), ResultJson.Length());
 
-    // 保存神经网络
-    bool bSuccess = SaveNeuralNetwork(ModelPath + "_NeuralNet.bin");
+    const FString ModelDir = FPaths::ProjectSavedDir() + ModelSavePath;
+    TSharedPtr<FChessModelSaveQueue, ESPMode::ThreadSafe> Queue = ModelSaveQueue;
+    const uint64 Sequence = ++Queue->LatestSequence;
 
-    // 保存决策树
-    if (DecisionTree.IsValid())
+    PendingModelSave = Async(EAsyncExecution::ThreadPool,
+        [Queue, Sequence, ModelDir, ModelName, Quantized, Weights, WeightsBundle, Forest = MoveTemp(Forest), Result = MoveTemp(Result)]()
+        {
+            FScopeLock Lock(&Queue->Lock);
+
+            // 后面还有更新的快照，由它写入
+            if (Sequence != Queue->LatestSequence)
+            {
+                return true;
+            }
+
+            TArray<FXQModelBundleSection, TInlineAllocator<4>> Sections;
+            if (Quantized.IsValid())
+            {
+                Sections.Add({ EXQModelSection::QuantizedNetwork, Quantized->GetData(), Quantized->GetDataSize() });
+            }
+
+            // 浮点权重用于继续训练；没有读取过的直接从原来的模型包复制
+            TArray<uint8> WeightsData;
+            FXQModelBundleSection WeightsSection;
+            if (Weights.IsValid())
+            {
+                FMemoryWriter Writer(WeightsData);
+                WriteNetwork(Writer, *Weights);
+                Sections.Add({ EXQModelSection::NetworkWeights, WeightsData.GetData(), WeightsData.Num() });
+            }
+            else if (WeightsBundle.IsValid() && WeightsBundle->FindSection(EXQModelSection::NetworkWeights, WeightsSection))
+            {
+                Sections.Add(WeightsSection);
+            }
+
+            if (!Forest.empty())
+            {
+                Sections.Add({ EXQModelSection::DecisionForest, Forest.data(), static_cast<int64>(Forest.size()) });
+            }
+            Sections.Add({ EXQModelSection::TrainingResult, reinterpret_cast<const uint8*>(Result.data()), static_cast<int64>(Result.size()) });
+
+            // 每次保存写一个新的代数，不覆盖可能正被映射的旧模型包
+            const TArray<TPair<uint64, FString>> OldBundles = FindModelBundles(ModelDir, ModelName);
+            const uint64 Generation = OldBundles.Num() > 0 ? OldBundles[0].Key + 1 : 1;
+            const FString Path = ModelDir + ModelName + FString::Printf(TEXT(".%llu"), Generation) + XQModelBundleExtension;
+            if (!FXQModelBundle::Write(TCHAR_TO_UTF8(*Path), Generation, Sections.GetData(), Sections.Num()))
+            {
+                ULogger::LogError(FString::Printf(TEXT("Failed to save model: %s"), *Path));
+                return false;
+            }
+
+            // 保留上一代，新的模型包校验不过时LoadModel退回它；更早的和旧版文件删除。
+            // Windows上仍被映射的文件删不掉，下次保存时再删
+            for (int32 i = 1; i < OldBundles.Num(); i++)
+            {
+                IFileManager::Get().Delete(*OldBundles[i].Value, false, false, true);
+            }
+            for (const TCHAR* Suffix : XQLegacyModelSuffixes)
+            {
+                IFileManager::Get().Delete(*(ModelDir + ModelName + Suffix), false, false, true);
+            }
+
+            ULogger::Log(FString::Printf(TEXT("Model saved successfully: %s"), *Path));
+            return true;
+        });
+
+    return true;
+}
+
+bool UChessMLModule::LoadModel(const FString& ModelName)
+{
+    const FString ModelDir = FPaths::ProjectSavedDir() + ModelSavePath;
+
+    // 从最新的模型包开始，校验不过时退回上一个
+    bool bSuccess = false;
+    const TArray<TPair<uint64, FString>> Bundles = FindModelBundles(ModelDir, ModelName);
+    for (const TPair<uint64, FString>& Entry : Bundles)
     {
-        bSuccess &= DecisionTree->SaveToFile(ModelPath + "_DecisionTree.bin");
+        TSharedPtr<FXQModelBundle, ESPMode::ThreadSafe> Bundle = MakeShared<FXQModelBundle, ESPMode::ThreadSafe>();
+        if (Bundle->Open(TCHAR_TO_UTF8(*Entry.Value)) && LoadModelBundle(Bundle))
+        {
+            bSuccess = true;
+            break;
+        }
+        ULogger::LogWarning(FString::Printf(TEXT("Invalid model bundle: %s"), *Entry.Value));
     }
 
-    // 保存训练结果
-    bSuccess &= SaveTrainingResult(ModelPath + "_TrainingResult.json");
+    // 没有模型包时读取旧版文件，并立即另存为模型包
+    if (!bSuccess && Bundles.Num() == 0 && LoadLegacyModel(ModelName))
+    {
+        bSuccess = true;
+        bIsInitialized = true;
+        SaveModel(ModelName);
+    }
 
     if (bSuccess)
     {
-        ULogger::Log(FString::Printf(TEXT("Model saved successfully: %s"), *ModelName));
+        ULogger::Log(FString::Printf(TEXT("Model loaded successfully: %s"), *ModelName));
+        bIsInitialized = true;
     }
     else
     {
-        ULogger::LogError(FString::Printf(TEXT("Failed to save model: %s"), *ModelName));
+        ULogger::LogError(FString::Printf(TEXT("Failed to load model: %s"), *ModelName));
     }
 
     return bSuccess;
 }
 
-bool UChessMLModule::LoadModel(const FString& ModelName)
+bool UChessMLModule::LoadModelBundle(const TSharedPtr<FXQModelBundle, ESPMode::ThreadSafe>& Bundle)
+{
+    FXQModelBundleSection Section;
+    FMLTrainingResult Result;
+    if (!Bundle->FindSection(EXQModelSection::TrainingResult, Section))
+    {
+        return false;
+    }
+    const FUTF8ToTCHAR Json(reinterpret_cast<const ANSICHAR*>(Section.Data), static_cast<int32>(Section.Size));
+    if (!TrainingResultFromJson(FString(Json.Length(), Json.Get()), Result))
+    {
+        return false;
+    }
+
+    // 量化模型直接使用映射中的数据；浮点权重等到继续训练时再读取
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> Quantized;
+    if (Bundle->FindSection(EXQModelSection::QuantizedNetwork, Section))
+    {
+        Quantized = MakeShared<FXQMLQuantizedNetwork, ESPMode::ThreadSafe>();
+        if (!Quantized->Load(Bundle->GetMapping(), Section.Data - Bundle->GetMapping()->GetData(), Section.Size) ||
+            Quantized->GetInputSize() != XQ_ML_NUM_FEATURES || Quantized->GetOutputSize() != XQ_ML_NUM_MOVES)
+        {
+            return false;
+        }
+    }
+
+    TSharedPtr<ChessDecisionTree> Tree;
+    if (Bundle->FindSection(EXQModelSection::DecisionForest, Section))
+    {
+        Tree = MakeShared<ChessDecisionTree>(12, 4, NumDecisionTrees);
+        if (!Tree->LoadFromMemory(Section.Data, Section.Size))
+        {
+            return false;
+        }
+    }
+
+    if (Tree.IsValid())
+    {
+        DecisionTree = Tree;
+    }
+    TrainingResult = Result;
+    Network.Reset();
+    QuantizedNetwork = Quantized;
+    PendingNetworkBundle = Bundle->FindSection(EXQModelSection::NetworkWeights, Section) ? Bundle : nullptr;
+
+    // 只有浮点权重时（不应出现）读取后量化
+    if (!QuantizedNetwork.IsValid() && PendingNetworkBundle.IsValid())
+    {
+        LoadPendingNeuralNetwork();
+        QuantizeNeuralNetwork();
+    }
+    return true;
+}
+
+bool UChessMLModule::LoadLegacyModel(const FString& ModelName)
 {
     FString ModelPath = FPaths::ProjectSavedDir() + ModelSavePath + ModelName;
 
-    // 加载神经网络
+    // 旧文件在另存为模型包后删除，所以浮点权重直接读入并重新量化，不映射旧的量化模型
     bool bSuccess = LoadNeuralNetwork(ModelPath + "_NeuralNet.bin");
+    if (bSuccess)
+    {
+        QuantizeNeuralNetwork();
+    }
 
     // 加载决策树
     if (DecisionTree.IsValid())
@@ -207,16 +1187,6 @@ bool UChessMLModule::LoadModel(const FString& ModelName)
     // 加载训练结果
     bSuccess &= LoadTrainingResult(ModelPath + "_TrainingResult.json");
 
-    if (bSuccess)
-    {
-        ULogger::Log(FString::Printf(TEXT("Model loaded successfully: %s"), *ModelName));
-        bIsInitialized = true;
-    }
-    else
-    {
-        ULogger::LogError(FString::Printf(TEXT("Failed to load model: %s"), *ModelName));
-    }
-
     return bSuccess;
 }
 
@@ -225,31 +1195,58 @@ bool UChessMLModule::SaveNeuralNetwork(const FString& FilePath)
 {
     TArray<uint8> Data;
     FMemoryWriter Writer(Data);
+    WriteNetwork(Writer, Network.IsValid() ? *Network : FXQMLNetwork());
 
-    // 保存网络结构
-    int32 NumLayers = NeuralNetworkWeights.Num();
-    Writer << NumLayers;
+    return FFileHelper::SaveArrayToFile(Data, *FilePath);
+}
+
+bool UChessMLModule::LoadQuantizedNetwork(const FString& FilePath)
+{
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> Quantized = MakeShared<FXQMLQuantizedNetwork, ESPMode::ThreadSafe>();
+    if (!Quantized->Load(TCHAR_TO_UTF8(*FilePath)) || Quantized->GetInputSize() != XQ_ML_NUM_FEATURES || Quantized->GetOutputSize() != XQ_ML_NUM_MOVES)
+    {
+        return false;
+    }
+    QuantizedNetwork = Quantized;
+    return true;
+}
+
+TSharedPtr<FXQMovePolicy, ESPMode::ThreadSafe> UChessMLModule::CreateMovePolicy() const
+{
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> Quantized = QuantizedNetwork;
+    if (!Quantized.IsValid())
+    {
+        return nullptr;
+    }
+
+    // 先验对象不持有网络，由删除器捕获的引用保证网络活得比它久
+    return MakeShareable<FXQMovePolicy>(new FXQMLMovePolicy(Quantized.Get()), [Quantized](FXQMovePolicy* Policy) { delete Policy; });
+}
 
-    for (int32 i = 0; i < NumLayers; i++)
+void UChessMLModule::QuantizeNeuralNetwork()
+{
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> Quantized = MakeShared<FXQMLQuantizedNetwork, ESPMode::ThreadSafe>();
+    if (Network.IsValid() && Quantized->Quantize(*Network))
     {
-        int32 NumWeights = NeuralNetworkWeights[i].Num();
-        Writer << NumWeights;
+        QuantizedNetwork = Quantized;
+    }
+}
 
-        for (float Weight : NeuralNetworkWeights[i])
+void UChessMLModule::LoadPendingNeuralNetwork()
+{
+    if (!Network.IsValid() && PendingNetworkBundle.IsValid())
+    {
+        TSharedPtr<FXQMLNetwork, ESPMode::ThreadSafe> Loaded = MakeShared<FXQMLNetwork, ESPMode::ThreadSafe>();
+        if (ReadNetworkSection(*PendingNetworkBundle, *Loaded, TEXT("model bundle")) && !Loaded->IsEmpty())
         {
-            Writer << Weight;
+            Network = Loaded;
         }
-
-        int32 NumBiases = NeuralNetworkBiases[i].Num();
-        Writer << NumBiases;
-
-        for (float Bias : NeuralNetworkBiases[i])
+        else
         {
-            Writer << Bias;
+            ULogger::LogWarning(TEXT("Failed to load neural network weights from the model bundle"));
         }
     }
-
-    return FFileHelper::SaveArrayToFile(Data, *FilePath);
+    PendingNetworkBundle.Reset();
 }
 
 bool UChessMLModule::LoadNeuralNetwork(const FString& FilePath)
@@ -261,50 +1258,18 @@ bool UChessMLModule::LoadNeuralNetwork(const FString& FilePath)
     }
 
     FMemoryReader Reader(Data);
-
-    int32 NumLayers = 0;
-    Reader << NumLayers;
-
-    NeuralNetworkWeights.SetNum(NumLayers);
-    NeuralNetworkBiases.SetNum(NumLayers);
-
-    for (int32 i = 0; i < NumLayers; i++)
+    TSharedPtr<FXQMLNetwork, ESPMode::ThreadSafe> Loaded = MakeShared<FXQMLNetwork, ESPMode::ThreadSafe>();
+    if (!ReadNetwork(Reader, *Loaded, FilePath) || Loaded->IsEmpty())
     {
-        int32 NumWeights = 0;
-        Reader << NumWeights;
-
-        NeuralNetworkWeights[i].SetNum(NumWeights);
-        for (int32 j = 0; j < NumWeights; j++)
-        {
-            Reader << NeuralNetworkWeights[i][j];
-        }
-
-        int32 NumBiases = 0;
-        Reader << NumBiases;
-
-        NeuralNetworkBiases[i].SetNum(NumBiases);
-        for (int32 j = 0; j < NumBiases; j++)
-        {
-            Reader << NeuralNetworkBiases[i][j];
-        }
+        return false;
     }
-
+    Network = Loaded;
     return true;
 }
 
 bool UChessMLModule::SaveTrainingResult(const FString& FilePath)
 {
-    TSharedPtr<FJsonObject> ResultObject = MakeShared<FJsonObject>();
-    ResultObject->SetNumberField("EpochsTrained", TrainingResult.EpochsTrained);
-    ResultObject->SetNumberField("Accuracy", TrainingResult.Accuracy);
-    ResultObject->SetNumberField("Loss", TrainingResult.Loss);
-    ResultObject->SetStringField("LastTrainingTime", TrainingResult.LastTrainingTime.ToString());
-
-    FString OutputString;
-    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
-    FJsonSerializer::Serialize(ResultObject.ToSharedRef(), Writer);
-
-    return FFileHelper::SaveStringToFile(OutputString, *FilePath);
+    return FFileHelper::SaveStringToFile(TrainingResultToJson(TrainingResult), *FilePath);
 }
 
 bool UChessMLModule::LoadTrainingResult(const FString& FilePath)
@@ -315,25 +1280,7 @@ bool UChessMLModule::LoadTrainingResult(const FString& FilePath)
         return false;
     }
 
-    TSharedPtr<FJsonObject> ResultObject;
-    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(FileContent);
-
-    if (FJsonSerializer::Deserialize(Reader, ResultObject) && ResultObject.IsValid())
-    {
-        ResultObject->TryGetNumberField(TEXT("EpochsTrained"), TrainingResult.EpochsTrained);
-        ResultObject->TryGetNumberField(TEXT("Accuracy"), TrainingResult.Accuracy);
-        ResultObject->TryGetNumberField(TEXT("Loss"), TrainingResult.Loss);
-
-        FString TimeString;
-        if (ResultObject->TryGetStringField(TEXT("LastTrainingTime"), TimeString))
-        {
-            FDateTime::Parse(TimeString, TrainingResult.LastTrainingTime);
-        }
-
-        return true;
-    }
-
-    return false;
+    return TrainingResultFromJson(FileContent, TrainingResult);
 }
 
 FMLTrainingResult UChessMLModule::GetTrainingStatus() const
@@ -348,57 +1295,86 @@ bool UChessMLModule::IsTrained() const
 
 void UChessMLModule::ClearData()
 {
-    TrainingData.Empty();
-    FeatureCache.Empty();
-    LabelCache.Empty();
+    // 训练线程还在读这些数据，训练完成后又会写回训练状态
+    if (bIsTraining)
+    {
+        ULogger::LogWarning(TEXT("UChessMLModule::ClearData: training in progress"));
+        return;
+    }
+
     TrainingResult = FMLTrainingResult();
 
-    // 删除数据文件
-    FString DataPath = FPaths::ProjectSavedDir() + DataSavePath + TEXT("TrainingData.json");
-    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-    PlatformFile.DeleteFile(*DataPath);
+    // 清空数据文件
+    if (TrainingLog.IsValid())
+    {
+        TrainingLog->Clear();
+    }
 
     ULogger::Log(TEXT("All training data cleared"));
 }
 
 FString UChessMLModule::PredictWithNeuralNetwork(const FString& BoardFen, const TArray<FString>& ValidMoves)
 {
-    if (NeuralNetworkWeights.Num() == 0 || ValidMoves.Num() == 0)
+    // 优先使用量化模型
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> Quantized = QuantizedNetwork;
+    TSharedPtr<const FXQMLNetwork, ESPMode::ThreadSafe> Float = Network;
+    const int32 InputSize = Quantized.IsValid() ? Quantized->GetInputSize() : (Float.IsValid() ? Float->GetInputSize() : 0);
+    const int32 OutputSize = Quantized.IsValid() ? Quantized->GetOutputSize() : (Float.IsValid() ? Float->GetOutputSize() : 0);
+
+    FXQPosition Position;
+    if (ValidMoves.Num() == 0 || InputSize != XQ_ML_NUM_FEATURES || !ParseFenString(BoardFen, Position))
     {
         return TEXT("");
     }
 
-    TArray<float> Features = ConvertBoardToFeatures(BoardFen);
-    TArray<TArray<float>> LayerOutputs;
-    TArray<float> Predictions = ForwardPass(Features, LayerOutputs);
-
-    // 找到概率最高的合法走法
-    float BestProbability = -1.0f;
-    FString BestMove;
-
-    for (const FString& Move : ValidMoves)
+    // 输入只有局面中各子对应的特征下标；每个线程复用输出和中间层缓冲区，推理时不再分配内存
+    uint16 Features[XQ_ML_MAX_ACTIVE_FEATURES];
+    const int32 NumFeatures = XQMLEncodeActiveFeatures(Position, Features);
+    thread_local std::vector<float> Logits;
+    thread_local std::vector<float> Scratch;
+    thread_local FXQMLQuantizedScratch QuantizedScratch;
+    thread_local std::vector<int32> Labels;
+    thread_local std::vector<float> Probabilities;
+    Logits.resize(OutputSize);
+    if (Quantized.IsValid())
     {
-        TArray<float> MoveFeatures = ConvertMoveToFeatures(Move);
-
-        // 计算这个走法的概率
-        float Probability = 0.0f;
-        for (int32 i = 0; i < FMath::Min(Predictions.Num(), MoveFeatures.Num()); i++)
-        {
-            if (MoveFeatures[i] > 0.5f) // 这个位置有走法
-            {
-                Probability += Predictions[i];
-                break; // 每个走法只对应一个输出位置
-            }
-        }
+        Quantized->ForwardLogits(Features, NumFeatures, Logits.data(), QuantizedScratch);
+    }
+    else
+    {
+        const int32 Offsets[2] = { 0, NumFeatures };
+        FXQMLSparseInput Input;
+        Input.Indices = Features;
+        Input.Offsets = Offsets;
+        Float->ForwardLogits(Input, 1, Logits.data(), Scratch);
+    }
 
-        if (Probability > BestProbability)
+    // 只在合法走法上做Softmax，每个走法对应一个策略输出
+    TArray<int32, TInlineAllocator<128>> MoveIndices;
+    Labels.clear();
+    for (int32 i = 0; i < ValidMoves.Num(); i++)
+    {
+        FXQMove EngineMove;
+        const int32 Label = ParseMoveString(ValidMoves[i], EngineMove) ? XQMLMoveLabel(EngineMove) : -1;
+        if (Label >= 0 && Label < static_cast<int32>(Logits.size()))
         {
-            BestProbability = Probability;
-            BestMove = Move;
+            Labels.push_back(Label);
+            MoveIndices.Add(i);
         }
     }
+    if (Labels.empty())
+    {
+        return TEXT("");
+    }
 
-    return BestMove;
+    Probabilities.resize(Labels.size());
+    XQMLMaskedSoftmax(Logits.data(), Labels.data(), static_cast<int32>(Labels.size()), Probabilities.data());
+    int32 Best = 0;
+    for (int32 i = 1; i < static_cast<int32>(Probabilities.size()); i++)
+    {
+        Best = Probabilities[i] > Probabilities[Best] ? i : Best;
+    }
+    return ValidMoves[MoveIndices[Best]];
 }
 
 FString UChessMLModule::PredictWithDecisionTree(const FString& BoardFen, const TArray<FString>& ValidMoves)
@@ -410,6 +1386,10 @@ FString UChessMLModule::PredictWithDecisionTree(const FString& BoardFen, const T
 
     TArray<float> Features = ConvertBoardToFeatures(BoardFen);
     TArray<float> Predictions = DecisionTree->Predict(Features);
+    if (Predictions.Num() == 0)
+    {
+        return TEXT("");
+    }
 
     // 找到概率最高的合法走法
     float BestScore = -MAX_FLT;
@@ -417,18 +1397,14 @@ FString UChessMLModule::PredictWithDecisionTree(const FString& BoardFen, const T
 
     for (const FString& Move : ValidMoves)
     {
-        TArray<float> MoveFeatures = ConvertMoveToFeatures(Move);
-
-        // 计算这个走法的得分（简化实现）
-        float Score = 0.0f;
-        for (int32 i = 0; i < FMath::Min(Predictions.Num(), MoveFeatures.Num()); i++)
+        FXQMove EngineMove;
+        if (!ParseMoveString(Move, EngineMove))
         {
-            if (MoveFeatures[i] > 0.5f) // 这个位置有走法
-            {
-                Score += Predictions[i];
-            }
+            continue;
         }
 
+        const int32 Label = XQMLMoveLabel(EngineMove);
+        const float Score = Label >= 0 && Label < Predictions.Num() ? Predictions[Label] : 0.0f;
         if (Score > BestScore)
         {
             BestScore = Score;
@@ -441,137 +1417,241 @@ FString UChessMLModule::PredictWithDecisionTree(const FString& BoardFen, const T
 
 void UChessMLModule::LoadTrainingDataFromFile()
 {
-    FString DataPath = FPaths::ProjectSavedDir() + DataSavePath + TEXT("TrainingData.json");
+    const FString DataDir = FPaths::ProjectSavedDir() + DataSavePath;
+    const FString LogPath = DataDir + TEXT("TrainingData.bin");
+
+    TrainingLog = MakeShared<FXQTrainingLog, ESPMode::ThreadSafe>();
+    if (!TrainingLog->Open(TCHAR_TO_UTF8(*LogPath)))
+    {
+        ULogger::LogError(FString::Printf(TEXT("UChessMLModule::LoadTrainingDataFromFile: cannot open %s"), *LogPath));
+        TrainingLog.Reset();
+        return;
+    }
+
+    const FString LegacyPath = DataDir + TEXT("TrainingData.json");
+    if (FPaths::FileExists(LegacyPath))
+    {
+        ImportLegacyTrainingData(LegacyPath);
+    }
+
+    CompactTrainingLogIfNeeded();
+}
 
+void UChessMLModule::ImportLegacyTrainingData(const FString& JsonPath)
+{
     FString FileContent;
-    if (!FFileHelper::LoadFileToString(FileContent, *DataPath))
+    if (!FFileHelper::LoadFileToString(FileContent, *JsonPath))
     {
-        return; // 文件不存在是正常的
+        return;
     }
 
     TSharedPtr<FJsonObject> RootObject;
     TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(FileContent);
-
-    if (FJsonSerializer::Deserialize(Reader, RootObject) && RootObject.IsValid())
+    if (!FJsonSerializer::Deserialize(Reader, RootObject) || !RootObject.IsValid())
     {
-        TrainingData.Empty();
+        ULogger::LogWarning(FString::Printf(TEXT("UChessMLModule::ImportLegacyTrainingData: cannot parse %s"), *JsonPath));
+        return;
+    }
 
-        const TArray<TSharedPtr<FJsonValue>>* DataArray;
-        if (RootObject->TryGetArrayField(TEXT("TrainingData"), DataArray))
+    int32 Imported = 0;
+    const TArray<TSharedPtr<FJsonValue>>* DataArray;
+    if (RootObject->TryGetArrayField(TEXT("TrainingData"), DataArray))
+    {
+        FXQPosition Position;
+        for (const TSharedPtr<FJsonValue>& Value : *DataArray)
         {
-            for (const TSharedPtr<FJsonValue>& Value : *DataArray)
+            TSharedPtr<FJsonObject> DataObject = Value->AsObject();
+            if (!DataObject.IsValid())
+            {
+                continue;
+            }
+
+            FString BoardFen;
+            FString Move;
+            float Score = 0.0f;
+            int32 Depth = 0;
+            FString TimestampString;
+            FDateTime Timestamp = FDateTime::Now();
+            DataObject->TryGetStringField(TEXT("BoardFen"), BoardFen);
+            DataObject->TryGetStringField(TEXT("Move"), Move);
+            DataObject->TryGetNumberField(TEXT("Score"), Score);
+            DataObject->TryGetNumberField(TEXT("Depth"), Depth);
+            if (DataObject->TryGetStringField(TEXT("Timestamp"), TimestampString))
             {
-                TSharedPtr<FJsonObject> DataObject = Value->AsObject();
-                if (DataObject.IsValid())
-                {
-                    FChessMLData Data;
-                    DataObject->TryGetStringField(TEXT("BoardFen"), Data.BoardFen);
-                    DataObject->TryGetStringField(TEXT("Move"), Data.Move);
-                    DataObject->TryGetNumberField(TEXT("Score"), Data.Score);
-                    DataObject->TryGetNumberField(TEXT("Depth"), Data.Depth);
-
-                    FString TimestampString;
-                    if (DataObject->TryGetStringField(TEXT("Timestamp"), TimestampString))
-                    {
-                        FDateTime::Parse(TimestampString, Data.Timestamp);
-                    }
-
-                    TrainingData.Add(Data);
-                }
+                FDateTime::Parse(TimestampString, Timestamp);
+            }
+
+            FXQMove EngineMove;
+            FXQTrainingLogEntry Entry;
+            if (ParseFenString(BoardFen, Position) && ParseMoveString(Move, EngineMove) && Entry.Record.Position.Pack(Position))
+            {
+                Entry.Record.BestMove = EngineMove.Value;
+                Entry.Record.Score = static_cast<int16>(FMath::Clamp(FMath::RoundToInt(Score), -32767, 32767));
+                Entry.Record.Depth = static_cast<uint8>(FMath::Clamp(Depth, 0, 255));
+                Entry.Timestamp = (Timestamp - FDateTime(1970, 1, 1)).GetTicks() / ETimespan::TicksPerMillisecond;
+                Imported += TrainingLog->Append(Entry) ? 1 : 0;
             }
         }
     }
 
-    // 更新特征缓存
-    UpdateFeatureCache();
+    IFileManager::Get().Delete(*JsonPath);
+    ULogger::Log(FString::Printf(TEXT("Imported %d samples from %s"), Imported, *JsonPath));
 }
 
-void UChessMLModule::SaveTrainingDataToFile()
+bool UChessMLModule::PrepareDataset(FChessTrainingOutput& Output) const
 {
-    FString DataPath = FPaths::ProjectSavedDir() + DataSavePath + TEXT("TrainingData.json");
-
-    TSharedPtr<FJsonObject> RootObject = MakeShared<FJsonObject>();
-    TArray<TSharedPtr<FJsonValue>> DataArray;
+    const FString& DataDir = Output.DataDir;
+    const FString SnapshotPath = DataDir + TEXT("TrainingSet.xqtd");
+    FXQMLDataset& NewDataset = Output.Dataset;
+    NewDataset.Close();
 
-    for (const FChessMLData& Data : TrainingData)
+    // 训练日志的记录带长度前缀，不便随机访问，转成定长格式的快照后再映射
+    if (Output.TrainingLog.IsValid() && Output.TrainingLog->GetNum() > 0)
     {
-        TSharedPtr<FJsonObject> DataObject = MakeShared<FJsonObject>();
-        DataObject->SetStringField(TEXT("BoardFen"), Data.BoardFen);
-        DataObject->SetStringField(TEXT("Move"), Data.Move);
-        DataObject->SetNumberField(TEXT("Score"), Data.Score);
-        DataObject->SetNumberField(TEXT("Depth"), Data.Depth);
-        DataObject->SetStringField(TEXT("Timestamp"), Data.Timestamp.ToString());
+        FXQTrainingFileWriter Writer;
+        if (!Writer.Open(TCHAR_TO_UTF8(*SnapshotPath)))
+        {
+            ULogger::LogError(FString::Printf(TEXT("UChessMLModule::PrepareDataset: cannot write %s"), *SnapshotPath));
+            return false;
+        }
 
-        DataArray.Add(MakeShared<FJsonValueObject>(DataObject));
+        TArray<FXQTrainingRecord> Buffer;
+        Buffer.Reserve(4096);
+        int64 NewestTimestamp = 0;
+        FXQTrainingLog::ReadAll(TCHAR_TO_UTF8(*(DataDir + TEXT("TrainingData.bin"))), [&Writer, &Buffer, &NewestTimestamp](const FXQTrainingLogEntry& Entry)
+        {
+            NewestTimestamp = FMath::Max(NewestTimestamp, Entry.Timestamp);
+            Buffer.Add(Entry.Record);
+            if (Buffer.Num() == 4096)
+            {
+                Writer.Write(Buffer.GetData(), Buffer.Num());
+                Buffer.Reset();
+            }
+        });
+        Writer.Write(Buffer.GetData(), Buffer.Num());
+        Output.NewestTimestamp = NewestTimestamp;
+        if (!Writer.Close() || !NewDataset.AddFile(TCHAR_TO_UTF8(*SnapshotPath)))
+        {
+            ULogger::LogError(FString::Printf(TEXT("UChessMLModule::PrepareDataset: cannot map %s"), *SnapshotPath));
+            return false;
+        }
     }
 
-    RootObject->SetArrayField(TEXT("TrainingData"), DataArray);
-
-    FString OutputString;
-    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
-    FJsonSerializer::Serialize(RootObject.ToSharedRef(), Writer);
+    for (const FString& ChunkPath : Output.ChunkPaths)
+    {
+        if (!NewDataset.AddFile(TCHAR_TO_UTF8(*ChunkPath)))
+        {
+            ULogger::LogWarning(FString::Printf(TEXT("UChessMLModule::PrepareDataset: skip invalid file %s"), *ChunkPath));
+        }
+    }
 
-    FFileHelper::SaveStringToFile(OutputString, *DataPath);
+    return NewDataset.GetNum() > 0;
 }
 
-void UChessMLModule::UpdateFeatureCache()
+TArray<FString> UChessMLModule::GetSelfPlayChunkPaths() const
 {
-    FeatureCache.Empty();
-    LabelCache.Empty();
+    const FString SelfPlayDir = FPaths::ProjectSavedDir() + DataSavePath + TEXT("SelfPlay/");
 
-    for (const FChessMLData& Data : TrainingData)
-    {
-        TArray<float> Features = ConvertBoardToFeatures(Data.BoardFen);
-        TArray<float> Labels = ConvertMoveToFeatures(Data.Move);
+    TArray<FString> FileNames;
+    IFileManager::Get().FindFiles(FileNames, *(SelfPlayDir + TEXT("*.bin")), true, false);
+    FileNames.Sort();
 
-        if (Features.Num() > 0 && Labels.Num() > 0)
-        {
-            FeatureCache.Add(Features);
-            LabelCache.Add(Labels);
-        }
+    TArray<FString> Paths;
+    for (const FString& FileName : FileNames)
+    {
+        Paths.Add(SelfPlayDir + FileName);
     }
+    return Paths;
 }
 
-void UChessMLModule::TrainNeuralNetwork(int32 Epochs)
+bool UChessMLModule::TrainNeuralNetwork(int32 Epochs, FChessTrainingJob& Job, FChessTrainingOutput& Output) const
 {
-    if (FeatureCache.Num() == 0 || LabelCache.Num() == 0)
+    const FXQMLDataset& Dataset = Output.Dataset;
+    if (Dataset.GetNum() == 0)
     {
         ULogger::LogWarning(TEXT("No training data available"));
-        return;
+        return true;
     }
 
-    // 初始化神经网络权重（如果未初始化）
-    if (NeuralNetworkWeights.Num() == 0)
+    // 接着已加载模型的浮点权重训练（只有模型包时从包里读出），没有时重新初始化
+    FXQMLNetwork& Candidate = Output.Network;
+    if (Output.BaseNetwork.IsValid())
     {
-        InitializeNeuralNetwork();
+        Candidate = *Output.BaseNetwork;
     }
-
-    for (int32 Epoch = 0; Epoch < Epochs; Epoch++)
+    else if (Output.BaseBundle.IsValid())
+    {
+        ReadNetworkSection(*Output.BaseBundle, Candidate, TEXT("model bundle"));
+    }
+    if (Candidate.IsEmpty())
     {
-        float TotalLoss = 0.0f;
-        int32 BatchCount = 0;
+        InitializeNeuralNetwork(Candidate);
+    }
 
-        // 小批量训练
-        for (int32 BatchStart = 0; BatchStart < FeatureCache.Num(); BatchStart += TrainingBatchSize)
+    // 验证集中的样本不参与训练
+    const int64 NumRecords = FMath::Min<int64>(Dataset.GetNum(), MAX_int32);
+    TArray<int64> Order;
+    Order.Reserve(static_cast<int32>(NumRecords));
+    for (int64 i = 0; i < NumRecords; i++)
+    {
+        if (!IsValidationSample(Dataset.GetRecordKey(i)))
         {
-            int32 BatchEnd = FMath::Min(BatchStart + TrainingBatchSize, FeatureCache.Num());
+            Order.Add(i);
+        }
+    }
+    const int32 NumSamples = Order.Num();
+    if (NumSamples == 0)
+    {
+        return true;
+    }
+
+    // 小批量的展开缓冲区以及训练器中的激活值、梯度缓冲区都只与批大小有关，在整个训练过程中复用
+    TArray<uint16> BatchFeatures;
+    BatchFeatures.SetNumUninitialized(TrainingBatchSize * XQ_ML_MAX_ACTIVE_FEATURES);
+    TArray<int32> BatchOffsets;
+    BatchOffsets.SetNumUninitialized(TrainingBatchSize + 1);
+    TArray<int32> BatchLabels;
+    BatchLabels.SetNumUninitialized(TrainingBatchSize);
+    FXQMLTrainer Trainer(Candidate, OptimizerSettings, TrainingBatchSize, GetTrainingThreadCount());
+    ULogger::Log(FString::Printf(TEXT("Training neural network on %d samples with %d threads"), NumSamples, Trainer.GetNumThreads()));
 
-            // 前向传播
-            TArray<TArray<float>> LayerOutputs;
-            TArray<float> Output = ForwardPass(FeatureCache[BatchStart], LayerOutputs);
+    FChessTrainingProgress Progress;
+    Progress.Phase = EChessTrainingPhase::NeuralNetwork;
+    Progress.NumEpochs = Epochs;
+
+    for (int32 Epoch = 0; Epoch < Epochs; Epoch++)
+    {
+        // 每轮打乱样本顺序
+        for (int32 i = NumSamples - 1; i > 0; i--)
+        {
+            Order.Swap(i, FMath::RandRange(0, i));
+        }
 
-            // 计算损失
-            float Loss = CalculateLoss(Output, LabelCache[BatchStart]);
-            TotalLoss += Loss;
+        double TotalLoss = 0.0;
+        Progress.Epoch = Epoch;
 
-            // 反向传播
-            BackwardPass(FeatureCache[BatchStart], LabelCache[BatchStart], LayerOutputs, Output);
+        // 每个小批量是各层一次前向、两次反向的矩阵乘法
+        for (int32 BatchStart = 0; BatchStart < NumSamples; BatchStart += TrainingBatchSize)
+        {
+            if (!Job.CheckPoint())
+            {
+                return false;
+            }
 
-            BatchCount++;
+            const int32 BatchCount = FMath::Min(TrainingBatchSize, NumSamples - BatchStart);
+            Dataset.ExpandBatch(&Order[BatchStart], BatchCount, BatchFeatures.GetData(), BatchOffsets.GetData(), BatchLabels.GetData());
+            FXQMLSparseInput BatchInput;
+            BatchInput.Indices = BatchFeatures.GetData();
+            BatchInput.Offsets = BatchOffsets.GetData();
+            TotalLoss += Trainer.TrainBatch(BatchInput, BatchLabels.GetData(), BatchCount) * BatchCount;
+
+            const int32 Done = BatchStart + BatchCount;
+            Progress.Progress = (Epoch + static_cast<float>(Done) / NumSamples) / Epochs;
+            Progress.Loss = static_cast<float>(TotalLoss / Done);
+            Job.ReportProgress(Progress);
         }
 
-        float AverageLoss = TotalLoss / BatchCount;
-        TrainingResult.Loss = AverageLoss;
+        float AverageLoss = static_cast<float>(TotalLoss / NumSamples);
 
         if (Epoch % 10 == 0)
         {
@@ -585,307 +1665,174 @@ void UChessMLModule::TrainNeuralNetwork(int32 Epochs)
             break;
         }
     }
-}
 
-void UChessMLModule::TrainDecisionTree(int32 Epochs)
-{
-    if (!DecisionTree.IsValid())
+    if (!Job.CheckPoint())
     {
-        DecisionTree = MakeShared<ChessDecisionTree>(10, 2);
+        return false;
     }
 
-    if (FeatureCache.Num() > 0 && LabelCache.Num() > 0)
+    EvaluateNeuralNetwork(Candidate, Dataset, Output.Status);
+
+    // 训练后量化，推理使用int8模型
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> Quantized = MakeShared<FXQMLQuantizedNetwork, ESPMode::ThreadSafe>();
+    if (Quantized->Quantize(Candidate))
     {
-        DecisionTree->Train(FeatureCache, LabelCache);
-        TrainingResult.Accuracy = 0.8f; // 简化实现，实际应该计算准确率
+        Output.QuantizedNetwork = Quantized;
     }
+    return true;
 }
 
-TArray<float> UChessMLModule::ForwardPass(const TArray<float>& Input, TArray<TArray<float>>& LayerOutputs)
+void UChessMLModule::EvaluateNeuralNetwork(const FXQMLNetwork& InNetwork, const FXQMLDataset& Data, FMLTrainingResult& OutStatus) const
 {
-    TArray<float> CurrentInput = Input;
-    LayerOutputs.Empty();
-
-    for (int32 Layer = 0; Layer < NeuralNetworkWeights.Num(); Layer++)
+    TArray<int64> Samples;
+    for (int64 i = 0; i < Data.GetNum() && Samples.Num() < MaxValidationSamples; i++)
     {
-        TArray<float> LayerOutput;
-        LayerOutput.SetNum(NeuralNetworkBiases[Layer].Num());
-
-        // 矩阵乘法: Output = Input * Weights + Biases
-        for (int32 i = 0; i < NeuralNetworkWeights[Layer].Num(); i += CurrentInput.Num())
-        {
-            float Sum = 0.0f;
-            for (int32 j = 0; j < CurrentInput.Num(); j++)
-            {
-                if (i + j < NeuralNetworkWeights[Layer].Num())
-                {
-                    Sum += CurrentInput[j] * NeuralNetworkWeights[Layer][i + j];
-                }
-            }
-            int32 OutputIndex = i / CurrentInput.Num();
-            if (OutputIndex < LayerOutput.Num())
-            {
-                LayerOutput[OutputIndex] = Sum + NeuralNetworkBiases[Layer][OutputIndex];
-            }
-        }
-
-        // 激活函数
-        if (Layer < NeuralNetworkWeights.Num() - 1)
-        {
-            ApplyReLU(LayerOutput); // 隐藏层用ReLU
-        }
-        else
+        if (IsValidationSample(Data.GetRecordKey(i)))
         {
-            ApplySoftmax(LayerOutput); // 输出层用Softmax
+            Samples.Add(i);
         }
-
-        LayerOutputs.Add(LayerOutput);
-        CurrentInput = LayerOutput;
+    }
+    if (Samples.Num() == 0)
+    {
+        return;
     }
 
-    return CurrentInput;
+    EvaluateNetwork(InNetwork, Data, Samples, OutStatus.Accuracy, OutStatus.Loss);
+    ULogger::Log(FString::Printf(TEXT("Neural network validation on %d samples: accuracy %.3f, loss %.3f"),
+        Samples.Num(), OutStatus.Accuracy, OutStatus.Loss));
 }
 
-void UChessMLModule::BackwardPass(const TArray<float>& Input, const TArray<float>& Target,
-    const TArray<TArray<float>>& LayerOutputs, const TArray<float>& Output)
+void UChessMLModule::EvaluateNetwork(const FXQMLNetwork& InNetwork, const FXQMLDataset& Data, const TArray<int64>& Samples, float& OutAccuracy, float& OutLoss) const
 {
-    // 计算输出层误差
-    TArray<float> Error = Output;
-    for (int32 i = 0; i < Error.Num(); i++)
-    {
-        Error[i] -= Target[i];
-    }
-
-    // 反向传播误差
-    for (int32 Layer = NeuralNetworkWeights.Num() - 1; Layer >= 0; Layer--)
+    TArray<uint16> BatchFeatures;
+    BatchFeatures.SetNumUninitialized(TrainingBatchSize * XQ_ML_MAX_ACTIVE_FEATURES);
+    TArray<int32> BatchOffsets;
+    BatchOffsets.SetNumUninitialized(TrainingBatchSize + 1);
+    TArray<int32> BatchLabels;
+    BatchLabels.SetNumUninitialized(TrainingBatchSize);
+    TArray<float> Probabilities;
+    Probabilities.SetNumUninitialized(TrainingBatchSize * XQ_ML_NUM_MOVES);
+    std::vector<float> Scratch;
+
+    int32 Correct = 0;
+    double TotalLoss = 0.0;
+    for (int32 BatchStart = 0; BatchStart < Samples.Num(); BatchStart += TrainingBatchSize)
     {
-        TArray<float> Gradient = Error;
-
-        // 计算梯度（如果是隐藏层，需要应用ReLU导数）
-        if (Layer < NeuralNetworkWeights.Num() - 1)
-        {
-            for (int32 i = 0; i < Gradient.Num(); i++)
-            {
-                // ReLU导数：如果输出>0则为1，否则为0
-                Gradient[i] *= (LayerOutputs[Layer][i] > 0.0f) ? 1.0f : 0.0f;
-            }
-        }
-
-        // 更新权重
-        TArray<float> PreviousOutput = (Layer == 0) ? Input : LayerOutputs[Layer - 1];
-
-        for (int32 i = 0; i < NeuralNetworkWeights[Layer].Num(); i++)
-        {
-            int32 OutputIndex = i / PreviousOutput.Num();
-            int32 InputIndex = i % PreviousOutput.Num();
-
-            if (OutputIndex < Gradient.Num())
-            {
-                NeuralNetworkWeights[Layer][i] -= LearningRate * Gradient[OutputIndex] * PreviousOutput[InputIndex];
-            }
-        }
-
-        // 更新偏置
-        for (int32 i = 0; i < NeuralNetworkBiases[Layer].Num(); i++)
-        {
-            if (i < Gradient.Num())
-            {
-                NeuralNetworkBiases[Layer][i] -= LearningRate * Gradient[i];
-            }
-        }
-
-        // 计算下一层的误差（如果需要）
-        if (Layer > 0)
+        const int32 BatchCount = FMath::Min(TrainingBatchSize, Samples.Num() - BatchStart);
+        Data.ExpandBatch(&Samples[BatchStart], BatchCount, BatchFeatures.GetData(), BatchOffsets.GetData(), BatchLabels.GetData());
+        FXQMLSparseInput BatchInput;
+        BatchInput.Indices = BatchFeatures.GetData();
+        BatchInput.Offsets = BatchOffsets.GetData();
+        InNetwork.Forward(BatchInput, BatchCount, Probabilities.GetData(), Scratch);
+
+        for (int32 i = 0; i < BatchCount; i++)
         {
-            Error.SetNum(PreviousOutput.Num());
-            for (int32 i = 0; i < PreviousOutput.Num(); i++)
+            const float* Row = Probabilities.GetData() + static_cast<int64>(i) * XQ_ML_NUM_MOVES;
+            int32 Best = 0;
+            for (int32 Label = 1; Label < XQ_ML_NUM_MOVES; Label++)
             {
-                Error[i] = 0.0f;
-                for (int32 j = 0; j < Gradient.Num(); j++)
-                {
-                    int32 WeightIndex = j * PreviousOutput.Num() + i;
-                    if (WeightIndex < NeuralNetworkWeights[Layer].Num())
-                    {
-                        Error[i] += Gradient[j] * NeuralNetworkWeights[Layer][WeightIndex];
-                    }
-                }
+                Best = Row[Label] > Row[Best] ? Label : Best;
             }
+            Correct += Best == BatchLabels[i] ? 1 : 0;
+            TotalLoss -= FMath::Loge(FMath::Max(Row[BatchLabels[i]], 1e-6f));
         }
     }
+
+    OutAccuracy = Samples.Num() > 0 ? static_cast<float>(Correct) / Samples.Num() : 0.0f;
+    OutLoss = Samples.Num() > 0 ? static_cast<float>(TotalLoss / Samples.Num()) : 0.0f;
 }
 
-void UChessMLModule::InitializeNeuralNetwork()
+bool UChessMLModule::TrainDecisionTree(int32 Epochs, FChessTrainingJob& Job, FChessTrainingOutput& Output) const
 {
-    // 简单的3层网络：输入层 -> 隐藏层 -> 输出层
-    int32 InputSize = 10 * 9 * 16;     // 棋盘特征
-    int32 HiddenSize = 256;           // 隐藏层大小
-    int32 OutputSize = 10 * 9 * 10 * 9; // 所有可能走法
-
-    NeuralNetworkWeights.SetNum(2);
-    NeuralNetworkBiases.SetNum(2);
-
-    // 初始化输入层到隐藏层
-    NeuralNetworkWeights[0].SetNum(InputSize * HiddenSize);
-    NeuralNetworkBiases[0].SetNum(HiddenSize);
-
-    // 初始化隐藏层到输出层
-    NeuralNetworkWeights[1].SetNum(HiddenSize * OutputSize);
-    NeuralNetworkBiases[1].SetNum(OutputSize);
-
-    // Xavier初始化权重
-    float Scale1 = FMath::Sqrt(2.0f / (InputSize + HiddenSize));
-    float Scale2 = FMath::Sqrt(2.0f / (HiddenSize + OutputSize));
-
-    for (int32 i = 0; i < NeuralNetworkWeights[0].Num(); i++)
+    const FXQMLDataset& Dataset = Output.Dataset;
+    if (Dataset.GetNum() == 0)
     {
-        NeuralNetworkWeights[0][i] = FMath::FRandRange(-Scale1, Scale1);
+        return true;
     }
 
-    for (int32 i = 0; i < NeuralNetworkWeights[1].Num(); i++)
+    FChessTrainingProgress Progress;
+    Progress.Phase = EChessTrainingPhase::DecisionTree;
+    Progress.Epoch = Epochs;
+    Progress.NumEpochs = Epochs;
+    Progress.Loss = Output.Status.Loss;
+    Job.ReportProgress(Progress, true);
+
+    // 均匀抽取最多MaxTreeSamples个样本，按稀疏的0/1特征保存
+    const int32 NumSamples = static_cast<int32>(FMath::Min<int64>(Dataset.GetNum(), MaxTreeSamples));
+    const double Stride = static_cast<double>(Dataset.GetNum()) / NumSamples;
+    FXQMLTreeData TreeData;
+    TreeData.Reset(XQ_ML_NUM_FEATURES, XQ_ML_NUM_MOVES);
+    TreeData.Reserve(NumSamples, static_cast<int64>(NumSamples) * XQ_ML_MAX_ACTIVE_FEATURES);
+    TArray<int32> Samples;
+    TArray<int32> ValidationSamples;
+    uint16 ActiveFeatures[XQ_ML_MAX_ACTIVE_FEATURES];
+    int32 Offsets[2];
+    for (int32 i = 0; i < NumSamples; i++)
     {
-        NeuralNetworkWeights[1][i] = FMath::FRandRange(-Scale2, Scale2);
+        const int64 Index = static_cast<int64>(i * Stride);
+        int32 Label = 0;
+        Dataset.ExpandBatch(&Index, 1, ActiveFeatures, Offsets, &Label);
+        TreeData.AddSample(ActiveFeatures, nullptr, Offsets[1], Label);
+        if (!IsValidationSample(Dataset.GetRecordKey(Index)))
+        {
+            Samples.Add(i);
+        }
+        else if (ValidationSamples.Num() < MaxValidationSamples)
+        {
+            ValidationSamples.Add(i);
+        }
     }
 
-    // 偏置初始化为0
-    for (int32 i = 0; i < NeuralNetworkBiases[0].Num(); i++)
+    // 森林的训练内部没有检查点，只在前后检查
+    if (!Job.CheckPoint())
     {
-        NeuralNetworkBiases[0][i] = 0.0f;
+        return false;
     }
-
-    for (int32 i = 0; i < NeuralNetworkBiases[1].Num(); i++)
+    TSharedPtr<ChessDecisionTree> NewTree = MakeShared<ChessDecisionTree>(12, 4, NumDecisionTrees);
+    const double StartTime = FPlatformTime::Seconds();
+    NewTree->Train(TreeData, Samples, GetTrainingThreadCount());
+    ULogger::Log(FString::Printf(TEXT("决策树训练完成，树数: %d, 样本数: %d, 用时: %.2f秒"),
+        NewTree->GetNumTrees(), Samples.Num(), FPlatformTime::Seconds() - StartTime));
+    if (!Job.CheckPoint())
     {
-        NeuralNetworkBiases[1][i] = 0.0f;
+        return false;
     }
-}
-
-TArray<float> UChessMLModule::ConvertBoardToFeatures(const FString& BoardFen)
-{
-    TArray<float> Features;
-    Features.SetNum(10 * 9 * 16); // 10x9棋盘，16种棋子类型
-
-    // 解析FEN字符串（简化版）
-    // 实际象棋FEN格式：rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR
-    TArray<FString> Rows;
-    BoardFen.ParseIntoArray(Rows, TEXT("/"));
 
-    int32 FeatureIndex = 0;
-
-    for (int32 i = 0; i < Rows.Num(); i++)
+    if (ValidationSamples.Num() > 0)
     {
-        FString Row = Rows[i];
-        int32 ColIndex = 0;
-
-        for (TCHAR Char : Row)
-        {
-            if (Char >= '1' && Char <= '9')
-            {
-                // 空格
-                int32 EmptySpaces = Char - '0';
-                for (int32 j = 0; j < EmptySpaces; j++)
-                {
-                    Features[FeatureIndex++] = 0.0f; // 空位
-                }
-                ColIndex += EmptySpaces;
-            }
-            else
-            {
-                // 棋子
-                int32 PieceType = GetPieceTypeFromChar(Char);
-                int32 PieceColor = FChar::IsUpper(Char) ? 0 : 1; // 红方0，黑方1
-
-                // 设置特征
-                int32 PieceIndex = PieceColor * 8 + PieceType;
-                Features[FeatureIndex + PieceIndex] = 1.0f;
-                FeatureIndex += 16; // 每个位置有16种可能
-
-                ColIndex++;
-            }
-        }
+        NewTree->Evaluate(TreeData, ValidationSamples, GetTrainingThreadCount(), Output.Status.TreeAccuracy, Output.Status.TreeLoss);
+        ULogger::Log(FString::Printf(TEXT("Decision forest validation on %d samples: accuracy %.3f, loss %.3f"),
+            ValidationSamples.Num(), Output.Status.TreeAccuracy, Output.Status.TreeLoss));
     }
-
-    return Features;
+    Output.DecisionTree = NewTree;
+    return true;
 }
 
-int32 UChessMLModule::GetPieceTypeFromChar(TCHAR Char)
+void UChessMLModule::InitializeNeuralNetwork(FXQMLNetwork& OutNetwork) const
 {
-    switch (FChar::ToLower(Char))
-    {
-    case 'k': return 0; // 将/帅
-    case 'a': return 1; // 士/仕
-    case 'b': return 2; // 象/相
-    case 'n': return 3; // 马
-    case 'r': return 4; // 车
-    case 'c': return 5; // 炮
-    case 'p': return 6; // 兵/卒
-    default: return 7;  // 未知
-    }
+    // 简单的3层网络：输入层 -> 隐藏层 -> 输出层，Xavier初始化权重，偏置初始化为0
+    const int32 InputSize = XQ_ML_NUM_FEATURES; // 棋盘特征
+    const int32 HiddenSize = 256;               // 隐藏层大小
+    const int32 OutputSize = XQ_ML_NUM_MOVES;   // 几何上可能的走法
+
+    OutNetwork.Initialize({ InputSize, HiddenSize, OutputSize }, FPlatformTime::Cycles64());
 }
 
-TArray<float> UChessMLModule::ConvertMoveToFeatures(const FString& Move)
+TArray<float> UChessMLModule::ConvertBoardToFeatures(const FString& BoardFen)
 {
     TArray<float> Features;
-    Features.SetNum(10 * 9 * 10 * 9); // 所有可能的走法
 
-    if (Move.Len() < 4) return Features;
-
-    // 解析走法格式："a0a1" 或 "h2e2"
-    int32 FromX = Move[0] - 'a';
-    int32 FromY = Move[1] - '0';
-    int32 ToX = Move[2] - 'a';
-    int32 ToY = Move[3] - '0';
-
-    if (FromX >= 0 && FromX < 9 && FromY >= 0 && FromY < 10 &&
-        ToX >= 0 && ToX < 9 && ToY >= 0 && ToY < 10)
+    // 与训练集使用同一种编码：每个格子16个特征（红方0-7，黑方8-15）
+    FXQPosition Position;
+    if (ParseFenString(BoardFen, Position))
     {
-        int32 MoveIndex = FromY * 9 * 10 * 9 + FromX * 10 * 9 + ToY * 9 + ToX;
-        if (MoveIndex >= 0 && MoveIndex < Features.Num())
-        {
-            Features[MoveIndex] = 1.0f;
-        }
+        Features.SetNumUninitialized(XQ_ML_NUM_FEATURES);
+        XQMLEncodeFeatures(Position, Features.GetData());
     }
-
-    return Features;
-}
-
-float UChessMLModule::CalculateLoss(const TArray<float>& Output, const TArray<float>& Target)
-{
-    // 交叉熵损失
-    float Loss = 0.0f;
-    for (int32 i = 0; i < Output.Num(); i++)
+    else
     {
-        if (Target[i] > 0.5f) // 这是正确的走法
-        {
-            Loss += -FMath::Loge(FMath::Max(Output[i], 1e-8f));
-        }
+        Features.SetNumZeroed(XQ_ML_NUM_FEATURES);
     }
-    return Loss;
-}
 
-void UChessMLModule::ApplyReLU(TArray<float>& Data)
-{
-    for (float& Value : Data)
-    {
-        Value = FMath::Max(0.0f, Value);
-    }
+    return Features;
 }
-
-void UChessMLModule::ApplySoftmax(TArray<float>& Data)
-{
-    float MaxVal = TNumericLimits<float>::Lowest();
-    for (float Val : Data)
-    {
-        if (Val > MaxVal) MaxVal = Val;
-    }
-
-    float Sum = 0.0f;
-    for (float& Val : Data)
-    {
-        Val = FMath::Exp(Val - MaxVal); // 数值稳定性
-        Sum += Val;
-    }
-
-    for (float& Val : Data)
-    {
-        Val /= Sum;
-    }
-}
\ No newline at end of file
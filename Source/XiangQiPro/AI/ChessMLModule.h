@@ -4,8 +4,28 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "Async/Future.h"
+#include "HAL/Runnable.h"
+
+#include "XQMLNetwork.h"
+
+#include <atomic>
+
 #include "ChessMLModule.generated.h"
 
+class FChessTrainingJob;
+class FXQMLDataset;
+class FXQModelBundle;
+class FXQMovePolicy;
+class FXQPosition;
+struct FXQMove;
+class FXQMLQuantizedNetwork;
+class FXQTrainingLog;
+class FRunnableThread;
+struct FChessIncrementalTrainingState;
+struct FChessTrainingOutput;
+struct FChessModelSaveQueue;
+
 // ѧϰݽṹ
 USTRUCT(BlueprintType)
 struct FChessMLData
@@ -37,16 +57,69 @@ struct FMLTrainingResult
     UPROPERTY()
     int32 EpochsTrained = 0;
 
+    // ֤ϵ׼ȷʺƽ
     UPROPERTY()
     float Accuracy = 0.0f;
 
     UPROPERTY()
     float Loss = 0.0f;
 
+    // ɭͬһ֤ϵ׼ȷʺƽ
+    UPROPERTY()
+    float TreeAccuracy = 0.0f;
+
+    UPROPERTY()
+    float TreeLoss = 0.0f;
+
     UPROPERTY()
     FDateTime LastTrainingTime;
+
+    // ģѵһ־ʱ䣨Unix룩֮¼ѵ
+    UPROPERTY()
+    int64 LastSampleTimestamp = 0;
 };
 
+// ѵ׶
+UENUM(BlueprintType)
+enum class EChessTrainingPhase : uint8
+{
+    Preparing,          // ׼ѵ
+    NeuralNetwork,      // ѵ
+    DecisionTree,       // ѵ
+    Finished,           // ѵ
+    Cancelled           // ѵȡ
+};
+
+// ѵȣϷ̹߳㲥
+USTRUCT(BlueprintType)
+struct FChessTrainingProgress
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly)
+    EChessTrainingPhase Phase = EChessTrainingPhase::Preparing;
+
+    // ǷΪԾ֮ѵ
+    UPROPERTY(BlueprintReadOnly)
+    bool bIncremental = false;
+
+    UPROPERTY(BlueprintReadOnly)
+    int32 Epoch = 0;
+
+    UPROPERTY(BlueprintReadOnly)
+    int32 NumEpochs = 0;
+
+    // ǰ׶εɱ01
+    UPROPERTY(BlueprintReadOnly)
+    float Progress = 0.0f;
+
+    // ǰһֵĿǰΪֹƽʧ
+    UPROPERTY(BlueprintReadOnly)
+    float Loss = 0.0f;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnChessTrainingProgress, const FChessTrainingProgress&);
+
 // ѧϰģľʵ
 UCLASS(BlueprintType, Blueprintable)
 class XIANGQIPRO_API UChessMLModule : public UObject
@@ -56,28 +129,63 @@ class XIANGQIPRO_API UChessMLModule : public UObject
 public:
     UChessMLModule();
 
+    virtual void BeginDestroy() override;
+
     // ʼ
     virtual bool Initialize();
 
     // ѵ
     virtual void SaveTrainingData(const FString& BoardFen, const FString& Move, float Score, int32 Depth);
 
+    // ֱӼ¼߷水ոʽдѵ־FENַ
+    void SaveTrainingData(const FXQPosition& Position, FXQMove Move, float Score, int32 Depth);
+
     // ʼѵ
     virtual bool StartTraining(int32 Epochs = 100);
 
+    // ԾֿʼʱtrueѵС֮óԾֽʱfalse漴Կʼѵ
+    void SetGameInProgress(bool bInProgress);
+
+    // ÿAIʾʼʱBeginSearchȡʱEndSearch߳ɶԣϷ̣߳
+    // ֻҪڽУѵͣڼ
+    void BeginSearch();
+
+    void EndSearch();
+
+    // ȡڽеѵѵһС֮ǰ˳ǰģͲ
+    void CancelTraining();
+
+    // ͣͻָStartTrainingʼѵ
+    void PauseTraining();
+
+    void ResumeTraining();
+
+    bool IsTraining() const { return bIsTraining; }
+
+    // ѵȣϷ̹߳㲥
+    FOnChessTrainingProgress OnTrainingProgress;
+
+    // ȼ߳¼¼΢磬֤ϸʱ滻ǰģ͡
+    // ԾֽСѵʱκ
+    bool StartIncrementalTraining();
+
     // Ԥ߷
     virtual FString PredictBestMove(const FString& BoardFen, const TArray<FString>& ValidMoves);
 
-    // ģ
+    // ģͣϷ߳ȡգɺ̨߳дһģͰModelName.<>.xqmodel
+    // Ƿύ棬д־
     virtual bool SaveModel(const FString& ModelName);
 
-    // ģ
+    // ģͣӳ䲢УµģͰûģͰʱȡɰɢļ
     virtual bool LoadModel(const FString& ModelName);
 
     bool SaveNeuralNetwork(const FString& FilePath);
 
     bool LoadNeuralNetwork(const FString& FilePath);
 
+    // ӳint8ģͣ.xqnnֱ
+    bool LoadQuantizedNetwork(const FString& FilePath);
+
     bool SaveTrainingResult(const FString& FilePath);
 
     bool LoadTrainingResult(const FString& FilePath);
@@ -86,9 +194,17 @@ public:
 
     bool IsTrained() const;
 
+    // ģ͸ṩ߷飬ûģʱؿաصĶģã֮ѵӰ
+    TSharedPtr<FXQMovePolicy, ESPMode::ThreadSafe> CreateMovePolicy() const;
+
     void ClearData();
 
 private:
+    // ȡConfig/MLConfig.iniеѵ
+    void LoadConfig();
+
+    int32 GetTrainingThreadCount() const;
+
     // Ԥ
     FString PredictWithNeuralNetwork(const FString& BoardFen, const TArray<FString>& ValidMoves);
 
@@ -98,56 +214,143 @@ private:
     // ѵ
     void LoadTrainingDataFromFile();
 
-    // ѵݵļ
-    void SaveTrainingDataToFile();
+    // ѾɰTrainingData.jsonѵ־ɹɾļ
+    void ImportLegacyTrainingData(const FString& JsonPath);
 
-    void UpdateFeatureCache();
+    // ѵ־޵ʱں̨ѹ
+    void CompactTrainingLogIfNeeded();
 
-    // ѵ
-    void TrainNeuralNetwork(int32 Epochs);
+    // ѵ߳ѵ־ĶգҶݣDataSavePath/SelfPlay/*.binһӳΪOutput.Dataset
+    bool PrepareDataset(FChessTrainingOutput& Output) const;
 
-    // ѵ
-    void TrainDecisionTree(int32 Epochs);
+    TArray<FString> GetSelfPlayChunkPaths() const;
 
-    TArray<float> ForwardPass(const TArray<float>& Input, TArray<TArray<float>>& LayerOutputs);
+    // ѵ񣬽תOnTrainingProgress
+    TSharedPtr<FChessTrainingJob, ESPMode::ThreadSafe> CreateTrainingJob();
 
-    void BackwardPass(const TArray<float>& Input, const TArray<float>& Target, const TArray<TArray<float>>& LayerOutputs, const TArray<float>& Output);
+    // ѵ߳Output.DatasetѵOutput.Networkȡʱfalseдģ״̬
+    bool TrainNeuralNetwork(int32 Epochs, FChessTrainingJob& Job, FChessTrainingOutput& Output) const;
 
-    void InitializeNeuralNetwork();
+    // ѵ߳ѵµľŽOutputȡʱfalseдģ״̬
+    bool TrainDecisionTree(int32 Epochs, FChessTrainingJob& Job, FChessTrainingOutput& Output) const;
 
-    // ̱ʾ
-    TArray<float> ConvertBoardToFeatures(const FString& BoardFen);
+    // ֤ϼ׼ȷʺʧ
+    void EvaluateNeuralNetwork(const FXQMLNetwork& InNetwork, const FXQMLDataset& Data, FMLTrainingResult& OutStatus) const;
+
+    void EvaluateNetwork(const FXQMLNetwork& InNetwork, const FXQMLDataset& Data, const TArray<int64>& Samples, float& OutAccuracy, float& OutLoss) const;
+
+    // ѵ̵߳壬BaseΪʼʱĸ磨ΪʱBaseBundleȡûͷѵ
+    void RunIncrementalTraining(FXQMLNetwork Base, TSharedPtr<FXQModelBundle, ESPMode::ThreadSafe> BaseBundle, FMLTrainingResult Status, FChessTrainingJob& Job);
+
+    bool ShouldYieldTraining() const { return bGameInProgress || bStopIncrementalTraining; }
 
-    int32 GetPieceTypeFromChar(TCHAR Char);
+    // ѵļ㣺ѵ;ͽȣдʱļ滻
+    bool SaveIncrementalCheckpoint(const FChessIncrementalTrainingState& State) const;
 
-    // ߷ʾ
-    TArray<float> ConvertMoveToFeatures(const FString& Move);
+    TSharedPtr<FChessIncrementalTrainingState, ESPMode::ThreadSafe> LoadIncrementalCheckpoint(int64 BaseTimestamp) const;
 
-    float CalculateLoss(const TArray<float>& Output, const TArray<float>& Target);
+    FString GetIncrementalCheckpointPath() const;
 
-    void ApplyReLU(TArray<float>& Data);
+    void InitializeNeuralNetwork(FXQMLNetwork& OutNetwork) const;
 
-    void ApplySoftmax(TArray<float>& Data);
+    // ɵǰĸģ
+    void QuantizeNeuralNetwork();
+
+    // ֻģʱȡȨ
+    void LoadPendingNeuralNetwork();
+
+    // ʹУģͰȱٱĶʱfalseҲı䵱ǰģ
+    bool LoadModelBundle(const TSharedPtr<FXQModelBundle, ESPMode::ThreadSafe>& Bundle);
+
+    // ɰģͣ_NeuralNet.bin_DecisionTree.bin_TrainingResult.json
+    bool LoadLegacyModel(const FString& ModelName);
+
+    // ̱ʾ
+    TArray<float> ConvertBoardToFeatures(const FString& BoardFen);
 
 protected:
-    TArray<FChessMLData> TrainingData;
+    int32 MaxTrainingSamples = 10000;
     FMLTrainingResult TrainingResult;
-    bool bIsTraining = false;
+    // ѵ߳˳ʱϷ߳ʱȡ
+    std::atomic<bool> bIsTraining{ false };
     bool bIsInitialized = false;
     FString ModelSavePath = "MLModels/";
     FString DataSavePath = "TrainingData/";
 
 private:
-    TArray<TArray<float>> NeuralNetworkWeights;
-    TArray<TArray<float>> NeuralNetworkBiases;
+    // ֻ׷ӵĶѵ־TrainingData.bin
+    TSharedPtr<FXQTrainingLog, ESPMode::ThreadSafe> TrainingLog;
+
+    // 磬ȨذţѵɱĿգѵʱ
+    // ѵͱֻãϷ߳ϲȨءΪձʾûиȨأָ磩
+    TSharedPtr<const FXQMLNetwork, ESPMode::ThreadSafe> Network;
+
+    // int8Ĳ磬
+    TSharedPtr<FXQMLQuantizedNetwork, ESPMode::ThreadSafe> QuantizedNetwork;
+
+    // Ѽģ͵ûжȡȨصģͰ
+    TSharedPtr<FXQModelBundle, ESPMode::ThreadSafe> PendingNetworkBundle;
+
+    // ̨ģͰ˳д룬ϾɵĿձµȡʱ
+    TSharedPtr<FChessModelSaveQueue, ESPMode::ThreadSafe> ModelSaveQueue;
+
+    // һύı棬ǰд
+    TFuture<bool> PendingModelSave;
 
     // 
     TSharedPtr<class ChessDecisionTree> DecisionTree;
 
-    // ѵݻ
-    TArray<TArray<float>> FeatureCache;
-    TArray<TArray<float>> LabelCache;
+    // ѵʹõÿԼֽڣ
+    int32 MaxTreeSamples = 1000000;
+
+    // ɭֵ1Ϊþ
+    int32 NumDecisionTrees = 8;
+
+    // ֤ʹõ
+    int32 MaxValidationSamples = 50000;
+
+    int32 TrainingBatchSize = 256;
+    FXQMLOptimizerSettings OptimizerSettings;
+
+    // ѵ߳ѵ̣߳0ΪCPU߳һ
+    int32 TrainingThreads = 0;
+
+    // ѵٻ۶ſʼѵ֣ÿ뼸
+    bool bEnableIncrementalTraining = true;
+    int32 IncrementalMinSamples = 200;
+    int32 IncrementalEpochs = 4;
+    int32 IncrementalReplayRatio = 3;
+
+    // ûģʱѵͷѵ
+    int32 InitialTrainingEpochs = 100;
+
+    // ̼룩
+    float IncrementalCheckpointInterval = 60.0f;
+
+    // ԾѵʱƬÿTrainingSliceMillisecondsóTrainingYieldMilliseconds
+    float TrainingSliceMilliseconds = 10.0f;
+    float TrainingYieldMilliseconds = 10.0f;
+
+    // ѵȱ̼룩
+    float TrainingProgressInterval = 0.25f;
+
+    // ڽеֻϷ̷߳
+    int32 ActiveSearchCount = 0;
+
+    // ǰһѵֻϷ̷߳
+    TSharedPtr<FChessTrainingJob, ESPMode::ThreadSafe> TrainingJob;
+
+    // StartTrainingõĹ
+    TWeakObjectPtr<class UAsyncWorker> TrainingWorker;
+
+    std::atomic<bool> bGameInProgress{ false };
+
+    std::atomic<bool> bStopIncrementalTraining{ false };
+
+    TUniquePtr<FRunnable> IncrementalRunnable;
+
+    FRunnableThread* IncrementalThread = nullptr;
 
-    int32 TrainingBatchSize = 32;
-    float LearningRate = 0.001f;
+    // Ծֿʼжϵѵֻѵ߳з
+    TSharedPtr<FChessIncrementalTrainingState, ESPMode::ThreadSafe> IncrementalState;
 };
@@ -0,0 +1,110 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "ChessTrainingJob.h"
+
+#include "XiangQiPro/Util/AsyncWorker.h"
+
+#include "Async/Async.h"
+#include "HAL/Event.h"
+
+FChessTrainingJob::FChessTrainingJob(TFunction<void(const FChessTrainingProgress&)> InOnProgress)
+    : OnProgress(MoveTemp(InOnProgress))
+    , WakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
+{
+}
+
+FChessTrainingJob::~FChessTrainingJob()
+{
+    if (WakeEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+        WakeEvent = nullptr;
+    }
+}
+
+void FChessTrainingJob::Configure(float InSliceSeconds, float InYieldSeconds, float InProgressInterval)
+{
+    SliceSeconds = FMath::Max(InSliceSeconds, 0.001f);
+    YieldSeconds = FMath::Max(InYieldSeconds, 0.0f);
+    ProgressInterval = FMath::Max(InProgressInterval, 0.0f);
+}
+
+void FChessTrainingJob::Cancel()
+{
+    bCancelled = true;
+    WakeEvent->Trigger();
+}
+
+void FChessTrainingJob::SetMatchRunning(bool bRunning)
+{
+    bMatchRunning = bRunning;
+    WakeEvent->Trigger();
+}
+
+void FChessTrainingJob::SetSearchRunning(bool bRunning)
+{
+    bSearchRunning = bRunning;
+    if (!bRunning)
+    {
+        WakeEvent->Trigger();
+    }
+}
+
+bool FChessTrainingJob::CheckPoint()
+{
+    if (Worker)
+    {
+        // 工作器暂停时在它的事件上等待，停止视同取消
+        Worker->CheckPause();
+        if (Worker->ShouldStop())
+        {
+            bCancelled = true;
+        }
+    }
+
+    // AI搜索期间完全停下，搜索结束或取消时被唤醒；等待有超时，以便再次检查工作器
+    while (bSearchRunning && !bCancelled)
+    {
+        WakeEvent->Wait(100);
+        SliceStartTime = FPlatformTime::Seconds();
+        if (Worker && Worker->ShouldStop())
+        {
+            bCancelled = true;
+        }
+    }
+    if (bCancelled)
+    {
+        return false;
+    }
+
+    // 对局中按时间片运行，给游戏线程和渲染留出CPU
+    const double Now = FPlatformTime::Seconds();
+    if (!bMatchRunning)
+    {
+        SliceStartTime = Now;
+    }
+    else if (Now - SliceStartTime >= SliceSeconds)
+    {
+        if (YieldSeconds > 0.0f)
+        {
+            WakeEvent->Wait(FMath::CeilToInt(YieldSeconds * 1000.0f));
+        }
+        SliceStartTime = FPlatformTime::Seconds();
+    }
+    return !bCancelled;
+}
+
+void FChessTrainingJob::ReportProgress(const FChessTrainingProgress& Progress, bool bForce)
+{
+    const double Now = FPlatformTime::Seconds();
+    if (!OnProgress || (!bForce && Now - LastProgressTime < ProgressInterval))
+    {
+        return;
+    }
+    LastProgressTime = Now;
+
+    AsyncTask(ENamedThreads::GameThread, [Callback = OnProgress, Progress]()
+    {
+        Callback(Progress);
+    });
+}
@@ -0,0 +1,77 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ChessMLModule.h"
+
+#include <atomic>
+
+class FEvent;
+class UAsyncWorker;
+
+/**
+ * 一次训练任务。训练循环在每轮和每个小批量之后调用CheckPoint，在这里响应取消和暂停；
+ * 对局进行中按时间片运行，AI搜索期间完全停下，把CPU让给搜索。
+ * 进度和损失节流后转到游戏线程
+ */
+class XIANGQIPRO_API FChessTrainingJob
+{
+public:
+    // OnProgress在游戏线程调用
+    explicit FChessTrainingJob(TFunction<void(const FChessTrainingProgress&)> InOnProgress);
+
+    ~FChessTrainingJob();
+
+    FChessTrainingJob(const FChessTrainingJob&) = delete;
+
+    FChessTrainingJob& operator=(const FChessTrainingJob&) = delete;
+
+    // 对局中每运行SliceSeconds让出YieldSeconds；进度最多每ProgressInterval秒报告一次
+    void Configure(float InSliceSeconds, float InYieldSeconds, float InProgressInterval);
+
+    // 训练所在的工作器，它的停止和暂停也在检查点生效。只在训练线程调用
+    void SetWorker(UAsyncWorker* InWorker) { Worker = InWorker; }
+
+    // 请求取消（任意线程），训练在下一个检查点退出
+    void Cancel();
+
+    bool IsCancelled() const { return bCancelled; }
+
+    // 对局是否在进行（任意线程）
+    void SetMatchRunning(bool bRunning);
+
+    // AI是否正在搜索（任意线程）
+    void SetSearchRunning(bool bRunning);
+
+    // 训练线程：每个小批量之后调用，返回false时应尽快退出
+    bool CheckPoint();
+
+    // 训练线程：报告进度，距上次报告不到ProgressInterval时丢弃，bForce用于阶段结束
+    void ReportProgress(const FChessTrainingProgress& Progress, bool bForce = false);
+
+private:
+    TFunction<void(const FChessTrainingProgress&)> OnProgress;
+
+    UAsyncWorker* Worker = nullptr;
+
+    // 取消、恢复或搜索结束时唤醒等待中的训练线程
+    FEvent* WakeEvent = nullptr;
+
+    std::atomic<bool> bCancelled{ false };
+
+    std::atomic<bool> bMatchRunning{ false };
+
+    std::atomic<bool> bSearchRunning{ false };
+
+    float SliceSeconds = 0.01f;
+
+    float YieldSeconds = 0.01f;
+
+    float ProgressInterval = 0.25f;
+
+    // 以下只在训练线程访问
+    double SliceStartTime = 0.0;
+
+    double LastProgressTime = -MAX_dbl;
+};
@@ -17,7 +17,6 @@
 #include "XiangQiPro/Util/Logger.h"
 #include "XiangQiPro/Util/ChessMove.h"
 #include "XiangQiPro/Util/ChessInfo.h"
-#include "XiangQiPro/Util/AsyncWorker.h"
 #include "XiangQiPro/Util/EndingLibrary.h"
 
 void AXQPGameStateBase::UpdateScore()
@@ -49,14 +48,15 @@ void AXQPGameStateBase::BeginPlay()
 
 void AXQPGameStateBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    if (AIAsync)
+    // 取消AI和提示搜索，搜索线程归AI2P所有，不在这里等待
+    if (AI2P)
     {
-        if (AIAsync->IsRunning())
-        {
-            AI2P->StopThinkingImmediately(); // 停止AI工作
-            AIAsync->StopAsyncWork(); // 停止异步任务
-        }
+        AI2P->CancelAnalysis(AIAnalysis);
+        AI2P->CancelAnalysis(HintAnalysis);
     }
+    AIAnalysis = 0;
+    HintAnalysis = 0;
+    PendingAIResult = nullptr;
 
     // 释放掉UObject对象
     if (board2P)
@@ -69,7 +69,7 @@ void AXQPGameStateBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 
     if (MLModule)
         MLModule->RemoveFromRoot();
-    AI2P = nullptr;
+    MLModule = nullptr;
 
     board2PActor.Reset();
 
@@ -79,12 +79,11 @@ void AXQPGameStateBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
 void AXQPGameStateBase::GamePause(UObject* OwnerObject)
 {
     UGameplayStatics::SetGamePaused(this, true);
-    if (AIAsync)
+    // 暂停AI：搜索停在原处，已经算完的走法等恢复后再走
+    bAIPaused = true;
+    if (AI2P)
     {
-        if (AIAsync->IsRunning())
-        {
-            AIAsync->PauseAsyncWork(); // 暂停AI
-        }
+        AI2P->PauseThinking();
     }
     IIF_GameState::GamePause(OwnerObject);
 }
@@ -92,12 +91,17 @@ void AXQPGameStateBase::GamePause(UObject* OwnerObject)
 void AXQPGameStateBase::GameResume(UObject* OwnerObject)
 {
     UGameplayStatics::SetGamePaused(this, false);
-    if (AIAsync)
+    // 恢复AI
+    bAIPaused = false;
+    if (AI2P)
     {
-        if (AIAsync->IsPaused())
-        {
-            AIAsync->ResumeAsyncWork(); // 恢复AI
-        }
+        AI2P->ResumeThinking();
+    }
+    if (PendingAIResult)
+    {
+        TFunction<void()> Result = MoveTemp(PendingAIResult);
+        PendingAIResult = nullptr;
+        Result();
     }
     IIF_GameState::GameResume(OwnerObject);
 }
@@ -154,6 +158,14 @@ void AXQPGameStateBase::Start2PGame(TWeakObjectPtr<AChessBoard2PActor> InBoard2P
     bIsJueSha = false;
     battleTurn = EPlayerTag::P1;
 
+    // 上一局还没交回的搜索结果作废
+    if (AI2P)
+    {
+        AI2P->CancelAnalysis(AIAnalysis);
+        AI2P->CancelAnalysis(HintAnalysis);
+    }
+    PendingAIResult = nullptr;
+
     board2PActor = InBoard2PActor;
     if (board2PActor.IsValid())
     {
@@ -184,6 +196,13 @@ void AXQPGameStateBase::Start2PGame(TWeakObjectPtr<AChessBoard2PActor> InBoard2P
         {
             AI2P = GetGameInstance()->GetSubsystem<UAI2P>();
             AI2P->AddToRoot();
+            AI2P->OnSearchStats.AddWeakLambda(this, [this](const FAI2PSearchStats& Stats)
+            {
+                if (HUD2P.IsValid())
+                {
+                    HUD2P->ShowSearchStats(Stats);
+                }
+            });
         }
 
         if (!MLModule)
@@ -191,11 +210,17 @@ void AXQPGameStateBase::Start2PGame(TWeakObjectPtr<AChessBoard2PActor> InBoard2P
             MLModule = NewObject<UChessMLModule>(this);
             MLModule->AddToRoot();
             MLModule->Initialize();
-            if (!MLModule->IsTrained())
+            MLModule->OnTrainingProgress.AddWeakLambda(this, [this](const FChessTrainingProgress& Progress)
             {
-                MLModule->StartTraining();
-            }
+                if (HUD2P.IsValid())
+                {
+                    HUD2P->ShowTrainingProgress(Progress);
+                }
+            });
         }
+
+        // 对局期间不训练，模型在对局之间由增量训练更新
+        MLModule->SetGameInProgress(true);
     }
     else
     {
@@ -225,6 +250,13 @@ void AXQPGameStateBase::OnFinishMove2P()
     }
     SwitchBattleTurn(); // 轮换执棋
 
+    // 换手后上一手的提示已经没有意义
+    if (AI2P)
+    {
+        AI2P->CancelAnalysis(HintAnalysis);
+    }
+    HintAnalysis = 0;
+
     switch (battleTurn) // 表示当前该谁了
     {
     case EPlayerTag::P1:
@@ -246,64 +278,184 @@ void AXQPGameStateBase::RunAI2P()
 {
     HUD2P->SetAITurn(true);
 
-    AIAsync = UAsyncWorker::CreateAndStartWorker(
-         [this](UAsyncWorker* WorkerInstance)
-         {
-             if (Cast<UXQPGameInstance>(GetGameInstance())->GetGameMode() == EGameMode::Ending)
-             {
-                 AIDifficulty = EAI2PDifficulty::Normal;
-                 AI2P->SetBoard(board2P);
-                 if (AI2P->IsJueSha(EChessColor::BLACKCHESS))
-                 {
-                     bIsJueSha = true;
-                     ULogger::Log(UTF8_TO_TCHAR("绝杀"));
-                     return;
-                 }
-             }
-             // 获取最佳移动方式和要移动的棋子 
-             AIMove2P = AI2P->GetBestMove(board2P, EChessColor::BLACKCHESS, AIDifficulty);
-
-             while (WorkerInstance->IsPaused())
-             {
-                 FPlatformProcess::Sleep(0.1f);
-             }
-         },
-         [this](EAsyncWorkerState State)
-         {
-             if (State != EAsyncWorkerState::Cancelled) // 任务正常执行完成
-             {
-                 if (bIsJueSha)
-                 {
-                     bIsJueSha = false;
-                     int32 EndingGameLevel = USaveGameLibrary::GetEndingGameLevel();
-                     int32 EndingGameLevel_Max = USaveGameLibrary::GetEndingGameLevel_Max();
-                     if (EndingGameLevel != EndingGameLevel_Max ||                      // 并非最大关卡
-                         EndingGameLevel_Max + 1 < UEndingLibrary::GetEndingGameNum())  // 未到达峰值
-                     {
-                         USaveGameLibrary::UpdateEndingGameLevelData(); // 更新残局关卡数据
-                     }
-                     EXEC_ONJUESHA();
-                     return;
-                 }
-
-                 if (AIMove2P.IsValid())
-                 {
-                     // 应用棋子的移动
-                     AIMovedChess = board2P->GetChess(AIMove2P.from.X, AIMove2P.from.Y);
-                     ApplyMove2P(AIMovedChess, AIMove2P);
-                     ULogger::Log(TEXT("AXQPGameStateBase::RunAI2P: AI FINISH"));
-                 }
-                 else
-                 {
-                     ULogger::LogWarning(TEXT("AXQPGameStateBase::RunAI2P: Invalid move."));
-                 }
-             }
-             else
-             {
-                 ULogger::LogWarning(TEXT("AXQPGameStateBase::RunAI2P: AI's work has been cancelled."));
-             }
-         }
-    );
+    // 在游戏线程取得当前量化模型的引用做成走法先验。训练得到的新模型也只在游戏线程换上，本次搜索始终用取得的这一份
+    AI2P->SetMovePolicy(MLModule ? MLModule->CreateMovePolicy() : nullptr);
+
+    if (Cast<UXQPGameInstance>(GetGameInstance())->GetGameMode() == EGameMode::Ending)
+    {
+        AIDifficulty = EAI2PDifficulty::Normal;
+        AI2P->SetBoard(board2P);
+        if (AI2P->IsJueSha(EChessColor::BLACKCHESS))
+        {
+            bIsJueSha = true;
+            ULogger::Log(UTF8_TO_TCHAR("绝杀"));
+        }
+    }
+
+    // 搜索期间训练停在检查点上。模块单独弱引用，游戏状态先于回调销毁时计数也能配平
+    TWeakObjectPtr<UChessMLModule> WeakML(MLModule);
+    if (MLModule)
+    {
+        MLModule->BeginSearch();
+    }
+
+    // 局面在这里做成快照，搜索在AI2P常驻的搜索线程上进行，结果在游戏线程交回
+    const FAI2PDifficultyProfile Profile = UAI2P::GetDifficultyProfile(AIDifficulty);
+    TWeakObjectPtr<AXQPGameStateBase> WeakThis(this);
+    AIAnalysis = AI2P->AnalyzePositionAsync(board2P, EChessColor::BLACKCHESS, Profile.Depth, Profile.MultiPV,
+        [WeakThis, WeakML, Profile](const FAI2PAnalysis& Analysis, bool bCancelled)
+        {
+            if (WeakML.IsValid())
+            {
+                WeakML->EndSearch();
+            }
+            if (!WeakThis.IsValid())
+            {
+                return;
+            }
+            AXQPGameStateBase* Self = WeakThis.Get();
+
+            if (bCancelled)
+            {
+                ULogger::LogWarning(TEXT("AXQPGameStateBase::RunAI2P: AI's work has been cancelled."));
+                return;
+            }
+
+            // 获取最佳移动方式和要移动的棋子
+            Self->AIMove2P = UAI2P::SelectMoveByTemperature(Analysis, Profile.Temperature, Profile.MaxScoreLoss);
+
+            // 游戏暂停时等到恢复再落子
+            if (Self->bAIPaused)
+            {
+                Self->PendingAIResult = [WeakThis, Analysis]()
+                {
+                    if (WeakThis.IsValid())
+                    {
+                        WeakThis->OnAI2PAnalysisReady(Analysis);
+                    }
+                };
+                return;
+            }
+            Self->OnAI2PAnalysisReady(Analysis);
+        });
+}
+
+void AXQPGameStateBase::OnAI2PAnalysisReady(const FAI2PAnalysis& Analysis)
+{
+    if (bIsJueSha)
+    {
+        bIsJueSha = false;
+        int32 EndingGameLevel = USaveGameLibrary::GetEndingGameLevel();
+        int32 EndingGameLevel_Max = USaveGameLibrary::GetEndingGameLevel_Max();
+        if (EndingGameLevel != EndingGameLevel_Max ||                      // 并非最大关卡
+            EndingGameLevel_Max + 1 < UEndingLibrary::GetEndingGameNum())  // 未到达峰值
+        {
+            USaveGameLibrary::UpdateEndingGameLevelData(); // 更新残局关卡数据
+        }
+        EXEC_ONJUESHA();
+        return;
+    }
+
+    if (AIMove2P.IsValid())
+    {
+        // 走子前记录训练样本：搜索得到的最佳走法，局面直接压缩写入训练日志
+        if (MLModule && Analysis.IsValid())
+        {
+            FXQPosition Position;
+            UAI2P::BuildPosition(board2P, EChessColor::BLACKCHESS, Position);
+            const FAI2PLine& Best = Analysis.Lines[0];
+            MLModule->SaveTrainingData(Position, UAI2P::ToEngineMove(Best.Move), static_cast<float>(Best.Score), Best.Depth);
+        }
+
+        // 应用棋子的移动
+        AIMovedChess = board2P->GetChess(AIMove2P.from.X, AIMove2P.from.Y);
+        ApplyMove2P(AIMovedChess, AIMove2P);
+        ULogger::Log(FString::Printf(TEXT("AXQPGameStateBase::RunAI2P: AI FINISH depth %d/%d nodes %lld nps %lld time %lldms"),
+            Analysis.Stats.Depth, Analysis.Stats.SelDepth, Analysis.Stats.Nodes, Analysis.Stats.Nps, Analysis.Stats.TimeMs));
+    }
+    else
+    {
+        ULogger::LogWarning(TEXT("AXQPGameStateBase::RunAI2P: Invalid move."));
+    }
+}
+
+void AXQPGameStateBase::RequestHint2P()
+{
+    if (bGameOver || !IsMyTurn() || !AI2P || !board2P)
+    {
+        return;
+    }
+
+    if (AI2P->IsAnalyzing(HintAnalysis))
+    {
+        return; // 上一次提示还在计算
+    }
+
+    // AI上一步所走变例中预期的应着就是玩家的最佳走法
+    FChessMove2P ExpectedReply;
+    if (AI2P->GetExpectedReply(AIMove2P, ExpectedReply) && ShowHint2P(ExpectedReply))
+    {
+        return;
+    }
+
+    // 没有可复用的变例（如开局第一步），在后台做一次浅层分析
+    TWeakObjectPtr<UChessMLModule> WeakML(MLModule);
+    if (MLModule)
+    {
+        MLModule->BeginSearch();
+    }
+    const FAI2PDifficultyProfile Profile = UAI2P::GetDifficultyProfile(EAI2PDifficulty::Normal);
+    TWeakObjectPtr<AXQPGameStateBase> WeakThis(this);
+    HintAnalysis = AI2P->AnalyzePositionAsync(board2P, EChessColor::REDCHESS, Profile.Depth, 1,
+        [WeakThis, WeakML](const FAI2PAnalysis& Analysis, bool bCancelled)
+        {
+            if (WeakML.IsValid())
+            {
+                WeakML->EndSearch();
+            }
+            if (!WeakThis.IsValid())
+            {
+                return;
+            }
+            AXQPGameStateBase* Self = WeakThis.Get();
+
+            Self->HintMove2P = UAI2P::SelectMoveByTemperature(Analysis, 0.0f, 0);
+            if (!bCancelled && Self->HintMove2P.IsValid() && Self->IsMyTurn())
+            {
+                Self->ShowHint2P(Self->HintMove2P);
+            }
+        });
+}
+
+bool AXQPGameStateBase::ShowHint2P(FChessMove2P Move)
+{
+    TWeakObjectPtr<AChesses> Chess = board2P->GetChess(Move.from.X, Move.from.Y);
+    if (!Chess.IsValid() || Chess->GetColor() != EChessColor::REDCHESS)
+    {
+        return false;
+    }
+
+    // 确认提示走法在当前局面下仍然可走
+    bool bCanMove = false;
+    for (const FChessMove2P& Candidate : board2P->GenerateMovesForChess(Move.from.X, Move.from.Y, Chess))
+    {
+        if (Candidate.to == Move.to)
+        {
+            bCanMove = true;
+            break;
+        }
+    }
+
+    if (!bCanMove)
+    {
+        return false;
+    }
+
+    if (HUD2P.IsValid())
+    {
+        HUD2P->ShowHint(Chess, Move);
+    }
+    return true;
 }
 
 bool AXQPGameStateBase::IsMyTurn() const
@@ -333,5 +485,11 @@ void AXQPGameStateBase::NotifyGameOver(EChessColor winner)
     bGameOver = true;
     HUD2P->ShowGameOver(winner);
 
+    // 对局结束，后台增量训练可以开始
+    if (MLModule)
+    {
+        MLModule->SetGameInProgress(false);
+    }
+
     EXEC_GAMEOVER(); // 调用游戏介绍事件
 }
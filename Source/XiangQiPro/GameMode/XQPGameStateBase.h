@@ -11,12 +11,13 @@
 
 class UAI2P;
 class UChessMLModule;
-class UAsyncWorker;
 class UChessBoard2P;
 class UUI_Battle2P_Base;
 class AChessBoard2PActor;
 class AChesses;
 
+struct FAI2PAnalysis;
+
 enum class EChessColor : uint8;
 enum class EAI2PDifficulty : uint8;
 
@@ -71,14 +72,32 @@ private:
 
 	bool bIsJueSha = false;
 
-	// AI첽
-	UAsyncWorker* AIAsync;
+	// AIıţ0ʾû
+	uint64 AIAnalysis = 0;
+
+	// ʾıţûпɸõıʱŻ
+	uint64 HintAnalysis = 0;
+
+	// ϷͣУAI߷Ȳ
+	bool bAIPaused = false;
+
+	// ͣڼɵAIָʱӦ
+	TFunction<void()> PendingAIResult;
+
+	// ʾõ߷
+	FChessMove2P HintMove2P;
 
 private:
 
 	// µ÷
 	void UpdateScore();
 
+	// ʾ߷ǷԿߣʾ
+	bool ShowHint2P(FChessMove2P Move);
+
+	// AIɣϷ̣߳ɱ߳ѡе߷
+	void OnAI2PAnalysisReady(const FAI2PAnalysis& Analysis);
+
 	// AI2Põƶ
 	FChessMove2P AIMove2P;
 
@@ -153,6 +172,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "AI")
 	void RunAI2P();
 
+	// ΪʾȸAIһҪ
+	UFUNCTION(BlueprintCallable, Category = "AI")
+	void RequestHint2P();
+
 	// жǷҵĻغ
 	bool IsMyTurn() const;
 
@@ -40,6 +40,73 @@ void UUI_Battle2P_Base::SetAITurn(bool bAITurn)
 		Image_RoundMark_P1->SetVisibility(ESlateVisibility::Visible); // 更新回合标记
 		Image_RoundMark_P2->SetVisibility(ESlateVisibility::Collapsed);
 	}
+
+	if (Text_Hint)
+	{
+		Text_Hint->SetVisibility(ESlateVisibility::Collapsed); // 回合变化后提示失效
+	}
+}
+
+void UUI_Battle2P_Base::RequestHint()
+{
+	if (GameState)
+	{
+		GameState->RequestHint2P();
+	}
+}
+
+void UUI_Battle2P_Base::ShowHint(TWeakObjectPtr<AChesses> targetChess, FChessMove2P move)
+{
+	FString Notation = GetEnhancedMoveNotation(targetChess, move);
+	if (Text_Hint)
+	{
+		Text_Hint->SetText(FText::FromString(Notation));
+		Text_Hint->SetVisibility(ESlateVisibility::Visible);
+	}
+	OnHintShown(Notation);
+}
+
+void UUI_Battle2P_Base::ShowTrainingProgress(const FChessTrainingProgress& Progress)
+{
+	if (Text_TrainingProgress)
+	{
+		FString Text;
+		switch (Progress.Phase)
+		{
+		case EChessTrainingPhase::Preparing:
+			Text = UTF8_TO_TCHAR("模型训练：准备数据");
+			break;
+		case EChessTrainingPhase::NeuralNetwork:
+			Text = FString::Printf(UTF8_TO_TCHAR("模型训练：第%d/%d轮 %d%% 损失%.3f"),
+				FMath::Min(Progress.Epoch + 1, Progress.NumEpochs), Progress.NumEpochs, FMath::RoundToInt(Progress.Progress * 100.0f), Progress.Loss);
+			break;
+		case EChessTrainingPhase::DecisionTree:
+			Text = UTF8_TO_TCHAR("模型训练：训练决策树");
+			break;
+		case EChessTrainingPhase::Finished:
+			Text = FString::Printf(UTF8_TO_TCHAR("模型训练完成 损失%.3f"), Progress.Loss);
+			break;
+		case EChessTrainingPhase::Cancelled:
+			Text = UTF8_TO_TCHAR("模型训练已取消");
+			break;
+		}
+		Text_TrainingProgress->SetText(FText::FromString(Text));
+		Text_TrainingProgress->SetVisibility(ESlateVisibility::Visible);
+	}
+	OnTrainingProgress(Progress);
+}
+
+void UUI_Battle2P_Base::ShowSearchStats(const FAI2PSearchStats& Stats)
+{
+	if (Text_SearchStats)
+	{
+		const FString Text = FString::Printf(UTF8_TO_TCHAR("深度%d/%d 节点%lld 速度%lldk/s 用时%lldms\n首步截断%d%% 减深成功%d%% 先验命中%d%%"),
+			Stats.Depth, Stats.SelDepth, Stats.Nodes, Stats.Nps / 1000, Stats.TimeMs,
+			FMath::RoundToInt(Stats.FirstMoveCutoffRate * 100.0f), FMath::RoundToInt(Stats.ReductionSuccessRate * 100.0f),
+			FMath::RoundToInt(Stats.PolicyHitRate * 100.0f));
+		Text_SearchStats->SetText(FText::FromString(Text));
+	}
+	OnSearchStats(Stats);
 }
 
 void UUI_Battle2P_Base::ExecGamePlayAgain()
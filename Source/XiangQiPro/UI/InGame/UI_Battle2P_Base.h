@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include "XiangQiPro/AI/AI2P.h"
+#include "XiangQiPro/AI/ChessMLModule.h"
 #include "XiangQiPro/Util/ChessInfo.h"
 #include "XiangQiPro/Util/ChessMove.h"
 
@@ -56,6 +58,18 @@ public:
 	UPROPERTY(EditAnywhere, meta = (BindWidget))
 	UTextBlock* Text_OperatingRecord;
 
+	// 提示走法
+	UPROPERTY(EditAnywhere, meta = (BindWidgetOptional))
+	UTextBlock* Text_Hint;
+
+	// 模型训练进度
+	UPROPERTY(EditAnywhere, meta = (BindWidgetOptional))
+	UTextBlock* Text_TrainingProgress;
+
+	// AI搜索统计
+	UPROPERTY(EditAnywhere, meta = (BindWidgetOptional))
+	UTextBlock* Text_SearchStats;
+
 	// 玩家1的回合标记
 	UPROPERTY(EditAnywhere, meta = (BindWidget))
 	UImage* Image_RoundMark_P1;
@@ -81,7 +95,32 @@ public:
 
 	UFUNCTION(BlueprintCallable)
 	void ExecGamePlayAgain();
+
+	// 提示按钮：向游戏状态请求提示走法
+	UFUNCTION(BlueprintCallable)
+	void RequestHint();
+
+	// 显示提示走法
+	void ShowHint(TWeakObjectPtr<AChesses> targetChess, FChessMove2P move);
+
+	// 提示走法已显示
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnHintShown(const FString& Notation);
 	
+	// 显示模型训练进度
+	void ShowTrainingProgress(const FChessTrainingProgress& Progress);
+
+	// 训练进度已更新
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnTrainingProgress(const FChessTrainingProgress& Progress);
+
+	// 显示AI搜索统计
+	void ShowSearchStats(const FAI2PSearchStats& Stats);
+
+	// 搜索统计已更新
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnSearchStats(const FAI2PSearchStats& Stats);
+
 	// 增加落子历史记录
 	void AddOperatingRecord(EPlayerTag player, TWeakObjectPtr<AChesses> targetChess, FChessMove2P move);
 
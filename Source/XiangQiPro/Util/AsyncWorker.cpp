@@ -120,8 +120,8 @@ void UAsyncWorker::StopAsyncWork()
     // 设置停止标志
     bShouldStop = true;
 
-    // 如果处于暂停状态，需要触发事件让线程继续以便检测停止
-    if (CurrentState == EAsyncWorkerState::Paused && PauseEvent)
+    // 触发事件让等待恢复的线程醒来检测停止（WaitForResume不再超时轮询）
+    if (PauseEvent)
     {
         PauseEvent->Trigger();
     }
@@ -260,10 +260,10 @@ void UAsyncWorker::WaitForResume()
 {
     if (PauseEvent)
     {
-        // 等待恢复事件，超时时间设为100毫秒以便定期检查停止标志
+        // 恢复和停止都会触发事件，不需要超时轮询
         while (bShouldPause && !bShouldStop)
         {
-            PauseEvent->Wait(100); // 等待100毫秒
+            PauseEvent->Wait();
         }
     }
 }
@@ -17,7 +17,8 @@ public class XiangQiPro : ModuleRules
             "Niagara",
             "MoviePlayer",
             "Json",           //  JSON ֧
-            "JsonUtilities"   //  JSON ֧
+            "JsonUtilities",  //  JSON ֧
+            "XiangQiEngine"   // 
              });
 
 
@@ -0,0 +1,99 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMatch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+static void PrintXQMatchUsage()
+{
+    std::cout <<
+        "usage: xqmatch -engine <config> -engine <config> [options]\n"
+        "  engine config: name=<name>,nodes=<n>,depth=<n>,movetime=<ms>,eval=<params file from xqtune>\n"
+        "  -games <n>            maximum number of games (default 1000)\n"
+        "  -concurrency <n>      games played at the same time (default: number of cores)\n"
+        "  -openings <file>      one opening per line: ICCS moves or 'fen <FEN> [moves ...]'\n"
+        "  -sprt <elo0> <elo1> [alpha] [beta]   stop early when a hypothesis is accepted\n"
+        "  -maxplies <n>         adjudicate a draw after n plies (default 400)\n"
+        "  -resign <score> <moves>   adjudicate a win when both engines agree (default 800 4)\n"
+        "  -log <file>           write one line per finished game\n";
+}
+
+int main(int Argc, char** Argv)
+{
+    FXQMatchSettings Settings;
+    Settings.Concurrency = std::max(1, static_cast<int32>(std::thread::hardware_concurrency()));
+
+    int32 NumEngines = 0;
+    for (int32 i = 1; i < Argc; i++)
+    {
+        const std::string Arg = Argv[i];
+        const bool bHasValue = i + 1 < Argc;
+        if (Arg == "-engine" && bHasValue)
+        {
+            if (NumEngines >= 2)
+            {
+                std::cerr << "exactly two engines are required" << std::endl;
+                return 1;
+            }
+
+            FXQEngineConfig& Config = Settings.Engines[NumEngines];
+            Config.Name = "engine" + std::to_string(NumEngines + 1);
+            std::string Error;
+            if (!Config.Parse(Argv[++i], Error))
+            {
+                std::cerr << Error << std::endl;
+                return 1;
+            }
+            NumEngines++;
+        }
+        else if (Arg == "-games" && bHasValue) Settings.Games = std::atoi(Argv[++i]);
+        else if (Arg == "-concurrency" && bHasValue) Settings.Concurrency = std::max(1, std::atoi(Argv[++i]));
+        else if (Arg == "-openings" && bHasValue) Settings.OpeningsFile = Argv[++i];
+        else if (Arg == "-maxplies" && bHasValue) Settings.Rules.MaxPlies = std::atoi(Argv[++i]);
+        else if (Arg == "-log" && bHasValue) Settings.LogFile = Argv[++i];
+        else if (Arg == "-resign" && i + 2 < Argc)
+        {
+            Settings.ResignScore = std::atoi(Argv[++i]);
+            Settings.ResignMoves = std::atoi(Argv[++i]);
+        }
+        else if (Arg == "-sprt" && i + 2 < Argc)
+        {
+            Settings.Sprt.bEnabled = true;
+            Settings.Sprt.Elo0 = std::atof(Argv[++i]);
+            Settings.Sprt.Elo1 = std::atof(Argv[++i]);
+            // 可选的alpha、beta
+            if (i + 1 < Argc && Argv[i + 1][0] != '-')
+            {
+                Settings.Sprt.Alpha = std::atof(Argv[++i]);
+            }
+            if (i + 1 < Argc && Argv[i + 1][0] != '-')
+            {
+                Settings.Sprt.Beta = std::atof(Argv[++i]);
+            }
+        }
+        else
+        {
+            PrintXQMatchUsage();
+            return Arg == "-help" || Arg == "-h" ? 0 : 1;
+        }
+    }
+
+    if (NumEngines != 2)
+    {
+        PrintXQMatchUsage();
+        return 1;
+    }
+    if (Settings.Sprt.bEnabled && (Settings.Sprt.Elo1 <= Settings.Sprt.Elo0 || Settings.Sprt.Alpha <= 0.0 || Settings.Sprt.Beta <= 0.0))
+    {
+        std::cerr << "invalid SPRT parameters" << std::endl;
+        return 1;
+    }
+
+    FXQMatchRunner Runner(Settings);
+    return Runner.Run();
+}
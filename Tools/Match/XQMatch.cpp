@@ -0,0 +1,380 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMatch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+// 内置开局：常见的均衡布局，每个都会交换先后手各下一局
+static const char* const XQDefaultOpenings[] = {
+    "h2e2 h9g7 h0g2 i9h9",          // 中炮对屏风马
+    "h2e2 h9g7 h0g2 i9h9 i0h0 b9c7", // 中炮对屏风马，两头蛇之前
+    "h2e2 b9c7 h0g2 h7f7",          // 中炮对反宫马
+    "h2e2 h7e7",                    // 顺炮
+    "h2e2 b7e7",                    // 列炮
+    "h2e2 b9c7",                    // 中炮对单提马
+    "h2e2 c6c5",                    // 中炮对进卒
+    "c3c4 g6g5",                    // 仙人指路对对兵
+    "c3c4 h7c7",                    // 仙人指路对卒底炮
+    "c3c4 b9c7",                    // 仙人指路对进马
+    "c0e2 h7e7",                    // 飞相对中炮
+    "c0e2 b7f7",                    // 飞相对过宫炮
+    "c0e2 c6c5",                    // 飞相对进卒
+    "h0g2 h9g7",                    // 起马对起马
+    "h0g2 c6c5",                    // 起马对挺卒
+    "h2d2 h9g7",                    // 过宫炮
+    "b2d2 b9c7",                    // 士角炮
+    "h2c2 h9g7",                    // 金钩炮
+    "g3g4 c6c5",                    // 仙人指路（右）
+    "b0c2 h9g7 h0g2 b9c7",          // 两头蛇对双马
+};
+
+static std::string TrimXQText(const std::string& Text)
+{
+    const size_t Begin = Text.find_first_not_of(" \t\r\n");
+    if (Begin == std::string::npos)
+    {
+        return std::string();
+    }
+    const size_t End = Text.find_last_not_of(" \t\r\n");
+    return Text.substr(Begin, End - Begin + 1);
+}
+
+static bool ParseXQOpeningLine(const std::string& Line, FXQOpening& OutOpening)
+{
+    OutOpening = FXQOpening();
+    OutOpening.Text = Line;
+
+    std::istringstream Stream(Line);
+    std::string Token;
+    std::vector<std::string> Tokens;
+    while (Stream >> Token)
+    {
+        Tokens.push_back(Token);
+    }
+
+    size_t Index = 0;
+    if (!Tokens.empty() && Tokens[0] == "fen")
+    {
+        std::string Fen;
+        for (Index = 1; Index < Tokens.size() && Tokens[Index] != "moves"; Index++)
+        {
+            Fen += Fen.empty() ? Tokens[Index] : " " + Tokens[Index];
+        }
+        if (!OutOpening.Start.SetFromFen(Fen.c_str(), static_cast<int32>(Fen.size())))
+        {
+            return false;
+        }
+        if (Index < Tokens.size())
+        {
+            Index++; // 跳过moves
+        }
+    }
+
+    for (; Index < Tokens.size(); Index++)
+    {
+        FXQMove Move;
+        if (!XQParseMove(Tokens[Index], Move))
+        {
+            return false;
+        }
+        OutOpening.Moves.push_back(Move);
+    }
+
+    FXQPosition Position;
+    return OutOpening.BuildPosition(Position);
+}
+
+bool FXQEngineConfig::Parse(const std::string& Text, std::string& OutError)
+{
+    std::istringstream Stream(Text);
+    std::string Item;
+    while (std::getline(Stream, Item, ','))
+    {
+        const size_t Equal = Item.find('=');
+        if (Equal == std::string::npos)
+        {
+            OutError = "expected key=value: " + Item;
+            return false;
+        }
+
+        const std::string Key = TrimXQText(Item.substr(0, Equal));
+        const std::string Value = TrimXQText(Item.substr(Equal + 1));
+        if (Key == "name") Name = Value;
+        else if (Key == "depth") Limits.Depth = std::atoi(Value.c_str());
+        else if (Key == "nodes") Limits.Nodes = std::atoll(Value.c_str());
+        else if (Key == "movetime") Limits.MoveTimeMs = std::atoi(Value.c_str());
+        else if (Key == "eval")
+        {
+            if (!EvalParams.LoadFromFile(Value))
+            {
+                OutError = "cannot load eval params: " + Value;
+                return false;
+            }
+        }
+        else
+        {
+            OutError = "unknown engine option: " + Key;
+            return false;
+        }
+    }
+
+    if (Limits.Nodes <= 0 && Limits.MoveTimeMs <= 0 && Limits.Depth >= XQ_MAX_PLY - 1)
+    {
+        OutError = "engine '" + Name + "' needs depth, nodes or movetime";
+        return false;
+    }
+    return true;
+}
+
+bool FXQOpening::BuildPosition(FXQPosition& OutPosition) const
+{
+    if (!Start.Unpack(OutPosition))
+    {
+        return false;
+    }
+    for (FXQMove Move : Moves)
+    {
+        if (!OutPosition.IsLegalMove(Move))
+        {
+            return false;
+        }
+        OutPosition.MakeMove(Move);
+    }
+    return true;
+}
+
+FXQMatchRunner::FXQMatchRunner(const FXQMatchSettings& InSettings)
+    : Settings(InSettings)
+    , NextPair(0)
+    , bStopRequested(false)
+{
+}
+
+std::vector<FXQOpening> FXQMatchRunner::GetDefaultOpenings()
+{
+    std::vector<FXQOpening> Result;
+    for (const char* Line : XQDefaultOpenings)
+    {
+        FXQOpening Opening;
+        if (ParseXQOpeningLine(Line, Opening))
+        {
+            Result.push_back(Opening);
+        }
+    }
+    return Result;
+}
+
+bool FXQMatchRunner::LoadOpenings(const std::string& Path, std::vector<FXQOpening>& OutOpenings, std::string& OutError)
+{
+    std::ifstream File(Path);
+    if (!File)
+    {
+        OutError = "cannot open " + Path;
+        return false;
+    }
+
+    OutOpenings.clear();
+    std::string Line;
+    int32 LineNumber = 0;
+    while (std::getline(File, Line))
+    {
+        LineNumber++;
+        Line = TrimXQText(Line);
+        if (Line.empty() || Line[0] == '#')
+        {
+            continue;
+        }
+
+        FXQOpening Opening;
+        if (!ParseXQOpeningLine(Line, Opening))
+        {
+            OutError = Path + ":" + std::to_string(LineNumber) + ": invalid opening";
+            return false;
+        }
+        OutOpenings.push_back(Opening);
+    }
+
+    if (OutOpenings.empty())
+    {
+        OutError = Path + ": no openings";
+        return false;
+    }
+    return true;
+}
+
+int32 FXQMatchRunner::Run()
+{
+    if (Settings.OpeningsFile.empty())
+    {
+        Openings = GetDefaultOpenings();
+    }
+    else
+    {
+        std::string Error;
+        if (!LoadOpenings(Settings.OpeningsFile, Openings, Error))
+        {
+            std::cerr << Error << std::endl;
+            return 1;
+        }
+    }
+
+    if (!Settings.LogFile.empty())
+    {
+        Log.open(Settings.LogFile, std::ios::out | std::ios::trunc);
+        if (!Log)
+        {
+            std::cerr << "cannot open " << Settings.LogFile << std::endl;
+            return 1;
+        }
+    }
+
+    const int32 Concurrency = std::max(1, Settings.Concurrency);
+    std::cout << Settings.Engines[0].Name << " vs " << Settings.Engines[1].Name << ": up to " << Settings.Games << " games, "
+        << Concurrency << " concurrent, " << Openings.size() << " openings" << std::endl;
+
+    std::vector<std::thread> Workers;
+    for (int32 i = 0; i < Concurrency; i++)
+    {
+        Workers.emplace_back(&FXQMatchRunner::WorkerMain, this);
+    }
+    for (std::thread& Worker : Workers)
+    {
+        Worker.join();
+    }
+
+    std::lock_guard<std::mutex> Lock(ReportMutex);
+    std::cout << "Finished: " << Stats.ToString(Settings.Sprt) << std::endl;
+    switch (Stats.GetSprtState(Settings.Sprt))
+    {
+    case EXQSprtState::AcceptH1: std::cout << "SPRT: H1 accepted (" << Settings.Engines[0].Name << " is stronger)" << std::endl; break;
+    case EXQSprtState::AcceptH0: std::cout << "SPRT: H0 accepted" << std::endl; break;
+    default: if (Settings.Sprt.bEnabled) std::cout << "SPRT: inconclusive" << std::endl; break;
+    }
+    return 0;
+}
+
+void FXQMatchRunner::WorkerMain()
+{
+    // 每个线程各自持有两个搜索实例，互不干扰
+    FXQSearch Searches[2];
+    for (int32 i = 0; i < 2; i++)
+    {
+        Searches[i].SetEvalParams(Settings.Engines[i].EvalParams);
+    }
+    const int32 NumPairs = std::max(1, Settings.Games / 2);
+    while (!bStopRequested)
+    {
+        const int32 PairIndex = NextPair++;
+        if (PairIndex >= NumPairs)
+        {
+            break;
+        }
+
+        const FXQOpening& Opening = Openings[PairIndex % Openings.size()];
+        FXQGameRecord Records[2];
+        for (int32 Game = 0; Game < 2; Game++)
+        {
+            // 第一局引擎A执红，第二局交换
+            Records[Game] = PlayGame(Opening, Game, Searches);
+        }
+        ReportPair(PairIndex, Records);
+    }
+}
+
+FXQGameRecord FXQMatchRunner::PlayGame(const FXQOpening& Opening, int32 EngineRed, FXQSearch* Searches) const
+{
+    FXQGameRecord Record;
+    FXQPosition Position;
+    Opening.BuildPosition(Position);
+
+    FXQReferee Referee(Settings.Rules);
+    Referee.Reset(Position);
+    EXQGameResult GameResult = Referee.Adjudicate(Position);
+
+    int32 WinningStreak = 0;
+    int32 DrawStreak = 0;
+    int32 LastWinningSign = 0;
+    for (int32 Ply = 0; GameResult == EXQGameResult::Ongoing; Ply++)
+    {
+        const EXQColor Us = Position.GetSideToMove();
+        const int32 Engine = Us == EXQColor::Red ? EngineRed : 1 - EngineRed;
+        const FXQSearchResult Result = Searches[Engine].Search(Position, Settings.Engines[Engine].Limits);
+        const FXQMove Move = Result.GetBestMove();
+        if (Move.IsNull())
+        {
+            Record.RedScore = Us == EXQColor::Red ? 0.0 : 1.0;
+            Record.Reason = "no move";
+            return Record;
+        }
+
+        // 评分裁决：双方连续若干步都认同同一方大优时直接判胜负，都认为均势时判和
+        const int32 Score = Result.Lines[0].Score;
+        const int32 RedScore = Us == EXQColor::Red ? Score : -Score;
+        const int32 Sign = RedScore >= Settings.ResignScore ? 1 : (RedScore <= -Settings.ResignScore ? -1 : 0);
+        WinningStreak = Sign != 0 && Sign == LastWinningSign ? WinningStreak + 1 : (Sign != 0 ? 1 : 0);
+        LastWinningSign = Sign;
+        DrawStreak = Ply >= Settings.DrawMinPly && std::abs(RedScore) <= Settings.DrawScore ? DrawStreak + 1 : 0;
+
+        Position.MakeMove(Move);
+        Record.Moves.push_back(Move);
+
+        if (WinningStreak >= Settings.ResignMoves * 2)
+        {
+            Record.RedScore = Sign > 0 ? 1.0 : 0.0;
+            Record.Reason = "score adjudication";
+            return Record;
+        }
+        if (DrawStreak >= Settings.DrawMoves * 2)
+        {
+            Record.Reason = "draw adjudication";
+            return Record;
+        }
+        GameResult = Referee.OnMove(Position);
+    }
+
+    Record.RedScore = FXQReferee::GetRedScore(GameResult);
+    Record.Reason = Referee.GetReason();
+    return Record;
+}
+
+void FXQMatchRunner::ReportPair(int32 PairIndex, const FXQGameRecord* Records)
+{
+    std::lock_guard<std::mutex> Lock(ReportMutex);
+
+    // 第一局引擎A执红，第二局执黑
+    const double ScoreA1 = Records[0].RedScore;
+    const double ScoreA2 = 1.0 - Records[1].RedScore;
+    Stats.AddPair(ScoreA1, ScoreA2);
+
+    const FXQOpening& Opening = Openings[PairIndex % Openings.size()];
+    WriteLog(PairIndex * 2, 0, Opening, Records[0]);
+    WriteLog(PairIndex * 2 + 1, 1, Opening, Records[1]);
+
+    std::cout << Stats.ToString(Settings.Sprt) << std::endl;
+    if (Stats.GetSprtState(Settings.Sprt) != EXQSprtState::Continue)
+    {
+        bStopRequested = true;
+    }
+}
+
+void FXQMatchRunner::WriteLog(int32 GameIndex, int32 EngineRed, const FXQOpening& Opening, const FXQGameRecord& Record)
+{
+    if (!Log.is_open())
+    {
+        return;
+    }
+
+    const char* Result = Record.RedScore > 0.75 ? "1-0" : (Record.RedScore < 0.25 ? "0-1" : "1/2-1/2");
+    Log << GameIndex + 1 << '\t' << Settings.Engines[EngineRed].Name << '\t' << Settings.Engines[1 - EngineRed].Name << '\t'
+        << Result << '\t' << Record.Reason << '\t' << Opening.Text << '\t';
+    for (size_t i = 0; i < Record.Moves.size(); i++)
+    {
+        Log << (i > 0 ? " " : "") << XQMoveToString(Record.Moves[i]);
+    }
+    Log << '\n';
+    Log.flush();
+}
@@ -0,0 +1,125 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQMatchStats.h"
+#include "XQPackedPosition.h"
+#include "XQPosition.h"
+#include "XQReferee.h"
+#include "XQSearch.h"
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 参赛引擎配置，命令行格式：name=base,nodes=20000,depth=10,movetime=100,eval=params.txt
+struct FXQEngineConfig
+{
+    std::string Name;
+
+    FXQSearchLimits Limits;
+
+    FXQEvalParams EvalParams = FXQEvalParams::GetDefault();
+
+    // 解析配置字符串，格式错误时返回false
+    bool Parse(const std::string& Text, std::string& OutError);
+};
+
+// 开局：起始局面及其后的若干步
+struct FXQOpening
+{
+    FXQOpening() { Start.SetFromFen(XQ_START_FEN); }
+
+    FXQPackedPosition Start;    // 起始局面，读取开局库时解析一次
+
+
+    std::vector<FXQMove> Moves;
+
+    std::string Text; // 原始描述，写入对局记录
+
+    // 生成开局后的局面，走法不合法时返回false
+    bool BuildPosition(FXQPosition& OutPosition) const;
+};
+
+struct FXQMatchSettings
+{
+    FXQEngineConfig Engines[2];
+
+    int32 Games = 1000;             // 最大对局数（按对取整）
+
+    int32 Concurrency = 1;          // 同时进行的对局数
+
+    FXQRefereeSettings Rules;       // 最大步数、自然限着
+
+    int32 ResignScore = 800;        // 双方评分都超过该值并持续ResignMoves步时判胜负
+
+    int32 ResignMoves = 4;
+
+    int32 DrawScore = 10;           // 第DrawMinPly步之后双方评分都在该值以内并持续DrawMoves步时判和
+
+    int32 DrawMoves = 8;
+
+    int32 DrawMinPly = 80;
+
+    FXQSprtParams Sprt;
+
+    std::string OpeningsFile;       // 为空时使用内置开局
+
+    std::string LogFile;            // 每局一行的对局记录
+};
+
+// 单局结果，RedScore为红方得分（胜1、和0.5、负0）
+struct FXQGameRecord
+{
+    double RedScore = 0.5;
+
+    std::string Reason;
+
+    std::vector<FXQMove> Moves;
+};
+
+/**
+ * 两个引擎配置之间的对局：每个开局交换先后手各下一局，
+ * 按并发数开多个线程同时对局，每对结束后更新统计，满足SPRT条件时提前结束
+ */
+class FXQMatchRunner
+{
+public:
+    explicit FXQMatchRunner(const FXQMatchSettings& InSettings);
+
+    // 运行全部对局，返回0表示正常结束
+    int32 Run();
+
+    // 内置的均衡开局
+    static std::vector<FXQOpening> GetDefaultOpenings();
+
+    // 读取开局文件：每行为一串ICCS走法，或"fen <FEN> [moves ...]"，#开头为注释
+    static bool LoadOpenings(const std::string& Path, std::vector<FXQOpening>& OutOpenings, std::string& OutError);
+
+private:
+    void WorkerMain();
+
+    // 下一局，EngineRed/EngineBlack为引擎序号
+    FXQGameRecord PlayGame(const FXQOpening& Opening, int32 EngineRed, FXQSearch* Searches) const;
+
+    void ReportPair(int32 PairIndex, const FXQGameRecord* Records);
+
+    void WriteLog(int32 GameIndex, int32 EngineRed, const FXQOpening& Opening, const FXQGameRecord& Record);
+
+private:
+    FXQMatchSettings Settings;
+
+    std::vector<FXQOpening> Openings;
+
+    std::atomic<int32> NextPair;
+
+    std::atomic<bool> bStopRequested;
+
+    std::mutex ReportMutex;
+
+    FXQMatchStats Stats;
+
+    std::ofstream Log;
+};
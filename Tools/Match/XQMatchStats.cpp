@@ -0,0 +1,138 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQMatchStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+double FXQSprtParams::GetLowerBound() const
+{
+    return std::log(Beta / (1.0 - Alpha));
+}
+
+double FXQSprtParams::GetUpperBound() const
+{
+    return std::log((1.0 - Beta) / Alpha);
+}
+
+void FXQMatchStats::AddPair(double ScoreA1, double ScoreA2)
+{
+    const double Scores[2] = { ScoreA1, ScoreA2 };
+    for (double Score : Scores)
+    {
+        if (Score > 0.75) Wins++;
+        else if (Score < 0.25) Losses++;
+        else Draws++;
+    }
+
+    const int32 Bin = std::max(0, std::min(4, static_cast<int32>(std::lround((ScoreA1 + ScoreA2) * 2.0))));
+    PairCounts[Bin]++;
+    Pairs++;
+}
+
+double FXQMatchStats::GetScore() const
+{
+    if (Pairs == 0)
+    {
+        return 0.5;
+    }
+
+    double Sum = 0.0;
+    for (int32 Bin = 0; Bin < 5; Bin++)
+    {
+        Sum += PairCounts[Bin] * (Bin * 0.25);
+    }
+    return Sum / Pairs;
+}
+
+double FXQMatchStats::GetPairVariance() const
+{
+    if (Pairs == 0)
+    {
+        return 0.0;
+    }
+
+    const double Mean = GetScore();
+    double Variance = 0.0;
+    for (int32 Bin = 0; Bin < 5; Bin++)
+    {
+        const double Delta = Bin * 0.25 - Mean;
+        Variance += PairCounts[Bin] * Delta * Delta;
+    }
+    return Variance / Pairs;
+}
+
+double FXQMatchStats::GetElo() const
+{
+    return ScoreToElo(GetScore());
+}
+
+double FXQMatchStats::GetEloError() const
+{
+    if (Pairs < 2)
+    {
+        return 0.0;
+    }
+
+    const double Margin = 1.959964 * std::sqrt(GetPairVariance() / Pairs);
+    const double Score = GetScore();
+    return (ScoreToElo(Score + Margin) - ScoreToElo(Score - Margin)) / 2.0;
+}
+
+double FXQMatchStats::GetLLR(const FXQSprtParams& Params) const
+{
+    const double Variance = GetPairVariance();
+    if (Pairs < 2 || Variance <= 0.0)
+    {
+        return 0.0;
+    }
+
+    // 均值为S0和S1的两个正态假设的对数似然比
+    const double Score0 = EloToScore(Params.Elo0);
+    const double Score1 = EloToScore(Params.Elo1);
+    return Pairs * (Score1 - Score0) * (2.0 * GetScore() - Score0 - Score1) / (2.0 * Variance);
+}
+
+EXQSprtState FXQMatchStats::GetSprtState(const FXQSprtParams& Params) const
+{
+    if (!Params.bEnabled)
+    {
+        return EXQSprtState::Continue;
+    }
+
+    const double LLR = GetLLR(Params);
+    if (LLR >= Params.GetUpperBound())
+    {
+        return EXQSprtState::AcceptH1;
+    }
+    if (LLR <= Params.GetLowerBound())
+    {
+        return EXQSprtState::AcceptH0;
+    }
+    return EXQSprtState::Continue;
+}
+
+std::string FXQMatchStats::ToString(const FXQSprtParams& Params) const
+{
+    char Buffer[256];
+    int32 Length = std::snprintf(Buffer, sizeof(Buffer), "Games: %d  W-D-L: %d-%d-%d  Score: %.1f%%  Elo: %.1f +- %.1f",
+        GetGames(), Wins, Draws, Losses, GetScore() * 100.0, GetElo(), GetEloError());
+    if (Params.bEnabled && Length > 0 && Length < static_cast<int32>(sizeof(Buffer)))
+    {
+        std::snprintf(Buffer + Length, sizeof(Buffer) - Length, "  LLR: %.2f (%.2f, %.2f) [%.1f, %.1f]",
+            GetLLR(Params), Params.GetLowerBound(), Params.GetUpperBound(), Params.Elo0, Params.Elo1);
+    }
+    return Buffer;
+}
+
+double FXQMatchStats::ScoreToElo(double Score)
+{
+    const double Clamped = std::max(1e-6, std::min(1.0 - 1e-6, Score));
+    return -400.0 * std::log10(1.0 / Clamped - 1.0);
+}
+
+double FXQMatchStats::EloToScore(double Elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -Elo / 400.0));
+}
@@ -0,0 +1,86 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQTypes.h"
+
+#include <string>
+
+// SPRT参数：H0为Elo差<=Elo0，H1为Elo差>=Elo1
+struct FXQSprtParams
+{
+    bool bEnabled = false;
+
+    double Elo0 = 0.0;
+
+    double Elo1 = 5.0;
+
+    double Alpha = 0.05;
+
+    double Beta = 0.05;
+
+    double GetLowerBound() const;
+
+    double GetUpperBound() const;
+};
+
+enum class EXQSprtState : uint8
+{
+    Continue,
+    AcceptH0,
+    AcceptH1
+};
+
+/**
+ * 对局统计：同一开局交换先后手的两局为一对，按五项分布（0、0.5、1、1.5、2分）统计，
+ * 比按单局统计的方差更小，SPRT需要的对局数更少
+ */
+class FXQMatchStats
+{
+public:
+    // 记录一对对局中引擎A的得分（每局胜1、和0.5、负0）
+    void AddPair(double ScoreA1, double ScoreA2);
+
+    int32 GetGames() const { return Pairs * 2; }
+
+    int32 GetWins() const { return Wins; }
+
+    int32 GetDraws() const { return Draws; }
+
+    int32 GetLosses() const { return Losses; }
+
+    // 引擎A的平均得分率
+    double GetScore() const;
+
+    // Elo差及95%置信区间的半宽
+    double GetElo() const;
+
+    double GetEloError() const;
+
+    // 对数似然比（广义SPRT，正态近似）
+    double GetLLR(const FXQSprtParams& Params) const;
+
+    EXQSprtState GetSprtState(const FXQSprtParams& Params) const;
+
+    // 一行进度摘要
+    std::string ToString(const FXQSprtParams& Params) const;
+
+    static double ScoreToElo(double Score);
+
+    static double EloToScore(double Elo);
+
+private:
+    // 每对得分的方差
+    double GetPairVariance() const;
+
+private:
+    int32 PairCounts[5] = { 0, 0, 0, 0, 0 };
+
+    int32 Pairs = 0;
+
+    int32 Wins = 0;
+
+    int32 Draws = 0;
+
+    int32 Losses = 0;
+};
@@ -0,0 +1,72 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQSelfPlay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+static FXQSelfPlayGenerator* GXQSelfPlayGenerator = nullptr;
+
+static void HandleXQSelfPlaySignal(int)
+{
+    // 第一次Ctrl+C写完已下完的对局后退出
+    if (GXQSelfPlayGenerator)
+    {
+        GXQSelfPlayGenerator->RequestStop();
+    }
+}
+
+static void PrintXQSelfPlayUsage()
+{
+    std::cout <<
+        "usage: xqselfplay [options]\n"
+        "  -out <dir>            output directory, existing chunks are resumed (default selfplay)\n"
+        "  -positions <n>        target number of unique positions (default 1000000)\n"
+        "  -games <n>            stop after n games in this run (default: unlimited)\n"
+        "  -concurrency <n>      games played at the same time (default: number of cores)\n"
+        "  -nodes <n>            node budget per move (default 20000)\n"
+        "  -random <n>           random opening plies, not recorded (default 8)\n"
+        "  -chunk <n>            positions per chunk file (default 65536)\n"
+        "  -seed <n>             random seed (default: time based)\n"
+        "  -maxplies <n>         adjudicate a draw after n plies (default 400)\n"
+        "  -keepchecks           also record positions where the side to move is in check\n";
+}
+
+int main(int Argc, char** Argv)
+{
+    FXQSelfPlaySettings Settings;
+    Settings.Concurrency = std::max(1, static_cast<int32>(std::thread::hardware_concurrency()));
+    Settings.Seed = static_cast<uint64>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    for (int32 i = 1; i < Argc; i++)
+    {
+        const std::string Arg = Argv[i];
+        const bool bHasValue = i + 1 < Argc;
+        if (Arg == "-out" && bHasValue) Settings.OutDir = Argv[++i];
+        else if (Arg == "-positions" && bHasValue) Settings.Positions = std::atoll(Argv[++i]);
+        else if (Arg == "-games" && bHasValue) Settings.Games = std::max(0, std::atoi(Argv[++i]));
+        else if (Arg == "-concurrency" && bHasValue) Settings.Concurrency = std::max(1, std::atoi(Argv[++i]));
+        else if (Arg == "-nodes" && bHasValue) Settings.Nodes = std::max(1LL, std::atoll(Argv[++i]));
+        else if (Arg == "-random" && bHasValue) Settings.RandomPlies = std::max(0, std::atoi(Argv[++i]));
+        else if (Arg == "-chunk" && bHasValue) Settings.ChunkSize = std::max(1, std::atoi(Argv[++i]));
+        else if (Arg == "-seed" && bHasValue) Settings.Seed = std::strtoull(Argv[++i], nullptr, 10);
+        else if (Arg == "-maxplies" && bHasValue) Settings.Rules.MaxPlies = std::atoi(Argv[++i]);
+        else if (Arg == "-keepchecks") Settings.bSkipChecks = false;
+        else
+        {
+            PrintXQSelfPlayUsage();
+            return Arg == "-help" || Arg == "-h" ? 0 : 1;
+        }
+    }
+
+    FXQSelfPlayGenerator Generator(Settings);
+    GXQSelfPlayGenerator = &Generator;
+    std::signal(SIGINT, HandleXQSelfPlaySignal);
+    const int32 ExitCode = Generator.Run();
+    GXQSelfPlayGenerator = nullptr;
+    return ExitCode;
+}
@@ -0,0 +1,326 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQSelfPlay.h"
+#include "XQPosition.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static uint64 MixXQSelfPlaySeed(uint64 Value)
+{
+    Value += 0x9E3779B97F4A7C15ull;
+    Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBull;
+    return Value ^ (Value >> 31);
+}
+
+// 文件名为chunk_NNNNNN.bin时返回编号，否则返回-1
+static int32 ParseXQChunkIndex(const std::string& FileName)
+{
+    int32 Index = -1;
+    char Tail = 0;
+    if (std::sscanf(FileName.c_str(), "chunk_%d.bi%c", &Index, &Tail) != 2 || Tail != 'n' || FileName.size() != 16)
+    {
+        return -1;
+    }
+    return Index;
+}
+
+FXQSelfPlayGenerator::FXQSelfPlayGenerator(const FXQSelfPlaySettings& InSettings)
+    : Settings(InSettings)
+    , bStopRequested(false)
+    , NextGame(0)
+{
+    Settings.ChunkSize = std::max(1, Settings.ChunkSize);
+    Settings.Concurrency = std::max(1, Settings.Concurrency);
+}
+
+std::string FXQSelfPlayGenerator::GetChunkPath(int32 ChunkIndex) const
+{
+    char FileName[32];
+    std::snprintf(FileName, sizeof(FileName), "chunk_%06d.bin", ChunkIndex);
+    return (fs::path(Settings.OutDir) / FileName).string();
+}
+
+bool FXQSelfPlayGenerator::LoadExisting()
+{
+    std::error_code Error;
+    fs::create_directories(Settings.OutDir, Error);
+    if (!fs::is_directory(Settings.OutDir, Error))
+    {
+        std::cerr << "cannot create " << Settings.OutDir << std::endl;
+        return false;
+    }
+
+    std::vector<int32> Chunks;
+    for (const fs::directory_entry& Entry : fs::directory_iterator(Settings.OutDir, Error))
+    {
+        const std::string FileName = Entry.path().filename().string();
+        if (Entry.path().extension() == ".tmp")
+        {
+            // 上次中断时没写完的分块
+            fs::remove(Entry.path(), Error);
+            continue;
+        }
+        const int32 Index = ParseXQChunkIndex(FileName);
+        if (Index >= 0)
+        {
+            Chunks.push_back(Index);
+        }
+    }
+    std::sort(Chunks.begin(), Chunks.end());
+
+    std::vector<FXQTrainingRecord> Buffer(1 << 14);
+    FXQPosition Position;
+    for (int32 Index : Chunks)
+    {
+        FXQTrainingFileReader Reader;
+        if (!Reader.Open(GetChunkPath(Index)))
+        {
+            std::cerr << "cannot read " << GetChunkPath(Index) << std::endl;
+            return false;
+        }
+        int64 Count;
+        while ((Count = Reader.Read(Buffer.data(), static_cast<int64>(Buffer.size()))) > 0)
+        {
+            for (int64 i = 0; i < Count; i++)
+            {
+                if (Buffer[i].Position.Unpack(Position))
+                {
+                    SeenKeys.insert(Position.GetKey());
+                }
+            }
+            NumPositions += Count;
+        }
+        NextChunk = Index + 1;
+    }
+
+    FirstChunk = NextChunk;
+    if (!Chunks.empty())
+    {
+        std::cout << "resuming: " << Chunks.size() << " chunks, " << NumPositions << " positions" << std::endl;
+    }
+    return true;
+}
+
+int32 FXQSelfPlayGenerator::Run()
+{
+    if (!LoadExisting())
+    {
+        return 1;
+    }
+    if (NumPositions >= Settings.Positions)
+    {
+        std::cout << "target of " << Settings.Positions << " positions already reached" << std::endl;
+        return 0;
+    }
+
+    std::cout << "self-play: " << Settings.Concurrency << " threads, " << Settings.Nodes << " nodes per move, target "
+        << Settings.Positions << " positions in " << Settings.OutDir << std::endl;
+
+    const auto StartTime = std::chrono::steady_clock::now();
+    const int64 StartPositions = NumPositions;
+
+    std::vector<std::thread> Workers;
+    for (int32 i = 0; i < Settings.Concurrency; i++)
+    {
+        Workers.emplace_back(&FXQSelfPlayGenerator::WorkerMain, this, i);
+    }
+    for (std::thread& Worker : Workers)
+    {
+        Worker.join();
+    }
+
+    // 最后不满一块的样本
+    if (!Pending.empty() && !bWriteFailed)
+    {
+        bWriteFailed = !WriteChunk(NextChunk++, Pending);
+        Pending.clear();
+    }
+
+    const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+    std::cout << "finished: " << NumGames << " games (+" << GameResults[0] << " =" << GameResults[1] << " -" << GameResults[2] << "), "
+        << NumPositions - StartPositions << " new positions, " << NumDuplicates << " duplicates, "
+        << static_cast<int64>((NumPositions - StartPositions) / std::max(Seconds, 1e-3)) << " positions/s" << std::endl;
+    return bWriteFailed ? 1 : 0;
+}
+
+void FXQSelfPlayGenerator::WorkerMain(int32 WorkerIndex)
+{
+    (void)WorkerIndex;
+
+    FXQSearch Search;
+    std::vector<FXQTrainingRecord> Records;
+    std::vector<uint64> Keys;
+    FXQPosition Position;
+    while (!bStopRequested)
+    {
+        const int32 GameIndex = NextGame++;
+        if (Settings.Games > 0 && GameIndex >= Settings.Games)
+        {
+            break;
+        }
+
+        // 续跑时已有分块数参与种子，避免重复上一次的对局
+        const uint64 GameSeed = MixXQSelfPlaySeed(Settings.Seed ^ MixXQSelfPlaySeed((static_cast<uint64>(FirstChunk) << 32) | static_cast<uint32>(GameIndex)));
+        PlayGame(Search, GameSeed, Records);
+        if (bStopRequested)
+        {
+            break;
+        }
+
+        Keys.clear();
+        for (const FXQTrainingRecord& Record : Records)
+        {
+            Record.Position.Unpack(Position);
+            Keys.push_back(Position.GetKey());
+        }
+        Submit(Records, Keys);
+    }
+}
+
+void FXQSelfPlayGenerator::PlayGame(FXQSearch& Search, uint64 GameSeed, std::vector<FXQTrainingRecord>& OutRecords) const
+{
+    OutRecords.clear();
+
+    FXQSearchLimits Limits;
+    Limits.Nodes = Settings.Nodes;
+
+    FXQPosition Position;
+    FXQMoveList Moves;
+    uint64 Random = GameSeed;
+
+    // 随机开局，走到无子可走时重来
+    for (int32 Attempt = 0; ; Attempt++)
+    {
+        Position.SetStartPosition();
+        int32 Ply = 0;
+        for (; Ply < Settings.RandomPlies; Ply++)
+        {
+            Position.GenerateLegalMoves(Moves);
+            if (Moves.Num == 0)
+            {
+                break;
+            }
+            Random = MixXQSelfPlaySeed(Random);
+            Position.MakeMove(Moves.Moves[Random % static_cast<uint64>(Moves.Num)]);
+        }
+        if (Ply == Settings.RandomPlies || Attempt >= 8)
+        {
+            break;
+        }
+    }
+
+    FXQReferee Referee(Settings.Rules);
+    Referee.Reset(Position);
+    EXQGameResult GameResult = Referee.Adjudicate(Position);
+    while (GameResult == EXQGameResult::Ongoing && !bStopRequested)
+    {
+        const FXQSearchResult Result = Search.Search(Position, Limits);
+        const FXQMove Move = Result.GetBestMove();
+        if (Move.IsNull())
+        {
+            GameResult = Position.GetSideToMove() == EXQColor::Red ? EXQGameResult::BlackWin : EXQGameResult::RedWin;
+            break;
+        }
+
+        const EXQColor Us = Position.GetSideToMove();
+        FXQTrainingRecord Record;
+        if ((!Settings.bSkipChecks || !Position.IsInCheck(Us)) && Record.Position.Pack(Position))
+        {
+            const int32 Score = Result.Lines[0].Score;
+            Record.BestMove = Move.Value;
+            Record.Score = static_cast<int16>(std::max(-32767, std::min(32767, Score)));
+            Record.Depth = static_cast<uint8>(std::min(255, Result.Depth));
+            Record.Ply = static_cast<uint16>(std::min(65535, Position.GetHistoryNum()));
+            OutRecords.push_back(Record);
+        }
+
+        Position.MakeMove(Move);
+        GameResult = Referee.OnMove(Position);
+    }
+
+    const int8 RedResult = GameResult == EXQGameResult::RedWin ? 1 : (GameResult == EXQGameResult::BlackWin ? -1 : 0);
+    for (FXQTrainingRecord& Record : OutRecords)
+    {
+        Record.Result = RedResult;
+    }
+}
+
+void FXQSelfPlayGenerator::Submit(const std::vector<FXQTrainingRecord>& Records, const std::vector<uint64>& Keys)
+{
+    std::vector<FXQTrainingRecord> Full;
+    int32 ChunkIndex = -1;
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (NumPositions >= Settings.Positions || bWriteFailed)
+        {
+            return;
+        }
+
+        NumGames++;
+        const int8 Result = Records.empty() ? 0 : Records[0].Result;
+        GameResults[Result > 0 ? 0 : (Result < 0 ? 2 : 1)]++;
+        for (size_t i = 0; i < Records.size() && NumPositions < Settings.Positions; i++)
+        {
+            if (!SeenKeys.insert(Keys[i]).second)
+            {
+                NumDuplicates++;
+                continue;
+            }
+            Pending.push_back(Records[i]);
+            NumPositions++;
+        }
+
+        if (static_cast<int32>(Pending.size()) >= Settings.ChunkSize)
+        {
+            Full.swap(Pending);
+            ChunkIndex = NextChunk++;
+        }
+        if (NumPositions >= Settings.Positions)
+        {
+            bStopRequested = true;
+        }
+        if (NumGames % 100 == 0)
+        {
+            std::cout << "games " << NumGames << ", positions " << NumPositions << ", duplicates " << NumDuplicates << std::endl;
+        }
+    }
+
+    // 写盘不占用锁，其他线程可以继续提交
+    if (ChunkIndex >= 0 && !WriteChunk(ChunkIndex, Full))
+    {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        bWriteFailed = true;
+        bStopRequested = true;
+    }
+}
+
+bool FXQSelfPlayGenerator::WriteChunk(int32 ChunkIndex, const std::vector<FXQTrainingRecord>& Records) const
+{
+    const std::string Path = GetChunkPath(ChunkIndex);
+    const std::string TempPath = Path + ".tmp";
+
+    FXQTrainingFileWriter Writer;
+    if (!Writer.Open(TempPath) || !Writer.Write(Records.data(), static_cast<int64>(Records.size())) || !Writer.Close())
+    {
+        std::cerr << "cannot write " << TempPath << std::endl;
+        return false;
+    }
+
+    std::error_code Error;
+    fs::rename(TempPath, Path, Error);
+    if (Error)
+    {
+        std::cerr << "cannot rename " << TempPath << ": " << Error.message() << std::endl;
+        return false;
+    }
+    std::cout << "wrote " << Path << " (" << Records.size() << " positions)" << std::endl;
+    return true;
+}
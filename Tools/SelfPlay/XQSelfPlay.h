@@ -0,0 +1,97 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQReferee.h"
+#include "XQSearch.h"
+#include "XQTrainingData.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct FXQSelfPlaySettings
+{
+    std::string OutDir = "selfplay";    // 分块文件chunk_NNNNNN.bin所在目录
+
+    int64 Positions = 1000000;          // 目标样本数（包括续跑前已有的样本）
+
+    int32 Games = 0;                    // 本次最多下多少局，0为不限
+
+    int32 Concurrency = 1;
+
+    int64 Nodes = 20000;                // 每步的节点数上限
+
+    int32 RandomPlies = 8;              // 开局随机走的半回合数（不记录），保证对局多样
+
+    int32 ChunkSize = 1 << 16;          // 每个分块的样本数
+
+    uint64 Seed = 0;
+
+    bool bSkipChecks = true;            // 不记录被将军的局面
+
+    FXQRefereeSettings Rules;
+};
+
+/**
+ * 自我对弈生成训练数据：多线程同时对局，每步固定节点数搜索，
+ * 记录（局面、最佳走法、评分、深度、对局结果），按Zobrist键值去重后分块写入目录。
+ * 分块先写到.tmp再改名，重新运行时读取已有分块恢复去重表并接着编号
+ */
+class FXQSelfPlayGenerator
+{
+public:
+    explicit FXQSelfPlayGenerator(const FXQSelfPlaySettings& InSettings);
+
+    // 运行到样本数达标、局数用完或RequestStop，返回0表示正常结束
+    int32 Run();
+
+    // 可在任意线程（包括信号处理函数）中调用，已下完的对局仍会写入
+    void RequestStop() { bStopRequested = true; }
+
+private:
+    // 读取已有分块，返回false表示目录不可用
+    bool LoadExisting();
+
+    void WorkerMain(int32 WorkerIndex);
+
+    // 下一局，Records返回按走子顺序的样本（Result已填好）
+    void PlayGame(FXQSearch& Search, uint64 GameSeed, std::vector<FXQTrainingRecord>& OutRecords) const;
+
+    // 去重后加入待写缓冲，满一块时写盘
+    void Submit(const std::vector<FXQTrainingRecord>& Records, const std::vector<uint64>& Keys);
+
+    bool WriteChunk(int32 ChunkIndex, const std::vector<FXQTrainingRecord>& Records) const;
+
+    std::string GetChunkPath(int32 ChunkIndex) const;
+
+private:
+    FXQSelfPlaySettings Settings;
+
+    std::atomic<bool> bStopRequested;
+
+    std::atomic<int32> NextGame;
+
+    int32 FirstChunk = 0;           // 本次运行开始时的分块编号，参与每局的随机种子
+
+    // 以下由Mutex保护
+    std::mutex Mutex;
+
+    std::unordered_set<uint64> SeenKeys;
+
+    std::vector<FXQTrainingRecord> Pending;
+
+    int32 NextChunk = 0;
+
+    int64 NumPositions = 0;         // 已写入和待写的样本数
+
+    int64 NumDuplicates = 0;
+
+    int32 NumGames = 0;
+
+    int32 GameResults[3] = { 0, 0, 0 }; // 红胜、和、黑胜
+
+    bool bWriteFailed = false;
+};
@@ -0,0 +1,221 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQTuner.h"
+#include "XQPosition.h"
+#include "XQTrainingData.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// 生成后复制到Source/XiangQiEngine/Private/替换原文件
+#define XQ_TUNE_DEFAULT_HEADER "XQTunedEvalParams.h"
+
+static void PrintXQTuneUsage()
+{
+    std::cout <<
+        "usage:\n"
+        "  xqtune convert <positions.txt> <out.bin>\n"
+        "      text lines: <FEN> <result>, result is 1-0 / 0-1 / 1/2-1/2 or [1.0] / [0.5] / [0.0] (red's view)\n"
+        "  xqtune tune <data.bin> [data2.bin ...] [options]\n"
+        "      -threads <n>      worker threads (default: number of cores)\n"
+        "      -epochs <n>       Adam iterations over the whole dataset (default 500)\n"
+        "      -lr <x>           Adam step size in centipawns (default 1.0)\n"
+        "      -k <x>            sigmoid scale, fitted automatically when omitted\n"
+        "      -header <file>    write the constexpr parameter header (default " XQ_TUNE_DEFAULT_HEADER ")\n"
+        "      -params <file>    also write a text parameter file (for xqmatch eval=<file>)\n"
+        "  xqtune export [-header <file>] [-params <file>]\n"
+        "      write the current built-in parameters\n";
+}
+
+// 解析结果记号，返回红方视角的结果（1、0、-1），无法识别时返回false
+static bool ParseXQTuneResult(const std::string& Token, int8& OutResult)
+{
+    if (Token == "1-0" || Token == "[1.0]" || Token == "[1]") { OutResult = 1; return true; }
+    if (Token == "0-1" || Token == "[0.0]" || Token == "[0]") { OutResult = -1; return true; }
+    if (Token == "1/2-1/2" || Token == "[0.5]") { OutResult = 0; return true; }
+    return false;
+}
+
+static int32 RunXQConvert(const std::string& InputPath, const std::string& OutputPath)
+{
+    std::ifstream Input(InputPath);
+    if (!Input)
+    {
+        std::cerr << "cannot open " << InputPath << std::endl;
+        return 1;
+    }
+
+    FXQTrainingFileWriter Writer;
+    if (!Writer.Open(OutputPath))
+    {
+        std::cerr << "cannot write " << OutputPath << std::endl;
+        return 1;
+    }
+
+    std::vector<FXQTrainingRecord> Buffer;
+    Buffer.reserve(1 << 16);
+    int64 Skipped = 0;
+    std::string Line;
+    FXQPosition Position;
+    while (std::getline(Input, Line))
+    {
+        const size_t Split = Line.find_last_of(" \t;");
+        if (Split == std::string::npos)
+        {
+            Skipped += Line.empty() ? 0 : 1;
+            continue;
+        }
+
+        FXQTrainingRecord Record;
+        std::string ResultToken = Line.substr(Split + 1);
+        ResultToken.erase(std::remove(ResultToken.begin(), ResultToken.end(), '\r'), ResultToken.end());
+        if (!ParseXQTuneResult(ResultToken, Record.Result) || !Position.SetFromFen(Line.substr(0, Split)) || !Record.Position.Pack(Position))
+        {
+            Skipped++;
+            continue;
+        }
+
+        Buffer.push_back(Record);
+        if (Buffer.size() == Buffer.capacity())
+        {
+            Writer.Write(Buffer.data(), static_cast<int64>(Buffer.size()));
+            Buffer.clear();
+        }
+    }
+    Writer.Write(Buffer.data(), static_cast<int64>(Buffer.size()));
+
+    const int64 Written = Writer.GetNum();
+    if (!Writer.Close())
+    {
+        std::cerr << "write failed: " << OutputPath << std::endl;
+        return 1;
+    }
+    std::cout << "converted " << Written << " positions, skipped " << Skipped << std::endl;
+    return 0;
+}
+
+static int32 WriteXQTuneOutputs(const FXQEvalParams& Params, const std::string& HeaderPath, const std::string& ParamsPath, const std::string& Comment)
+{
+    if (!HeaderPath.empty())
+    {
+        if (!FXQTexelTuner::WriteHeader(HeaderPath, Params, Comment))
+        {
+            std::cerr << "cannot write " << HeaderPath << std::endl;
+            return 1;
+        }
+        std::cout << "wrote " << HeaderPath << std::endl;
+    }
+    if (!ParamsPath.empty())
+    {
+        if (!Params.SaveToFile(ParamsPath))
+        {
+            std::cerr << "cannot write " << ParamsPath << std::endl;
+            return 1;
+        }
+        std::cout << "wrote " << ParamsPath << std::endl;
+    }
+    return 0;
+}
+
+int main(int Argc, char** Argv)
+{
+    if (Argc < 2)
+    {
+        PrintXQTuneUsage();
+        return 1;
+    }
+
+    const std::string Command = Argv[1];
+    if (Command == "convert")
+    {
+        if (Argc != 4)
+        {
+            PrintXQTuneUsage();
+            return 1;
+        }
+        return RunXQConvert(Argv[2], Argv[3]);
+    }
+
+    FXQTunerSettings Settings;
+    Settings.Threads = std::max(1, static_cast<int32>(std::thread::hardware_concurrency()));
+    std::string HeaderPath = XQ_TUNE_DEFAULT_HEADER;
+    std::string ParamsPath;
+    std::vector<std::string> DataPaths;
+    for (int32 i = 2; i < Argc; i++)
+    {
+        const std::string Arg = Argv[i];
+        const bool bHasValue = i + 1 < Argc;
+        if (Arg == "-threads" && bHasValue) Settings.Threads = std::max(1, std::atoi(Argv[++i]));
+        else if (Arg == "-epochs" && bHasValue) Settings.Epochs = std::max(0, std::atoi(Argv[++i]));
+        else if (Arg == "-lr" && bHasValue) Settings.LearningRate = std::atof(Argv[++i]);
+        else if (Arg == "-k" && bHasValue) Settings.K = std::atof(Argv[++i]);
+        else if (Arg == "-header" && bHasValue) HeaderPath = Argv[++i];
+        else if (Arg == "-params" && bHasValue) ParamsPath = Argv[++i];
+        else if (!Arg.empty() && Arg[0] != '-') DataPaths.push_back(Arg);
+        else
+        {
+            PrintXQTuneUsage();
+            return 1;
+        }
+    }
+
+    if (Command == "export")
+    {
+        return WriteXQTuneOutputs(FXQEvalParams::GetDefault(), HeaderPath, ParamsPath, "手工设定的初始参数（未调参）");
+    }
+    if (Command != "tune" || DataPaths.empty())
+    {
+        PrintXQTuneUsage();
+        return 1;
+    }
+
+    const auto StartTime = std::chrono::steady_clock::now();
+    auto GetSeconds = [StartTime]()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+    };
+
+    FXQTexelTuner Tuner(Settings);
+    for (const std::string& Path : DataPaths)
+    {
+        const int64 Loaded = Tuner.LoadDataset(Path);
+        if (Loaded < 0)
+        {
+            std::cerr << "cannot read " << Path << std::endl;
+            return 1;
+        }
+        std::cout << "loaded " << Loaded << " positions from " << Path << std::endl;
+    }
+    if (Tuner.GetNumPositions() == 0)
+    {
+        std::cerr << "no positions" << std::endl;
+        return 1;
+    }
+
+    if (Settings.K > 0.0)
+    {
+        Tuner.SetK(Settings.K);
+    }
+    else
+    {
+        Tuner.FitK();
+    }
+    std::cout << "K = " << Tuner.GetK() << ", initial loss " << Tuner.ComputeLoss() << " (" << GetSeconds() << "s)" << std::endl;
+
+    FXQTexelTuner::FProgressCallback OnProgress = [&GetSeconds](int32 Epoch, double Loss)
+    {
+        std::cout << "epoch " << Epoch << " loss " << Loss << " (" << GetSeconds() << "s)" << std::endl;
+    };
+    Tuner.Train(OnProgress);
+
+    const double FinalLoss = Tuner.ComputeLoss();
+    std::cout << "final loss " << FinalLoss << std::endl;
+
+    char Comment[256];
+    std::snprintf(Comment, sizeof(Comment), "样本数 %lld，K = %.4f，均方误差 %.6f", static_cast<long long>(Tuner.GetNumPositions()), Tuner.GetK(), FinalLoss);
+    return WriteXQTuneOutputs(Tuner.GetParams(), HeaderPath, ParamsPath, Comment);
+}
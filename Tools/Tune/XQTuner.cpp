@@ -0,0 +1,336 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQTuner.h"
+#include "XQTrainingData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+static const char* const XQTunePieceNames[8] = { "Empty", "Jiang", "Shi", "Xiang", "Ma", "Jv", "Pao", "Bing" };
+
+static int32 GetXQTunePstIndex(int32 Type, int32 RelativeSquare)
+{
+    const int32 File = XQFileOf(RelativeSquare);
+    const int32 Folded = std::min(File, XQ_FILES - 1 - File);
+    return XQ_TUNE_PST_BASE + (Type * XQ_RANKS + XQRankOf(RelativeSquare)) * XQ_TUNE_FOLDED_FILES + Folded;
+}
+
+FXQTexelTuner::FXQTexelTuner(const FXQTunerSettings& InSettings)
+    : Settings(InSettings)
+    , Weights(XQ_TUNE_NUM_PARAMS, 0.0)
+    , Gradient(XQ_TUNE_NUM_PARAMS, 0.0)
+{
+    Settings.Threads = std::max(1, Settings.Threads);
+    SetParams(FXQEvalParams::GetDefault());
+    Offsets.push_back(0);
+}
+
+int64 FXQTexelTuner::LoadDataset(const std::string& Path)
+{
+    FXQTrainingFileReader Reader;
+    if (!Reader.Open(Path))
+    {
+        return -1;
+    }
+
+    Results.reserve(Results.size() + static_cast<size_t>(Reader.GetNum()));
+    Offsets.reserve(Offsets.size() + static_cast<size_t>(Reader.GetNum()));
+
+    std::vector<FXQTrainingRecord> Block(1 << 16);
+
+    // 同一下标的系数（如两个车的子力）先合并再写入
+    std::vector<int32> Dense(XQ_TUNE_NUM_PARAMS, 0);
+    std::vector<uint8> Marked(XQ_TUNE_NUM_PARAMS, 0);
+    std::vector<uint16> Touched;
+
+    int64 Loaded = 0;
+    for (;;)
+    {
+        const int64 Count = Reader.Read(Block.data(), static_cast<int64>(Block.size()));
+        if (Count <= 0)
+        {
+            break;
+        }
+
+        for (int64 i = 0; i < Count; i++)
+        {
+            const FXQTrainingRecord& Record = Block[static_cast<size_t>(i)];
+            Touched.clear();
+
+            // 直接从槽位展开特征，无需还原棋盘
+            for (int32 Slot = 0; Slot < 32; Slot++)
+            {
+                const uint8 Square = Slot == 0 ? static_cast<uint8>(Record.Position.Slots[0] & 0x7F) : Record.Position.Slots[Slot];
+                if (Square >= XQ_SQUARES)
+                {
+                    continue;
+                }
+
+                const bool bRed = Slot < 16;
+                const int32 Type = static_cast<int32>(FXQPackedPosition::GetSlotType(Slot));
+                const int32 FeatureIndices[2] = { Type, GetXQTunePstIndex(Type, bRed ? Square : XQMirrorSquare(Square)) };
+                for (int32 Index : FeatureIndices)
+                {
+                    if (!Marked[Index])
+                    {
+                        Marked[Index] = 1;
+                        Touched.push_back(static_cast<uint16>(Index));
+                    }
+                    Dense[Index] += bRed ? 1 : -1;
+                }
+            }
+
+            for (uint16 Index : Touched)
+            {
+                if (Dense[Index] != 0)
+                {
+                    Indices.push_back(Index);
+                    Coeffs.push_back(static_cast<int8>(Dense[Index]));
+                }
+                Dense[Index] = 0;
+                Marked[Index] = 0;
+            }
+            Offsets.push_back(static_cast<uint32>(Indices.size()));
+            Results.push_back(static_cast<float>(Record.Result + 1) * 0.5f);
+            Loaded++;
+        }
+    }
+    return Loaded;
+}
+
+double FXQTexelTuner::FitK()
+{
+    // 黄金分割搜索，误差关于K是单峰的
+    const double Ratio = 0.5 * (std::sqrt(5.0) - 1.0);
+    double Low = 0.05;
+    double High = 4.0;
+    double X1 = High - Ratio * (High - Low);
+    double X2 = Low + Ratio * (High - Low);
+    K = X1;
+    double F1 = ComputeLoss();
+    K = X2;
+    double F2 = ComputeLoss();
+    for (int32 Iteration = 0; Iteration < 40; Iteration++)
+    {
+        if (F1 < F2)
+        {
+            High = X2;
+            X2 = X1;
+            F2 = F1;
+            X1 = High - Ratio * (High - Low);
+            K = X1;
+            F1 = ComputeLoss();
+        }
+        else
+        {
+            Low = X1;
+            X1 = X2;
+            F1 = F2;
+            X2 = Low + Ratio * (High - Low);
+            K = X2;
+            F2 = ComputeLoss();
+        }
+    }
+    K = 0.5 * (Low + High);
+    return K;
+}
+
+double FXQTexelTuner::ComputeLoss()
+{
+    return Evaluate(false);
+}
+
+void FXQTexelTuner::Train(const FProgressCallback& OnProgress)
+{
+    // Adam
+    const double Beta1 = 0.9;
+    const double Beta2 = 0.999;
+    const double Epsilon = 1e-8;
+    std::vector<double> Moment(XQ_TUNE_NUM_PARAMS, 0.0);
+    std::vector<double> Velocity(XQ_TUNE_NUM_PARAMS, 0.0);
+    for (int32 Epoch = 1; Epoch <= Settings.Epochs; Epoch++)
+    {
+        const double Loss = Evaluate(true);
+
+        const double Correction1 = 1.0 - std::pow(Beta1, Epoch);
+        const double Correction2 = 1.0 - std::pow(Beta2, Epoch);
+        for (int32 i = 0; i < XQ_TUNE_NUM_PARAMS; i++)
+        {
+            // 将帅的子力价值固定，双方抵消，不参与调整
+            if (i == static_cast<int32>(EXQPieceType::Jiang) || Gradient[i] == 0.0)
+            {
+                continue;
+            }
+            Moment[i] = Beta1 * Moment[i] + (1.0 - Beta1) * Gradient[i];
+            Velocity[i] = Beta2 * Velocity[i] + (1.0 - Beta2) * Gradient[i] * Gradient[i];
+            Weights[i] -= Settings.LearningRate * (Moment[i] / Correction1) / (std::sqrt(Velocity[i] / Correction2) + Epsilon);
+        }
+
+        if (OnProgress && (Epoch % std::max(1, Settings.ReportInterval) == 0 || Epoch == Settings.Epochs))
+        {
+            OnProgress(Epoch, Loss);
+        }
+    }
+}
+
+double FXQTexelTuner::Evaluate(bool bGradient)
+{
+    const int64 Num = GetNumPositions();
+    const int32 NumThreads = static_cast<int32>(std::max<int64>(1, std::min<int64>(Settings.Threads, Num / 1024 + 1)));
+
+    // 每个线程独立累加误差和梯度，最后按线程顺序归约，结果与调度无关
+    std::vector<double> Losses(static_cast<size_t>(NumThreads), 0.0);
+    std::vector<std::vector<double>> Gradients(static_cast<size_t>(NumThreads));
+    std::vector<std::thread> Workers;
+    for (int32 t = 0; t < NumThreads; t++)
+    {
+        const int64 Begin = Num * t / NumThreads;
+        const int64 End = Num * (t + 1) / NumThreads;
+        Workers.emplace_back([this, t, Begin, End, bGradient, &Losses, &Gradients]()
+        {
+            EvaluateRange(Begin, End, bGradient, Losses[static_cast<size_t>(t)], Gradients[static_cast<size_t>(t)]);
+        });
+    }
+    for (std::thread& Worker : Workers)
+    {
+        Worker.join();
+    }
+
+    double Loss = 0.0;
+    std::fill(Gradient.begin(), Gradient.end(), 0.0);
+    for (int32 t = 0; t < NumThreads; t++)
+    {
+        Loss += Losses[static_cast<size_t>(t)];
+        if (bGradient)
+        {
+            const std::vector<double>& Local = Gradients[static_cast<size_t>(t)];
+            for (int32 i = 0; i < XQ_TUNE_NUM_PARAMS; i++)
+            {
+                Gradient[i] += Local[static_cast<size_t>(i)];
+            }
+        }
+    }
+
+    const double Scale = Num > 0 ? 1.0 / static_cast<double>(Num) : 0.0;
+    for (double& Value : Gradient)
+    {
+        Value *= Scale;
+    }
+    return Loss * Scale;
+}
+
+void FXQTexelTuner::EvaluateRange(int64 Begin, int64 End, bool bGradient, double& OutLoss, std::vector<double>& OutGradient) const
+{
+    if (bGradient)
+    {
+        OutGradient.assign(XQ_TUNE_NUM_PARAMS, 0.0);
+    }
+
+    // sigmoid(e) = 1 / (1 + 10^(-K * e / 400))
+    const double Scale = K * std::log(10.0) / 400.0;
+    const double* W = Weights.data();
+    const uint16* FeatureIndices = Indices.data();
+    const int8* FeatureCoeffs = Coeffs.data();
+
+    double Loss = 0.0;
+    for (int64 i = Begin; i < End; i++)
+    {
+        const uint32 First = Offsets[static_cast<size_t>(i)];
+        const uint32 Last = Offsets[static_cast<size_t>(i) + 1];
+
+        double Eval = 0.0;
+        for (uint32 f = First; f < Last; f++)
+        {
+            Eval += W[FeatureIndices[f]] * FeatureCoeffs[f];
+        }
+
+        const double Predicted = 1.0 / (1.0 + std::exp(-Scale * Eval));
+        const double Error = Results[static_cast<size_t>(i)] - Predicted;
+        Loss += Error * Error;
+
+        if (bGradient)
+        {
+            const double Delta = -2.0 * Error * Predicted * (1.0 - Predicted) * Scale;
+            for (uint32 f = First; f < Last; f++)
+            {
+                OutGradient[FeatureIndices[f]] += Delta * FeatureCoeffs[f];
+            }
+        }
+    }
+    OutLoss = Loss;
+}
+
+void FXQTexelTuner::SetParams(const FXQEvalParams& Params)
+{
+    std::fill(Weights.begin(), Weights.end(), 0.0);
+    for (int32 Type = 0; Type < 8; Type++)
+    {
+        Weights[Type] = Params.Material[Type];
+
+        // 左右对称的两个格子取平均
+        for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+        {
+            Weights[GetXQTunePstIndex(Type, Square)] += 0.5 * Params.PositionValues[Type][Square];
+        }
+        for (int32 Rank = 0; Rank < XQ_RANKS; Rank++)
+        {
+            // 中路只有一个格子，上面加了一次一半
+            Weights[GetXQTunePstIndex(Type, XQMakeSquare(Rank, XQ_FILES / 2))] *= 2.0;
+        }
+    }
+}
+
+FXQEvalParams FXQTexelTuner::GetParams() const
+{
+    FXQEvalParams Params;
+    for (int32 Type = 0; Type < 8; Type++)
+    {
+        Params.Material[Type] = static_cast<int32>(std::lround(Weights[Type]));
+        for (int32 Square = 0; Square < XQ_SQUARES; Square++)
+        {
+            Params.PositionValues[Type][Square] = static_cast<int32>(std::lround(Weights[GetXQTunePstIndex(Type, Square)]));
+        }
+    }
+    return Params;
+}
+
+bool FXQTexelTuner::WriteHeader(const std::string& Path, const FXQEvalParams& Params, const std::string& Comment)
+{
+    std::FILE* File = std::fopen(Path.c_str(), "wb");
+    if (File == nullptr)
+    {
+        return false;
+    }
+
+    std::fputs("\xEF\xBB\xBF// Copyright 2026 Ultimate Player All Rights Reserved.\n", File);
+    std::fputs("// 此文件由xqtune生成，请勿手工修改\n", File);
+    std::fprintf(File, "// %s\n\n", Comment.c_str());
+    std::fputs("#pragma once\n\n#include \"XQTypes.h\"\n\n", File);
+
+    std::fputs("// 子力价值，按EXQPieceType索引\n", File);
+    std::fputs("constexpr int32 XQTunedMaterial[8] = { ", File);
+    for (int32 Type = 0; Type < 8; Type++)
+    {
+        std::fprintf(File, Type < 7 ? "%d, " : "%d };\n\n", Params.Material[Type]);
+    }
+
+    std::fputs("// 位置分（红方视角），按EXQPieceType索引，每行9个，第0行为红方底线\n", File);
+    std::fputs("constexpr int32 XQTunedPositionValues[8][XQ_SQUARES] = {\n", File);
+    for (int32 Type = 0; Type < 8; Type++)
+    {
+        std::fprintf(File, "    { // %s\n", XQTunePieceNames[Type]);
+        for (int32 Rank = 0; Rank < XQ_RANKS; Rank++)
+        {
+            std::fputs("        ", File);
+            for (int32 Column = 0; Column < XQ_FILES; Column++)
+            {
+                std::fprintf(File, Column < XQ_FILES - 1 ? "%d, " : "%d,\n", Params.PositionValues[Type][XQMakeSquare(Rank, Column)]);
+            }
+        }
+        std::fputs("    },\n", File);
+    }
+    std::fputs("};\n", File);
+    return std::fclose(File) == 0;
+}
@@ -0,0 +1,88 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQEvaluation.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// 参数布局：子力价值8个，随后是8种棋子x10行x5列的位置分（左右对称，只调半边）
+#define XQ_TUNE_FOLDED_FILES 5
+#define XQ_TUNE_PST_BASE 8
+#define XQ_TUNE_NUM_PARAMS (XQ_TUNE_PST_BASE + 8 * XQ_RANKS * XQ_TUNE_FOLDED_FILES)
+
+struct FXQTunerSettings
+{
+    int32 Threads = 1;
+
+    int32 Epochs = 500;
+
+    double LearningRate = 1.0;      // Adam步长（分）
+
+    double K = 0.0;                 // Sigmoid缩放，0表示由FitK自动拟合
+
+    int32 ReportInterval = 25;      // 每隔多少轮输出一次误差
+};
+
+/**
+ * Texel调参：评估是参数的线性函数，每个局面预先展开成稀疏特征（下标、系数），
+ * 用 sigmoid(K * Eval) 拟合对局结果，多线程计算全量梯度后用Adam更新
+ */
+class FXQTexelTuner
+{
+public:
+    typedef std::function<void(int32 Epoch, double Loss)> FProgressCallback;
+
+    explicit FXQTexelTuner(const FXQTunerSettings& InSettings);
+
+    // 读取训练数据文件（XQTrainingData格式），返回加载的局面数，失败返回-1
+    int64 LoadDataset(const std::string& Path);
+
+    int64 GetNumPositions() const { return static_cast<int64>(Results.size()); }
+
+    // 以当前参数拟合K
+    double FitK();
+
+    void SetK(double InK) { K = InK; }
+
+    // 当前参数下的均方误差
+    double ComputeLoss();
+
+    // 以当前K进行Settings.Epochs轮Adam迭代
+    void Train(const FProgressCallback& OnProgress);
+
+    void SetParams(const FXQEvalParams& Params);
+
+    FXQEvalParams GetParams() const;
+
+    double GetK() const { return K; }
+
+    // 输出constexpr参数表头文件，供XQEvaluation.cpp编译使用
+    static bool WriteHeader(const std::string& Path, const FXQEvalParams& Params, const std::string& Comment);
+
+private:
+    // 多线程计算误差，bGradient为true时同时累加梯度到Gradient
+    double Evaluate(bool bGradient);
+
+    void EvaluateRange(int64 Begin, int64 End, bool bGradient, double& OutLoss, std::vector<double>& OutGradient) const;
+
+private:
+    FXQTunerSettings Settings;
+
+    double K = 1.0;
+
+    std::vector<double> Weights;
+
+    std::vector<double> Gradient;
+
+    // 稀疏特征：局面i的特征位于[Offsets[i], Offsets[i+1])
+    std::vector<uint32> Offsets;
+
+    std::vector<uint16> Indices;
+
+    std::vector<int8> Coeffs;
+
+    std::vector<float> Results;     // 红方得分：1、0.5、0
+};
@@ -0,0 +1,14 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQProtocol.h"
+
+#include <iostream>
+
+int main()
+{
+    std::ios::sync_with_stdio(false);
+
+    FXQProtocol Protocol(std::cin, std::cout);
+    Protocol.Run();
+    return 0;
+}
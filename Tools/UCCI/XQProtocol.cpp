@@ -0,0 +1,517 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#include "XQProtocol.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#define XQ_ENGINE_NAME "XiangQiPro"
+#define XQ_ENGINE_AUTHOR "Ultimate Player"
+#define XQ_MAX_MULTIPV 16
+
+// 性能测试局面：开局、中局和残局各若干
+static const char* const XQBenchFens[] = {
+    XQ_START_FEN,
+    "r1bakabr1/9/1cn4cn/p1p1p1p1p/9/9/P1P1P1P1P/1C2C1N2/9/RNBAKAB1R w - - 0 1",
+    "r2akab2/9/1cn1b1n2/p1p1p3p/6p2/2P6/P3P1P1P/1CN1B1N2/4A4/R2AK1B1R b - - 0 1",
+    "2bakab2/9/2n1c1n2/p3p3p/2p3p2/9/P1P3P1P/2N1C1N2/9/2BAKAB2 w - - 0 1",
+    "3ak4/4a4/4b4/4P4/9/9/9/4B4/4A4/3AK1R2 w - - 0 1",
+};
+
+static std::vector<std::string> SplitXQTokens(const std::string& Line)
+{
+    std::vector<std::string> Tokens;
+    std::istringstream Stream(Line);
+    std::string Token;
+    while (Stream >> Token)
+    {
+        Tokens.push_back(Token);
+    }
+    return Tokens;
+}
+
+static int64 ParseXQInt(const std::vector<std::string>& Tokens, size_t Index, int64 Default)
+{
+    if (Index >= Tokens.size())
+    {
+        return Default;
+    }
+    char* End = nullptr;
+    const long long Value = std::strtoll(Tokens[Index].c_str(), &End, 10);
+    return End != Tokens[Index].c_str() ? static_cast<int64>(Value) : Default;
+}
+
+static int64 GetXQNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FXQProtocol::FXQProtocol(std::istream& InInput, std::ostream& InOutput)
+    : Input(InInput)
+    , Output(InOutput)
+{
+    Position.SetStartPosition();
+}
+
+FXQProtocol::~FXQProtocol()
+{
+    StopSearch(false);
+}
+
+void FXQProtocol::Run()
+{
+    std::string Line;
+    while (std::getline(Input, Line))
+    {
+        if (!HandleCommand(Line))
+        {
+            break;
+        }
+    }
+    StopSearch(false);
+}
+
+bool FXQProtocol::HandleCommand(const std::string& Line)
+{
+    const std::vector<std::string> Tokens = SplitXQTokens(Line);
+    if (Tokens.empty())
+    {
+        return true;
+    }
+
+    const std::string& Command = Tokens[0];
+    if (Command == "ucci" || Command == "uci")
+    {
+        Mode = Command == "ucci" ? EXQProtocolMode::UCCI : EXQProtocolMode::UCI;
+        WriteLine("id name " XQ_ENGINE_NAME);
+        WriteLine("id author " XQ_ENGINE_AUTHOR);
+        if (Mode == EXQProtocolMode::UCCI)
+        {
+            WriteLine("option multipv type spin min 1 max " + std::to_string(XQ_MAX_MULTIPV) + " default 1");
+            WriteLine("option statsfile type string default <empty>");
+            WriteLine("ucciok");
+        }
+        else
+        {
+            WriteLine("option name MultiPV type spin default 1 min 1 max " + std::to_string(XQ_MAX_MULTIPV));
+            WriteLine("option name Ponder type check default true");
+            WriteLine("option name StatsFile type string default <empty>");
+            WriteLine("uciok");
+        }
+    }
+    else if (Command == "isready")
+    {
+        WriteLine("readyok");
+    }
+    else if (Command == "setoption")
+    {
+        HandleSetOption(Tokens);
+    }
+    else if (Command == "position")
+    {
+        StopSearch(false);
+        HandlePosition(Tokens);
+    }
+    else if (Command == "ucinewgame")
+    {
+        StopSearch(false);
+        Position.SetStartPosition();
+    }
+    else if (Command == "go")
+    {
+        HandleGo(Tokens);
+    }
+    else if (Command == "stop")
+    {
+        StopSearch(true);
+    }
+    else if (Command == "ponderhit")
+    {
+        Search.PonderHit();
+
+        std::lock_guard<std::mutex> Lock(OutputMutex);
+        bHoldBestMove = false;
+        if (bSearchFinished && !bBestMoveEmitted)
+        {
+            EmitBestMove();
+        }
+    }
+    else if (Command == "perft")
+    {
+        StopSearch(false);
+        HandlePerft(Tokens);
+    }
+    else if (Command == "bench")
+    {
+        StopSearch(false);
+        HandleBench(Tokens);
+    }
+    else if (Command == "d")
+    {
+        char Fen[XQ_FEN_BUFFER_SIZE];
+        Position.WriteFen(Fen);
+        WriteLine(Fen);
+    }
+    else if (Command == "quit")
+    {
+        StopSearch(false);
+        if (Mode == EXQProtocolMode::UCCI)
+        {
+            WriteLine("bye");
+        }
+        return false;
+    }
+    return true;
+}
+
+void FXQProtocol::HandlePosition(const std::vector<std::string>& Tokens)
+{
+    // 在副本上解析，FEN或任一走法无效时整条命令不生效，保留原局面
+    FXQPosition NewPosition = Position;
+    size_t Index = 1;
+    if (Index < Tokens.size() && Tokens[Index] == "startpos")
+    {
+        NewPosition.SetStartPosition();
+        Index++;
+    }
+    else if (Index < Tokens.size() && Tokens[Index] == "fen")
+    {
+        // 各字段拼回定长缓冲区，过长的FEN视为无效
+        char Fen[XQ_FEN_BUFFER_SIZE];
+        int32 Length = 0;
+        bool bFits = true;
+        for (Index++; Index < Tokens.size() && Tokens[Index] != "moves"; Index++)
+        {
+            const int32 TokenLength = static_cast<int32>(Tokens[Index].size());
+            if (Length + TokenLength + 1 >= XQ_FEN_BUFFER_SIZE)
+            {
+                bFits = false;
+                continue;
+            }
+            if (Length > 0)
+            {
+                Fen[Length++] = ' ';
+            }
+            std::memcpy(Fen + Length, Tokens[Index].data(), TokenLength);
+            Length += TokenLength;
+        }
+        Fen[Length] = '\0';
+        if (!bFits || !NewPosition.SetFromFen(Fen, Length))
+        {
+            WriteLine(std::string("info string invalid fen ") + Fen);
+            return;
+        }
+    }
+
+    if (Index < Tokens.size() && Tokens[Index] == "moves")
+    {
+        for (Index++; Index < Tokens.size(); Index++)
+        {
+            FXQMove Move;
+            if (!XQParseMove(Tokens[Index], Move) || !NewPosition.MakeMoveIfLegal(Move))
+            {
+                WriteLine("info string illegal move " + Tokens[Index]);
+                return;
+            }
+        }
+    }
+    Position = NewPosition;
+}
+
+void FXQProtocol::HandleSetOption(const std::vector<std::string>& Tokens)
+{
+    // UCI: setoption name MultiPV value 3
+    // UCCI: setoption multipv 3
+    std::string Name;
+    std::string Value;
+    for (size_t i = 1; i < Tokens.size(); i++)
+    {
+        if (Tokens[i] == "name" && i + 1 < Tokens.size())
+        {
+            Name = Tokens[++i];
+        }
+        else if (Tokens[i] == "value" && i + 1 < Tokens.size())
+        {
+            Value = Tokens[++i];
+        }
+        else if (Name.empty())
+        {
+            Name = Tokens[i];
+        }
+        else if (Value.empty())
+        {
+            Value = Tokens[i];
+        }
+    }
+
+    std::transform(Name.begin(), Name.end(), Name.begin(), [](unsigned char C) { return static_cast<char>(std::tolower(C)); });
+    if (Name == "multipv")
+    {
+        const std::vector<std::string> ValueTokens(1, Value);
+        MultiPV = static_cast<int32>(std::max<int64>(1, std::min<int64>(XQ_MAX_MULTIPV, ParseXQInt(ValueTokens, 0, 1))));
+    }
+    else if (Name == "statsfile")
+    {
+        // 追加写入，新文件先写表头；空值或<empty>关闭
+        std::lock_guard<std::mutex> Lock(OutputMutex);
+        StatsFile.close();
+        StatsFile.clear();
+        if (!Value.empty() && Value != "<empty>")
+        {
+            StatsFile.open(Value, std::ios::app);
+            if (!StatsFile)
+            {
+                Output << "info string cannot open stats file " << Value << std::endl;
+            }
+            else if (StatsFile.tellp() == 0)
+            {
+                StatsFile << FXQSearchStats::GetCsvHeader() << '\n';
+            }
+        }
+    }
+}
+
+void FXQProtocol::HandleGo(const std::vector<std::string>& Tokens)
+{
+    StopSearch(false);
+
+    FXQSearchLimits Limits;
+    Limits.MultiPV = MultiPV;
+
+    const bool bRed = Position.GetSideToMove() == EXQColor::Red;
+    int64 TimeLeft = 0;
+    int64 Increment = 0;
+    int64 MovesToGo = 0;
+    for (size_t i = 1; i < Tokens.size(); i++)
+    {
+        const std::string& Token = Tokens[i];
+        if (Token == "infinite") Limits.bInfinite = true;
+        else if (Token == "ponder") Limits.bPonder = true;
+        else if (Token == "depth") Limits.Depth = static_cast<int32>(ParseXQInt(Tokens, ++i, Limits.Depth));
+        else if (Token == "nodes") Limits.Nodes = ParseXQInt(Tokens, ++i, 0);
+        else if (Token == "movetime") Limits.MoveTimeMs = static_cast<int32>(ParseXQInt(Tokens, ++i, 0));
+        else if (Token == "time") TimeLeft = ParseXQInt(Tokens, ++i, 0);
+        else if (Token == "increment") Increment = ParseXQInt(Tokens, ++i, 0);
+        else if (Token == "movestogo") MovesToGo = ParseXQInt(Tokens, ++i, 0);
+        else if (Token == "wtime") { const int64 Value = ParseXQInt(Tokens, ++i, 0); if (bRed) TimeLeft = Value; }
+        else if (Token == "btime") { const int64 Value = ParseXQInt(Tokens, ++i, 0); if (!bRed) TimeLeft = Value; }
+        else if (Token == "winc") { const int64 Value = ParseXQInt(Tokens, ++i, 0); if (bRed) Increment = Value; }
+        else if (Token == "binc") { const int64 Value = ParseXQInt(Tokens, ++i, 0); if (!bRed) Increment = Value; }
+    }
+
+    // 按剩余时间分配本步用时，保留一点余量给通信
+    if (Limits.MoveTimeMs == 0 && TimeLeft > 0)
+    {
+        const int64 Divider = MovesToGo > 0 ? std::min<int64>(MovesToGo, 30) : 30;
+        const int64 Budget = TimeLeft / Divider + Increment * 3 / 4;
+        Limits.MoveTimeMs = static_cast<int32>(std::max<int64>(10, std::min(Budget, TimeLeft - 50)));
+    }
+
+    StartSearch(Limits);
+}
+
+void FXQProtocol::StartSearch(const FXQSearchLimits& Limits)
+{
+    {
+        std::lock_guard<std::mutex> Lock(OutputMutex);
+        LastResult = FXQSearchResult();
+        bSearchFinished = false;
+        bBestMoveEmitted = false;
+        bHoldBestMove = Limits.bInfinite || Limits.bPonder;
+    }
+
+    // 在启动线程之前清除停止请求，紧接着到达的stop不会被搜索入口覆盖
+    Search.ResetStop();
+    const FXQPosition Root = Position;
+    SearchThread = std::thread([this, Root, Limits]()
+    {
+        const FXQSearchResult Result = Search.Search(Root, Limits, [this](const FXQSearchResult& Iteration) { OnIteration(Iteration); });
+
+        std::lock_guard<std::mutex> Lock(OutputMutex);
+        LastResult = Result;
+        bSearchFinished = true;
+        if (!bHoldBestMove)
+        {
+            EmitBestMove();
+        }
+    });
+}
+
+void FXQProtocol::StopSearch(bool bEmit)
+{
+    if (!SearchThread.joinable())
+    {
+        return;
+    }
+
+    Search.Stop();
+    SearchThread.join();
+
+    std::lock_guard<std::mutex> Lock(OutputMutex);
+    bHoldBestMove = false;
+    if (bEmit && !bBestMoveEmitted)
+    {
+        EmitBestMove();
+    }
+    bBestMoveEmitted = true;
+}
+
+void FXQProtocol::OnIteration(const FXQSearchResult& Result)
+{
+    const FXQSearchStats& Stats = Result.Stats;
+    const int64 Nps = Stats.GetNps();
+    const int32 NumLines = std::min(MultiPV, static_cast<int32>(Result.Lines.size()));
+
+    std::lock_guard<std::mutex> Lock(OutputMutex);
+    for (int32 i = 0; i < NumLines; i++)
+    {
+        const FXQSearchLine& Line = Result.Lines[i];
+        std::string Text = "info depth " + std::to_string(Result.Depth) + " seldepth " + std::to_string(Stats.SelDepth);
+        if (NumLines > 1 || Mode == EXQProtocolMode::UCI)
+        {
+            Text += " multipv " + std::to_string(i + 1);
+        }
+        Text += " score " + FormatScore(Line.Score);
+        Text += " nodes " + std::to_string(Result.Nodes) + " time " + std::to_string(Result.TimeMs) + " nps " + std::to_string(Nps);
+        Text += " pv";
+        for (FXQMove Move : Line.PV)
+        {
+            Text += " " + XQMoveToString(Move);
+        }
+        Output << Text << '\n';
+    }
+
+    // 协议没有的统计项放在info string中
+    char Text[256];
+    std::snprintf(Text, sizeof(Text), "info string stats qnodes %lld itertime %lld fmcut %.3f reduce %lld reducesuccess %.3f policyhit %.3f",
+        static_cast<long long>(Stats.QNodes), static_cast<long long>(Stats.IterationTimeMs), Stats.GetFirstMoveCutoffRate(),
+        static_cast<long long>(Stats.Reductions), Stats.GetReductionSuccessRate(), Stats.GetPolicyHitRate());
+    Output << Text << '\n';
+    Output.flush();
+
+    if (StatsFile.is_open())
+    {
+        StatsFile << Stats.ToCsvRow() << '\n';
+        StatsFile.flush();
+    }
+}
+
+void FXQProtocol::EmitBestMove()
+{
+    bBestMoveEmitted = true;
+
+    const FXQMove BestMove = LastResult.GetBestMove();
+    if (BestMove.IsNull())
+    {
+        Output << (Mode == EXQProtocolMode::UCI ? "bestmove (none)" : "nobestmove") << std::endl;
+        return;
+    }
+
+    Output << "bestmove " << XQMoveToString(BestMove);
+    const FXQMove PonderMove = LastResult.GetPonderMove();
+    if (!PonderMove.IsNull())
+    {
+        Output << " ponder " << XQMoveToString(PonderMove);
+    }
+    Output << std::endl;
+}
+
+void FXQProtocol::WriteLine(const std::string& Text)
+{
+    std::lock_guard<std::mutex> Lock(OutputMutex);
+    Output << Text << std::endl;
+}
+
+std::string FXQProtocol::FormatScore(int32 Score) const
+{
+    if (Mode == EXQProtocolMode::UCI)
+    {
+        if (FXQSearch::IsMateScore(Score))
+        {
+            const int32 Plies = XQ_MATE_SCORE - std::abs(Score);
+            const int32 MateIn = (Plies + 1) / 2;
+            return "mate " + std::to_string(Score > 0 ? MateIn : -MateIn);
+        }
+        return "cp " + std::to_string(Score);
+    }
+    return std::to_string(Score);
+}
+
+void FXQProtocol::HandlePerft(const std::vector<std::string>& Tokens)
+{
+    const int32 Depth = static_cast<int32>(std::max<int64>(1, ParseXQInt(Tokens, 1, 1)));
+    const int64 StartMs = GetXQNowMs();
+
+    FXQPosition Root = Position;
+    FXQMoveList Moves;
+    Root.GenerateLegalMoves(Moves);
+
+    uint64 Total = 0;
+    for (FXQMove Move : Moves)
+    {
+        Root.MakeMove(Move);
+        const uint64 Count = Perft(Root, Depth - 1);
+        Root.UnmakeMove();
+
+        Total += Count;
+        WriteLine(XQMoveToString(Move) + ": " + std::to_string(Count));
+    }
+
+    const int64 ElapsedMs = std::max<int64>(1, GetXQNowMs() - StartMs);
+    WriteLine("nodes " + std::to_string(Total) + " time " + std::to_string(ElapsedMs) + " nps " + std::to_string(Total * 1000 / static_cast<uint64>(ElapsedMs)));
+}
+
+void FXQProtocol::HandleBench(const std::vector<std::string>& Tokens)
+{
+    FXQSearchLimits Limits;
+    Limits.Depth = static_cast<int32>(std::max<int64>(1, ParseXQInt(Tokens, 1, 6)));
+
+    int64 TotalNodes = 0;
+    const int64 StartMs = GetXQNowMs();
+    for (const char* Fen : XQBenchFens)
+    {
+        FXQPosition BenchPosition;
+        if (!BenchPosition.SetFromFen(Fen))
+        {
+            WriteLine(std::string("info string invalid bench fen ") + Fen);
+            continue;
+        }
+
+        Search.ResetStop();
+        const FXQSearchResult Result = Search.Search(BenchPosition, Limits);
+        TotalNodes += Result.Nodes;
+        WriteLine(std::string(Fen) + " bestmove " + XQMoveToString(Result.GetBestMove()) + " nodes " + std::to_string(Result.Nodes));
+    }
+
+    const int64 ElapsedMs = std::max<int64>(1, GetXQNowMs() - StartMs);
+    WriteLine("bench nodes " + std::to_string(TotalNodes) + " time " + std::to_string(ElapsedMs) + " nps " + std::to_string(TotalNodes * 1000 / ElapsedMs));
+}
+
+uint64 FXQProtocol::Perft(FXQPosition& Node, int32 Depth)
+{
+    if (Depth <= 0)
+    {
+        return 1;
+    }
+
+    FXQMoveList Moves;
+    Node.GenerateMoves(Moves);
+
+    uint64 Count = 0;
+    for (FXQMove Move : Moves)
+    {
+        if (!Node.MakeMoveIfLegal(Move))
+        {
+            continue;
+        }
+        Count += Depth == 1 ? 1 : Perft(Node, Depth - 1);
+        Node.UnmakeMove();
+    }
+    return Count;
+}
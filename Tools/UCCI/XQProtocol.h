@@ -0,0 +1,94 @@
+﻿// Copyright 2026 Ultimate Player All Rights Reserved.
+
+#pragma once
+
+#include "XQPosition.h"
+#include "XQSearch.h"
+
+#include <fstream>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 协议类型：UCCI（象棋通用引擎协议）或UCI，二者走法记法相同，输出格式略有差异
+enum class EXQProtocolMode : uint8
+{
+    None,
+    UCCI,
+    UCI
+};
+
+/**
+ * 控制台引擎协议：从输入流逐行读取命令，搜索在单独的线程中进行
+ */
+class FXQProtocol
+{
+public:
+    FXQProtocol(std::istream& InInput, std::ostream& InOutput);
+
+    ~FXQProtocol();
+
+    // 处理命令直到quit或输入结束
+    void Run();
+
+    // 处理一行命令，返回false表示退出
+    bool HandleCommand(const std::string& Line);
+
+private:
+    void HandlePosition(const std::vector<std::string>& Tokens);
+
+    void HandleSetOption(const std::vector<std::string>& Tokens);
+
+    void HandleGo(const std::vector<std::string>& Tokens);
+
+    void HandlePerft(const std::vector<std::string>& Tokens);
+
+    void HandleBench(const std::vector<std::string>& Tokens);
+
+    void StartSearch(const FXQSearchLimits& Limits);
+
+    // 停止搜索并等待搜索线程结束，bEmit为true时输出尚未输出的bestmove
+    void StopSearch(bool bEmit);
+
+    void OnIteration(const FXQSearchResult& Result);
+
+    // 调用前需持有OutputMutex
+    void EmitBestMove();
+
+    void WriteLine(const std::string& Text);
+
+    std::string FormatScore(int32 Score) const;
+
+    static uint64 Perft(FXQPosition& Node, int32 Depth);
+
+private:
+    std::istream& Input;
+
+    std::ostream& Output;
+
+    std::mutex OutputMutex;
+
+    EXQProtocolMode Mode = EXQProtocolMode::None;
+
+    FXQPosition Position;
+
+    FXQSearch Search;
+
+    std::thread SearchThread;
+
+    int32 MultiPV = 1;
+
+    // 以下成员由OutputMutex保护
+    // setoption StatsFile设置后，每轮迭代的搜索统计追加到这个CSV文件
+    std::ofstream StatsFile;
+
+    FXQSearchResult LastResult;
+
+    bool bSearchFinished = true;
+
+    bool bBestMoveEmitted = true;
+
+    bool bHoldBestMove = false; // 后台思考和无限思考时，搜索结束也要等stop/ponderhit才输出
+};